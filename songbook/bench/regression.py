@@ -0,0 +1,289 @@
+'''
+Guards conversion output and performance against regressions.
+
+run      converts fixed corpora (regression.xml and a songbook generated by
+         songbook_corpus, both without <language> so that the song order
+         does not depend on the installed locales) to LaTeX, text and transposed LaTeX, checks that
+         the outputs are byte-identical to golden files and that wall time
+         and heap allocations (reported by '--stats=json'; allocations only
+         with -DSONGBOOK_ALLOC_STATS=ON) stay within stored budgets, and
+         appends the measurements to a history file; outputs of the
+         '--trusted' XML reader (also with '--fast-validate') and of the
+         external sort ('--memory-budget') must match the golden files of
+         the Xerces reader and a songbook with errors must be rejected by
+         both validators
+run --update
+         saves the current outputs of the Xerces reader as golden files and
+         the allocations as budgets (wall time too with --time-budgets; it
+         depends on the machine, so it is not stored in the committed
+         budgets); nothing is saved when any variant fails
+compare  compares the last history entry with the median of the previous
+         ones
+
+Exit status is 1 when an output differs or a regression is found.
+'''
+
+import argparse
+import datetime
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+# corpus name -> XML file (str) or songbook_corpus arguments (list)
+CORPORA = {
+    'regression': os.path.join(SCRIPT_DIR, 'regression.xml'),
+    'corpus50': ['--songs', '50', '--seed', '1', '--language', ''],
+}
+
+# songbook_corpus arguments of a songbook with errors
+INVALID_CORPUS = ['--songs', '200', '--seed', '1', '--invalid', '0.05']
+
+# variant name -> songbook arguments ({out} is replaced by the output file)
+VARIANTS = {
+    'tex': ['-l', '{out}'],
+    'txt': ['-txt', '{out}'],
+    't3.tex': ['-transpose', '3', '-l', '{out}'],
+    'trusted.tex': ['--trusted', '-l', '{out}'],
+    'trusted.txt': ['--trusted', '-txt', '{out}'],
+    'validated.tex': ['--fast-validate', '-l', '{out}'],
+    'budget.tex': ['--memory-budget', '1', '-l', '{out}'],
+    'trusted.budget.tex': ['--trusted', '--memory-budget', '1', '-l', '{out}'],
+}
+
+# variants which must produce the same output as another one (differential
+#   checks); they have no golden files of their own
+SAME_OUTPUT = {
+    'trusted.tex': 'tex',
+    'trusted.txt': 'txt',
+    'validated.tex': 'tex',
+    'budget.tex': 'tex',
+    'trusted.budget.tex': 'tex',
+}
+
+
+def run_songbook(songbook, xml, variant_args, out):
+    '''Converts `xml` and returns the statistics printed by `--stats=json`.'''
+    args = [songbook] + [a.replace('{out}', out) for a in variant_args]
+    proc = subprocess.run(args + ['--stats=json', xml],
+                          capture_output=True, text=True)
+    if proc.returncode != 0:
+        raise RuntimeError(f'{" ".join(args)} failed:\n{proc.stderr}')
+    # other messages (e.g. about the locale) may precede the statistics
+    start = proc.stderr.rfind('{\n  "phases"')
+    return json.loads(proc.stderr[start:])
+
+
+def measure(stats):
+    '''Total wall time and allocations (None when not counted).'''
+    phases = stats['phases']
+    result = {'wall_ms': round(sum(p['wall_ms'] for p in phases), 3)}
+    if phases and 'allocations' in phases[0]:
+        result['allocations'] = sum(p['allocations'] for p in phases)
+    return result
+
+
+def first_difference(a, b):
+    '''Line number (1-based) of the first difference of two byte strings.'''
+    for i, (line_a, line_b) in enumerate(zip(a.splitlines(), b.splitlines())):
+        if line_a != line_b:
+            return i + 1
+    return min(len(a.splitlines()), len(b.splitlines())) + 1
+
+
+def exceeds(value, budget, tolerance):
+    return budget is not None and value is not None and value > budget * (1 + tolerance)
+
+
+def git_commit():
+    try:
+        return subprocess.run(['git', 'rev-parse', '--short', 'HEAD'], cwd=SCRIPT_DIR,
+                              capture_output=True, text=True).stdout.strip()
+    except OSError:
+        return ''
+
+
+def run(args):
+    budgets = {}
+    if os.path.exists(args.budgets):
+        with open(args.budgets) as f:
+            budgets = json.load(f)
+
+    failures = []
+    results = {}
+    new_goldens = {}  # golden file -> output, saved only when nothing failed
+    os.makedirs(args.golden, exist_ok=True)
+    with tempfile.TemporaryDirectory() as tmp:
+        for corpus, source in CORPORA.items():
+            xml = source
+            if isinstance(source, list):
+                xml = os.path.join(tmp, corpus + '.xml')
+                subprocess.run([args.corpus, '-o', xml] + source, check=True)
+
+            for variant, variant_args in VARIANTS.items():
+                key = f'{corpus}/{variant}'
+                out = os.path.join(tmp, f'{corpus}.{variant}')
+                # the fastest of the runs is the least disturbed one
+                try:
+                    runs = [measure(run_songbook(args.songbook, xml, variant_args, out))
+                            for _ in range(args.repeat)]
+                except RuntimeError as e:
+                    failures.append(f'{key}: {e}')
+                    continue
+                result = min(runs, key=lambda r: r['wall_ms'])
+                results[key] = result
+
+                golden = os.path.join(args.golden,
+                                      f'{corpus}.{SAME_OUTPUT.get(variant, variant)}')
+                with open(out, 'rb') as f:
+                    output = f.read()
+                if args.update and variant in SAME_OUTPUT:
+                    # compared with the output of the Xerces reader just made
+                    if golden not in new_goldens:
+                        failures.append(f'{key}: no output of {corpus}/{SAME_OUTPUT[variant]}'
+                                        ' to compare with')
+                    elif output != new_goldens[golden]:
+                        failures.append(f'{key}: output differs from '
+                                        f'{corpus}/{SAME_OUTPUT[variant]}')
+                elif args.update:
+                    new_goldens[golden] = output
+                elif not os.path.exists(golden):
+                    failures.append(f'{key}: golden file missing (run with --update)')
+                else:
+                    with open(golden, 'rb') as f:
+                        expected = f.read()
+                    if output != expected:
+                        failures.append(f'{key}: output differs from {golden} '
+                                        f'(line {first_difference(output, expected)})')
+
+                if args.update:
+                    # measurements not taken in this run keep their budgets
+                    measured = {m: result[m] for m in ('allocations', 'wall_ms')
+                                if m in result and (m != 'wall_ms' or args.time_budgets)}
+                    if measured:
+                        budgets.setdefault(key, {}).update(measured)
+
+                budget = budgets.get(key, {})
+                if not args.update:
+                    if exceeds(result['wall_ms'], budget.get('wall_ms'), args.time_tolerance):
+                        failures.append(f'{key}: {result["wall_ms"]:.1f} ms > budget '
+                                        f'{budget["wall_ms"]:.1f} ms')
+                    if exceeds(result.get('allocations'), budget.get('allocations'),
+                               args.alloc_tolerance):
+                        failures.append(f'{key}: {result["allocations"]} allocations > '
+                                        f'budget {budget["allocations"]}')
+
+                print(f'{key:28} {result["wall_ms"]:10.1f} ms'
+                      + (f' {result["allocations"]:12} allocations'
+                         if 'allocations' in result else ''))
+
+        # an invalid songbook must be rejected by Xerces and by the generated validator
+        invalid = os.path.join(tmp, 'invalid.xml')
+        subprocess.run([args.corpus, '-o', invalid] + INVALID_CORPUS, check=True,
+                       capture_output=True)
+        for validator_args in ([], ['--fast-validate']):
+            proc = subprocess.run([args.songbook] + validator_args +
+                                  ['-txt', os.path.join(tmp, 'invalid.txt'), invalid],
+                                  capture_output=True, text=True)
+            if proc.returncode == 0:
+                failures.append(f'invalid songbook accepted with {validator_args or "Xerces"}')
+
+    if args.update and failures:
+        # golden files must come from the validating Xerces reader; a partial
+        #   update would let another reader's output become the reference
+        failures.append('nothing updated, golden files and budgets are only saved '
+                        'when all variants succeed')
+    elif args.update:
+        for golden, output in new_goldens.items():
+            with open(golden, 'wb') as f:
+                f.write(output)
+        with open(args.budgets, 'w') as f:
+            json.dump(budgets, f, indent=2, sort_keys=True)
+            f.write('\n')
+
+    if args.history:
+        with open(args.history, 'a') as f:
+            entry = {'time': datetime.datetime.now().isoformat(timespec='seconds'),
+                     'commit': git_commit(), 'results': results}
+            f.write(json.dumps(entry, sort_keys=True) + '\n')
+
+    for failure in failures:
+        print('FAIL ' + failure, file=sys.stderr)
+    return 1 if failures else 0
+
+
+def compare(args):
+    with open(args.history) as f:
+        entries = [json.loads(line) for line in f if line.strip()]
+    if len(entries) < 2:
+        print('Nothing to compare, at least two history entries are needed')
+        return 0
+
+    latest = entries[-1]
+    previous = entries[-1 - args.window:-1]
+    regressions = 0
+    for key, result in sorted(latest['results'].items()):
+        for measure_name, tolerance in (('wall_ms', args.time_tolerance),
+                                        ('allocations', args.alloc_tolerance)):
+            values = [e['results'][key][measure_name] for e in previous
+                      if measure_name in e['results'].get(key, {})]
+            if measure_name not in result or not values:
+                continue
+            baseline = statistics.median(values)
+            change = (result[measure_name] - baseline) / baseline if baseline else 0
+            flag = ''
+            if exceeds(result[measure_name], baseline, tolerance):
+                flag = '  REGRESSION'
+                regressions += 1
+            print(f'{key:28} {measure_name:12} {baseline:14.1f} -> '
+                  f'{result[measure_name]:14.1f} ({change:+.1%}){flag}')
+
+    print(f'{latest["commit"] or "latest"} compared with the median of '
+          f'{len(previous)} previous run(s)')
+    return 1 if regressions else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    run_parser = commands.add_parser('run', help='check outputs and budgets')
+    run_parser.add_argument('--songbook', required=True, help='songbook executable')
+    run_parser.add_argument('--corpus', required=True, help='songbook_corpus executable')
+    run_parser.add_argument('--golden', default=os.path.join(SCRIPT_DIR, 'golden'),
+                            help='directory with golden outputs')
+    run_parser.add_argument('--budgets',
+                            default=os.path.join(SCRIPT_DIR, 'regression_budgets.json'),
+                            help='time and allocation budgets')
+    run_parser.add_argument('--history', help='file to append the measurements to')
+    run_parser.add_argument('--repeat', type=int, default=3,
+                            help='conversions of each variant; the fastest is used (3)')
+    run_parser.add_argument('--update', action='store_true',
+                            help='save golden outputs and budgets')
+    run_parser.add_argument('--time-budgets', action='store_true',
+                            help='with --update, save wall time budgets too')
+    run_parser.set_defaults(func=run)
+
+    compare_parser = commands.add_parser('compare', help='compare history entries')
+    compare_parser.add_argument('--history', required=True, help='history file')
+    compare_parser.add_argument('--window', type=int, default=5,
+                                help='previous entries forming the baseline (5)')
+    compare_parser.set_defaults(func=compare)
+
+    for p in (run_parser, compare_parser):
+        p.add_argument('--time-tolerance', type=float, default=0.25,
+                       help='allowed relative increase of wall time (0.25)')
+        p.add_argument('--alloc-tolerance', type=float, default=0.02,
+                       help='allowed relative increase of allocations (0.02)')
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
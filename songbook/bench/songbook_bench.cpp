@@ -0,0 +1,584 @@
+#include "SongbookConverter.hpp"
+#include "LineBuffer.hpp"
+#include "StaticSongbookConverter.hpp"
+#include "SongbookPrinterLatex.hpp"
+#include "SongbookException.hpp"
+#include "Song.hpp"
+#include "allocationStats.hpp"
+#include "schemaValidator.hpp"
+#include "trustedXml.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+//------  Allocation counting ------
+
+// with SONGBOOK_ALLOC_STATS, the core library replaces operator new
+//   and also counts allocations made by Xerces
+#ifndef SONGBOOK_ALLOC_STATS
+
+namespace {
+    /**
+     * Number of heap allocations since the program start.
+     */
+    std::atomic<std::size_t> allocation_count{0};
+}
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+#endif
+
+
+namespace {
+    using namespace songbook;
+
+    /**
+     * Result of one benchmark.
+     */
+    struct BenchResult {
+        std::string name;       ///< benchmark name
+        long long iterations;   ///< number of measured operations
+        double ns_per_op;       ///< nanoseconds per operation
+        double allocs_per_op;   ///< heap allocations per operation
+        double bytes_per_op;    ///< bytes processed per operation (0 when not meaningful)
+    };
+
+    /**
+     * Options given on the command line.
+     */
+    struct BenchOptions {
+        std::string xml_file{"data/sb.xml"};   ///< songbook used by all benchmarks
+        std::string filter;                    ///< only benchmarks containing this run
+        double min_time_ms{200};               ///< minimal measured time of a benchmark
+        std::vector<int> scales{10, 50};       ///< enlarged copies of `xml_file` (times the songs)
+        bool json{false};                      ///< JSON output
+        std::string budgets_file;              ///< allocation budgets to check
+        double alloc_tolerance{0.02};          ///< allowed relative excess of a budget
+    };
+
+    /**
+     * Returns the number of heap allocations since the program start.
+     *
+     * @return allocation count
+     */
+    std::size_t current_allocations() {
+#ifdef SONGBOOK_ALLOC_STATS
+        return static_cast<std::size_t>(allocation_counts().allocations);
+#else
+        return allocation_count.load();
+#endif
+    }
+
+    /**
+     * Keeps results of benchmarked code alive so that it is not optimized away.
+     */
+    volatile std::size_t result_sink;
+
+    /**
+     * A converter giving access to the parsed document and protected members.
+     */
+    class BenchConverter: public SongbookConverter {
+        public:
+        using SongbookConverter::read_chord;
+
+        /**
+         * Returns the parsed document's root element.
+         *
+         * @return `<songbook>` element
+         */
+        const xercesc::DOMElement* get_root() const {
+            return parser->getDocument()->getDocumentElement();
+        }
+    };
+
+    /**
+     * Returns the first child element with a given name.
+     *
+     * @param parent element to search in
+     * @param name element name
+     * @return the element or `nullptr`
+     */
+    const xercesc::DOMElement* find_child(const xercesc::DOMElement* parent,
+        const std::string& name) {
+
+        for (auto elem = parent->getFirstElementChild(); elem; elem = elem->getNextElementSibling()) {
+            if (get_node_name(elem) == name)
+                return elem;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Finds the first `<line>` inside an element (in document order).
+     *
+     * @param parent element to search in
+     * @return the line or `nullptr`
+     */
+    const xercesc::DOMElement* find_line(const xercesc::DOMElement* parent) {
+        for (auto elem = parent->getFirstElementChild(); elem; elem = elem->getNextElementSibling()) {
+            if (get_node_name(elem) == "line")
+                return elem;
+            if (auto line = find_line(elem))
+                return line;
+        }
+        return nullptr;
+    }
+
+    /**
+     * Measures an operation. The number of iterations is doubled until
+     * the measured time reaches `options.min_time_ms`.
+     *
+     * @param options benchmark options
+     * @param name benchmark name
+     * @param bytes bytes processed by one operation (0 when not meaningful)
+     * @param op the operation; returns a value derived from its result
+     * @param results results to append to
+     */
+    void run_benchmark(const BenchOptions& options, const std::string& name, double bytes,
+        const std::function<std::size_t()>& op, std::vector<BenchResult>& results) {
+
+        if (name.find(options.filter) == std::string::npos)
+            return;
+
+        // warm-up run
+        result_sink = op();
+
+        for (long long iterations = 1; ; iterations *= 2) {
+            std::size_t allocations = current_allocations();
+            auto start = std::chrono::steady_clock::now();
+            for (long long i = 0; i < iterations; ++i)
+                result_sink = op();
+            auto end = std::chrono::steady_clock::now();
+            allocations = current_allocations() - allocations;
+
+            double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            if (ns >= options.min_time_ms * 1e6 || iterations >= (1LL << 40)) {
+                results.push_back(BenchResult{name, iterations, ns / iterations,
+                    static_cast<double>(allocations) / iterations, bytes});
+                if (!options.json)
+                    std::cerr << name << " done\n";
+                return;
+            }
+        }
+    }
+
+    /**
+     * Creates a songbook with the songs of another one repeated.
+     *
+     * @param xml songbook XML
+     * @param times how many times the songs are included
+     * @return the enlarged songbook
+     */
+    std::string repeat_songs(const std::string& xml, int times) {
+        size_t start = xml.find("<songs>");
+        size_t end = xml.rfind("</songs>");
+        if (start == std::string::npos || end == std::string::npos)
+            throw std::runtime_error("no <songs> element found");
+        start += std::string("<songs>").size();
+
+        std::string songs = xml.substr(start, end - start);
+        std::string result = xml.substr(0, start);
+        result.reserve(xml.size() + songs.size() * (times - 1));
+        for (int i = 0; i < times; ++i)
+            result.append(songs);
+        result.append(xml, end, std::string::npos);
+
+        return result;
+    }
+
+    /**
+     * Benchmarks of single functions used during conversion.
+     *
+     * @param options benchmark options
+     * @param results results to append to
+     */
+    void micro_benchmarks(const BenchOptions& options, std::vector<BenchResult>& results) {
+        BenchConverter converter{};
+        converter.set_printer<SongbookPrinterLatex>();
+        converter.parse_songbook(options.xml_file);
+        SongbookPrinterLatex printer{};
+
+        // the first line of the first song and its first lyrics and chord
+        auto song = find_child(find_child(converter.get_root(), "songs"), "song");
+        const xercesc::DOMElement* line = song ? find_line(song) : nullptr;
+        if (!line)
+            throw std::runtime_error("no <line> found in the first song");
+
+        const xercesc::DOMNode* text_node = nullptr;
+        const xercesc::DOMNode* chord_node = nullptr;
+        LineBuffer line_buffer;
+        for (auto node = line->getFirstChild(); node; node = node->getNextSibling()) {
+            if (node->getNodeType() == xercesc::DOMNode::TEXT_NODE) {
+                if (!text_node)
+                    text_node = node;
+                std::string& lyrics = line_buffer.scratch();
+                append_text_value(node, lyrics);
+                line_buffer.add(LineItemType::lyrics, lyrics);
+            } else if (get_node_name(node) == "chord") {
+                if (!chord_node)
+                    chord_node = node;
+                std::string& printed = line_buffer.scratch();
+                printer.append_chord(converter.read_chord(node), printed);
+                line_buffer.add(LineItemType::chord, printed);
+            }
+        }
+        if (!text_node || !chord_node)
+            throw std::runtime_error("the first line must contain lyrics and a chord");
+        const std::vector<LineItem>& line_items = line_buffer.items();
+
+        std::string lyrics = get_text_value(text_node);
+        TagValueMap chord = converter.read_chord(chord_node);
+        double line_bytes = 0;
+        for (const LineItem& item: line_items)
+            line_bytes += item.value.size();
+
+        run_benchmark(options, "micro/get_text_value", lyrics.size(),
+            [&]() { return get_text_value(text_node).size(); }, results);
+
+        // output strings reused as by the converters
+        std::string output;
+        run_benchmark(options, "micro/append_text_value", lyrics.size(),
+            [&]() { output.clear(); append_text_value(text_node, output); return output.size(); }, 
+            results);
+
+        run_benchmark(options, "micro/replace_newlines", lyrics.size(),
+            [&]() { return replace_newlines(lyrics).size(); }, results);
+
+        run_benchmark(options, "micro/read_chord", 0,
+            [&]() { return converter.read_chord(chord_node).size(); }, results);
+
+        run_benchmark(options, "micro/print_chord", 0,
+            [&]() { return printer.print_chord(chord).size(); }, results);
+
+        run_benchmark(options, "micro/print_line", line_bytes,
+            [&]() { return printer.print_line(line_items).size(); }, results);
+
+        run_benchmark(options, "micro/append_line", line_bytes,
+            [&]() { output.clear(); printer.append_line(line_items, output); return output.size(); }, 
+            results);
+
+        // songs named after the songs of the songbook, 1000 in total
+        std::vector<std::string> names;
+        for (auto elem = find_child(converter.get_root(), "songs")->getFirstElementChild(); elem;
+            elem = elem->getNextElementSibling()) {
+
+            names.push_back(get_text_value(find_child(find_child(elem, "header"), "name")));
+        }
+        std::vector<Song> songs;
+        for (size_t i = 0; i < 1000; ++i)
+            songs.emplace_back(names[i % names.size()] + ' ' + std::to_string(i), "", "");
+        std::reverse(begin(songs), end(songs));
+
+        run_benchmark(options, "micro/sort_songs_1000", 0,
+            [&]() {
+                std::vector<Song> sorted{songs};
+                std::sort(begin(sorted), end(sorted));
+                return sorted.size();
+            }, results);
+
+        run_benchmark(options, "micro/replace_parameter", latex_document_start.size(),
+            [&]() {
+                std::string document{latex_document_start};
+                return static_cast<std::size_t>(replace_parameter(document, "tocTitle", "Obsah"));
+            }, results);
+    }
+
+    /**
+     * Benchmarks of parsing and conversion of whole songbooks.
+     *
+     * @param options benchmark options
+     * @param results results to append to
+     */
+    void end_to_end_benchmarks(const BenchOptions& options, std::vector<BenchResult>& results) {
+        std::string xml = load_xml(options.xml_file);
+
+        // the songbook itself and larger ones with repeated songs
+        std::vector<std::pair<std::string, std::string>> inputs{{"sb", options.xml_file}};
+        for (int times: options.scales) {
+            if (times <= 1)
+                continue;
+            auto file = std::filesystem::temp_directory_path() /
+                ("songbook_bench_x" + std::to_string(times) + ".xml");
+            std::ofstream ofs{file, std::ios::binary};
+            ofs << repeat_songs(xml, times);
+            if (!ofs)
+                throw std::runtime_error("cannot write " + file.string());
+            inputs.emplace_back("sb_x" + std::to_string(times), file.string());
+        }
+
+        for (const auto& [label, file]: inputs) {
+            double input_size = static_cast<double>(std::filesystem::file_size(file));
+
+            SongbookConverter virtual_converter = init_converter<SongbookPrinterLatex>();
+            run_benchmark(options, "e2e/" + label + "/parse", input_size,
+                [&]() { virtual_converter.parse_songbook(file); return std::size_t{1}; }, results);
+
+            // the generated validator with LaTeX and user-defined entities
+            std::string input = load_xml(file);
+            TagValueMap entities = expand_entity_values(SongbookPrinterLatex{}.get_entities());
+            ExtractedEntities user_entities = extract_entities_element(input);
+            if (!user_entities.xml.empty()) {
+                for (auto& [name, value]: read_trusted_entities(user_entities.xml, entities,
+                    user_entities.offset))
+                    entities[name] = std::move(value);
+            }
+            run_benchmark(options, "e2e/" + label + "/validate_generated", input_size,
+                [&]() { validate_xml(input, entities); return std::size_t{1}; }, results);
+
+            StaticSongbookConverter<SongbookPrinterLatex> static_converter{};
+            static_converter.parse_songbook(file);
+            virtual_converter.parse_songbook(file);
+
+            run_benchmark(options, "e2e/" + label + "/convert_virtual", input_size,
+                [&]() { return virtual_converter.convert().size(); }, results);
+
+            run_benchmark(options, "e2e/" + label + "/convert_static", input_size,
+                [&]() { return static_converter.convert().size(); }, results);
+
+            run_benchmark(options, "e2e/" + label + "/parse_convert", input_size,
+                [&]() {
+                    static_converter.parse_songbook(file);
+                    return static_converter.convert().size();
+                }, results);
+        }
+
+        for (size_t i = 1; i < inputs.size(); ++i)
+            std::filesystem::remove(inputs[i].second);
+    }
+
+    /**
+     * Escapes a string for JSON output.
+     *
+     * @param str string to escape
+     * @return escaped string (without quotes)
+     */
+    std::string json_escape(const std::string& str) {
+        std::string result;
+        for (char c: str) {
+            if (c == '"' || c == '\\')
+                result.push_back('\\');
+            result.push_back(c);
+        }
+        return result;
+    }
+
+    /**
+     * Prints benchmark results.
+     *
+     * @param results results to print
+     * @param json should JSON be printed instead of a table?
+     */
+    void print_results(const std::vector<BenchResult>& results, bool json) {
+        std::cout << std::fixed;
+
+        if (json) {
+            std::cout << "{\n  \"benchmarks\": [";
+            for (size_t i = 0; i < results.size(); ++i) {
+                const BenchResult& r = results[i];
+                std::cout << (i ? "," : "") << "\n    {\"name\": \"" << json_escape(r.name)
+                    << "\", \"iterations\": " << r.iterations
+                    << ", \"ns_per_op\": " << std::setprecision(1) << r.ns_per_op
+                    << ", \"allocs_per_op\": " << std::setprecision(2) << r.allocs_per_op
+                    << ", \"mb_per_s\": ";
+                if (r.bytes_per_op > 0)
+                    std::cout << std::setprecision(2) << r.bytes_per_op * 1000.0 / r.ns_per_op;
+                else
+                    std::cout << "null";
+                std::cout << "}";
+            }
+            std::cout << "\n  ]\n}\n";
+            return;
+        }
+
+        std::cout << std::left << std::setw(32) << "benchmark" << std::right
+            << std::setw(16) << "ns/op" << std::setw(14) << "allocs/op"
+            << std::setw(12) << "MB/s" << '\n';
+        for (const BenchResult& r: results) {
+            std::cout << std::left << std::setw(32) << r.name << std::right
+                << std::setw(16) << std::setprecision(1) << r.ns_per_op
+                << std::setw(14) << std::setprecision(2) << r.allocs_per_op
+                << std::setw(12);
+            if (r.bytes_per_op > 0)
+                std::cout << r.bytes_per_op * 1000.0 / r.ns_per_op;
+            else
+                std::cout << "-";
+            std::cout << '\n';
+        }
+    }
+
+    /**
+     * Reads allocation budgets: lines with a benchmark name and the maximal
+     * allocations per operation; empty lines and lines starting with `#`
+     * are ignored.
+     *
+     * @param file budgets file
+     * @return budgets by benchmark name
+     * @throw std::runtime_error when the file cannot be read or parsed
+     */
+    std::map<std::string, double> read_budgets(const std::string& file) {
+        std::ifstream ifs{file};
+        if (!ifs)
+            throw std::runtime_error("Cannot open budgets file " + file);
+
+        std::map<std::string, double> budgets;
+        int line_no{0};
+        for (std::string line; std::getline(ifs, line);) {
+            ++line_no;
+            std::istringstream iss{line};
+            std::string name;
+            double budget;
+            if (!(iss >> name) || name[0] == '#')
+                continue;
+            if (!(iss >> budget))
+                throw std::runtime_error(file + ":" + std::to_string(line_no) + ": missing budget");
+            budgets[name] = budget;
+        }
+        return budgets;
+    }
+
+    /**
+     * Compares allocations of benchmarks with their budgets and reports
+     * exceeded ones to std::cerr. A zero budget stays exact as the relative
+     * tolerance does not apply to it.
+     *
+     * @param results benchmark results
+     * @param budgets maximal allocations per operation by benchmark name
+     * @param tolerance allowed relative excess (0.02 allows 2 % more)
+     * @return number of exceeded budgets
+     */
+    int check_budgets(const std::vector<BenchResult>& results,
+        const std::map<std::string, double>& budgets, double tolerance) {
+
+        int exceeded{0};
+        for (const BenchResult& r: results) {
+            auto search = budgets.find(r.name);
+            if (search != budgets.end() && r.allocs_per_op > search->second * (1 + tolerance)) {
+                std::cerr << "Allocation budget exceeded: " << r.name << ": "
+                    << r.allocs_per_op << " allocs/op > " << search->second << '\n';
+                ++exceeded;
+            }
+        }
+        return exceeded;
+    }
+
+    /**
+     * Prints program usage.
+     */
+    void print_usage() {
+        std::cerr << "Usage: songbook_bench [options] [xml_file]\n\n"
+            "Benchmarks conversion functions and whole conversions of xml_file\n"
+            "(data/sb.xml by default) and of its enlarged copies.\n\n"
+            "Options:\n"
+            "  --json             Print results as JSON.\n"
+            "  --filter <text>    Run only benchmarks whose name contains <text>.\n"
+            "  --min-time <ms>    Minimal measured time of a benchmark (200 ms).\n"
+            "  --budgets <file>   Fail when a benchmark makes more allocations per\n"
+            "                     operation than given in <file> (lines \"name max\").\n"
+            "  --alloc-tolerance <fraction>\n"
+            "                     Allowed relative excess of allocation budgets (0.02).\n"
+            "  --scales <n>[,<n>...]\n"
+            "                     Also convert copies of xml_file with songs repeated\n"
+            "                     <n> times (10,50); 1 means no copies, e.g. for large\n"
+            "                     songbooks made by songbook_corpus.\n";
+    }
+}
+
+/**
+ * Runs micro-benchmarks of conversion functions and end-to-end benchmarks
+ * of parsing and conversion, and reports time, heap allocations and
+ * throughput per operation.
+ */
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+
+    try {
+        std::vector<std::string> args{argv + 1, argv + argc};
+        for (size_t i = 0; i < args.size(); ++i) {
+            if (args[i] == "--json")
+                options.json = true;
+            else if (args[i] == "--filter" && i + 1 < args.size())
+                options.filter = args[++i];
+            else if (args[i] == "--min-time" && i + 1 < args.size())
+                options.min_time_ms = std::stod(args[++i]);
+            else if (args[i] == "--budgets" && i + 1 < args.size())
+                options.budgets_file = args[++i];
+            else if (args[i] == "--alloc-tolerance" && i + 1 < args.size())
+                options.alloc_tolerance = std::stod(args[++i]);
+            else if (args[i] == "--scales" && i + 1 < args.size()) {
+                std::istringstream iss{args[++i]};
+                options.scales.clear();
+                for (std::string scale; std::getline(iss, scale, ',');)
+                    options.scales.push_back(std::stoi(scale));
+            }
+            else if (!args[i].empty() && args[i][0] != '-')
+                options.xml_file = args[i];
+            else {
+                print_usage();
+                return 1;
+            }
+        }
+
+        // read before running so that a bad file fails early
+        std::map<std::string, double> budgets;
+        if (!options.budgets_file.empty())
+            budgets = read_budgets(options.budgets_file);
+
+        std::vector<BenchResult> results;
+        micro_benchmarks(options, results);
+        end_to_end_benchmarks(options, results);
+        print_results(results, options.json);
+
+        if (check_budgets(results, budgets, options.alloc_tolerance) > 0)
+            return 1;
+    }
+    catch (songbook::SongbookException& se) {
+        std::cerr << "Error(s) during XML parsing:\n" << se.what();
+        return 1;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
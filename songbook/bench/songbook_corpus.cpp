@@ -0,0 +1,445 @@
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+    /**
+     * Parameters of a generated songbook.
+     */
+    struct CorpusOptions {
+        std::uint64_t seed{1};          ///< random seed; the same seed gives the same output
+        std::size_t songs{1000};        ///< number of songs
+        double verses{4};               ///< average number of verses and choruses per song
+        double lines{4};                ///< average number of lines per verse
+        double chords{2};               ///< average number of chords per line
+        double multicols{0.2};          ///< share of songs using `<multicols>`
+        double unicode{0.3};            ///< share of non-ASCII words
+        std::size_t entities{5};        ///< number of user-defined entities
+        double invalid{0};              ///< share of songs with an injected error
+        std::string language{"cs;Czech"};  ///< `<language>` setting (omitted when empty)
+        std::string output;             ///< output file (standard output when empty)
+    };
+
+    /**
+     * Random number generator (SplitMix64) with its own mapping to ranges,
+     * so that the output is the same with every compiler and standard
+     * library (unlike `std::uniform_int_distribution`).
+     */
+    class CorpusRandom {
+        public:
+        /**
+         * Constructor.
+         *
+         * @param seed initial state
+         */
+        explicit CorpusRandom(std::uint64_t seed): state{seed} {}
+
+        /**
+         * Returns the next random 64-bit number.
+         *
+         * @return random number
+         */
+        std::uint64_t next() {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        /**
+         * Returns a random number from [0, n).
+         *
+         * @param n upper bound (exclusive), must be positive
+         * @return random number
+         */
+        std::size_t below(std::size_t n) {
+            return static_cast<std::size_t>((next() >> 32) * n >> 32);
+        }
+
+        /**
+         * Returns `true` with a given probability.
+         *
+         * @param p probability
+         * @return random bool
+         */
+        bool chance(double p) {
+            return static_cast<double>(next() >> 11) * 0x1.0p-53 < p;
+        }
+
+        /**
+         * Returns a random count with a given mean (at least 1 when
+         * `mean` >= 1).
+         *
+         * @param mean average count
+         * @return count from [1, 2 * mean - 1] or [0, 2 * mean]
+         */
+        std::size_t around(double mean) {
+            if (mean >= 1) {
+                auto max = static_cast<std::size_t>(2 * mean - 1);
+                return 1 + below(max);
+            }
+            return chance(mean) ? 1 : 0;
+        }
+
+        /**
+         * Returns a random item of an array.
+         *
+         * @param items items to choose from
+         * @return random item
+         */
+        template <typename T, std::size_t N>
+        const T& pick(const std::array<T, N>& items) {
+            return items[below(N)];
+        }
+
+        private:
+        std::uint64_t state;
+    };
+
+    const std::array<const char*, 32> ascii_words{
+        "love", "road", "night", "river", "song", "wind", "home", "heart",
+        "little", "old", "blue", "sky", "rain", "fire", "time", "dream",
+        "mountain", "light", "moon", "train", "sea", "summer", "town", "stone",
+        "walk", "sing", "know", "gone", "down", "away", "never", "again"};
+
+    const std::array<const char*, 32> unicode_words{
+        "píseň", "řeka", "hvězdy", "večer", "údolí", "čas", "vítr", "srdce",
+        "Straße", "Grüße", "Mädchen", "schön", "garçon", "été", "fenêtre", "naïve",
+        "żółw", "łąka", "dziękuję", "ölçü", "güzel", "Ångström", "őszi", "ďábel",
+        "песня", "дорога", "ночь", "звезда", "τραγούδι", "θάλασσα", "ήλιος", "νύχτα"};
+
+    const std::array<const char*, 14> roots{
+        "C", "C#", "Db", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "H", "B"};
+
+    const std::array<const char*, 9> chord_types{
+        "", "", "m", "7", "m7", "maj7", "sus4", "dim", "6"};
+
+    /**
+     * Kinds of injected errors.
+     */
+    const std::array<const char*, 6> error_kinds{
+        "invalid chord root", "missing song name", "unknown element",
+        "too many columns", "undefined entity", "invalid year"};
+
+    /**
+     * Writes songbooks according to `CorpusOptions`.
+     */
+    class CorpusWriter {
+        public:
+        /**
+         * Constructor.
+         *
+         * @param options songbook parameters
+         * @param out output stream
+         */
+        CorpusWriter(const CorpusOptions& options, std::ostream& out):
+            options(options), random(options.seed), out(out) {}
+
+        /**
+         * Writes the whole songbook.
+         */
+        void write_songbook() {
+            out << "<songbook>\n<settings>\n";
+            if (!options.language.empty())
+                out << "  <language>" << options.language << "</language>\n";
+            out << "  <sortSongsBy>name</sortSongsBy>\n"
+                "  <convertAddedSince>all</convertAddedSince>\n";
+            if (options.entities > 0) {
+                out << "  <entities>\n";
+                for (std::size_t i = 0; i < options.entities; ++i) {
+                    out << "    <entity><name>e" << i << "</name><value>"
+                        << word() << ' ' << word() << "</value></entity>\n";
+                }
+                out << "  </entities>\n";
+            }
+            out << "</settings>\n\n<songs>\n";
+
+            for (std::size_t i = 0; i < options.songs; ++i)
+                write_song();
+
+            out << "</songs>\n</songbook>\n";
+        }
+
+        /**
+         * Getter for `injected`.
+         *
+         * @return number of injected errors of each kind
+         */
+        const std::map<std::string, std::size_t>& get_injected() const {
+            return injected;
+        }
+
+        private:
+        /**
+         * Returns a random word.
+         *
+         * @return the word
+         */
+        std::string word() {
+            return random.chance(options.unicode) ? random.pick(unicode_words)
+                                                  : random.pick(ascii_words);
+        }
+
+        /**
+         * Returns several random words, the first one capitalized when ASCII.
+         *
+         * @param count number of words
+         * @return space-separated words
+         */
+        std::string title(std::size_t count) {
+            std::string result;
+            for (std::size_t i = 0; i < count; ++i) {
+                if (i > 0)
+                    result.push_back(' ');
+                result.append(word());
+            }
+            if (!result.empty() && result[0] >= 'a' && result[0] <= 'z')
+                result[0] = static_cast<char>(result[0] - 'a' + 'A');
+            return result;
+        }
+
+        /**
+         * Returns a random date in the `YYYY-MM-DD` format.
+         *
+         * @return the date
+         */
+        std::string date() {
+            std::string month = std::to_string(1 + random.below(12));
+            std::string day = std::to_string(1 + random.below(28));
+            return std::to_string(2000 + random.below(26)) + '-' +
+                (month.size() < 2 ? "0" : "") + month + '-' +
+                (day.size() < 2 ? "0" : "") + day;
+        }
+
+        /**
+         * Counts the error to be injected into the current song; no other
+         * error is injected into the song then.
+         */
+        void inject() {
+            ++injected[error_kinds[error]];
+            error = -1;
+        }
+
+        /**
+         * Writes one song, possibly with an injected error.
+         */
+        void write_song() {
+            error = random.chance(options.invalid) ? static_cast<int>(random.below(error_kinds.size())) : -1;
+
+            out << "<song>\n  <header>\n";
+            if (error == 1)
+                inject();
+            else
+                out << "    <name>" << title(1 + random.below(4)) << "</name>\n";
+            if (random.chance(0.1))
+                out << "    <sortingName>" << title(2) << "</sortingName>\n";
+            if (random.chance(0.2)) {
+                out << "    <authors>\n";
+                for (std::size_t i = 0, n = 2 + random.below(2); i < n; ++i)
+                    out << "      <author>" << title(2) << "</author>\n";
+                out << "    </authors>\n";
+            } else if (random.chance(0.9)) {
+                out << "    <author>" << title(2) << "</author>\n";
+            }
+            if (random.chance(0.5))
+                out << "    <album>" << title(1 + random.below(3)) << "</album>\n";
+            if (error == 5) {
+                inject();
+                out << "    <year>19x5</year>\n";
+            }
+            else if (random.chance(0.6))
+                out << "    <year>" << 1950 + random.below(75) << "</year>\n";
+            out << "    <dateAdded>" << (random.chance(0.3) ? "NA" : date()) << "</dateAdded>\n";
+            if (random.chance(0.05))
+                out << "    <transpose>" << static_cast<int>(random.below(5)) - 2 << "</transpose>\n";
+            out << "  </header>\n";
+
+            if (error == 2) {
+                inject();
+                out << "<bridge/>\n";
+            }
+
+            std::size_t verses = random.around(options.verses);
+            if (random.chance(options.multicols) || error == 3) {
+                out << "<multicols number=\"";
+                if (error == 3) {
+                    inject();
+                    out << 7;
+                } else
+                    out << 2 + random.below(2);
+                out << "\">\n";
+                for (std::size_t i = 0; i < verses; ++i) {
+                    if (i > 0 && i == verses / 2)
+                        out << "<columnbreak/>\n";
+                    write_verse();
+                }
+                out << "</multicols>\n";
+            } else {
+                for (std::size_t i = 0; i < verses; ++i)
+                    write_verse();
+            }
+
+            out << "</song>\n\n";
+        }
+
+        /**
+         * Writes a verse or a chorus.
+         */
+        void write_verse() {
+            const char* element = random.chance(0.25) ? "chorus" : "verse";
+            out << '<' << element << ">\n";
+            for (std::size_t i = 0, n = random.around(options.lines); i < n; ++i)
+                write_line();
+            out << "</" << element << ">\n";
+        }
+
+        /**
+         * Writes a line of lyrics with chords.
+         */
+        void write_line() {
+            std::size_t words = 3 + random.below(6);
+            std::size_t chords = random.around(options.chords);
+            out << "<line>";
+            for (std::size_t i = 0; i < words; ++i) {
+                // chords are spread over the line
+                if (chords > 0 && random.below(words - i) < chords) {
+                    --chords;
+                    write_chord();
+                }
+                if (options.entities > 0 && random.chance(0.02))
+                    out << "&e" << random.below(options.entities) << "; ";
+                else if (random.chance(0.01))
+                    out << "&hellip;";
+                if (error == 4) {
+                    inject();
+                    out << "&undefined; ";
+                }
+                out << word() << ' ';
+            }
+            out << "</line>\n";
+        }
+
+        /**
+         * Writes one chord.
+         */
+        void write_chord() {
+            out << "\n<chord root=\"";
+            if (error == 0) {
+                inject();
+                out << "X";
+            } else
+                out << random.pick(roots);
+            out << '"';
+
+            const char* type = random.pick(chord_types);
+            if (*type)
+                out << " type=\"" << type << '"';
+            if (random.chance(0.1))
+                out << " bass=\"" << random.pick(roots) << '"';
+            if (random.chance(0.05))
+                out << " optional=\"yes\"";
+            out << "/>";
+        }
+
+        const CorpusOptions& options;
+        CorpusRandom random;
+        std::ostream& out;
+        int error{-1};                              ///< error to inject into the current song
+        std::map<std::string, std::size_t> injected;  ///< number of injected errors by kind
+    };
+
+    /**
+     * Prints program usage.
+     */
+    void print_usage() {
+        std::cerr << "Usage: songbook_corpus [options]\n\n"
+            "Generates a songbook XML with random songs. The output is the same\n"
+            "for the same options on all platforms.\n\n"
+            "Options:\n"
+            "  -o <file>          Output file (standard output by default).\n"
+            "  --songs <n>        Number of songs (1000).\n"
+            "  --seed <n>         Random seed (1).\n"
+            "  --verses <x>       Average number of verses per song (4).\n"
+            "  --lines <x>        Average number of lines per verse (4).\n"
+            "  --chords <x>       Average number of chords per line (2).\n"
+            "  --multicols <p>    Share of songs using <multicols> (0.2).\n"
+            "  --unicode <p>      Share of non-ASCII words (0.3).\n"
+            "  --entities <n>     Number of user-defined entities (5).\n"
+            "  --invalid <p>      Share of songs with an error making the XML\n"
+            "                     invalid (0); counts are printed to stderr.\n"
+            "  --language <l>     Value of the <language> setting (cs;Czech);\n"
+            "                     omitted when empty, so that songs are sorted\n"
+            "                     the same way in every environment.\n";
+    }
+}
+
+/**
+ * Generates synthetic songbooks for benchmarks and stress tests.
+ */
+int main(int argc, char* argv[]) {
+    CorpusOptions options;
+
+    try {
+        std::vector<std::string> args{argv + 1, argv + argc};
+        for (size_t i = 0; i < args.size(); ++i) {
+            bool has_value = i + 1 < args.size();
+            if (args[i] == "-o" && has_value)
+                options.output = args[++i];
+            else if (args[i] == "--songs" && has_value)
+                options.songs = std::stoull(args[++i]);
+            else if (args[i] == "--seed" && has_value)
+                options.seed = std::stoull(args[++i]);
+            else if (args[i] == "--verses" && has_value)
+                options.verses = std::stod(args[++i]);
+            else if (args[i] == "--lines" && has_value)
+                options.lines = std::stod(args[++i]);
+            else if (args[i] == "--chords" && has_value)
+                options.chords = std::stod(args[++i]);
+            else if (args[i] == "--multicols" && has_value)
+                options.multicols = std::stod(args[++i]);
+            else if (args[i] == "--unicode" && has_value)
+                options.unicode = std::stod(args[++i]);
+            else if (args[i] == "--entities" && has_value)
+                options.entities = std::stoull(args[++i]);
+            else if (args[i] == "--invalid" && has_value)
+                options.invalid = std::stod(args[++i]);
+            else if (args[i] == "--language" && has_value)
+                options.language = args[++i];
+            else {
+                print_usage();
+                return 1;
+            }
+        }
+
+        std::ofstream ofs;
+        if (!options.output.empty()) {
+            ofs.open(options.output, std::ios::binary);
+            if (!ofs)
+                throw std::runtime_error("Output file " + options.output + " cannot be opened");
+        }
+        std::ostream& out = options.output.empty() ? std::cout : ofs;
+
+        CorpusWriter writer{options, out};
+        writer.write_songbook();
+        out.flush();
+        if (!out)
+            throw std::runtime_error("Output could not be written");
+
+        for (const auto& [kind, count]: writer.get_injected())
+            std::cerr << "Injected " << kind << ": " << count << '\n';
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,222 @@
+#include "ConversionStats.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+namespace songbook {
+
+    void ConversionStats::add_phase_time(const std::string& name, double wall_ms, double cpu_ms,
+        std::uint64_t allocations, std::uint64_t allocated_bytes) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto it = std::find_if(begin(phases), end(phases),
+            [&name](const Phase& phase){ return phase.name == name; });
+        if (it == end(phases)) {
+            phases.push_back(Phase{name, wall_ms, cpu_ms, allocations, allocated_bytes});
+        } else {
+            it->wall_ms += wall_ms;
+            it->cpu_ms += cpu_ms;
+            it->allocations += allocations;
+            it->allocated_bytes += allocated_bytes;
+        }
+    }
+
+    void ConversionStats::add(const std::string& name, std::uint64_t n) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto it = std::find_if(begin(counters), end(counters),
+            [&name](const auto& counter){ return counter.first == name; });
+        if (it == end(counters))
+            counters.emplace_back(name, n);
+        else
+            it->second += n;
+    }
+
+    void ConversionStats::add_max(const std::string& name, std::uint64_t value) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto it = std::find_if(begin(counters), end(counters),
+            [&name](const auto& counter){ return counter.first == name; });
+        if (it == end(counters))
+            counters.emplace_back(name, value);
+        else
+            it->second = std::max(it->second, value);
+    }
+
+    std::vector<ConversionStats::Phase> ConversionStats::get_phases() const {
+        std::lock_guard<std::mutex> lock{mutex};
+        return phases;
+    }
+
+    std::uint64_t ConversionStats::get_counter(const std::string& name) const {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        for (const auto& [counter, value]: counters) {
+            if (counter == name)
+                return value;
+        }
+        return 0;
+    }
+
+    std::string ConversionStats::to_text() const {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        bool allocations = allocation_accounting_enabled();
+
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(1)
+            << std::left << std::setw(24) << "phase" << std::right
+            << std::setw(12) << "wall [ms]" << std::setw(12) << "CPU [ms]";
+        if (allocations)
+            oss << std::setw(14) << "allocations" << std::setw(14) << "alloc [kB]";
+        oss << '\n';
+
+        double wall_total{0}, cpu_total{0};
+        std::uint64_t allocations_total{0}, bytes_total{0};
+        for (const Phase& phase: phases) {
+            oss << std::left << std::setw(24) << phase.name << std::right
+                << std::setw(12) << phase.wall_ms << std::setw(12) << phase.cpu_ms;
+            if (allocations) {
+                oss << std::setw(14) << phase.allocations 
+                    << std::setw(14) << phase.allocated_bytes / 1024;
+            }
+            oss << '\n';
+            wall_total += phase.wall_ms;
+            cpu_total += phase.cpu_ms;
+            allocations_total += phase.allocations;
+            bytes_total += phase.allocated_bytes;
+        }
+        oss << std::left << std::setw(24) << "total" << std::right
+            << std::setw(12) << wall_total << std::setw(12) << cpu_total;
+        if (allocations)
+            oss << std::setw(14) << allocations_total << std::setw(14) << bytes_total / 1024;
+        oss << "\n\n";
+
+        oss << std::left << std::setw(24) << "peak RSS [kB]" << std::right
+            << std::setw(12) << peak_rss_kb() << '\n';
+        for (const auto& [name, value]: counters)
+            oss << std::left << std::setw(24) << name << std::right << std::setw(12) << value << '\n';
+
+        return oss.str();
+    }
+
+    std::string ConversionStats::to_json() const {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        // names are set by the program, no escaping needed
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(3) << "{\n  \"phases\": [";
+        for (size_t i = 0; i < phases.size(); ++i) {
+            oss << (i ? "," : "") << "\n    {\"name\": \"" << phases[i].name
+                << "\", \"wall_ms\": " << phases[i].wall_ms
+                << ", \"cpu_ms\": " << phases[i].cpu_ms;
+            if (allocation_accounting_enabled()) {
+                oss << ", \"allocations\": " << phases[i].allocations
+                    << ", \"allocated_bytes\": " << phases[i].allocated_bytes;
+            }
+            oss << '}';
+        }
+        oss << "\n  ],\n  \"peak_rss_kb\": " << peak_rss_kb() << ",\n  \"counters\": {";
+        for (size_t i = 0; i < counters.size(); ++i) {
+            oss << (i ? "," : "") << "\n    \"" << counters[i].first << "\": "
+                << counters[i].second;
+        }
+        oss << "\n  }\n}\n";
+
+        return oss.str();
+    }
+
+    std::string ConversionStats::summary() const {
+        double wall_total{0};
+        for (const Phase& phase: get_phases())
+            wall_total += phase.wall_ms;
+
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(0) << get_counter("songs") << " songs in "
+            << wall_total << " ms, peak memory " << peak_rss_kb() / 1024 << " MB";
+        return oss.str();
+    }
+
+    void ConversionStats::set_trace(ConversionTrace* target) {
+        trace = target;
+    }
+
+    ConversionTrace* ConversionStats::get_trace() const {
+        return trace;
+    }
+
+    PhaseTimer::PhaseTimer(ConversionStats* stats, std::string name):
+        stats(stats), name(std::move(name)) {
+
+        if (stats) {
+            wall_start = std::chrono::steady_clock::now();
+            cpu_start = process_cpu_ms();
+            allocations_start = allocation_counts();
+        }
+    }
+
+    PhaseTimer::~PhaseTimer() {
+        stop();
+    }
+
+    void PhaseTimer::stop() {
+        if (!stats)
+            return;
+
+        auto wall_end = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::milli> wall = wall_end - wall_start;
+        AllocationCounts allocations = allocation_counts();
+        stats->add_phase_time(name, wall.count(), process_cpu_ms() - cpu_start,
+            allocations.allocations - allocations_start.allocations,
+            allocations.bytes - allocations_start.bytes);
+        if (ConversionTrace* trace = stats->get_trace())
+            trace->add_span(name, wall_start, wall_end);
+        stats = nullptr;
+    }
+
+    //------  Nonmember functions ------
+
+    double process_cpu_ms() {
+#ifdef _WIN32
+        return 1000.0 * std::clock() / CLOCKS_PER_SEC;
+#else
+        // XeLaTeX runs in a child process
+        double ms{0};
+        for (int who: {RUSAGE_SELF, RUSAGE_CHILDREN}) {
+            rusage usage{};
+            if (getrusage(who, &usage) == 0) {
+                ms += usage.ru_utime.tv_sec * 1000.0 + usage.ru_utime.tv_usec / 1000.0 +
+                    usage.ru_stime.tv_sec * 1000.0 + usage.ru_stime.tv_usec / 1000.0;
+            }
+        }
+        return ms;
+#endif
+    }
+
+    std::uint64_t peak_rss_kb() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return counters.PeakWorkingSetSize / 1024;
+        return 0;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+    #ifdef __APPLE__
+        return static_cast<std::uint64_t>(usage.ru_maxrss) / 1024;  // bytes on macOS
+    #else
+        return static_cast<std::uint64_t>(usage.ru_maxrss);
+    #endif
+#endif
+    }
+}
@@ -0,0 +1,191 @@
+#ifndef SONGBOOK_CONVERSIONSTATS_HPP
+#define SONGBOOK_CONVERSIONSTATS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "allocationStats.hpp"
+#include "ConversionTrace.hpp"
+
+namespace songbook {
+
+    /**
+     * Time spent in phases of a conversion (reading, parsing, converting,
+     * XeLaTeX runs, ...) together with counters of processed items.
+     * Heap allocations made in phases are recorded as well when allocation
+     * accounting is compiled in (see allocationStats.hpp).
+     *
+     * Phases and counters are kept in the order in which they were first
+     * recorded; times of a phase recorded several times are summed. The
+     * statistics can be shared by threads.
+     *
+     * @code
+     * ConversionStats stats;
+     * converter.set_stats(&stats);
+     * converter.parse_songbook("sb.xml");
+     * {
+     *     PhaseTimer timer{&stats, "write"};
+     *     ofs << converter.convert();
+     * }
+     * std::cerr << stats.to_text();
+     * @endcode
+     */
+    class ConversionStats {
+
+        public:
+        /**
+         * Time spent in one phase.
+         */
+        struct Phase {
+            std::string name;    ///< phase name
+            double wall_ms{0};   ///< wall-clock time in milliseconds
+            double cpu_ms{0};    ///< CPU time in milliseconds (including child processes)
+            std::uint64_t allocations{0};      ///< number of heap allocations
+            std::uint64_t allocated_bytes{0};  ///< heap-allocated bytes
+        };
+
+        /**
+         * Adds time spent in a phase.
+         *
+         * @param name phase name
+         * @param wall_ms wall-clock time in milliseconds
+         * @param cpu_ms CPU time in milliseconds
+         * @param allocations number of heap allocations
+         * @param allocated_bytes heap-allocated bytes
+         */
+        void add_phase_time(const std::string& name, double wall_ms, double cpu_ms,
+            std::uint64_t allocations = 0, std::uint64_t allocated_bytes = 0);
+
+        /**
+         * Increases a counter.
+         *
+         * @param name counter name
+         * @param n value to add
+         */
+        void add(const std::string& name, std::uint64_t n = 1);
+
+        /**
+         * Raises a counter to a value unless it is already higher.
+         *
+         * @param name counter name
+         * @param value new candidate maximum
+         */
+        void add_max(const std::string& name, std::uint64_t value);
+
+        /**
+         * Returns phase times.
+         *
+         * @return phases in the order of their first recording
+         */
+        std::vector<Phase> get_phases() const;
+
+        /**
+         * Returns a counter value.
+         *
+         * @param name counter name
+         * @return counter value; 0 for an unknown counter
+         */
+        std::uint64_t get_counter(const std::string& name) const;
+
+        /**
+         * Formats the statistics as a table.
+         *
+         * @return phases, peak memory and counters, one per line
+         */
+        std::string to_text() const;
+
+        /**
+         * Formats the statistics as JSON.
+         *
+         * @return JSON object with `phases`, `peak_rss_kb` and `counters`
+         */
+        std::string to_json() const;
+
+        /**
+         * Formats the most important values on one line.
+         *
+         * @return total time, peak memory and song count
+         */
+        std::string summary() const;
+
+        /**
+         * Attaches a trace to which phases measured by `PhaseTimer` are 
+         * added as spans; converters also add spans of single songs.
+         *
+         * @param target trace (`nullptr` for none)
+         */
+        void set_trace(ConversionTrace* target);
+
+        /**
+         * Getter for `trace`.
+         *
+         * @return attached trace or `nullptr`
+         */
+        ConversionTrace* get_trace() const;
+
+        private:
+        mutable std::mutex mutex;   ///< guards `phases` and `counters`
+        std::vector<Phase> phases;  ///< phase times
+        std::vector<std::pair<std::string, std::uint64_t>> counters;  ///< counter values
+        ConversionTrace* trace{nullptr};  ///< trace receiving phase spans
+    };
+
+
+    /**
+     * Measures a phase from its construction until `stop()` or destruction
+     * and adds the time to `ConversionStats` (and a span to its trace). 
+     * Does nothing when no statistics are given.
+     */
+    class PhaseTimer {
+
+        public:
+        /**
+         * Constructor, starts measuring.
+         *
+         * @param stats statistics to add the time to (can be `nullptr`)
+         * @param name phase name
+         */
+        PhaseTimer(ConversionStats* stats, std::string name);
+
+        PhaseTimer(const PhaseTimer& other) = delete;
+        PhaseTimer& operator=(const PhaseTimer& other) = delete;
+
+        /**
+         * Destructor, stops measuring unless already stopped.
+         */
+        ~PhaseTimer();
+
+        /**
+         * Stops measuring and records the phase.
+         */
+        void stop();
+
+        private:
+        ConversionStats* stats;        ///< target statistics
+        std::string name;              ///< phase name
+        std::chrono::steady_clock::time_point wall_start;  ///< start of the phase
+        double cpu_start{0};           ///< process CPU time at the start (ms)
+        AllocationCounts allocations_start;  ///< allocation counts at the start
+    };
+
+
+    /**
+     * Returns CPU time used by the process and its finished child processes.
+     *
+     * @return CPU time in milliseconds
+     */
+    double process_cpu_ms();
+
+    /**
+     * Returns the peak resident set size (maximal physical memory used)
+     * of the process.
+     *
+     * @return peak RSS in kilobytes; 0 when not available
+     */
+    std::uint64_t peak_rss_kb();
+}
+
+#endif  // SONGBOOK_CONVERSIONSTATS_HPP
@@ -0,0 +1,105 @@
+#include "ConversionTrace.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace songbook {
+
+    namespace {
+        /**
+         * Escapes a string for use in JSON (song names come from the user).
+         *
+         * @param str string to escape
+         * @return escaped string (without quotes)
+         */
+        std::string json_escape(const std::string& str) {
+            std::ostringstream oss;
+            for (char c: str) {
+                if (c == '"' || c == '\\')
+                    oss << '\\' << c;
+                else if (static_cast<unsigned char>(c) < 0x20)
+                    oss << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                        << static_cast<int>(c) << std::dec;
+                else
+                    oss << c;
+            }
+            return oss.str();
+        }
+    }
+
+    ConversionTrace::ConversionTrace(): start(Clock::now()) {}
+
+    void ConversionTrace::add_span(const std::string& name, Clock::time_point span_start,
+        Clock::time_point span_end, const std::string& song) {
+
+        using us = std::chrono::duration<double, std::micro>;
+        std::thread::id id = std::this_thread::get_id();
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto it = std::find(begin(threads), end(threads), id);
+        if (it == end(threads))
+            it = threads.insert(end(threads), id);
+
+        spans.push_back(Span{name, song, us(span_start - start).count(),
+            us(span_end - span_start).count(), static_cast<int>(it - begin(threads))});
+    }
+
+    std::vector<ConversionTrace::Span> ConversionTrace::get_spans() const {
+        std::lock_guard<std::mutex> lock{mutex};
+        return spans;
+    }
+
+    std::string ConversionTrace::to_json() const {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        std::ostringstream oss;
+        oss << std::fixed << std::setprecision(3) << "{\"traceEvents\": [";
+        // thread names shown by the viewers
+        for (size_t i = 0; i < threads.size(); ++i) {
+            oss << (i ? "," : "") << "\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+                << "\"tid\": " << i << ", \"args\": {\"name\": \""
+                << "thread " << i << "\"}}";
+        }
+        for (size_t i = 0; i < spans.size(); ++i) {
+            const Span& span = spans[i];
+            oss << (i || !threads.empty() ? "," : "") << "\n  {\"name\": \"" 
+                << json_escape(span.song.empty() ? span.name : span.song)
+                << "\", \"cat\": \"" << json_escape(span.name) << "\", \"ph\": \"X\""
+                << ", \"ts\": " << span.start_us << ", \"dur\": " << span.duration_us
+                << ", \"pid\": 1, \"tid\": " << span.thread;
+            if (!span.song.empty())
+                oss << ", \"args\": {\"song\": \"" << json_escape(span.song) << "\"}";
+            oss << '}';
+        }
+        oss << "\n], \"displayTimeUnit\": \"ms\"}\n";
+
+        return oss.str();
+    }
+
+    void ConversionTrace::save(const std::string& file) const {
+        std::ofstream ofs{file};
+        if (!ofs.is_open())
+            throw std::runtime_error("Trace file " + file + " cannot be opened");
+        ofs << to_json();
+    }
+
+    TraceSpan::TraceSpan(ConversionTrace* trace, std::string name, std::string song):
+        trace(trace), name(std::move(name)), song(std::move(song)) {
+
+        if (trace)
+            start = ConversionTrace::Clock::now();
+    }
+
+    TraceSpan::~TraceSpan() {
+        if (trace)
+            trace->add_span(name, start, ConversionTrace::Clock::now(), song);
+    }
+
+    void TraceSpan::set_song(std::string name) {
+        song = std::move(name);
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef SONGBOOK_CONVERSIONTRACE_HPP
+#define SONGBOOK_CONVERSIONTRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * Spans of a conversion (phases, single songs, XeLaTeX passes, ...) 
+     * recorded with the threads they ran in, saved in the Chrome trace 
+     * event format viewable in Perfetto (https://ui.perfetto.dev) or 
+     * `chrome://tracing`.
+     *
+     * Spans are usually recorded by `PhaseTimer` (when the trace is attached
+     * to `ConversionStats`) or by `TraceSpan`. The trace can be shared by 
+     * threads.
+     */
+    class ConversionTrace {
+
+        public:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * One recorded span.
+         */
+        struct Span {
+            std::string name;       ///< span name
+            std::string song;       ///< name of the song the span belongs to (can be empty)
+            double start_us{0};     ///< start since the trace creation in microseconds
+            double duration_us{0};  ///< duration in microseconds
+            int thread{0};          ///< thread number (0 for the first recording thread)
+        };
+
+        /**
+         * Constructor, the trace time starts now.
+         */
+        ConversionTrace();
+
+        /**
+         * Adds a span which ran in the calling thread.
+         *
+         * @param name span name
+         * @param start span start
+         * @param end span end
+         * @param song song name (empty when the span is not a song)
+         */
+        void add_span(const std::string& name, Clock::time_point start, 
+            Clock::time_point end, const std::string& song = "");
+
+        /**
+         * Returns recorded spans.
+         *
+         * @return spans in the order of their ends
+         */
+        std::vector<Span> get_spans() const;
+
+        /**
+         * Formats the trace as JSON.
+         *
+         * @return JSON object with `traceEvents`
+         */
+        std::string to_json() const;
+
+        /**
+         * Saves the trace to a file.
+         *
+         * @param file output file name
+         * @throw std::runtime_error when the file cannot be written
+         */
+        void save(const std::string& file) const;
+
+        private:
+        mutable std::mutex mutex;         ///< guards `spans` and `threads`
+        Clock::time_point start;          ///< trace time origin
+        std::vector<Span> spans;          ///< recorded spans
+        std::vector<std::thread::id> threads;  ///< threads in the order of their first span
+    };
+
+
+    /**
+     * Records a span into `ConversionTrace` from its construction until
+     * destruction. Does nothing when no trace is given.
+     */
+    class TraceSpan {
+
+        public:
+        /**
+         * Constructor, starts the span.
+         *
+         * @param trace trace to add the span to (can be `nullptr`)
+         * @param name span name
+         * @param song song name (empty when the span is not a song)
+         */
+        TraceSpan(ConversionTrace* trace, std::string name, std::string song = "");
+
+        TraceSpan(const TraceSpan& other) = delete;
+        TraceSpan& operator=(const TraceSpan& other) = delete;
+
+        /**
+         * Destructor, ends the span.
+         */
+        ~TraceSpan();
+
+        /**
+         * Sets the song name (e.g. when known only after the song is read).
+         *
+         * @param name song name
+         */
+        void set_song(std::string name);
+
+        private:
+        ConversionTrace* trace;   ///< target trace
+        std::string name;         ///< span name
+        std::string song;         ///< song name
+        ConversionTrace::Clock::time_point start;  ///< span start
+    };
+}
+
+#endif  // SONGBOOK_CONVERSIONTRACE_HPP
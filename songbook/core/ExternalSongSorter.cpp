@@ -0,0 +1,184 @@
+#include "ExternalSongSorter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <stdexcept>
+
+namespace songbook {
+
+    namespace {
+
+        /**
+         * Writes one record (key and content, each preceded by its size)
+         * to a run file.
+         *
+         * @param file run file
+         * @param key collation key
+         * @param content song content
+         * @return number of bytes written
+         * @throws std::runtime_error writing failed
+         */
+        std::uint64_t write_record(std::FILE* file, const std::string& key,
+            const std::string& content) {
+
+            std::uint64_t sizes[2] = {key.size(), content.size()};
+            if (std::fwrite(sizes, sizeof(sizes), 1, file) != 1 ||
+                std::fwrite(key.data(), 1, key.size(), file) != key.size() ||
+                std::fwrite(content.data(), 1, content.size(), file) != content.size())
+                throw std::runtime_error("Temporary file for sorting songs cannot be written");
+
+            return sizeof(sizes) + key.size() + content.size();
+        }
+
+        /**
+         * Reads one record written by `write_record()`.
+         *
+         * @param file run file
+         * @param key collation key (its memory is reused)
+         * @param content song content (its memory is reused)
+         * @return `false` at the end of the file
+         * @throws std::runtime_error reading failed
+         */
+        bool read_record(std::FILE* file, std::string& key, std::string& content) {
+            std::uint64_t sizes[2];
+            if (std::fread(sizes, sizeof(sizes), 1, file) != 1) {
+                if (std::ferror(file))
+                    throw std::runtime_error("Temporary file for sorting songs cannot be read");
+                return false;
+            }
+
+            key.resize(sizes[0]);
+            content.resize(sizes[1]);
+            if (std::fread(key.data(), 1, key.size(), file) != key.size() ||
+                std::fread(content.data(), 1, content.size(), file) != content.size())
+                throw std::runtime_error("Temporary file for sorting songs cannot be read");
+
+            return true;
+        }
+    }
+
+    ExternalSongSorter::ExternalSongSorter(size_t memory_budget, bool sort):
+        memory_budget(memory_budget), sort(sort) {}
+
+    void ExternalSongSorter::add(const Song& song) {
+        Record record{sort ? collation_key(song.get_sorting_name()) : "", song.get_content()};
+        records_size += sizeof(Record) + record.key.size() + record.content.size();
+        records.push_back(std::move(record));
+
+        if (records_size > memory_budget)
+            spill();
+    }
+
+    void ExternalSongSorter::write(std::ostream& output) {
+
+        // everything fits into memory
+        if (runs.empty()) {
+            std::stable_sort(begin(records), end(records), 
+                [](const Record& lhs, const Record& rhs) { return lhs.key < rhs.key; });
+            for (const Record& record: records)
+                output << record.content;
+            records.clear();
+            records_size = 0;
+            return;
+        }
+
+        spill();
+        while (runs.size() > max_merge_runs)
+            merge_last_runs(runs.size() - max_merge_runs);
+
+        merge(0, runs.size(), [&](const Record& record) { output << record.content; });
+        runs.clear();
+    }
+
+    size_t ExternalSongSorter::get_run_count() const {
+        return run_count;
+    }
+
+    std::uint64_t ExternalSongSorter::get_spilled_bytes() const {
+        return spilled_bytes;
+    }
+
+    void ExternalSongSorter::spill() {
+        if (records.empty())
+            return;
+
+        std::stable_sort(begin(records), end(records),
+            [](const Record& lhs, const Record& rhs) { return lhs.key < rhs.key; });
+
+        Run run = new_run(0);
+        for (const Record& record: records)
+            spilled_bytes += write_record(run.file.get(), record.key, record.content);
+        runs.push_back(std::move(run));
+        records.clear();
+        records_size = 0;
+
+        // levels never increase towards the end, so the last runs have 
+        //   the same level when the first of them has the last one's level
+        while (runs.size() >= max_merge_runs && 
+            runs[runs.size() - max_merge_runs].level == runs.back().level)
+            merge_last_runs(runs.size() - max_merge_runs);
+    }
+
+    ExternalSongSorter::Run ExternalSongSorter::new_run(int level) {
+        Run run{{std::tmpfile(), FileCloser{}}, level};
+        if (!run.file)
+            throw std::runtime_error("Temporary file for sorting songs cannot be created");
+        ++run_count;
+
+        return run;
+    }
+
+    void ExternalSongSorter::merge_last_runs(size_t first) {
+        Run merged = new_run(runs[first].level + 1);
+        merge(first, runs.size(), [&](const Record& record) {
+            spilled_bytes += write_record(merged.file.get(), record.key, record.content);
+        });
+        runs.erase(begin(runs) + first, end(runs));
+        runs.push_back(std::move(merged));
+    }
+
+    void ExternalSongSorter::merge(size_t first, size_t last,
+        const std::function<void(const Record&)>& write) {
+
+        // the current song of each run; equal keys are taken from earlier
+        //   runs first, which keeps the order of addition
+        std::vector<Record> heads(last - first);
+        auto later = [&heads](size_t lhs, size_t rhs) {
+            int cmp = heads[lhs].key.compare(heads[rhs].key);
+            return cmp > 0 || (cmp == 0 && lhs > rhs);
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(later)> queue{later};
+
+        for (size_t i = 0; i < heads.size(); ++i) {
+            std::FILE* run = runs[first + i].file.get();
+            if (std::fflush(run) != 0 || std::fseek(run, 0, SEEK_SET) != 0)
+                throw std::runtime_error("Temporary file for sorting songs cannot be read");
+            if (read_record(run, heads[i].key, heads[i].content))
+                queue.push(i);
+        }
+
+        while (!queue.empty()) {
+            size_t i = queue.top();
+            queue.pop();
+            write(heads[i]);
+            if (read_record(runs[first + i].file.get(), heads[i].key, heads[i].content))
+                queue.push(i);
+        }
+    }
+
+    //------  Nonmember functions ------
+
+    std::string collation_key(const std::string& str) {
+        // the key is usually a few times longer than the string
+        std::string key(str.size() * 4 + 1, '\0');
+        size_t size = std::strxfrm(key.data(), str.c_str(), key.size());
+        if (size >= key.size()) {
+            key.resize(size + 1);
+            std::strxfrm(key.data(), str.c_str(), key.size());
+        }
+        key.resize(size);
+
+        return key;
+    }
+}
@@ -0,0 +1,164 @@
+#ifndef SONGBOOK_EXTERNALSONGSORTER_HPP
+#define SONGBOOK_EXTERNALSONGSORTER_HPP
+
+#include "Song.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * Sorts printed songs within a memory budget and writes their content
+     * in order (an external merge sort).
+     *
+     * Songs are collected in memory until their size exceeds the budget;
+     * they are then sorted and spilled to a temporary run file. Runs are
+     * finally merged directly into the output stream. Songs are compared
+     * by collation keys (`std::strxfrm()` of their sorting names), which
+     * order them as `operator<` of `Song` does, but can be compared
+     * bytewise. Songs with equal keys keep the order in which they were
+     * added.
+     *
+     * Apart from the budget, one song per run is held in memory while
+     * merging. To keep the number of open run files low, every 
+     * `max_merge_runs` runs of similar length are merged into a longer one
+     * as soon as they are written.
+     *
+     * @code
+     * ExternalSongSorter sorter{64 << 20};
+     * for (...)
+     *     sorter.add(song);
+     * sorter.write(output);
+     * @endcode
+     */
+    class ExternalSongSorter {
+
+        public:
+        /**
+         * Maximal number of runs merged at once.
+         */
+        static constexpr size_t max_merge_runs{16};
+
+        /**
+         * Constructor.
+         *
+         * @param memory_budget maximal size of songs kept in memory in bytes
+         * @param sort should songs be sorted? Otherwise they are written in
+         * the order of addition.
+         */
+        explicit ExternalSongSorter(size_t memory_budget, bool sort = true);
+
+        /**
+         * Adds a song, spilling songs to a run file when the budget is exceeded.
+         *
+         * @param song printed song
+         * @throws std::runtime_error a temporary file cannot be created or written
+         */
+        void add(const Song& song);
+
+        /**
+         * Writes the content of all added songs in order and removes them.
+         *
+         * @param output stream to write to
+         * @throws std::runtime_error a temporary file cannot be created or read
+         */
+        void write(std::ostream& output);
+
+        /**
+         * Returns the number of run files written so far.
+         *
+         * @return number of runs (including runs created by merging)
+         */
+        size_t get_run_count() const;
+
+        /**
+         * Returns the number of bytes written to run files so far.
+         *
+         * @return spilled bytes
+         */
+        std::uint64_t get_spilled_bytes() const;
+
+        private:
+        /**
+         * A song waiting for sorting.
+         */
+        struct Record {
+            std::string key;      ///< collation key
+            std::string content;  ///< song content
+        };
+
+        /**
+         * Closes a temporary file (which removes it).
+         */
+        struct FileCloser {
+            void operator()(std::FILE* file) const { std::fclose(file); }
+        };
+
+        /**
+         * A run file with sorted songs.
+         */
+        struct Run {
+            std::unique_ptr<std::FILE, FileCloser> file;  ///< temporary file
+            int level;  ///< 0 for spilled songs, levels of merged runs + 1 for merged runs
+        };
+
+        /**
+         * Sorts songs in memory and writes them to a new run file.
+         *
+         * @throws std::runtime_error a temporary file cannot be created or written
+         */
+        void spill();
+
+        /**
+         * Creates a new run.
+         *
+         * @param level level of the run
+         * @return run with an empty file
+         * @throws std::runtime_error the file cannot be created
+         */
+        Run new_run(int level);
+
+        /**
+         * Merges the last runs into a single run.
+         *
+         * @param first first run to merge
+         * @throws std::runtime_error a temporary file cannot be created, read or written
+         */
+        void merge_last_runs(size_t first);
+
+        /**
+         * Merges runs.
+         *
+         * @param first first run to merge
+         * @param last run after the last run to merge
+         * @param write called with each song in order
+         * @throws std::runtime_error a temporary file cannot be read
+         */
+        void merge(size_t first, size_t last, const std::function<void(const Record&)>& write);
+
+        size_t memory_budget;          ///< see the constructor
+        bool sort;                     ///< see the constructor
+        std::vector<Record> records;   ///< songs in memory
+        size_t records_size{0};        ///< bytes taken by `records`
+        std::vector<Run> runs;         ///< runs in the order of their songs
+        size_t run_count{0};           ///< see `get_run_count()`
+        std::uint64_t spilled_bytes{0};  ///< see `get_spilled_bytes()`
+    };
+
+    /**
+     * Returns a collation key of a string in the current locale.
+     *
+     * @param str string
+     * @return key; keys of two strings compare as `std::strcoll()` compares
+     * the strings
+     */
+    std::string collation_key(const std::string& str);
+}
+
+#endif  // SONGBOOK_EXTERNALSONGSORTER_HPP
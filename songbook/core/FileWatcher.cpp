@@ -0,0 +1,117 @@
+#include "FileWatcher.hpp"
+
+#include <filesystem>
+#include <set>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace songbook {
+
+    FileWatcher::FileWatcher(std::vector<std::string> files): files(std::move(files)) {
+        for (const std::string& file: this->files)
+            stamps.push_back(get_stamp(file));
+
+#ifdef __linux__
+        notify.reset(inotify_init1(IN_CLOEXEC));
+        if (notify.get() < 0)
+            return;
+
+        // directories rather than files, whose inodes change when they are
+        //   saved by renaming
+        std::set<std::string> dirs;
+        for (const std::string& file: this->files) {
+            std::filesystem::path dir = std::filesystem::path{file}.parent_path();
+            dirs.insert(dir.empty() ? "." : dir.string());
+        }
+        for (const std::string& dir: dirs) {
+            if (inotify_add_watch(notify.get(), dir.c_str(),
+                IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE | IN_ATTRIB) < 0) {
+                // polling is used instead
+                notify.reset();
+                return;
+            }
+        }
+#endif
+    }
+
+    std::vector<std::string> FileWatcher::wait() {
+        while (true) {
+            wait_for_event();
+
+            std::vector<std::string> changed;
+            for (size_t i = 0; i < files.size(); ++i) {
+                FileStamp stamp = get_stamp(files[i]);
+                if (stamp.exists && !(stamp == stamps[i])) {
+                    stamps[i] = stamp;
+                    changed.push_back(files[i]);
+                }
+            }
+            if (!changed.empty())
+                return changed;
+        }
+    }
+
+    bool FileWatcher::uses_notifications() const {
+        return notify.get() >= 0;
+    }
+
+    bool FileWatcher::FileStamp::operator==(const FileStamp& other) const {
+        return exists == other.exists && mtime == other.mtime && size == other.size;
+    }
+
+    FileWatcher::FileStamp FileWatcher::get_stamp(const std::string& file) {
+        std::error_code error;
+        auto mtime = std::filesystem::last_write_time(file, error);
+        if (error)
+            return FileStamp{};
+        std::uint64_t size = std::filesystem::file_size(file, error);
+        if (error)
+            return FileStamp{};
+
+        return FileStamp{true, static_cast<std::int64_t>(mtime.time_since_epoch().count()), size};
+    }
+
+    void FileWatcher::wait_for_event() {
+#ifdef __linux__
+        if (notify.get() >= 0) {
+            // events are only drained, files are checked afterwards
+            alignas(inotify_event) char buffer[4096];
+            pollfd fd{notify.get(), POLLIN, 0};
+            int timeout = -1;
+            while (poll(&fd, 1, timeout) > 0) {
+                if (read(notify.get(), buffer, sizeof(buffer)) < 0) {
+                    // polling from now on
+                    notify.reset();
+                    break;
+                }
+                timeout = static_cast<int>(settle_time.count());
+            }
+            return;
+        }
+#endif
+        std::this_thread::sleep_for(poll_interval);
+    }
+
+    //------  NotifyHandle member functions ------
+
+    FileWatcher::NotifyHandle::~NotifyHandle() {
+        reset();
+    }
+
+    void FileWatcher::NotifyHandle::reset(int new_fd) {
+#ifdef __linux__
+        if (fd >= 0)
+            close(fd);
+#endif
+        fd = new_fd;
+    }
+
+    int FileWatcher::NotifyHandle::get() const {
+        return fd;
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef SONGBOOK_FILEWATCHER_HPP
+#define SONGBOOK_FILEWATCHER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * Waits for changes of files.
+     *
+     * A file is changed when its modification time or size differs from
+     * the last time it was checked. On Linux, the directories of the files
+     * are watched by inotify, so that files are only checked after
+     * something happened in their directories; files replaced by renaming
+     * (as many editors save them) are detected as well. Elsewhere, or when
+     * inotify is not available, files are checked every `poll_interval`.
+     *
+     * @code
+     * FileWatcher watcher{{"sb.xml"}};
+     * while (true) {
+     *     watcher.wait();
+     *     rebuild();
+     * }
+     * @endcode
+     */
+    class FileWatcher {
+
+        public:
+        /**
+         * Interval of checking files without inotify.
+         */
+        static constexpr std::chrono::milliseconds poll_interval{250};
+
+        /**
+         * Time without further events after which a file being written
+         * is considered complete.
+         */
+        static constexpr std::chrono::milliseconds settle_time{30};
+
+        /**
+         * Constructor. Current states of the files are taken as unchanged.
+         *
+         * @param files files to watch
+         */
+        explicit FileWatcher(std::vector<std::string> files);
+
+        FileWatcher(const FileWatcher& other) = delete;
+        FileWatcher& operator=(const FileWatcher& other) = delete;
+
+        /**
+         * Blocks until at least one of the files changes. Files which do
+         * not exist (e.g. while being replaced) are not reported until they
+         * exist again.
+         *
+         * @return changed files
+         */
+        std::vector<std::string> wait();
+
+        /**
+         * Are changes detected by inotify (rather than by polling)?
+         *
+         * @return `true` with inotify
+         */
+        bool uses_notifications() const;
+
+        private:
+        /**
+         * Owns an inotify instance and closes it (which stops watching).
+         */
+        class NotifyHandle {
+            public:
+            NotifyHandle() = default;
+            NotifyHandle(const NotifyHandle& other) = delete;
+            NotifyHandle& operator=(const NotifyHandle& other) = delete;
+            ~NotifyHandle();
+
+            /**
+             * Closes the owned descriptor and takes another one.
+             *
+             * @param new_fd descriptor to own, -1 for none
+             */
+            void reset(int new_fd = -1);
+
+            /**
+             * Returns the owned descriptor.
+             *
+             * @return descriptor, -1 for none
+             */
+            int get() const;
+
+            private:
+            int fd{-1};  ///< owned descriptor
+        };
+
+        /**
+         * State of a file compared between checks.
+         */
+        struct FileStamp {
+            bool exists{false};       ///< does the file exist?
+            std::int64_t mtime{0};    ///< modification time
+            std::uint64_t size{0};    ///< file size
+
+            bool operator==(const FileStamp& other) const;
+        };
+
+        /**
+         * Returns the current state of a file.
+         *
+         * @param file file name
+         * @return file state
+         */
+        static FileStamp get_stamp(const std::string& file);
+
+        /**
+         * Blocks until something may have changed: an inotify event was
+         * followed by `settle_time` without events, or `poll_interval` passed.
+         */
+        void wait_for_event();
+
+        std::vector<std::string> files;  ///< watched files
+        std::vector<FileStamp> stamps;   ///< last states of `files`
+        NotifyHandle notify;             ///< inotify instance, none when polling
+    };
+}
+
+#endif  // SONGBOOK_FILEWATCHER_HPP
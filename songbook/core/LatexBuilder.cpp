@@ -0,0 +1,408 @@
+#include "LatexBuilder.hpp"
+#include "SongbookPrinterLatex.hpp"
+#include "contentHash.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #define popen _popen
+    #define pclose _pclose
+#endif
+
+namespace songbook {
+
+    namespace {
+        /**
+         * Reads a whole text file.
+         * 
+         * @param file file name
+         * @param content string to store the content to
+         * @return `false` when the file cannot be read
+         */
+        bool read_text_file(const std::string& file, std::string& content) {
+            std::ifstream ifs{file, std::ios::binary};
+            if (!ifs)
+                return false;
+            std::ostringstream oss;
+            oss << ifs.rdbuf();
+            content = std::move(oss).str();
+            return true;
+        }
+
+        /**
+         * Writes a whole text file.
+         * 
+         * @param file file name
+         * @param content file content
+         * @throws std::runtime_error the file cannot be written
+         */
+        void write_text_file(const std::string& file, const std::string& content) {
+            std::ofstream ofs{file, std::ios::binary};
+            ofs << content;
+            if (!ofs)
+                throw std::runtime_error("LaTeX file " + file + " cannot be written");
+        }
+
+        /**
+         * Reads counter values stored in the `.aux` file of a unit at its 
+         * end, which determine the numbering of the following units.
+         * 
+         * @param aux_file `.aux` file of a unit
+         * @return `\setcounter` lines; empty when the file cannot be read
+         */
+        std::string read_unit_counters(const std::string& aux_file) {
+            std::string aux;
+            if (!read_text_file(aux_file, aux))
+                return "";
+
+            std::string counters;
+            std::istringstream iss{aux};
+            for (std::string line; getline(iss, line); ) {
+                if (line.rfind("\\setcounter{", 0) == 0)
+                    counters.append(line).push_back('\n');
+            }
+            return counters;
+        }
+
+        /**
+         * Hashes of a unit at the last successful full build.
+         */
+        struct UnitHashes {
+            std::string name;      ///< unit name
+            std::string content;   ///< hash of the unit's LaTeX file
+            std::string counters;  ///< hash of its counters (see `read_unit_counters()`)
+        };
+
+        /**
+         * State of the last successful full build of a document split into
+         * units, saved next to it in `<name>.units`: a line with the hash
+         * of the main document followed by a line per unit.
+         */
+        struct FullBuildState {
+            std::string main;                ///< hash of the main document
+            std::vector<UnitHashes> units;   ///< units in the order of including
+        };
+
+        /**
+         * Hashes a string for `FullBuildState`.
+         *
+         * @param str string to hash
+         * @return hexadecimal hash
+         */
+        std::string hash_text(const std::string& str) {
+            return hash_to_hex(content_hash(str));
+        }
+
+        /**
+         * Reads the state of the last full build.
+         *
+         * @param file state file
+         * @param state read state
+         * @return `false` when the file does not exist or is damaged
+         */
+        bool read_full_build_state(const std::string& file, FullBuildState& state) {
+            std::string content;
+            if (!read_text_file(file, content))
+                return false;
+
+            std::istringstream iss{content};
+            if (!getline(iss, state.main) || state.main.empty())
+                return false;
+            for (std::string line; getline(iss, line); ) {
+                UnitHashes unit;
+                std::istringstream line_stream{line};
+                line_stream >> unit.content >> unit.counters >> std::ws;
+                if (!getline(line_stream, unit.name))
+                    return false;
+                state.units.push_back(std::move(unit));
+            }
+            return true;
+        }
+
+        /**
+         * Saves the state of the last full build.
+         *
+         * @param file state file
+         * @param state state to save
+         * @throws std::runtime_error the file cannot be written
+         */
+        void write_full_build_state(const std::string& file, const FullBuildState& state) {
+            std::string content{state.main + '\n'};
+            for (const UnitHashes& unit: state.units)
+                content.append(unit.content + ' ' + unit.counters + ' ' + unit.name + '\n');
+            write_text_file(file, content);
+        }
+    }
+
+    LatexBuilder::LatexBuilder(std::string latex_file): 
+        latex_file(std::move(latex_file)) {}
+
+    void LatexBuilder::set_use_format(bool use) {
+        use_format = use;
+    }
+
+    void LatexBuilder::set_stats(ConversionStats* target) {
+        stats = target;
+    }
+
+    void LatexBuilder::set_working_directory(std::string dir) {
+        working_directory = std::move(dir);
+    }
+
+    void LatexBuilder::set_log_file(std::string file) {
+        // the command runs in the working directory
+        log_file = file.empty() ? file : std::filesystem::absolute(file).string();
+    }
+
+    std::string LatexBuilder::prepare_format() {
+        if (!use_format)
+            return "";
+
+        std::string version = read_command_output("xelatex --version");
+        // XeLaTeX not available
+        if (version.empty())
+            return "";
+
+        std::string preamble = SongbookPrinterLatex{}.print_format_preamble();
+        std::string name = latex_format_name(preamble, 
+            version.substr(0, version.find('\n')));
+
+        // format already cached
+        if (std::filesystem::exists(working_path(name + ".fmt")))
+            return name;
+
+        // the preamble is dumped from its own file
+        std::ofstream ofs{working_path(name + ".tex")};
+        if (!ofs)
+            return "";
+        ofs << preamble;
+        ofs.close();
+
+        std::string command{"xelatex -ini -interaction=nonstopmode -jobname=" + 
+            name + " \"&xelatex\" mylatexformat.ltx " + name + ".tex"};
+        if (log_file.empty())
+            std::cerr << "Building LaTeX preamble format: " << command << "\n";
+        if (!run_command(command) || !std::filesystem::exists(working_path(name + ".fmt"))) {
+            std::cerr << "LaTeX preamble format could not be built, " <<
+                "running XeLaTeX without it\n";
+            return "";
+        }
+
+        return name;
+    }
+
+    bool LatexBuilder::run(int n_runs) {
+        return run_file(latex_file, n_runs);
+    }
+
+    bool LatexBuilder::run_units(const LatexUnits& document, int n_runs) {
+        namespace fs = std::filesystem;
+
+        // only changed files are written, so that the others keep their times
+        PhaseTimer write_timer{stats, "write units"};
+        std::vector<std::string> names;
+        for (const auto& [name, content]: document.units) {
+            names.push_back(name);
+            std::string old_content;
+            if (!read_text_file(working_path(name + ".tex"), old_content) || old_content != content)
+                write_text_file(working_path(name + ".tex"), content);
+        }
+        std::string old_main;
+        if (!read_text_file(working_path(latex_file), old_main) || old_main != document.main)
+            write_text_file(working_path(latex_file), document.main);
+        write_timer.stop();
+
+        // units are compared with the last full build, not with the previous
+        //   (possibly partial) build, so that no edit is missing in the proof
+        std::string job = fs::path{latex_file}.stem().string();
+        std::string state_file = working_path(job + ".units");
+        FullBuildState full;
+        std::string aux;
+        bool partial = n_runs == 1 && read_full_build_state(state_file, full) &&
+            full.main == hash_text(document.main) && full.units.size() == names.size() &&
+            fs::exists(working_path(job + ".pdf")) &&
+            read_text_file(working_path(job + ".aux"), aux) && included_units(aux) == names &&
+            std::all_of(begin(names), end(names), [this](const std::string& name) {
+                return fs::exists(working_path(name + ".aux"));
+            });
+
+        std::vector<size_t> changed;
+        for (size_t i = 0; partial && i < names.size(); ++i) {
+            if (full.units[i].name != names[i])
+                partial = false;
+            else if (full.units[i].content != hash_text(document.units[i].second))
+                changed.push_back(i);
+        }
+
+        // a failed full build is not taken as the last one
+        auto run_full = [&]() {
+            std::error_code error;
+            fs::remove(state_file, error);
+            if (!run_file(latex_file, n_runs)) {
+                fs::remove(working_path(job + ".aux"), error);
+                return false;
+            }
+
+            FullBuildState state{hash_text(document.main), {}};
+            for (const auto& [name, content]: document.units) {
+                state.units.push_back(UnitHashes{name, hash_text(content),
+                    hash_text(read_unit_counters(working_path(name + ".aux")))});
+            }
+            write_full_build_state(state_file, state);
+            return true;
+        };
+
+        if (!partial)
+            return run_full();
+        if (changed.empty()) {
+            if (log_file.empty())
+                std::cerr << "No LaTeX unit changed since the last full build\n";
+            return true;
+        }
+
+        // the document with `\includeonly` is compiled under its own name,
+        //   so that the last full build is kept
+        std::string includeonly{"\\includeonly{"};
+        for (size_t i: changed)
+            includeonly.append(names[i]).push_back(',');
+        includeonly.back() = '}';
+
+        std::string proof_main{document.main};
+        size_t doc_begin = proof_main.find("\\begin{document}");
+        if (doc_begin == std::string::npos)
+            return run_full();
+        proof_main.insert(doc_begin, includeonly + '\n');
+
+        fs::path proof_file = fs::path{latex_file}.replace_extension(".proof.tex");
+        write_text_file(working_path(proof_file.string()), proof_main);
+
+        // the proof starts from the auxiliary files of the full build: its
+        //   `.aux` inputs the checkpoints of the excluded units, so that pages
+        //   and counters continue from them, and the table of contents is kept
+        for (const std::string extension: {".aux", ".toc", ".out"}) {
+            std::error_code error;
+            std::string from = working_path(job + extension);
+            std::string to = working_path(job + ".proof" + extension);
+            if (fs::exists(from, error))
+                fs::copy_file(from, to, fs::copy_options::overwrite_existing, error);
+            else
+                fs::remove(to, error);
+            if (error)
+                return run_full();
+        }
+        if (log_file.empty()) {
+            std::cerr << "Building LaTeX units changed since the last full build (" <<
+                changed.size() << " of " << names.size() << ") into " << job << ".proof.pdf\n";
+        }
+
+        // failed units still differ from the full build, so they are compiled next time
+        if (!run_file(proof_file.string(), 1))
+            return false;
+
+        // following units would be numbered incorrectly
+        for (size_t i: changed) {
+            if (hash_text(read_unit_counters(working_path(names[i] + ".aux"))) != full.units[i].counters) {
+                if (log_file.empty())
+                    std::cerr << "Page numbers changed, building the whole document\n";
+                return run_full();
+            }
+        }
+
+        return true;
+    }
+
+    bool LatexBuilder::run_file(const std::string& file, int n_runs) {
+        PhaseTimer format_timer{stats, "xelatex format"};
+        std::string format = prepare_format();
+        format_timer.stop();
+
+        std::string command{"xelatex "};
+        if (!format.empty())
+            command.append("-fmt=" + format + " ");
+        command.append(file);
+
+        for (int i = 0; i < n_runs; ++i) {
+            PhaseTimer pass_timer{stats, "xelatex pass " + std::to_string(i + 1)};
+            if (log_file.empty())
+                std::cerr << "Running XeLaTeX: " << command << "\n";
+            if (!run_command(command))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool LatexBuilder::run_command(const std::string& command) const {
+        std::string full_command{command};
+        if (!working_directory.empty()) {
+#ifdef _WIN32
+            full_command = "cd /d \"" + working_directory + "\" && " + full_command;
+#else
+            full_command = "cd \"" + working_directory + "\" && " + full_command;
+#endif
+        }
+
+        if (!log_file.empty()) {
+            std::ofstream log{log_file, std::ios::app};
+            log << "Running: " << command << "\n";
+            log.close();
+            full_command.append(" >> \"" + log_file + "\" 2>&1");
+        }
+
+        return std::system(full_command.c_str()) == 0;
+    }
+
+    std::string LatexBuilder::working_path(const std::string& file) const {
+        if (working_directory.empty())
+            return file;
+        return (std::filesystem::path{working_directory} / file).string();
+    }
+
+    std::string latex_format_name(const std::string& preamble, 
+        const std::string& engine_version) {
+
+        std::uint64_t hash = content_hash(preamble);
+        hash = content_hash(engine_version, hash);
+
+        return "songbook-" + hash_to_hex(hash);
+    }
+
+    std::string read_command_output(const std::string& command) {
+        FILE* pipe = popen(command.c_str(), "r");
+        if (!pipe)
+            return "";
+
+        std::string output;
+        char buffer[256];
+        while (std::fgets(buffer, sizeof(buffer), pipe))
+            output.append(buffer);
+
+        // failed command (e.g., not found)
+        if (pclose(pipe) != 0)
+            return "";
+
+        return output;
+    }
+
+    std::vector<std::string> included_units(const std::string& aux) {
+        // each unit has its own `.aux` file input from the main one
+        const std::string input{"\\@input{"};
+        std::vector<std::string> units;
+        std::istringstream iss{aux};
+        for (std::string line; getline(iss, line); ) {
+            if (line.rfind(input, 0) != 0)
+                continue;
+            size_t end = line.rfind(".aux}");
+            if (end != std::string::npos && end >= input.size())
+                units.push_back(line.substr(input.size(), end - input.size()));
+        }
+        return units;
+    }
+}
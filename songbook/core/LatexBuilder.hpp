@@ -0,0 +1,186 @@
+#ifndef SONGBOOK_LATEXBUILDER_HPP
+#define SONGBOOK_LATEXBUILDER_HPP
+
+#include "ConversionStats.hpp"
+#include "SongbookPrinterLatex.hpp"
+
+#include <string>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * Produces a PDF from a songbook LaTeX file by running XeLaTeX.
+     * 
+     * The static part of the preamble (see 
+     * `SongbookPrinterLatex::print_format_preamble()`) is precompiled into
+     * a format file using the *mylatexformat* package so that XeLaTeX does 
+     * not have to process it on every run. The format is cached in the 
+     * working directory under a name derived from the hash of the preamble 
+     * and of the XeTeX version, so it is rebuilt automatically whenever 
+     * either of them changes. When the format cannot be built, XeLaTeX runs 
+     * without it.
+     * 
+     * XeLaTeX can run in another working directory and its output can be
+     * saved to a log file, so that several builders can run in parallel
+     * (see `LatexJobRunner`).
+     * 
+     * A document split into `\include` units can be built partially: only
+     * units which differ from the last full build are compiled (see 
+     * `run_units()`).
+     * 
+     * @code
+     * LatexBuilder builder{"sb.tex"};
+     * builder.run(2);
+     * @endcode
+     */
+    class LatexBuilder {
+
+        public:
+        /**
+         * Constructor.
+         * 
+         * @param latex_file LaTeX file to compile
+         */
+        explicit LatexBuilder(std::string latex_file);
+
+        /**
+         * Enables/disables using the precompiled preamble format.
+         * 
+         * @param use Should the format be used?
+         */
+        void set_use_format(bool use);
+
+        /**
+         * Sets statistics to which times of the format preparation and of
+         * each XeLaTeX pass are added.
+         * 
+         * @param target statistics (not owned); `nullptr` disables collecting
+         */
+        void set_stats(ConversionStats* target);
+
+        /**
+         * Sets the directory in which XeLaTeX runs and where the format is
+         * cached. The LaTeX file name is relative to it.
+         * 
+         * @param dir working directory; empty for the current one
+         */
+        void set_working_directory(std::string dir);
+
+        /**
+         * Sets a file to which the commands run and their output are 
+         * appended instead of printing them to the console.
+         * 
+         * @param file log file; empty for the console
+         */
+        void set_log_file(std::string file);
+
+        /**
+         * Builds the preamble format unless it is already cached. 
+         * 
+         * @return format name or empty string when the format is disabled 
+         * or could not be built
+         */
+        std::string prepare_format();
+
+        /**
+         * Runs XeLaTeX (with the preamble format when available).
+         * 
+         * @param n_runs number of XeLaTeX runs
+         * @return `true` when all runs were successful, `false` otherwise
+         */
+        bool run(int n_runs = 1);
+
+        /**
+         * Writes a document split into units (see 
+         * `SongbookPrinterLatex::print_document_units()`) to the LaTeX file
+         * and unit files and builds it. Only files whose content changed
+         * are rewritten.
+         * 
+         * Hashes of the main document and of the units are saved after
+         * each successful full build (`<name>.units`, `sb.units` for 
+         * `sb.tex`). Units which differ from the last full build are
+         * compiled by a single XeLaTeX run using `\includeonly` into 
+         * `<name>.proof.pdf` (`sb.proof.pdf` for `sb.tex`), so that
+         * partial builds in a row include all edits since the full build;
+         * page numbers and the table of contents are taken from the
+         * auxiliary files of the last full build, which are copied to
+         * `<name>.proof.aux`, `.toc` and `.out` before the run. Nothing is compiled when all units
+         * are the same as in the full build (its PDF is up to date). When
+         * the main document or the list of units changed, when page or 
+         * song numbers of a compiled unit changed (so that the following
+         * units would be numbered incorrectly) or when `n_runs` is more 
+         * than 1, the whole document is built by `run()`.
+         * 
+         * @param document main document and units
+         * @param n_runs number of XeLaTeX runs of a full build
+         * @return `true` when all runs were successful, `false` otherwise
+         * @throws std::runtime_error a LaTeX file cannot be written
+         */
+        bool run_units(const LatexUnits& document, int n_runs = 1);
+
+        private:
+        /**
+         * Runs XeLaTeX on a file.
+         * 
+         * @param file LaTeX file relative to the working directory
+         * @param n_runs number of XeLaTeX runs
+         * @return `true` when all runs were successful, `false` otherwise
+         */
+        bool run_file(const std::string& file, int n_runs);
+
+        /**
+         * Runs a command in the working directory, with its output
+         * redirected to the log file when it is set.
+         * 
+         * @param command command to run
+         * @return `true` when the command succeeded
+         */
+        bool run_command(const std::string& command) const;
+
+        /**
+         * Returns a path in the working directory.
+         * 
+         * @param file file name relative to the working directory
+         * @return path relative to the current directory
+         */
+        std::string working_path(const std::string& file) const;
+
+        std::string latex_file;   ///< LaTeX file to compile
+        bool use_format = true;   ///< should the preamble format be used?
+        ConversionStats* stats{nullptr};  ///< collected statistics
+        std::string working_directory;    ///< see `set_working_directory()`
+        std::string log_file;             ///< see `set_log_file()`
+    };
+
+
+    /**
+     * Creates the name of a preamble format file (without the `.fmt` 
+     * extension) based on the preamble content and the TeX engine version.
+     * 
+     * @param preamble static LaTeX preamble
+     * @param engine_version TeX engine version string
+     * @return format name
+     */
+    std::string latex_format_name(const std::string& preamble, 
+        const std::string& engine_version);
+
+    /**
+     * Runs a command and captures its standard output.
+     * 
+     * @param command command to run
+     * @return standard output of the command; empty when it could not be run
+     */
+    std::string read_command_output(const std::string& command);
+
+    /**
+     * Reads names of `\include` units from the main `.aux` file of a LaTeX
+     * document.
+     * 
+     * @param aux content of the `.aux` file
+     * @return unit names in the order of including
+     */
+    std::vector<std::string> included_units(const std::string& aux);
+}
+
+#endif  // SONGBOOK_LATEXBUILDER_HPP
@@ -0,0 +1,149 @@
+#include "LatexJobRunner.hpp"
+#include "LatexBuilder.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace songbook {
+
+    LatexJobRunner::LatexJobRunner(std::string output_dir):
+        output_dir(std::move(output_dir)) {}
+
+    void LatexJobRunner::set_job_limit(unsigned n) {
+        job_limit = n;
+    }
+
+    void LatexJobRunner::set_passes(int n) {
+        passes = n;
+    }
+
+    void LatexJobRunner::set_use_format(bool use) {
+        use_format = use;
+    }
+
+    void LatexJobRunner::set_stats(ConversionStats* target) {
+        stats = target;
+    }
+
+    void LatexJobRunner::add_job(std::string name, std::string latex) {
+        jobs.push_back(Job{std::move(name), std::move(latex)});
+    }
+
+    bool LatexJobRunner::run() {
+        namespace fs = std::filesystem;
+        results.clear();
+
+        // LaTeX files are written before any XeLaTeX runs
+        PhaseTimer write_timer{stats, "write jobs"};
+        for (const Job& job: jobs) {
+            fs::path dir = fs::path{output_dir} / job.name;
+            std::error_code error;
+            fs::create_directories(dir, error);
+            if (error)
+                throw std::runtime_error("Directory " + dir.string() + " cannot be created");
+
+            std::ofstream ofs{dir / (job.name + ".tex")};
+            ofs << job.latex;
+            if (!ofs)
+                throw std::runtime_error("LaTeX file for job " + job.name + " cannot be written");
+        }
+        write_timer.stop();
+
+        // one format shared by all jobs
+        PhaseTimer format_timer{stats, "xelatex format"};
+        std::string format;
+        if (use_format && !jobs.empty()) {
+            LatexBuilder builder{""};
+            builder.set_working_directory(output_dir);
+            format = builder.prepare_format();
+        }
+        format_timer.stop();
+
+        PhaseTimer jobs_timer{stats, "xelatex jobs"};
+        unsigned n_threads = job_limit > 0 ? job_limit : std::thread::hardware_concurrency();
+        n_threads = std::max(1u, std::min(n_threads, static_cast<unsigned>(jobs.size())));
+
+        // threads take jobs in the order of adding
+        results.resize(jobs.size());
+        std::atomic<size_t> next{0};
+        auto worker = [&]() {
+            for (size_t i = next++; i < jobs.size(); i = next++)
+                results[i] = build(jobs[i], format);
+        };
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < n_threads; ++i)
+            threads.emplace_back(worker);
+        for (std::thread& thread: threads)
+            thread.join();
+        jobs_timer.stop();
+
+        size_t failed = std::count_if(begin(results), end(results),
+            [](const LatexJobResult& result){ return !result.success; });
+        if (stats) {
+            stats->add("xelatex jobs", results.size());
+            stats->add("xelatex jobs failed", failed);
+        }
+
+        return failed == 0;
+    }
+
+    const std::vector<LatexJobResult>& LatexJobRunner::get_results() const {
+        return results;
+    }
+
+    std::string LatexJobRunner::summary() const {
+        std::ostringstream oss;
+        size_t failed{0};
+        for (const LatexJobResult& result: results) {
+            if (result.success)
+                continue;
+            ++failed;
+            oss << "Failed: " << result.name << " (see " << result.log_file << ")\n";
+        }
+        oss << results.size() - failed << " PDF(s) built in " << output_dir << ", " <<
+            failed << " failed\n";
+
+        return oss.str();
+    }
+
+    LatexJobResult LatexJobRunner::build(const Job& job, const std::string& format) const {
+        namespace fs = std::filesystem;
+        auto start = std::chrono::steady_clock::now();
+
+        fs::path dir = fs::path{output_dir} / job.name;
+        fs::path log = dir / "xelatex.log";
+        fs::path pdf = fs::path{output_dir} / (job.name + ".pdf");
+        LatexJobResult result{job.name, false, 0, pdf.string(), log.string()};
+
+        // logs and PDFs are kept for the last run only
+        std::error_code error;
+        fs::remove(log, error);
+        fs::remove(pdf, error);
+
+        // the format is linked rather than copied when possible
+        bool job_format = !format.empty();
+        if (job_format && !fs::exists(dir / (format + ".fmt"))) {
+            fs::path shared = fs::path{output_dir} / (format + ".fmt");
+            fs::create_hard_link(shared, dir / (format + ".fmt"), error);
+            if (error)
+                job_format = fs::copy_file(shared, dir / (format + ".fmt"), error);
+        }
+
+        LatexBuilder builder{job.name + ".tex"};
+        builder.set_working_directory(dir.string());
+        builder.set_log_file(log.string());
+        builder.set_use_format(job_format);
+        result.success = builder.run(passes) &&
+            fs::copy_file(dir / (job.name + ".pdf"), pdf, fs::copy_options::overwrite_existing, error);
+
+        result.seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef SONGBOOK_LATEXJOBRUNNER_HPP
+#define SONGBOOK_LATEXJOBRUNNER_HPP
+
+#include "ConversionStats.hpp"
+
+#include <string>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * Result of one job run by `LatexJobRunner`.
+     */
+    struct LatexJobResult {
+        std::string name;      /**< job name */
+        bool success;          /**< did all XeLaTeX passes succeed? */
+        double seconds;        /**< wall time of the job */
+        std::string pdf_file;  /**< produced PDF (valid only on success) */
+        std::string log_file;  /**< output of the XeLaTeX passes */
+    };
+
+    /**
+     * Builds PDFs from several LaTeX documents (e.g. volumes of a songbook
+     * or single songs) by XeLaTeX processes running in parallel.
+     *
+     * Each job runs in its own directory `<output_dir>/<name>/`, which
+     * contains its LaTeX file, auxiliary files and the log of all XeLaTeX
+     * passes (`xelatex.log`); the resulting PDF is copied to
+     * `<output_dir>/<name>.pdf`. The preamble format (see `LatexBuilder`) is
+     * built once in `output_dir` and linked into the job directories.
+     *
+     * @code
+     * LatexJobRunner runner{"sb.split"};
+     * runner.set_job_limit(8);
+     * runner.add_job("vol1", latex1);
+     * runner.add_job("vol2", latex2);
+     * bool ok = runner.run();
+     * @endcode
+     */
+    class LatexJobRunner {
+
+        public:
+        /**
+         * Constructor.
+         *
+         * @param output_dir directory for job directories and PDFs (created
+         * when it does not exist)
+         */
+        explicit LatexJobRunner(std::string output_dir);
+
+        /**
+         * Sets the maximal number of XeLaTeX processes running at once.
+         *
+         * @param n number of jobs; 0 for the number of hardware threads
+         */
+        void set_job_limit(unsigned n);
+
+        /**
+         * Sets the number of XeLaTeX passes of each job.
+         *
+         * @param n number of passes
+         */
+        void set_passes(int n);
+
+        /** @copydoc LatexBuilder::set_use_format() */
+        void set_use_format(bool use);
+
+        /**
+         * Sets statistics to which the time of building all PDFs is added.
+         *
+         * @param target statistics (not owned); `nullptr` disables collecting
+         */
+        void set_stats(ConversionStats* target);
+
+        /**
+         * Adds a job.
+         *
+         * @param name job name (used for its directory and PDF); must be
+         * unique and usable as a file name
+         * @param latex LaTeX document to build
+         */
+        void add_job(std::string name, std::string latex);
+
+        /**
+         * Writes LaTeX files of all jobs and builds them.
+         *
+         * @return `true` when all jobs succeeded
+         * @throws std::runtime_error a directory or a LaTeX file cannot be
+         * created
+         */
+        bool run();
+
+        /**
+         * Returns results of jobs of the last `run()`.
+         *
+         * @return results in the order of adding jobs
+         */
+        const std::vector<LatexJobResult>& get_results() const;
+
+        /**
+         * Returns a summary of the last `run()`: one line per failed job
+         * (with its log file) and the numbers of succeeded and failed jobs.
+         *
+         * @return summary text
+         */
+        std::string summary() const;
+
+        private:
+        /**
+         * A document waiting for building.
+         */
+        struct Job {
+            std::string name;   ///< job name
+            std::string latex;  ///< LaTeX document
+        };
+
+        /**
+         * Builds one job in its directory.
+         *
+         * @param job job to build
+         * @param format name of the preamble format in `output_dir` (empty
+         * when not used)
+         * @return result of the job
+         */
+        LatexJobResult build(const Job& job, const std::string& format) const;
+
+        std::string output_dir;             ///< see the constructor
+        unsigned job_limit{0};              ///< see `set_job_limit()`
+        int passes{1};                      ///< see `set_passes()`
+        bool use_format{true};              ///< see `set_use_format()`
+        ConversionStats* stats{nullptr};    ///< collected statistics
+        std::vector<Job> jobs;              ///< jobs to run
+        std::vector<LatexJobResult> results;  ///< see `get_results()`
+    };
+}
+
+#endif  // SONGBOOK_LATEXJOBRUNNER_HPP
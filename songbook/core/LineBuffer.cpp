@@ -0,0 +1,34 @@
+#include "LineBuffer.hpp"
+
+namespace songbook {
+
+    void LineBuffer::clear() {
+        entries.clear();
+        line_items.clear();
+        text.clear();
+    }
+
+    void LineBuffer::add_view(LineItemType type, std::string_view value) {
+        entries.push_back(Entry{type, value.data(), 0, value.size()});
+    }
+
+    void LineBuffer::add(LineItemType type, std::string_view value) {
+        entries.push_back(Entry{type, nullptr, text.size(), value.size()});
+        text.append(value);
+    }
+
+    std::string& LineBuffer::scratch() {
+        scratch_text.clear();
+        return scratch_text;
+    }
+
+    const std::vector<LineItem>& LineBuffer::items() {
+        line_items.clear();
+        for (const Entry& entry: entries) {
+            line_items.emplace_back(entry.type, entry.data ?
+                std::string_view{entry.data, entry.size} :
+                std::string_view{text}.substr(entry.offset, entry.size));
+        }
+        return line_items;
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef SONGBOOK_LINEBUFFER_HPP
+#define SONGBOOK_LINEBUFFER_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "songbookTypes.hpp"
+
+namespace songbook {
+
+    /**
+     * Collects items of one song line before they are printed.
+     *
+     * Items either refer to text which outlives the line (e.g. lyrics in
+     * `SongData`) or to a copy kept in the buffer (transcoded or printed
+     * text). The buffer is meant to be reused for all lines of a song:
+     * `clear()` keeps the allocated memory, so once the buffer has grown
+     * to the longest line no more allocations are made.
+     *
+     * @code
+     * LineBuffer line;
+     * for (...) {
+     *     line.clear();
+     *     line.add_view(LineItemType::lyrics, lyrics);
+     *     std::string& chord = line.scratch();
+     *     printer.append_chord(chord_attrs, chord);
+     *     line.add(LineItemType::chord, chord);
+     *     printer.append_line(line.items(), output);
+     * }
+     * @endcode
+     */
+    class LineBuffer {
+
+        public:
+        /**
+         * Removes all items, keeps allocated memory.
+         */
+        void clear();
+
+        /**
+         * Adds an item referring to text outside of the buffer.
+         *
+         * @param type item type
+         * @param value item text; must stay valid until the line is printed
+         */
+        void add_view(LineItemType type, std::string_view value);
+
+        /**
+         * Adds an item with a copy of the text.
+         *
+         * @param type item type
+         * @param value item text (can be `scratch()`)
+         */
+        void add(LineItemType type, std::string_view value);
+
+        /**
+         * Returns an empty string for preparing item text, whose memory is
+         * reused by later calls.
+         *
+         * @return empty scratch string
+         */
+        std::string& scratch();
+
+        /**
+         * Returns items added since the last `clear()`. The item values
+         * are valid until the next change of the buffer.
+         *
+         * @return line items
+         */
+        const std::vector<LineItem>& items();
+
+        private:
+        /**
+         * An added item; copied text is referred to by its offset in `text`,
+         * which can be reallocated while the line is being built.
+         */
+        struct Entry {
+            LineItemType type;      ///< item type
+            const char* data;       ///< text outside of the buffer, `nullptr` for copied text
+            size_t offset;          ///< offset of copied text in `text`
+            size_t size;            ///< text size
+        };
+
+        std::vector<Entry> entries;        ///< items in the order of addition
+        std::vector<LineItem> line_items;  ///< items returned by `items()`
+        std::string text;                  ///< copied item text
+        std::string scratch_text;          ///< see `scratch()`
+    };
+}
+
+#endif  // SONGBOOK_LINEBUFFER_HPP
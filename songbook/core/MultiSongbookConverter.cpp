@@ -0,0 +1,624 @@
+#include "MultiSongbookConverter.hpp"
+#include "SongbookException.hpp"
+#include "contentHash.hpp"
+#include "trustedXml.hpp"
+#include "schemaValidator.hpp"
+#include "LineBuffer.hpp"
+#include "xmlCursor.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+
+namespace songbook {
+
+    void MultiSongbookConverter::add_printer(std::unique_ptr<SongbookPrinter> printer,
+        std::ostream& output, int semitones) {
+
+        if (parsed)
+            throw std::logic_error("printers must be added before parsing");
+
+        sinks.push_back(PrinterSink{std::move(printer), &output, {}, semitones});
+    }
+
+    TagValueMap MultiSongbookConverter::expand_printer_entities(const SongbookPrinter& target) {
+        TagValueMap entities = target.get_entities();
+        if (entities.empty())
+            return entities;
+
+        // an `<entities>` element referencing each entity in its value
+        std::string xml{"<entities>"};
+        for (const auto& [name, value]: entities)
+            xml.append("<entity><name>" + name + "</name><value>&" + name + ";</value></entity>");
+        xml.append("</entities>");
+
+        std::string root{"entities"};
+        insert_dtd(xml, generate_dtd(entities, root), root);
+        parser->parse_string(std::move(xml));
+
+        return read_entities();
+    }
+
+    void MultiSongbookConverter::set_trusted(bool enabled) {
+        trusted = enabled;
+    }
+
+    void MultiSongbookConverter::set_generated_validation(bool enabled) {
+        generated_validation = enabled;
+    }
+
+    bool MultiSongbookConverter::uses_trusted_reader() const {
+        return trusted || generated_validation;
+    }
+
+    void MultiSongbookConverter::parse_songbook(const std::string& filename) {
+        if (sinks.empty())
+            throw std::logic_error("no printer added before parsing");
+
+        // entity values as each of the printers would have them after parsing
+        //   and markers for all entity names
+        PhaseTimer entities_timer{stats, "entities"};
+        TagValueMap markers;
+        for (PrinterSink& sink: sinks) {
+            sink.entities = uses_trusted_reader() ? expand_entity_values(sink.printer->get_entities()) :
+                expand_printer_entities(*sink.printer);
+            for (const auto& entity: sink.entities)
+                markers[entity.first] = entity_marker_start + entity.first + entity_marker_end;
+        }
+
+        entities_timer.stop();
+
+        std::string xml = load_songbook(filename);
+
+        // user-defined entities -- may contain markers of printer entities
+        PhaseTimer user_entities_timer{stats, "entities"};
+        ExtractedEntities entities = extract_entities_element(xml);
+        std::string root;
+
+        if (!entities.xml.empty() && uses_trusted_reader()) {
+            for (auto& [name, value]: read_trusted_entities(entities.xml, markers, entities.offset))
+                markers[name] = std::move(value);
+        } else if (!entities.xml.empty()) {
+            root = "entities";
+            insert_dtd(entities.xml, generate_dtd(markers, root), root);
+            parser->parse_string(std::move(entities.xml), entities.offset);
+
+            for (auto& [name, value]: read_entities())
+                markers[name] = std::move(value);
+        }
+        user_entities_timer.stop();
+
+        if (generated_validation) {
+            PhaseTimer validate_timer{stats, "validate"};
+            validate_xml(xml, markers);
+        }
+
+        // parse the songbook leaving printer entities as markers
+        PhaseTimer parse_timer{stats, "parse"};
+        if (uses_trusted_reader()) {
+            // unchanged songs are not read again when songs are cached
+            TrustedSongCache* cache = nullptr;
+            if (song_cache) {
+                std::uint64_t entities_hash = content_hash("");
+                for (const auto& [name, value]: markers)
+                    entities_hash = content_hash(name + '\t' + value + '\n', entities_hash);
+                if (entities_hash != read_cache_entities)
+                    read_cache.clear();
+                read_cache_entities = entities_hash;
+                cache = &read_cache;
+            }
+
+            // with a memory budget, songs are read one by one when converting
+            if (memory_budget > 0) {
+                streamed_xml = std::move(xml);
+                streamed_entities = std::move(markers);
+                trusted_data = SongbookData{};
+            } else {
+                trusted_data = read_trusted_songbook(xml, markers, cache);
+                streamed_xml.clear();
+            }
+            parsed = true;
+            return;
+        }
+        root = "songbook";
+        insert_dtd(xml, generate_dtd(markers, root), root);
+        parser->parse_string(std::move(xml));
+
+        parsed = true;
+    }
+
+    void MultiSongbookConverter::add_songs(std::vector<SongData> songs) {
+        added_songs.insert(end(added_songs), std::make_move_iterator(begin(songs)),
+            std::make_move_iterator(end(songs)));
+    }
+
+    void MultiSongbookConverter::clear_added_songs() {
+        added_songs.clear();
+    }
+
+    std::uint64_t MultiSongbookConverter::apply_settings(
+        const std::vector<std::pair<std::string, std::string>>& settings) {
+
+        // everything affecting all songs is a part of the songs' cache keys
+        std::uint64_t seed = content_hash("");
+        for (const auto& [name, value]: settings) {
+            seed = content_hash(name + '\t' + value + '\n', seed);
+            if (process_setting(name, value)) {
+                for (PrinterSink& sink: sinks)
+                    sink.printer->set_parameter(name, expand_entity_markers(value, sink.entities));
+            }
+        }
+        return content_hash(std::to_string(transposition) + '\t' +
+            std::to_string(static_cast<int>(sort_songs_by)), seed);
+    }
+
+    std::vector<const SongData*> MultiSongbookConverter::prepare_songs(SongbookData& xml_data,
+        std::vector<std::uint64_t>& keys) {
+
+        PhaseTimer model_timer{stats, "read model"};
+        std::uint64_t transcoded_start = transcoded_bytes();
+        if (parsed && !uses_trusted_reader())
+            xml_data = read_songbook();
+        else if (parsed && !streamed_xml.empty())   // kept for a memory budget
+            trusted_data = read_trusted_songbook(streamed_xml, streamed_entities);
+        const SongbookData& data = uses_trusted_reader() ? trusted_data : xml_data;
+        model_timer.stop();
+
+        std::uint64_t seed = apply_settings(data.settings);
+
+        // songs to be converted
+        std::vector<const SongData*> songs;
+        keys.clear();
+        size_t all_songs = data.songs.size() + added_songs.size();
+        for (size_t i = 0; i < all_songs; ++i) {
+            // songs added from other sources follow the XML ones
+            const SongData& song = i < data.songs.size() ? 
+                data.songs[i] : added_songs[i - data.songs.size()];
+            auto search = song.header.find("dateAdded");  // must be present
+            if (search->second >= convert_added_since) {
+                songs.push_back(&song);
+                keys.push_back(song_cache ? song_hash(song, seed) : 0);
+            }
+        }
+
+        if (stats) {
+            stats->add("songs", songs.size());
+            stats->add("songs skipped", all_songs - songs.size());
+            stats->add("bytes transcoded", transcoded_bytes() - transcoded_start);
+            std::uint64_t lines{0}, chords{0};
+            for (const SongData* song: songs) {
+                for (const SongEvent& event: song->events) {
+                    if (event.type != SongEventType::line)
+                        continue;
+                    ++lines;
+                    chords += std::count_if(begin(event.line), end(event.line),
+                        [](const LineElement& elem){ return elem.type == LineItemType::chord; });
+                }
+            }
+            stats->add("lines", lines);
+            stats->add("chords", chords);
+        }
+
+        return songs;
+    }
+
+    void MultiSongbookConverter::convert(bool parallel) {
+        if (memory_budget > 0) {
+            convert_within_budget();
+            return;
+        }
+
+        SongbookData xml_data;
+        std::vector<std::uint64_t> keys;
+        std::vector<const SongData*> songs = prepare_songs(xml_data, keys);
+
+        // all printers have the same songs cached
+        changed_songs.clear();
+        for (size_t i = 0; i < songs.size(); ++i) {
+            if (!song_cache || sinks.front().cache.count(keys[i]) == 0)
+                changed_songs.push_back(i);
+        }
+
+        // progress over songs of all printers
+        std::mutex progress_mutex;
+        size_t done{0};
+        size_t total = songs.size() * sinks.size();
+        auto song_printed = [&]() {
+            if (!progress_handler)
+                return;
+            std::lock_guard<std::mutex> lock{progress_mutex};
+            if (!progress_handler(++done, total))
+                throw ConversionCancelled();
+        };
+
+        std::vector<std::string> outputs(sinks.size());
+        auto print = [&](size_t i) {
+            outputs[i] = print_songbook(sinks[i], songs, keys, song_printed);
+        };
+        PhaseTimer convert_timer{stats, "convert"};
+
+        if (parallel && sinks.size() > 1) {
+            std::vector<std::exception_ptr> errors(sinks.size());
+            std::vector<std::thread> threads;
+            for (size_t i = 0; i < sinks.size(); ++i) {
+                threads.emplace_back([&, i]() {
+                    try {
+                        print(i);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+                });
+            }
+            for (std::thread& thread: threads)
+                thread.join();
+            for (std::exception_ptr& error: errors) {
+                if (error)
+                    std::rethrow_exception(error);
+            }
+        } else {
+            for (size_t i = 0; i < sinks.size(); ++i)
+                print(i);
+        }
+
+        convert_timer.stop();
+
+        // write outputs from this thread -- sinks may share a stream
+        PhaseTimer write_timer{stats, "write"};
+        for (size_t i = 0; i < sinks.size(); ++i)
+            *sinks[i].output << outputs[i];
+    }
+
+    void MultiSongbookConverter::convert_within_budget() {
+        // printed songs are sorted into temporary files and merged into the
+        //   outputs when they are written
+        std::vector<std::unique_ptr<ExternalSongSorter>> sorters;
+        for (const PrinterSink& sink: sinks) {
+            if (!sink.printer->prints_songs_separately())
+                throw std::logic_error("a memory budget cannot be used with a printer "
+                    "which lays out the whole document (e.g. PDF)");
+            sorters.push_back(std::make_unique<ExternalSongSorter>(
+                memory_budget / sinks.size(), sort_songs_by != SortSongsBy::none));
+        }
+
+        // the model is never read as a whole -- each song is printed by all
+        //   printers as soon as it is read and then dropped
+        ConversionTrace* trace = stats ? stats->get_trace() : nullptr;
+        std::uint64_t transcoded_start = transcoded_bytes();
+        std::uint64_t skipped{0}, lines{0}, chords{0};
+        size_t total = progress_handler ? count_xml_songs() + added_songs.size() : 0;
+        changed_songs.clear();
+
+        auto convert_song = [&](const SongData& song) {
+            if (song.header.find("dateAdded")->second < convert_added_since) {  // must be present
+                ++skipped;
+                return;
+            }
+
+            TraceSpan span{trace, "song", trace ? song.header.find("name")->second : ""};
+            for (size_t i = 0; i < sinks.size(); ++i)
+                sorters[i]->add(print_song(sinks[i], song));
+            changed_songs.push_back(changed_songs.size());
+
+            if (stats) {
+                for (const SongEvent& event: song.events) {
+                    if (event.type != SongEventType::line)
+                        continue;
+                    ++lines;
+                    chords += std::count_if(begin(event.line), end(event.line),
+                        [](const LineElement& elem){ return elem.type == LineItemType::chord; });
+                }
+            }
+            if (progress_handler && !progress_handler(changed_songs.size() + skipped, total))
+                throw ConversionCancelled();
+        };
+        auto settings_read = [this](std::vector<std::pair<std::string, std::string>> settings) {
+            apply_settings(settings);
+        };
+
+        PhaseTimer convert_timer{stats, "convert"};
+        if (parsed && uses_trusted_reader() && streamed_xml.empty()) {
+            // read before the budget was set
+            settings_read(trusted_data.settings);
+            for (const SongData& song: trusted_data.songs)
+                convert_song(song);
+        } else if (parsed && uses_trusted_reader())
+            stream_trusted_songbook(streamed_xml, streamed_entities, settings_read,
+                [&](SongData song){ convert_song(song); });
+        else if (parsed)
+            read_songbook(settings_read, [&](SongData song){ convert_song(song); });
+        else
+            apply_settings({});
+        for (const SongData& song: added_songs)
+            convert_song(song);
+        convert_timer.stop();
+
+        if (stats) {
+            stats->add("songs", changed_songs.size());
+            stats->add("songs skipped", skipped);
+            stats->add("bytes transcoded", transcoded_bytes() - transcoded_start);
+            stats->add("lines", lines);
+            stats->add("chords", chords);
+        }
+
+        // write outputs from this thread -- sinks may share a stream
+        PhaseTimer write_timer{stats, "write"};
+        for (size_t i = 0; i < sinks.size(); ++i) {
+            const SongbookPrinter& printer = *sinks[i].printer;
+            *sinks[i].output << printer.print_document_start();
+            sorters[i]->write(*sinks[i].output);
+            *sinks[i].output << printer.print_document_end();
+            if (stats) {
+                stats->add("sort runs", sorters[i]->get_run_count());
+                stats->add("bytes spilled", sorters[i]->get_spilled_bytes());
+            }
+        }
+    }
+
+    size_t MultiSongbookConverter::count_xml_songs() const {
+        if (!parsed)
+            return 0;
+
+        if (uses_trusted_reader()) {
+            // start tags `<song>` (not `<songs>`), possibly with attributes
+            size_t count{0};
+            for (size_t pos = streamed_xml.find("<song"); pos != std::string::npos;
+                pos = streamed_xml.find("<song", pos + 1)) {
+                char next = pos + 5 < streamed_xml.size() ? streamed_xml[pos + 5] : '\0';
+                if (next == '>' || next == '/' || is_xml_space(next))
+                    ++count;
+            }
+            return count;
+        }
+
+        xercesc::DOMElement* elem = parser->getDocument()->getDocumentElement()
+            ->getFirstElementChild();
+        if (elem && get_node_name(elem) == "settings")
+            elem = elem->getNextElementSibling();
+        return elem ? elem->getChildElementCount() : 0;
+    }
+
+    std::vector<Song> MultiSongbookConverter::convert_songs(size_t printer_i) {
+        const PrinterSink& sink = sinks.at(printer_i);
+        SongbookData xml_data;
+        std::vector<std::uint64_t> keys;
+        std::vector<const SongData*> songs = prepare_songs(xml_data, keys);
+
+        PhaseTimer convert_timer{stats, "convert"};
+        ConversionTrace* trace = stats ? stats->get_trace() : nullptr;
+        std::vector<Song> printed;
+        printed.reserve(songs.size());
+        for (const SongData* song: songs) {
+            TraceSpan span{trace, "song", trace ? song->header.find("name")->second : ""};
+            printed.push_back(print_song(sink, *song));
+            if (progress_handler && !progress_handler(printed.size(), songs.size()))
+                throw ConversionCancelled();
+        }
+
+        if (sort_songs_by != SortSongsBy::none) {
+            TraceSpan span{trace, "sort"};
+            std::stable_sort(begin(printed), end(printed));
+        }
+
+        return printed;
+    }
+
+    void MultiSongbookConverter::set_memory_budget(size_t bytes) {
+        memory_budget = bytes;
+    }
+
+    void MultiSongbookConverter::set_song_cache(bool enabled) {
+        song_cache = enabled;
+        if (!enabled) {
+            for (PrinterSink& sink: sinks) {
+                sink.cache.clear();
+                sink.songs.clear();
+            }
+            read_cache.clear();
+        }
+    }
+
+    const std::vector<size_t>& MultiSongbookConverter::get_changed_songs() const {
+        return changed_songs;
+    }
+
+    const Song& MultiSongbookConverter::get_printed_song(size_t printer_i, size_t song_i) const {
+        return sinks.at(printer_i).songs.at(song_i);
+    }
+
+    std::string MultiSongbookConverter::print_songbook(PrinterSink& sink,
+        const std::vector<const SongData*>& songs, const std::vector<std::uint64_t>& keys,
+        const std::function<void()>& song_printed) const {
+
+        // spans of songs and sorting show the balance of the printing threads
+        ConversionTrace* trace = stats ? stats->get_trace() : nullptr;
+
+        std::vector<Song> printed;
+        std::unordered_map<std::uint64_t, Song> cache;
+        printed.reserve(songs.size());
+        for (size_t i = 0; i < songs.size(); ++i) {
+            TraceSpan span{trace, "song", trace ? songs[i]->header.find("name")->second : ""};
+            auto search = song_cache ? sink.cache.find(keys[i]) : sink.cache.end();
+            if (search != sink.cache.end())
+                printed.push_back(search->second);
+            else
+                printed.push_back(print_song(sink, *songs[i]));
+
+            if (song_cache)
+                cache.emplace(keys[i], printed.back());
+            song_printed();
+        }
+
+        // songs no longer present are dropped
+        if (song_cache) {
+            sink.cache = std::move(cache);
+            sink.songs = printed;
+        }
+
+        if (sort_songs_by != SortSongsBy::none) {
+            TraceSpan span{trace, "sort"};
+            // songs with equal names keep their order (as with a memory budget)
+            std::stable_sort(begin(printed), end(printed));
+        }
+
+        TraceSpan span{trace, "document"};
+        return sink.printer->print_document(printed);
+    }
+
+    Song MultiSongbookConverter::print_song(const PrinterSink& sink, const SongData& song) const {
+        const SongbookPrinter& printer = *sink.printer;
+
+        Transposition song_transp;
+        int semitones = transposition + sink.semitones + song.transpose;
+        if (semitones % 12 != 0) {
+            std::vector<TagValueMap> chords;
+            for (const SongEvent& event: song.events) {
+                for (const LineElement& elem: event.line) {
+                    if (elem.type == LineItemType::chord)
+                        chords.push_back(elem.chord);
+                }
+            }
+            song_transp = song_transposition(semitones, chords);
+        }
+
+        std::string content;
+        LineBuffer line;
+        TagValueMap chord;  // reused for all chords, see below
+        for (const SongEvent& event: song.events) {
+            switch (event.type) {
+                case SongEventType::multicols_start:
+                    content.append(printer.print_multicols_start(event.number));
+                    break;
+                case SongEventType::columnbreak:
+                    content.append(printer.print_columnbreak());
+                    break;
+                case SongEventType::multicols_end:
+                    content.append(printer.print_multicols_end());
+                    break;
+                case SongEventType::verse_start:
+                    content.append(printer.print_verse_start(event.verse_type));
+                    break;
+                case SongEventType::verse_end:
+                    content.append(printer.print_verse_end(event.verse_type));
+                    break;
+                case SongEventType::line: {
+                    // lyrics are printed directly from the song model unless
+                    //   they contain entities
+                    line.clear();
+                    for (const LineElement& elem: event.line) {
+                        if (elem.type == LineItemType::lyrics) {
+                            if (elem.lyrics.find(entity_marker_start) == std::string::npos) {
+                                line.add_view(LineItemType::lyrics, elem.lyrics);
+                            } else {
+                                std::string& lyrics = line.scratch();
+                                expand_entity_markers(elem.lyrics, sink.entities, lyrics);
+                                line.add(LineItemType::lyrics, lyrics);
+                            }
+                        } else {
+                            // assignment reuses the map's nodes
+                            chord = elem.chord;
+                            for (auto& attr: chord) {
+                                if (attr.second.find(entity_marker_start) != std::string::npos)
+                                    attr.second = expand_entity_markers(attr.second, sink.entities);
+                            }
+                            transpose_chord(chord, song_transp);
+                            std::string& printed = line.scratch();
+                            printer.append_chord(chord, printed);
+                            line.add(LineItemType::chord, printed);
+                        }
+                    }
+                    printer.append_line(line.items(), content);
+                    break;
+                }
+            }
+        }
+
+        TagValueMultiMap header{song.header};
+        for (auto& tag: header)
+            tag.second = expand_entity_markers(tag.second, sink.entities);
+
+        std::string sorting_name;
+        if (sort_songs_by == SortSongsBy::dateAdded)
+            sorting_name = header.find("dateAdded")->second;
+        else {
+            auto search = header.find("sortingName");
+            if (search != header.end())
+                sorting_name = search->second;
+        }
+
+        // name must be present
+        std::string name = header.find("name")->second;
+        std::string printed = printer.print_song(header, content);
+
+        return Song{
+            std::move(name),
+            std::move(sorting_name),
+            std::move(printed)};
+    }
+
+    //------  Nonmember functions ------
+
+    std::string expand_entity_markers(const std::string& text, const TagValueMap& entities) {
+        if (text.find(entity_marker_start) == std::string::npos)
+            return text;
+
+        std::string result;
+        expand_entity_markers(text, entities, result);
+        return result;
+    }
+
+    void expand_entity_markers(const std::string& text, const TagValueMap& entities, 
+        std::string& output) {
+
+        size_t start = text.find(entity_marker_start);
+        size_t pos = 0;
+        while (start != std::string::npos) {
+            size_t name_start = start + entity_marker_start.size();
+            size_t end = text.find(entity_marker_end, name_start);
+            if (end == std::string::npos)
+                break;
+
+            output.append(text, pos, start - pos);
+            auto search = entities.find(text.substr(name_start, end - name_start));
+            if (search != entities.end())
+                output.append(search->second);
+
+            pos = end + entity_marker_end.size();
+            start = text.find(entity_marker_start, pos);
+        }
+        output.append(text, pos, std::string::npos);
+    }
+
+    std::uint64_t song_hash(const SongData& song, std::uint64_t seed) {
+        // every field is terminated so that moving text between fields
+        //   changes the hash
+        auto add = [&seed](std::string_view field) {
+            seed = content_hash(field, seed);
+            seed = content_hash("\x1F", seed);
+        };
+
+        for (const auto& [tag, value]: song.header) {
+            add(tag);
+            add(value);
+        }
+        add(std::to_string(song.transpose));
+
+        for (const SongEvent& event: song.events) {
+            add(std::to_string(static_cast<int>(event.type)));
+            add(std::to_string(static_cast<int>(event.verse_type)));
+            add(event.number);
+            for (const LineElement& elem: event.line) {
+                add(elem.type == LineItemType::lyrics ? "l" : "c");
+                add(elem.lyrics);
+                for (const auto& [name, value]: elem.chord) {
+                    add(name);
+                    add(value);
+                }
+            }
+        }
+
+        return seed;
+    }
+}
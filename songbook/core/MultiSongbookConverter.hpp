@@ -0,0 +1,408 @@
+#ifndef SONGBOOK_MULTISONGBOOKCONVERTER_HPP
+#define SONGBOOK_MULTISONGBOOKCONVERTER_HPP
+
+#include "SongbookConverter.hpp"
+#include "SongbookPrinter.hpp"
+#include "ExternalSongSorter.hpp"
+#include "songModel.hpp"
+#include "Song.hpp"
+#include "trustedXml.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <ostream>
+
+namespace songbook {
+
+    /**
+     * Converts a XML songbook file into several formats at once.
+     *
+     * The XML is parsed and validated only once and read into a
+     * `SongbookData`, which is then printed by each of the printers into
+     * its own output stream. Printers can run in parallel. Each printer can
+     * have its own transposition, so one printer class can be added several
+     * times to produce the songbook in several keys.
+     *
+     * Because entity values differ between printers, entities are not
+     * expanded during parsing: each printer entity is replaced by a marker
+     * (`entity_marker_start`, entity name, `entity_marker_end`), which is
+     * replaced with the printer's value before printing. User-defined
+     * entities are expanded during parsing as usual.
+     *
+     * Trusted (already validated) XML can be read by a faster reader which
+     * does not use Xerces and does not validate (see `set_trusted()`). The
+     * same reader can also be preceded by the validator generated from the
+     * schema (see `set_generated_validation()`).
+     *
+     * Songs read from other sources (e.g. ChordPro files, see chordPro.hpp)
+     * can be added by `add_songs()`; they follow the songs of the XML, which
+     * can also be omitted altogether (no settings are used then).
+     *
+     * With the song cache enabled (see `set_song_cache()`), printed songs
+     * are kept between conversions and converting an edited songbook again
+     * prints only the songs which changed. The trusted reader then also
+     * reads only `<song>` elements whose content changed.
+     *
+     * With a memory budget (see `set_memory_budget()`), songs are read
+     * from the XML one at a time, printed, sorted by an external sort and
+     * written directly into the output streams, so very large songbooks
+     * can be converted without holding their whole model or output in
+     * memory.
+     *
+     * @code
+     * MultiSongbookConverter converter{};
+     * converter.add_printer<SongbookPrinterLatex>(latex_stream);
+     * converter.add_printer<SongbookPrinter>(text_stream);
+     * converter.parse_songbook("sb.xml");
+     * converter.convert();
+     * @endcode
+     */
+    class MultiSongbookConverter: public SongbookConverter {
+
+        public:
+        /**
+         * Adds a printer together with its output stream. Printers must be
+         * added before parsing.
+         *
+         * @param printer printer to add
+         * @param output stream the printer's output will be written to
+         * @param semitones transposition of the printer's output (added
+         * to the one set by `set_transposition()`)
+         * @throws std::logic_error a songbook has already been parsed
+         */
+        void add_printer(std::unique_ptr<SongbookPrinter> printer, std::ostream& output,
+            int semitones = 0);
+
+        /**
+         * Constructs and adds a printer together with its output stream.
+         *
+         * @tparam T printer class derived from `SongbookPrinter`
+         * @param output stream the printer's output will be written to
+         * @param semitones transposition of the printer's output
+         * @return the new printer (e.g. for setting its parameters)
+         * @throws std::logic_error a songbook has already been parsed
+         */
+        template <typename T> T& add_printer(std::ostream& output, int semitones = 0);
+
+        /**
+         * Selects the XML reader used by `parse_songbook()`.
+         *
+         * @param enabled read the XML by the non-validating reader from 
+         * trustedXml.hpp instead of Xerces?
+         */
+        void set_trusted(bool enabled);
+
+        /**
+         * Enables validation by the validator generated from the schema
+         * (schemaValidator.hpp) instead of Xerces. The XML is then read by
+         * the reader used for trusted XML.
+         *
+         * @param enabled validate by the generated validator?
+         */
+        void set_generated_validation(bool enabled);
+
+        /**
+         * Parses a songbook XML read from a file.
+         *
+         * @param filename path to the songbook XML file
+         * @throws std::runtime_error when the file can't be opened
+         * @throws std::logic_error no printer has been added
+         * @throws SongbookException a problem during XML parsing
+         */
+        void parse_songbook(const std::string& filename);
+
+        /**
+         * Adds songs converted after those of the XML songbook.
+         *
+         * @param songs songs to add (e.g. from `load_chordpro()`)
+         */
+        void add_songs(std::vector<SongData> songs);
+
+        /**
+         * Removes songs added by `add_songs()` (e.g. before adding them again
+         * from edited files).
+         */
+        void clear_added_songs();
+
+        /**
+         * Converts parsed XML (if any) and added songs using all printers and writes results into
+         * their output streams (in the order in which printers were added).
+         *
+         * @param parallel should printers run in parallel threads? (not
+         * with a memory budget, where each song is printed as soon as it is read)
+         * @throws ConversionCancelled the progress handler stopped the conversion
+         */
+        void convert(bool parallel = true);
+
+        /**
+         * Converts parsed XML (if any) and added songs using one printer,
+         * but returns printed songs instead of writing the document (e.g.
+         * to split the songbook into several documents). The song cache
+         * is not used.
+         *
+         * @param printer_i printer index (in the order of adding)
+         * @return printed songs in the order of the document
+         * @throws ConversionCancelled the progress handler stopped the conversion
+         */
+        std::vector<Song> convert_songs(size_t printer_i = 0);
+
+        /**
+         * Enables or disables keeping printed songs between conversions.
+         *
+         * A song is reprinted only when its content, the settings or the
+         * transposition changed; songs not present in the last conversion
+         * are dropped from the cache. With the trusted reader, songs read
+         * from the XML are cached as well (see `TrustedSongCache`).
+         *
+         * @param enabled should printed songs be cached?
+         */
+        void set_song_cache(bool enabled);
+
+        /**
+         * Limits the memory taken by songs. Songs are read into the model
+         * one at a time and printed by all printers right away; printed
+         * songs over the budget are sorted and spilled to temporary files,
+         * which are then merged into the output streams (see
+         * `ExternalSongSorter`). The budget is shared by all printers; the
+         * song cache is not used with it.
+         *
+         * The XML text itself is not a part of the budget, and neither is
+         * the document parsed by Xerces, which holds the whole songbook;
+         * only the trusted reader (`set_trusted()`,
+         * `set_generated_validation()`) avoids it. Set the budget before
+         * parsing so that the trusted reader does not read the whole model.
+         *
+         * @param bytes memory budget in bytes, 0 for no limit
+         */
+        void set_memory_budget(size_t bytes);
+
+        /**
+         * Returns songs which were printed (i.e. not taken from the cache)
+         * during the last `convert()`. With the cache enabled, these are
+         * the songs changed since the previous conversion.
+         *
+         * @return positions of the songs among converted songs (document order)
+         */
+        const std::vector<size_t>& get_changed_songs() const;
+
+        /**
+         * Returns a song as printed during the last `convert()`. Only
+         * available with the song cache enabled.
+         *
+         * @param printer_i printer index (in the order of adding)
+         * @param song_i song position among converted songs (document order)
+         * @return printed song
+         */
+        const Song& get_printed_song(size_t printer_i, size_t song_i) const;
+
+        private:
+        /**
+         * A printer and everything needed to produce its output.
+         */
+        struct PrinterSink {
+            std::unique_ptr<SongbookPrinter> printer;  ///< the printer
+            std::ostream* output;                      ///< output stream
+            TagValueMap entities;                      ///< expanded entity values
+            int semitones;                             ///< transposition
+            std::unordered_map<std::uint64_t, Song> cache{};  ///< printed songs by song key
+            std::vector<Song> songs{};                 ///< songs from the last conversion
+        };
+
+        /**
+         * Expands all entities of a printer by letting the parser read them.
+         *
+         * @param target printer whose entities are expanded
+         * @return entity name-value pairs
+         */
+        TagValueMap expand_printer_entities(const SongbookPrinter& target);
+
+        /**
+         * Is the XML read by the reader from trustedXml.hpp (with or
+         * without the generated validator)?
+         */
+        bool uses_trusted_reader() const;
+
+        /**
+         * Passes settings to the printers.
+         *
+         * @param settings setting name-value pairs in document order
+         * @return seed of the songs' cache keys (covering everything which
+         * affects all songs)
+         */
+        std::uint64_t apply_settings(
+            const std::vector<std::pair<std::string, std::string>>& settings);
+
+        /**
+         * Reads the songbook model, passes settings to the printers and
+         * selects songs to be converted.
+         *
+         * @param[out] xml_data storage for the model read by Xerces
+         * @param[out] keys cache keys of the selected songs
+         * @return songs to convert (those of the XML followed by added ones)
+         */
+        std::vector<const SongData*> prepare_songs(SongbookData& xml_data,
+            std::vector<std::uint64_t>& keys);
+
+        /**
+         * Prints the whole songbook using one printer.
+         *
+         * @param sink printer to use; its cache is updated when caching is enabled
+         * @param songs songs to print
+         * @param keys cache keys of `songs`
+         * @param song_printed called after each song
+         * @return converted songbook
+         */
+        std::string print_songbook(PrinterSink& sink, const std::vector<const SongData*>& songs,
+            const std::vector<std::uint64_t>& keys, const std::function<void()>& song_printed) const;
+
+        /**
+         * Prints one song using one printer.
+         *
+         * @param sink printer to use
+         * @param song song to print
+         * @return converted song
+         */
+        Song print_song(const PrinterSink& sink, const SongData& song) const;
+
+        /**
+         * Converts songs within the memory budget (`convert()` with a budget
+         * set): songs are read one by one, printed into external sorters
+         * and merged into the output streams.
+         *
+         * @throws std::logic_error a printer lays out the whole document
+         * @throws ConversionCancelled the progress handler stopped the conversion
+         */
+        void convert_within_budget();
+
+        /**
+         * Returns the number of songs in the parsed XML without reading
+         * them (for progress reporting).
+         *
+         * @return number of `<song>` elements
+         */
+        size_t count_xml_songs() const;
+
+        /**
+         * Printers and their outputs.
+         */
+        std::vector<PrinterSink> sinks;
+
+        /**
+         * Has a songbook been parsed?
+         */
+        bool parsed{false};
+
+        /**
+         * Is the XML read by the trusted reader?
+         */
+        bool trusted{false};
+
+        /**
+         * Is the XML validated by the generated validator?
+         */
+        bool generated_validation{false};
+
+        /**
+         * Songbook read by the trusted reader.
+         */
+        SongbookData trusted_data;
+
+        /**
+         * XML kept for the trusted reader to read songs one by one (with a
+         * memory budget).
+         */
+        std::string streamed_xml;
+
+        /**
+         * Entity values `streamed_xml` is read with.
+         */
+        TagValueMap streamed_entities;
+
+        /**
+         * Songs added by `add_songs()`.
+         */
+        std::vector<SongData> added_songs;
+
+        /**
+         * Are printed songs kept between conversions?
+         */
+        bool song_cache{false};
+
+        /**
+         * Songs read by the trusted reader (when the song cache is enabled).
+         */
+        TrustedSongCache read_cache;
+
+        /**
+         * Hash of entity values `read_cache` was read with.
+         */
+        std::uint64_t read_cache_entities{0};
+
+        /**
+         * Songs printed during the last conversion.
+         */
+        std::vector<size_t> changed_songs;
+
+        /**
+         * Memory budget for printed songs in bytes (0 for no limit).
+         */
+        size_t memory_budget{0};
+    };
+
+
+    /**
+     * Beginning of a marker standing for an unexpanded entity (U+E000).
+     */
+    inline const std::string entity_marker_start{"\xEE\x80\x80"};
+
+    /**
+     * End of a marker standing for an unexpanded entity (U+E001).
+     */
+    inline const std::string entity_marker_end{"\xEE\x80\x81"};
+
+    /**
+     * Replaces entity markers with entity values.
+     *
+     * @param text text possibly containing entity markers
+     * @param entities entity name-value pairs; markers of entities not
+     * present are removed
+     * @return text with expanded entities
+     */
+    std::string expand_entity_markers(const std::string& text, const TagValueMap& entities);
+
+    /**
+     * Appends text with entity markers replaced by entity values.
+     *
+     * @param text text possibly containing entity markers
+     * @param entities entity name-value pairs; markers of entities not
+     * present are removed
+     * @param output string to append the text with expanded entities to
+     */
+    void expand_entity_markers(const std::string& text, const TagValueMap& entities,
+        std::string& output);
+
+    /**
+     * Computes a hash of a song's content (header, transposition and events).
+     *
+     * @param song song to hash
+     * @param seed hash to continue from
+     * @return hash value
+     */
+    std::uint64_t song_hash(const SongData& song, std::uint64_t seed);
+
+
+    template <typename T>
+    T& MultiSongbookConverter::add_printer(std::ostream& output, int semitones) {
+        auto new_printer = std::make_unique<T>();
+        T& result = *new_printer;
+        add_printer(std::move(new_printer), output, semitones);
+
+        return result;
+    }
+}
+
+#endif  // SONGBOOK_MULTISONGBOOKCONVERTER_HPP
@@ -0,0 +1,93 @@
+#include "PdfWriter.hpp"
+#include "SongbookException.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace songbook {
+
+    int PdfWriter::reserve_object() {
+        offsets.push_back(0);
+        return static_cast<int>(offsets.size());
+    }
+
+    void PdfWriter::set_object(int id, const std::string& content) {
+        offsets[id - 1] = pdf.size();
+        pdf.append(std::to_string(id) + " 0 obj\n");
+        pdf.append(content);
+        pdf.append("\nendobj\n");
+    }
+
+    int PdfWriter::add_object(const std::string& content) {
+        int id = reserve_object();
+        set_object(id, content);
+        return id;
+    }
+
+    void PdfWriter::set_stream(int id, const std::string& dict_entries, 
+        const std::string& data) {
+
+        offsets[id - 1] = pdf.size();
+        pdf.append(std::to_string(id) + " 0 obj\n<< /Length " + 
+            std::to_string(data.size()) + " " + dict_entries + " >>\nstream\n");
+        pdf.append(data);
+        pdf.append("\nendstream\nendobj\n");
+    }
+
+    int PdfWriter::add_stream(const std::string& dict_entries, const std::string& data) {
+        int id = reserve_object();
+        set_stream(id, dict_entries, data);
+        return id;
+    }
+
+    std::string PdfWriter::finish(int catalog) {
+        std::size_t xref = pdf.size();
+        pdf.append("xref\n0 " + std::to_string(offsets.size() + 1) + "\n");
+        pdf.append("0000000000 65535 f \n");
+
+        char entry[21];
+        for (std::size_t i = 0; i < offsets.size(); ++i) {
+            if (offsets[i] == 0)
+                throw SongbookException("PDF object " + std::to_string(i + 1) + 
+                    " was reserved but not written");
+            std::snprintf(entry, sizeof(entry), "%010zu 00000 n \n", offsets[i]);
+            pdf.append(entry);
+        }
+
+        pdf.append("trailer\n<< /Size " + std::to_string(offsets.size() + 1) + 
+            " /Root " + std::to_string(catalog) + " 0 R >>\nstartxref\n" + 
+            std::to_string(xref) + "\n%%EOF\n");
+
+        return std::move(pdf);
+    }
+
+    std::string pdf_number(double x) {
+        // round to 2 decimal places and strip trailing zeros
+        long long hundredths = std::llround(x * 100);
+        std::string result = hundredths < 0 ? "-" : "";
+        hundredths = std::llabs(hundredths);
+        result.append(std::to_string(hundredths / 100));
+
+        int fraction = static_cast<int>(hundredths % 100);
+        if (fraction != 0) {
+            result += '.';
+            result += static_cast<char>('0' + fraction / 10);
+            if (fraction % 10 != 0)
+                result += static_cast<char>('0' + fraction % 10);
+        }
+
+        return result;
+    }
+
+    std::string pdf_literal(const std::string& str) {
+        std::string result{"("};
+        for (char c: str) {
+            if (c == '(' || c == ')' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        result += ')';
+
+        return result;
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef SONGBOOK_PDFWRITER_HPP
+#define SONGBOOK_PDFWRITER_HPP
+
+#include <string>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * Assembles a PDF file from individual objects.
+     * 
+     * Objects are identified by numbers which can be reserved before the 
+     * object content is known so that objects can refer to each other 
+     * regardless of the order in which they are written.
+     * 
+     * @code
+     * PdfWriter writer;
+     * int catalog = writer.reserve_object();
+     * ...
+     * writer.set_object(catalog, "<< /Type /Catalog /Pages 2 0 R >>");
+     * std::string pdf = writer.finish(catalog);
+     * @endcode
+     */
+    class PdfWriter {
+
+        public:
+        /**
+         * Reserves a number for an object which will be written later.
+         * 
+         * @return object number
+         */
+        int reserve_object();
+
+        /**
+         * Writes a previously reserved object.
+         * 
+         * @param id object number
+         * @param content object content (e.g., a dictionary)
+         */
+        void set_object(int id, const std::string& content);
+
+        /**
+         * Writes a new object.
+         * 
+         * @param content object content
+         * @return object number
+         */
+        int add_object(const std::string& content);
+
+        /**
+         * Writes a previously reserved stream object.
+         * 
+         * @param id object number
+         * @param dict_entries additional stream dictionary entries 
+         * (`/Length` is added automatically)
+         * @param data stream data
+         */
+        void set_stream(int id, const std::string& dict_entries, const std::string& data);
+
+        /**
+         * Writes a new stream object.
+         * 
+         * @param dict_entries additional stream dictionary entries
+         * @param data stream data
+         * @return object number
+         */
+        int add_stream(const std::string& dict_entries, const std::string& data);
+
+        /**
+         * Finishes the document by writing the cross-reference table and 
+         * the trailer.
+         * 
+         * @param catalog object number of the document catalog
+         * @return the whole PDF file
+         * @throws SongbookException when a reserved object was not written
+         */
+        std::string finish(int catalog);
+
+        private:
+        std::string pdf{"%PDF-1.6\n%\xe2\xe3\xcf\xd3\n"};  ///< PDF written so far
+        std::vector<std::size_t> offsets;  ///< object offsets (index = number - 1)
+    };
+
+    /**
+     * Formats a number for use in PDF content (at most 2 decimal places, 
+     * no exponent).
+     * 
+     * @param x number
+     * @return formatted number
+     */
+    std::string pdf_number(double x);
+
+    /**
+     * Escapes and encloses a string in parentheses to form a PDF literal 
+     * string.
+     * 
+     * @param str string
+     * @return PDF literal string
+     */
+    std::string pdf_literal(const std::string& str);
+}
+
+#endif  // SONGBOOK_PDFWRITER_HPP
@@ -0,0 +1,298 @@
+#include "SearchIndex.hpp"
+#include "SongbookConverter.hpp"
+#include "SongbookPrinter.hpp"
+#include "textUtils.hpp"
+#include "contentHash.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace songbook {
+
+    namespace {
+        /**
+         * First line of an index file (followed by the content hash,
+         * modification time and size of the XML).
+         */
+        const std::string index_signature{"songbook-index 2"};
+
+        /**
+         * Intersects two sorted id vectors.
+         *
+         * @param a first vector
+         * @param b second vector
+         * @return ids present in both
+         */
+        std::vector<std::uint32_t> intersect(const std::vector<std::uint32_t>& a,
+            const std::vector<std::uint32_t>& b) {
+
+            std::vector<std::uint32_t> result;
+            std::set_intersection(begin(a), end(a), begin(b), end(b),
+                std::back_inserter(result));
+            return result;
+        }
+    }
+
+    SearchIndex::SearchIndex(const SongbookData& songbook, std::uint64_t source_hash,
+        std::int64_t mtime, std::uint64_t size):
+        source_hash(source_hash), mtime(mtime), file_size(size) {
+
+        std::unordered_map<std::string, std::vector<std::uint32_t>> index;
+
+        auto add_text = [&index](std::string_view text, std::uint32_t id) {
+            for (std::string& word: tokenize(text)) {
+                std::vector<std::uint32_t>& ids = index[std::move(word)];
+                if (ids.empty() || ids.back() != id)
+                    ids.push_back(id);
+            }
+        };
+
+        documents.reserve(songbook.songs.size());
+        for (const SongData& song: songbook.songs) {
+            auto id = static_cast<std::uint32_t>(documents.size());
+            SearchDocument doc;
+
+            for (const auto& [tag, value]: song.header) {
+                if (tag == "name") {
+                    doc.name = remove_separators(value);
+                    add_text(value, id);
+                } else if (tag == "author") {
+                    if (!doc.authors.empty())
+                        doc.authors.append(" / ");
+                    doc.authors.append(remove_separators(value));
+                    add_text(value, id);
+                } else if (tag == "sortingName") {
+                    add_text(value, id);
+                }
+            }
+
+            // lyrics of a line are joined as chords can split words
+            std::string lyrics;
+            for (const SongEvent& event: song.events) {
+                lyrics.clear();
+                for (const LineElement& elem: event.line) {
+                    if (elem.type == LineItemType::lyrics)
+                        lyrics.append(elem.lyrics);
+                }
+                add_text(lyrics, id);
+            }
+
+            documents.push_back(std::move(doc));
+        }
+
+        terms.reserve(index.size());
+        for (const auto& entry: index)
+            terms.push_back(entry.first);
+        std::sort(begin(terms), end(terms));
+
+        postings.reserve(index.size());
+        for (const std::string& term: terms)
+            postings.push_back(std::move(index[term]));
+    }
+
+    std::vector<std::uint32_t> SearchIndex::find_word(const std::string& word, bool prefix) const {
+        auto first = std::lower_bound(begin(terms), end(terms), word);
+        auto last = first;
+        if (prefix) {
+            while (last != end(terms) && last->compare(0, word.size(), word) == 0)
+                ++last;
+        } else if (last != end(terms) && *last == word) {
+            ++last;
+        }
+
+        if (first == last)
+            return {};
+        if (last - first == 1)
+            return postings[first - begin(terms)];
+
+        // union of all terms starting with `word` -- marking songs is cheaper
+        //   than merging many lists
+        std::vector<char> found(documents.size(), 0);
+        for (auto it = first; it != last; ++it) {
+            for (std::uint32_t id: postings[it - begin(terms)])
+                found[id] = 1;
+        }
+        std::vector<std::uint32_t> result;
+        for (size_t id = 0; id < found.size(); ++id) {
+            if (found[id])
+                result.push_back(static_cast<std::uint32_t>(id));
+        }
+
+        return result;
+    }
+
+    std::vector<size_t> SearchIndex::search(std::string_view query) const {
+        std::vector<std::string> words = tokenize(query);
+        if (words.empty())
+            return {};
+
+        // complete words from the rarest one, the last word as a prefix 
+        std::vector<const std::vector<std::uint32_t>*> lists;
+        for (size_t i = 0; i + 1 < words.size(); ++i) {
+            auto it = std::lower_bound(begin(terms), end(terms), words[i]);
+            if (it == end(terms) || *it != words[i])
+                return {};
+            lists.push_back(&postings[it - begin(terms)]);
+        }
+        std::sort(begin(lists), end(lists),
+            [](auto* a, auto* b){ return a->size() < b->size(); });
+
+        std::vector<std::uint32_t> ids;
+        if (lists.empty()) {
+            ids = find_word(words.back(), true);
+        } else {
+            ids = *lists.front();
+            for (size_t i = 1; i < lists.size() && !ids.empty(); ++i)
+                ids = intersect(ids, *lists[i]);
+            if (!ids.empty())
+                ids = intersect(ids, find_word(words.back(), true));
+        }
+
+        return std::vector<size_t>(begin(ids), end(ids));
+    }
+
+    const SearchDocument& SearchIndex::get_document(size_t id) const {
+        return documents.at(id);
+    }
+
+    size_t SearchIndex::size() const {
+        return documents.size();
+    }
+
+    std::uint64_t SearchIndex::get_source_hash() const {
+        return source_hash;
+    }
+
+    bool SearchIndex::is_current(std::int64_t mtime, std::uint64_t size) const {
+        return this->mtime == mtime && file_size == size;
+    }
+
+    void SearchIndex::set_file_state(std::int64_t mtime, std::uint64_t size) {
+        this->mtime = mtime;
+        file_size = size;
+    }
+
+    void SearchIndex::save(const std::string& filename) const {
+        std::ofstream ofs{filename, std::ios::binary};
+        if (!ofs)
+            throw std::runtime_error("Index file " + filename + " cannot be opened");
+
+        ofs << index_signature << '\n'
+            << hash_to_hex(source_hash) << ' ' << mtime << ' ' << file_size << '\n'
+            << documents.size() << ' ' << terms.size() << '\n';
+        for (const SearchDocument& doc: documents)
+            ofs << doc.name << '\t' << doc.authors << '\n';
+
+        // song ids are delta-encoded
+        for (size_t i = 0; i < terms.size(); ++i) {
+            ofs << terms[i];
+            std::uint32_t previous{0};
+            for (std::uint32_t id: postings[i]) {
+                ofs << ' ' << id - previous;
+                previous = id;
+            }
+            ofs << '\n';
+        }
+
+        if (!ofs)
+            throw std::runtime_error("Index file " + filename + " cannot be written");
+    }
+
+    bool SearchIndex::load(const std::string& filename) {
+        *this = SearchIndex{};
+
+        std::ifstream ifs{filename, std::ios::binary};
+        if (!ifs)
+            return false;
+
+        std::string line;
+        if (!getline(ifs, line) || line != index_signature)
+            return false;
+
+        SearchIndex loaded;
+        size_t n_documents, n_terms;
+        if (!(ifs >> std::hex >> loaded.source_hash >> std::dec >> loaded.mtime >>
+            loaded.file_size >> n_documents >> n_terms) || !getline(ifs, line))
+            return false;
+
+        loaded.documents.reserve(n_documents);
+        for (size_t i = 0; i < n_documents && getline(ifs, line); ++i) {
+            size_t tab = line.find('\t');
+            if (tab == std::string::npos)
+                return false;
+            loaded.documents.push_back(SearchDocument{line.substr(0, tab), line.substr(tab + 1)});
+        }
+
+        loaded.terms.reserve(n_terms);
+        loaded.postings.reserve(n_terms);
+        for (size_t i = 0; i < n_terms && getline(ifs, line); ++i) {
+            std::istringstream iss{line};
+            std::string term;
+            iss >> term;
+
+            std::vector<std::uint32_t> ids;
+            std::uint32_t id{0}, delta;
+            while (iss >> delta) {
+                id += delta;
+                if (id >= n_documents)
+                    return false;
+                ids.push_back(id);
+            }
+            loaded.terms.push_back(std::move(term));
+            loaded.postings.push_back(std::move(ids));
+        }
+
+        if (loaded.documents.size() != n_documents || loaded.terms.size() != n_terms)
+            return false;
+
+        *this = std::move(loaded);
+        return true;
+    }
+
+    //------  Nonmember functions ------
+
+    std::string search_index_file(const std::string& xml_file) {
+        return xml_file + ".index";
+    }
+
+    SearchIndex load_search_index(const std::string& xml_file) {
+        std::error_code error;
+        auto mtime = static_cast<std::int64_t>(std::filesystem::last_write_time(xml_file, error)
+            .time_since_epoch().count());
+        std::uint64_t size = std::filesystem::file_size(xml_file, error);
+        if (error)
+            throw std::runtime_error("Input file " + xml_file + " cannot be opened");
+
+        std::string index_file = search_index_file(xml_file);
+        SearchIndex index;
+        bool loaded = index.load(index_file);
+        if (loaded && index.is_current(mtime, size))
+            return index;
+
+        // file changed on disk -- its content may still be the same
+        std::uint64_t hash = content_hash(load_xml(xml_file));
+        if (loaded && index.get_source_hash() == hash) {
+            index.set_file_state(mtime, size);
+        } else {
+            // index missing or outdated -- build a new one
+            SongbookConverter converter = init_converter<SongbookPrinter>();
+            converter.parse_songbook(xml_file);
+            index = SearchIndex{converter.read_songbook(), hash, mtime, size};
+        }
+
+        try {
+            index.save(index_file);
+        } catch (const std::runtime_error& e) {
+            // the index can still be used
+            std::cerr << e.what() << std::endl;
+        }
+
+        return index;
+    }
+}
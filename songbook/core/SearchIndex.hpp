@@ -0,0 +1,163 @@
+#ifndef SONGBOOK_SEARCHINDEX_HPP
+#define SONGBOOK_SEARCHINDEX_HPP
+
+#include "songModel.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * A song as returned by a search.
+     */
+    struct SearchDocument {
+        std::string name;     /**< song name */
+        std::string authors;  /**< song authors separated by " / " */
+    };
+
+    /**
+     * Inverted index over song names, sorting names, authors and lyrics.
+     *
+     * Words are folded (see `tokenize()`) so that searching ignores case
+     * and diacritics. A song matches a query when it contains all of the
+     * query's words; the last word of the query matches as a prefix, so
+     * that an incomplete word can be searched for.
+     *
+     * The index can be saved next to the songbook XML and reused while
+     * the XML stays the same (see `load_search_index()`):
+     * @code
+     * SearchIndex index = load_search_index("sb.xml");
+     * for (size_t id: index.search("yellow submar"))
+     *     std::cout << index.get_document(id).name << '\n';
+     * @endcode
+     */
+    class SearchIndex {
+
+        public:
+        /**
+         * Creates an empty index.
+         */
+        SearchIndex() = default;
+
+        /**
+         * Builds an index of a songbook.
+         *
+         * @param songbook songbook read by `SongbookConverter::read_songbook()`
+         * @param source_hash content hash of the songbook XML
+         * @param mtime modification time of the XML file (ticks since the clock's epoch)
+         * @param size size of the XML file in bytes
+         */
+        SearchIndex(const SongbookData& songbook, std::uint64_t source_hash,
+            std::int64_t mtime, std::uint64_t size);
+
+        /**
+         * Finds songs containing all words of a query.
+         *
+         * @param query words to search for (the last one can be incomplete)
+         * @return ids of matching songs in document order
+         */
+        std::vector<size_t> search(std::string_view query) const;
+
+        /**
+         * Returns a song by its id.
+         *
+         * @param id song id (order of the song in the XML)
+         * @return song name and authors
+         */
+        const SearchDocument& get_document(size_t id) const;
+
+        /**
+         * Returns the number of indexed songs.
+         *
+         * @return number of songs
+         */
+        size_t size() const;
+
+        /**
+         * Getter for `source_hash`.
+         *
+         * @return content hash of the indexed XML
+         */
+        std::uint64_t get_source_hash() const;
+
+        /**
+         * Checks whether the index was created for a file with the given
+         * modification time and size.
+         *
+         * @param mtime modification time of the file
+         * @param size size of the file
+         * @return `true` when both match
+         */
+        bool is_current(std::int64_t mtime, std::uint64_t size) const;
+
+        /**
+         * Records a new modification time and size of the indexed file, e.g.
+         * after the file was touched without changing its content.
+         *
+         * @param mtime modification time of the file
+         * @param size size of the file
+         */
+        void set_file_state(std::int64_t mtime, std::uint64_t size);
+
+        /**
+         * Saves the index to a file.
+         *
+         * @param filename file to save to
+         * @throws std::runtime_error the file cannot be written
+         */
+        void save(const std::string& filename) const;
+
+        /**
+         * Loads the index from a file.
+         *
+         * @param filename file to load from
+         * @return `false` when the file does not exist or is damaged; the
+         * index is empty then
+         */
+        bool load(const std::string& filename);
+
+        private:
+        /**
+         * Returns ids of songs containing a word.
+         *
+         * @param word folded word
+         * @param prefix should words starting with `word` match as well?
+         * @return sorted song ids
+         */
+        std::vector<std::uint32_t> find_word(const std::string& word, bool prefix) const;
+
+        std::vector<SearchDocument> documents;             ///< indexed songs
+        std::vector<std::string> terms;                    ///< sorted folded words
+        std::vector<std::vector<std::uint32_t>> postings;  ///< song ids for each term
+        std::uint64_t source_hash{0};                      ///< content hash of the XML
+        std::int64_t mtime{0};                             ///< modification time of the XML
+        std::uint64_t file_size{0};                        ///< size of the XML
+    };
+
+
+    /**
+     * Returns the name of the index file of a songbook XML.
+     *
+     * @param xml_file songbook XML file
+     * @return index file name (next to the XML file)
+     */
+    std::string search_index_file(const std::string& xml_file);
+
+    /**
+     * Loads the search index of a songbook XML. The XML is only read when
+     * its modification time or size differ from the saved index; when its
+     * content hash differs as well (or the index is missing), the XML is
+     * parsed, indexed and the index is saved.
+     *
+     * @param xml_file songbook XML file
+     * @return search index
+     * @throws std::runtime_error when the XML file can't be opened
+     * @throws SongbookException a problem during XML parsing
+     */
+    SearchIndex load_search_index(const std::string& xml_file);
+}
+
+#endif  // SONGBOOK_SEARCHINDEX_HPP
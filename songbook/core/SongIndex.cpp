@@ -0,0 +1,328 @@
+#include "SongIndex.hpp"
+#include "SongbookConverter.hpp"
+#include "SongbookException.hpp"
+#include "SongbookPrinter.hpp"
+#include "contentHash.hpp"
+#include "textUtils.hpp"
+#include "trustedXml.hpp"
+#include "xmlCursor.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+
+namespace songbook {
+
+    namespace {
+        /**
+         * First line of an index file.
+         */
+        const std::string index_signature{"songbook-song-index 1"};
+
+        /**
+         * Joins folded words of a song name.
+         *
+         * @param name song name
+         * @return name for case- and diacritics-insensitive comparison
+         */
+        std::string fold_name(std::string_view name) {
+            std::string folded;
+            for (const std::string& word: tokenize(name)) {
+                if (!folded.empty())
+                    folded.push_back(' ');
+                folded.append(word);
+            }
+            return folded;
+        }
+
+        /**
+         * Reads a byte range of a file and appends it to a string.
+         *
+         * @param ifs file opened in binary mode
+         * @param offset start of the range
+         * @param length length of the range
+         * @param output string to append to
+         * @return `false` when the range cannot be read
+         */
+        bool append_range(std::ifstream& ifs, std::uint64_t offset, std::uint64_t length,
+            std::string& output) {
+
+            size_t start = output.size();
+            output.resize(start + length);
+            ifs.seekg(static_cast<std::streamoff>(offset));
+            return static_cast<bool>(ifs.read(output.data() + start,
+                static_cast<std::streamsize>(length)));
+        }
+    }
+
+    SongIndex::SongIndex(const std::string& xml, std::int64_t mtime, std::uint64_t size,
+        const SongIndex* previous): mtime(mtime), file_size(size) {
+
+        // entities which can be used in song headers
+        TagValueMap entities = expand_entity_values(SongbookPrinter{}.get_entities());
+        ExtractedEntities user_entities = extract_entities_element(xml);
+        entities_hash = content_hash(user_entities.xml);
+        if (!user_entities.xml.empty()) {
+            for (auto& [name, value]: read_trusted_entities(user_entities.xml, entities,
+                user_entities.offset))
+                entities[name] = std::move(value);
+        }
+
+        // headers of unchanged songs can be reused when entities are the same
+        std::unordered_map<std::uint64_t, const IndexedSong*> previous_songs;
+        if (previous && previous->entities_hash == entities_hash) {
+            for (const IndexedSong& song: previous->songs)
+                previous_songs.emplace(song.hash, &song);
+        }
+
+        // line numbers are counted incrementally while scanning
+        size_t counted{0};
+        int line_offset{0};
+        auto line_offset_at = [&](size_t offset) {
+            line_offset += static_cast<int>(
+                std::count(xml.begin() + counted, xml.begin() + offset, '\n'));
+            counted = offset;
+            return line_offset;
+        };
+
+        // songs are only skipped, no references are expanded
+        TagValueMap no_entities;
+        XmlCursor cursor{xml, no_entities, 0};
+        Token root = cursor.next_element();
+        if (root.type != TokenType::start || root.name != "songbook")
+            cursor.error("<songbook> expected");
+
+        for (Token elem = cursor.next_element(); elem.type == TokenType::start;
+            elem = cursor.next_element()) {
+
+            if (elem.name != "songs") {
+                cursor.skip_element();
+                continue;
+            }
+
+            songs_start = cursor.position();
+            Token song = cursor.next_element();
+            for (; song.type == TokenType::start; song = cursor.next_element()) {
+                cursor.skip_element();
+
+                std::string_view content = std::string_view{xml}.substr(song.offset,
+                    cursor.position() - song.offset);
+                IndexedSong indexed{song.offset, content.size(), line_offset_at(song.offset),
+                    content_hash(content), {}};
+
+                auto reused = previous_songs.find(indexed.hash);
+                indexed.header = reused != previous_songs.end() ? reused->second->header :
+                    read_trusted_song_header(content, entities, indexed.line_offset);
+                songs.push_back(std::move(indexed));
+            }
+            songs_end = song.offset;
+            songs_end_line_offset = line_offset_at(song.offset);
+        }
+
+        if (songs_start == 0)
+            cursor.error("<songs> expected");
+    }
+
+    bool SongIndex::is_current(std::int64_t mtime, std::uint64_t size) const {
+        return this->mtime == mtime && file_size == size;
+    }
+
+    std::vector<size_t> SongIndex::find_songs(const std::vector<std::string>& names) const {
+        std::vector<std::string> folded_names;
+        std::vector<size_t> ids;
+
+        for (const std::string& name: names) {
+            size_t found = ids.size();
+            for (size_t id = 0; id < songs.size(); ++id) {
+                auto [first, last] = songs[id].header.equal_range("name");
+                if (std::any_of(first, last, [&name](const auto& tag){ return tag.second == name; }))
+                    ids.push_back(id);
+            }
+            if (ids.size() > found)
+                continue;
+
+            // no exact match -- compare folded names
+            if (folded_names.empty()) {
+                folded_names.reserve(songs.size());
+                for (const IndexedSong& song: songs) {
+                    auto it = song.header.find("name");
+                    folded_names.push_back(it != song.header.end() ? fold_name(it->second) : "");
+                }
+            }
+            std::string folded = fold_name(name);
+            for (size_t id = 0; id < songs.size(); ++id) {
+                if (!folded.empty() && folded_names[id] == folded)
+                    ids.push_back(id);
+            }
+            if (ids.size() == found)
+                throw SongbookException("Song not found: " + name);
+        }
+
+        std::sort(begin(ids), end(ids));
+        ids.erase(std::unique(begin(ids), end(ids)), end(ids));
+
+        return ids;
+    }
+
+    std::string SongIndex::read_songs(const std::string& xml_file,
+        const std::vector<size_t>& ids) const {
+
+        std::ifstream ifs{xml_file, std::ios::binary};
+        if (!ifs)
+            throw std::runtime_error("Input file " + xml_file + " cannot be opened");
+
+        auto read_error = [&xml_file]() {
+            return std::runtime_error("Input file " + xml_file +
+                " does not match its song index (was it changed?)");
+        };
+
+        // everything before songs
+        std::string xml;
+        if (!append_range(ifs, 0, songs_start, xml))
+            throw read_error();
+        int line_offset = static_cast<int>(std::count(xml.begin(), xml.end(), '\n'));
+
+        for (size_t id: ids) {
+            const IndexedSong& song = songs.at(id);
+            xml.append(static_cast<size_t>(std::max(song.line_offset - line_offset, 0)), '\n');
+
+            size_t start = xml.size();
+            if (!append_range(ifs, song.offset, song.length, xml) ||
+                content_hash(std::string_view{xml}.substr(start)) != song.hash)
+                throw read_error();
+            line_offset = song.line_offset + static_cast<int>(
+                std::count(xml.begin() + start, xml.end(), '\n'));
+        }
+
+        // everything after songs
+        xml.append(static_cast<size_t>(std::max(songs_end_line_offset - line_offset, 0)), '\n');
+        if (!append_range(ifs, songs_end, file_size - songs_end, xml))
+            throw read_error();
+
+        return xml;
+    }
+
+    const IndexedSong& SongIndex::get_song(size_t id) const {
+        return songs.at(id);
+    }
+
+    size_t SongIndex::size() const {
+        return songs.size();
+    }
+
+    void SongIndex::save(const std::string& filename) const {
+        std::ofstream ofs{filename, std::ios::binary};
+        if (!ofs)
+            throw std::runtime_error("Index file " + filename + " cannot be opened");
+
+        ofs << index_signature << '\n'
+            << mtime << ' ' << file_size << ' ' << hash_to_hex(entities_hash) << '\n'
+            << songs_start << ' ' << songs_end << ' ' << songs_end_line_offset << ' '
+            << songs.size() << '\n';
+
+        // one song per line: position and hash followed by header elements
+        for (const IndexedSong& song: songs) {
+            ofs << song.offset << ' ' << song.length << ' ' << song.line_offset << ' '
+                << hash_to_hex(song.hash);
+            for (const auto& [tag, value]: song.header)
+                ofs << '\t' << tag << '\t' << remove_separators(value);
+            ofs << '\n';
+        }
+
+        if (!ofs)
+            throw std::runtime_error("Index file " + filename + " cannot be written");
+    }
+
+    bool SongIndex::load(const std::string& filename) {
+        *this = SongIndex{};
+
+        std::ifstream ifs{filename, std::ios::binary};
+        if (!ifs)
+            return false;
+
+        std::string line;
+        if (!getline(ifs, line) || line != index_signature)
+            return false;
+
+        SongIndex loaded;
+        size_t n_songs;
+        if (!(ifs >> loaded.mtime >> loaded.file_size >> std::hex >> loaded.entities_hash >>
+            std::dec >> loaded.songs_start >> loaded.songs_end >> loaded.songs_end_line_offset >>
+            n_songs) || !getline(ifs, line))
+            return false;
+
+        loaded.songs.reserve(n_songs);
+        for (size_t i = 0; i < n_songs && getline(ifs, line); ++i) {
+            std::istringstream iss{line.substr(0, line.find('\t'))};
+            IndexedSong song{};
+            if (!(iss >> song.offset >> song.length >> song.line_offset >> std::hex >> song.hash) ||
+                song.offset + song.length > loaded.songs_end)
+                return false;
+
+            // tab-separated header tags and values
+            size_t tab = line.find('\t');
+            while (tab != std::string::npos) {
+                size_t value_tab = line.find('\t', tab + 1);
+                if (value_tab == std::string::npos)
+                    return false;
+                size_t next_tab = line.find('\t', value_tab + 1);
+                song.header.emplace(line.substr(tab + 1, value_tab - tab - 1),
+                    line.substr(value_tab + 1, next_tab == std::string::npos ?
+                        std::string::npos : next_tab - value_tab - 1));
+                tab = next_tab;
+            }
+            loaded.songs.push_back(std::move(song));
+        }
+
+        if (loaded.songs.size() != n_songs || loaded.songs_end > loaded.file_size)
+            return false;
+
+        *this = std::move(loaded);
+        return true;
+    }
+
+    //------  Nonmember functions ------
+
+    std::string song_index_file(const std::string& xml_file) {
+        return xml_file + ".songs";
+    }
+
+    SongIndex load_song_index(const std::string& xml_file) {
+        std::error_code error;
+        auto mtime = static_cast<std::int64_t>(std::filesystem::last_write_time(xml_file, error)
+            .time_since_epoch().count());
+        std::uint64_t size = std::filesystem::file_size(xml_file, error);
+        if (error)
+            throw std::runtime_error("Input file " + xml_file + " cannot be opened");
+
+        std::string index_file = song_index_file(xml_file);
+        SongIndex index;
+        bool loaded = index.load(index_file);
+        if (loaded && index.is_current(mtime, size))
+            return index;
+
+        // index missing or outdated -- scan the XML (offsets need binary reading)
+        std::ifstream ifs{xml_file, std::ios::binary};
+        if (!ifs)
+            throw std::runtime_error("Input file " + xml_file + " cannot be opened");
+        std::ostringstream oss;
+        oss << ifs.rdbuf();
+        std::string xml = std::move(oss).str();
+
+        index = SongIndex{xml, mtime, xml.size(), loaded ? &index : nullptr};
+
+        try {
+            index.save(index_file);
+        } catch (const std::runtime_error& e) {
+            // the index can still be used
+            std::cerr << e.what() << std::endl;
+        }
+
+        return index;
+    }
+}
@@ -0,0 +1,160 @@
+#ifndef SONGBOOK_SONGINDEX_HPP
+#define SONGBOOK_SONGINDEX_HPP
+
+#include "songbookTypes.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * Position and header of a song in the songbook XML.
+     */
+    struct IndexedSong {
+        std::uint64_t offset;     /**< byte offset of the `<song>` start tag */
+        std::uint64_t length;     /**< length of the `<song>` element in bytes */
+        int line_offset;          /**< number of lines before the element */
+        std::uint64_t hash;       /**< content hash of the element */
+        TagValueMultiMap header;  /**< header elements (as in `SongData::header`) */
+    };
+
+    /**
+     * Byte ranges and headers of songs in a songbook XML, which allow
+     * parsing only selected songs instead of the whole songbook.
+     *
+     * The index is built by a fast scan of the XML (see `XmlCursor`) and
+     * saved next to it. It is valid while the XML's modification time and
+     * size stay the same; when they change, the index is rebuilt, but
+     * headers of songs whose content did not change are reused.
+     *
+     * A subset of the songbook (settings and selected songs) is a valid
+     * songbook XML with the original line numbers, so it can be parsed
+     * and validated as usual:
+     * @code
+     * SongIndex index = load_song_index("sb.xml");
+     * std::string xml = index.read_songs("sb.xml", index.find_songs({"Bludný Holaňďan"}));
+     * @endcode
+     */
+    class SongIndex {
+
+        public:
+        /**
+         * Creates an empty index.
+         */
+        SongIndex() = default;
+
+        /**
+         * Builds an index of a songbook XML.
+         *
+         * @param xml songbook XML (without the DTD)
+         * @param mtime modification time of the XML file (ticks since the clock's epoch)
+         * @param size size of the XML file
+         * @param previous index of a previous version of the file whose
+         * song headers are reused when possible (can be `nullptr`)
+         * @throws SongbookException malformed XML, an undefined entity or a
+         * missing required song header element
+         */
+        SongIndex(const std::string& xml, std::int64_t mtime, std::uint64_t size,
+            const SongIndex* previous = nullptr);
+
+        /**
+         * Checks whether the index was built for a file.
+         *
+         * @param mtime modification time of the file
+         * @param size size of the file
+         * @return `true` when both match
+         */
+        bool is_current(std::int64_t mtime, std::uint64_t size) const;
+
+        /**
+         * Finds songs by their names. Songs with exactly the same name are
+         * looked for first; when there is none, names are compared ignoring
+         * case, diacritics and punctuation (see `tokenize()`).
+         *
+         * @param names song names
+         * @return ids of all matching songs in document order
+         * @throws SongbookException no song has one of the names
+         */
+        std::vector<size_t> find_songs(const std::vector<std::string>& names) const;
+
+        /**
+         * Reads a subset of the songbook: everything but songs and selected
+         * songs. Songs are padded with newlines so that they stay on their
+         * original lines (for error messages).
+         *
+         * @param xml_file songbook XML file the index was built for
+         * @param ids ids of songs to read (in document order)
+         * @return songbook XML with the selected songs
+         * @throws std::runtime_error the file cannot be read or its content
+         * does not match the index
+         */
+        std::string read_songs(const std::string& xml_file, const std::vector<size_t>& ids) const;
+
+        /**
+         * Returns a song by its id.
+         *
+         * @param id song id (order of the song in the XML)
+         * @return song position and header
+         */
+        const IndexedSong& get_song(size_t id) const;
+
+        /**
+         * Returns the number of indexed songs.
+         *
+         * @return number of songs
+         */
+        size_t size() const;
+
+        /**
+         * Saves the index to a file.
+         *
+         * @param filename file to save to
+         * @throws std::runtime_error the file cannot be written
+         */
+        void save(const std::string& filename) const;
+
+        /**
+         * Loads the index from a file.
+         *
+         * @param filename file to load from
+         * @return `false` when the file does not exist or is damaged; the
+         * index is empty then
+         */
+        bool load(const std::string& filename);
+
+        private:
+        std::vector<IndexedSong> songs;     ///< songs in document order
+        std::uint64_t songs_start{0};       ///< offset just after the `<songs>` start tag
+        std::uint64_t songs_end{0};         ///< offset of the `</songs>` end tag
+        int songs_end_line_offset{0};       ///< number of lines before `</songs>`
+        std::uint64_t entities_hash{0};     ///< content hash of the `<entities>` element
+        std::int64_t mtime{0};              ///< modification time of the indexed file
+        std::uint64_t file_size{0};         ///< size of the indexed file
+    };
+
+
+    /**
+     * Returns the name of the song index file of a songbook XML.
+     *
+     * @param xml_file songbook XML file
+     * @return index file name (next to the XML file)
+     */
+    std::string song_index_file(const std::string& xml_file);
+
+    /**
+     * Loads the song index of a songbook XML. When the saved index is
+     * missing or outdated, the XML is scanned (reusing the outdated index)
+     * and the index is saved.
+     *
+     * @param xml_file songbook XML file
+     * @return song index
+     * @throws std::runtime_error when the XML file can't be opened
+     * @throws SongbookException a problem during XML scanning
+     */
+    SongIndex load_song_index(const std::string& xml_file);
+}
+
+#endif  // SONGBOOK_SONGINDEX_HPP
@@ -1,14 +1,19 @@
 #include "SongbookConverter.hpp"
 #include "SongbookPrinter.hpp"
 #include "SongbookException.hpp"
+#include "SongIndex.hpp"
+#include "allocationStats.hpp"
+#include "textUtils.hpp"
 
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <atomic>
 #include <xercesc/util/PlatformUtils.hpp>
 #include <xercesc/util/XMLString.hpp>
+#include <xercesc/util/XMLUni.hpp>
 #include <xercesc/util/TransService.hpp>
 //#include <xercesc/framework/MemBufInputSource.hpp>
 
@@ -17,15 +22,46 @@ namespace songbook {
 
     using namespace xercesc;
 
-    LineItem::LineItem(LineItemType type, std::string&& value): 
-        type(type), value(std::move(value)) {};
+    namespace {
+        /**
+         * Bytes produced by `get_text_value()` and `get_value()`.
+         */
+        std::atomic<std::uint64_t> transcoded_total{0};
+
+        /**
+         * Appends UTF-16 text transcoded to UTF-8.
+         *
+         * @param text null-terminated UTF-16 text
+         * @param output string to append to
+         * @param drop_newlines should newlines (LF and CRLF) be left out?
+         */
+        void append_utf8(const XMLCh* text, std::string& output, bool drop_newlines) {
+            for (const XMLCh* c = text; *c; ++c) {
+                std::uint32_t code = *c;
+                // surrogate pair (the parser has checked it is complete)
+                if (code >= 0xD800 && code <= 0xDBFF && c[1]) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (c[1] - 0xDC00);
+                    ++c;
+                }
+
+                if (drop_newlines && (code == '\n' || (code == '\r' && c[1] == '\n')))
+                    continue;  // newlines are removed (see `replace_newlines()`)
+                songbook::append_utf8(output, static_cast<char32_t>(code));
+            }
+        }
+    }
+
+    LineItem::LineItem(LineItemType type, std::string_view value): 
+        type(type), value(value) {};
 
     //------  SongbookConverter member functions ------
 
     SongbookConverter::SongbookConverter() {
 
         try {
-            XMLPlatformUtils::Initialize();
+            // the memory manager is used only by the first initialization
+            XMLPlatformUtils::Initialize(XMLUni::fgXercescDefaultLocale, 0, 0, 
+                counting_memory_manager());
         } 
         catch (const XMLException& e) {
             char* message = XMLString::transcode(e.getMessage());
@@ -105,9 +141,10 @@ namespace songbook {
 
 
     void SongbookConverter::parse_songbook(const std::string& filename) {
-        std::string xml = load_xml(filename);
+        std::string xml = load_songbook(filename);
 
         // extract entities from the XML and parse them
+        PhaseTimer entities_timer{stats, "entities"};
         ExtractedEntities entities = extract_entities_element(xml);
         std::string root;
 
@@ -119,13 +156,40 @@ namespace songbook {
             // read entities and update the printer with them
             printer->update_entities(read_entities());
         }
+        entities_timer.stop();
 
         // parse the songbook using updated entities
+        PhaseTimer parse_timer{stats, "parse"};
         root = "songbook";
         insert_dtd(xml, generate_dtd(printer->get_entities(), root), root);
         parser->parse_string(std::move(xml));
     }
 
+    std::string SongbookConverter::load_songbook(const std::string& filename) const {
+        if (selected_songs.empty()) {
+            PhaseTimer read_timer{stats, "read"};
+            std::string xml = load_xml(filename);
+            read_timer.stop();
+            if (stats)
+                stats->add("input bytes", xml.size());
+            return xml;
+        }
+
+        PhaseTimer index_timer{stats, "index"};
+        SongIndex index = load_song_index(filename);
+        std::vector<size_t> ids = index.find_songs(selected_songs);
+        index_timer.stop();
+
+        PhaseTimer read_timer{stats, "read"};
+        std::string xml = index.read_songs(filename, ids);
+        read_timer.stop();
+        if (stats) {
+            stats->add("input bytes", xml.size());
+            stats->add("indexed songs", index.size());
+        }
+        return xml;
+    }
+
     SongbookConverter::~SongbookConverter() {
         // the pointer must be deleted before calling Terminate()
         parser.reset(nullptr);
@@ -133,96 +197,182 @@ namespace songbook {
     }
 
     std::string SongbookConverter::convert() {
+        return convert_with(VirtualPrinter{*printer});
+    }
+
+    void SongbookConverter::process_settings(const DOMElement* settings) {
+        for (const auto& [name, value]: read_settings(settings)) {
+            if (process_setting(name, value))
+                printer->set_parameter(name, value);
+        }
+    }
 
+    std::vector<std::pair<std::string, std::string>> SongbookConverter::read_settings(
+        const DOMElement* settings) const {
+
+        std::vector<std::pair<std::string, std::string>> result;
+
+        DOMElement* elem = settings->getFirstElementChild();
+        while (elem) {
+            std::string e_name = get_node_name(elem);
+            if (e_name != "entities")
+                result.emplace_back(std::move(e_name), get_text_value(elem));
+
+            elem = elem->getNextElementSibling();
+        }
+
+        return result;
+    }
+
+    bool SongbookConverter::process_setting(const std::string& name, 
+        const std::string& value) {
+
+        if (name == "language")
+            set_language(value);
+        if (name == "sortSongsBy") {
+            sort_songs_by = (value == "name") ?
+                SortSongsBy::name : (value == "dateAdded" ?
+                    SortSongsBy::dateAdded : SortSongsBy::none);
+        } if (name == "convertAddedSince") {
+            convert_added_since = (value == "all") ? "0001-01-01" : value;
+            return false;
+        }
+
+        return true;
+    }
+
+    void SongbookConverter::set_transposition(int semitones) {
+        transposition = semitones;
+    }
+
+    void SongbookConverter::set_progress_handler(ProgressHandler handler) {
+        progress_handler = std::move(handler);
+    }
+
+    void SongbookConverter::set_stats(ConversionStats* target) {
+        stats = target;
+    }
+
+    void SongbookConverter::select_songs(std::vector<std::string> names) {
+        selected_songs = std::move(names);
+    }
+
+    SongbookData SongbookConverter::read_songbook() const {
         DOMElement* root = parser->getDocument()->getDocumentElement();
         DOMElement* elem = root->getFirstElementChild();
 
-        // process settings when present
+        SongbookData data;
+
         if (get_node_name(elem) == "settings") {
-            process_settings(elem);
+            data.settings = read_settings(elem);
             // proceed to the `<songs>` element
             elem = elem->getNextElementSibling();
         }
 
-        // for storing converted songs
-        std::vector<Song> songs;
         if (elem) {
             // proceed to the first `<song>` element
             elem = elem->getFirstElementChild();
 
             while (elem) {
-                try {
-                    songs.push_back(convert_song(elem));
-                } catch (SongbookException se) {};
+                data.songs.push_back(read_song(elem));
                 elem = elem->getNextElementSibling();
             }
         }
 
-        if (sort_songs_by != SortSongsBy::none)
-            std::sort(begin(songs), end(songs));
-
-        return printer->print_document(songs);
+        return data;
     }
 
-    void SongbookConverter::process_settings(const DOMElement* settings) {
-        DOMElement* elem = settings->getFirstElementChild();
-        while (elem) {
-            std::string e_name = get_node_name(elem);
-            if (e_name == "language")
-                set_language(get_text_value(elem));
-            if (e_name == "sortSongsBy") {
-                std::string sort_by{get_text_value(elem)};
-                sort_songs_by = (sort_by == "name") ?
-                    SortSongsBy::name : (sort_by == "dateAdded" ?
-                        SortSongsBy::dateAdded : SortSongsBy::none);
-            } if (e_name == "convertAddedSince") {
-                std::string since{get_text_value(elem)};
-                convert_added_since = (since == "all") ? "0001-01-01" : since;
-            } else if (e_name != "entities")
-                printer->set_parameter(e_name, get_text_value(elem));
+    void SongbookConverter::read_songbook(
+        const std::function<void(std::vector<std::pair<std::string, std::string>>)>& settings_read,
+        const std::function<void(SongData)>& song_read) const {
 
+        DOMElement* root = parser->getDocument()->getDocumentElement();
+        DOMElement* elem = root->getFirstElementChild();
+
+        if (get_node_name(elem) == "settings") {
+            settings_read(read_settings(elem));
             elem = elem->getNextElementSibling();
-            
+        } else {
+            settings_read({});
         }
+
+        for (elem = elem ? elem->getFirstElementChild() : nullptr; elem; 
+            elem = elem->getNextElementSibling())
+            song_read(read_song(elem));
     }
 
-    Song SongbookConverter::convert_song(const DOMNode* song_n) const {
-        auto* song_e = dynamic_cast<const DOMElement*>(song_n);
+    SongData SongbookConverter::read_song(const DOMElement* song_e) const {
+        SongData song;
 
-        // process header
         DOMElement* header_e = song_e->getFirstElementChild();
-        TagValueMultiMap header_tags = read_song_header(header_e);
-
-        // abort song processing when it was added before `convert_added_since`
-        auto search = header_tags.find("dateAdded");  // must be present
-        std::string date_added = search->second;
-        if (date_added < convert_added_since)
-            throw SongbookException("song added before convertAddedSince");
-
-        // convert song content
-        DOMElement* elem = header_e->getNextElementSibling();
-        std::string content = convert_song_content(elem);
-
-        std::string song = printer->print_song(header_tags, content);
-
-        std::string sorting_name;
-        if (sort_songs_by == SortSongsBy::dateAdded)
-            sorting_name = date_added;
-        else {
-            search = header_tags.find("sortingName");
-            if (search != header_tags.end())
-                sorting_name = search->second;
+        song.header = read_song_header(header_e);
+
+        auto search = song.header.find("transpose");
+        if (search != song.header.end()) {
+            song.transpose = parse_semitones(search->second);
+            song.header.erase(search);
         }
 
-        // name must be present
-        search = header_tags.find("name");
+        read_song_content(header_e->getNextElementSibling(), song.events);
+
+        return song;
+    }
+
+    void SongbookConverter::read_song_content(const DOMElement* content, 
+        std::vector<SongEvent>& events) const {
+
+        // the given element and all its subsequent siblings
+        while (content) {
+            std::string el_name = get_node_name(content);
+
+            if (el_name == "multicols") {
+                SongEvent start{SongEventType::multicols_start};
+                start.number = get_attr_value(content, "number");
+                events.push_back(std::move(start));
+                read_song_content(content->getFirstElementChild(), events);
+                events.push_back(SongEvent{SongEventType::multicols_end});
+            } else if (el_name == "line") {
+                SongEvent line{SongEventType::line};
+                DOMNode* node = content->getFirstChild();
+                while (node) {
+                    DOMNode::NodeType type = node->getNodeType();
+                    if (type == DOMNode::NodeType::TEXT_NODE) {            // lyrics
+                        std::string lyrics = get_text_value(node);
+                        if (!lyrics.empty())
+                            line.line.push_back(LineElement{
+                                LineItemType::lyrics, std::move(lyrics), {}});
+                    } else if (type == DOMNode::NodeType::ELEMENT_NODE) {  // chord
+                        line.line.push_back(LineElement{
+                            LineItemType::chord, {}, read_chord(node)});
+                    }
+                    node = node->getNextSibling();
+                }
+                events.push_back(std::move(line));
+            } else if (el_name == "columnbreak") {
+                events.push_back(SongEvent{SongEventType::columnbreak});
+            } else {     // <verse> or <chorus>
+                VerseType type = el_name == "verse" ? VerseType::verse : VerseType::chorus;
+                events.push_back(SongEvent{SongEventType::verse_start, type});
+                read_song_content(content->getFirstElementChild(), events);
+                events.push_back(SongEvent{SongEventType::verse_end, type});
+            }
 
-        return Song{
-            search->second,
-            std::move(sorting_name),
-            std::move(song)};
+            content = content->getNextElementSibling();
+        }
     }
 
+    void SongbookConverter::read_chords(const DOMElement* elem, 
+        std::vector<TagValueMap>& chords) const {
+
+        DOMElement* child = elem->getFirstElementChild();
+        while (child) {
+            if (get_node_name(child) == "chord")
+                chords.push_back(read_chord(child));
+            else
+                read_chords(child, chords);
+            child = child->getNextElementSibling();
+        }
+    }
 
     TagValueMultiMap SongbookConverter::read_song_header(const DOMElement* header) const {
         TagValueMultiMap tag_values;
@@ -250,93 +400,16 @@ namespace songbook {
     }
 
 
-    std::string SongbookConverter::convert_song_content(const DOMElement* content) const {
-
-        std::string result;
-
-        // the given element and all its subsequent siblings
-        while (content) {
-        
-            std::string el_name = get_node_name(content);
-            std::string tmp;
-
-            if (el_name == "multicols") {
-                tmp = convert_multicols(content);
-            } else if (el_name == "line") {
-                tmp = convert_line(content);
-            } else if (el_name == "columnbreak") {
-                tmp = printer->print_columnbreak();
-            } else {     // <verse> or <chorus>
-                tmp = convert_verse(content, 
-                    el_name == "verse" ? VerseType::verse : VerseType::chorus); 
-            }
-            result.append(tmp);
-
-            content = content->getNextElementSibling();
-        }
-
-        return result;
-    }
-
-    std::string SongbookConverter::convert_multicols(const DOMElement* multicols) const {
-    
-        std::string number = get_attr_value(multicols, "number");
-
-        // start multicols, add content, end multicols
-        std::string result = printer->print_multicols_start(number);
-        result.append(convert_song_content(multicols->getFirstElementChild()));
-        result.append(printer->print_multicols_end());
-        return result;
-    }
-
-    std::string SongbookConverter::convert_verse(const DOMElement* verse,
-        VerseType type) const {
-    
-        // start verse, add content, end verse
-        std::string result = printer->print_verse_start(type);
-        result.append(convert_song_content(verse->getFirstElementChild()));
-        result.append(printer->print_verse_end(type));
-        return result;
-    }
-
-    std::string SongbookConverter::convert_line(const DOMElement* line) const {
-        DOMNode* node = line->getFirstChild();
-
-        std::vector<LineItem> line_content;
-
-        // first use `printer` to create string representations of all elements
-        while (node) {
-            DOMNode::NodeType type = node->getNodeType();
-            if (type == DOMNode::NodeType::TEXT_NODE) {            // lyrics
-                std::string lyrics = get_text_value(node);
-                // don't include empty lyrics -- might emerge from newline-only
-                //   lyrics nodes after newline removal
-                if (!lyrics.empty()) {
-                    line_content.emplace_back(LineItemType::lyrics, 
-                        std::move(lyrics));
-                }
-            } else if (type == DOMNode::NodeType::ELEMENT_NODE) {  // chord
-                TagValueMap chord = read_chord(node);
-                line_content.emplace_back(LineItemType::chord, 
-                    printer->print_chord(chord));
-            }
-            node = node->getNextSibling();
-        }
-
-        // now print the final line
-        std::string result = printer->print_line(line_content);
-        
-        return result;
-    }
-
     TagValueMap SongbookConverter::read_chord(const DOMNode* chord) const {
         TagValueMap attr_values;
         DOMNamedNodeMap* attrs = chord->getAttributes();
         
-        // store all attribute values
+        // store all attribute values; names and values are transcoded
+        //   directly, without Xerces transcoders allocating for each of them
         for (XMLSize_t i=0; i < attrs->getLength(); ++i) {
             DOMAttr* attr = dynamic_cast<DOMAttr*>(attrs->item(i));
-            std::string a_name = get_node_name(attr);
+            std::string a_name;
+            append_utf8(attr->getName(), a_name, false);
             std::string a_value = get_value(attr);
 
             // delete value when "root" is "special"
@@ -398,13 +471,31 @@ namespace songbook {
     }
 
     std::string get_text_value(const DOMNode* node) {
+        std::string result;
+        append_text_value(node, result);
+        return result;
+    }
+
+    /**
+     * Text is transcoded from UTF-16 here rather than by `TranscodeToStr`,
+     * which would allocate a new buffer for every node.
+     */
+    void append_text_value(const DOMNode* node, std::string& output) {
         if (!node || node->getNodeType() != DOMNode::NodeType::TEXT_NODE)    
-            return "";
+            return;
 
-        TranscodeToStr tts(node->getNodeValue(), "utf-8");
-        std::string result = reinterpret_cast<char*>(tts.adopt());
+        size_t start = output.size();
+        append_utf8(node->getNodeValue(), output, true);
+        transcoded_total.fetch_add(output.size() - start, std::memory_order_relaxed);
+    }
 
-        return replace_newlines(std::move(result));
+    bool node_name_is(const DOMNode* node, std::string_view name) {
+        const XMLCh* node_name = node->getNodeName();
+        for (char c: name) {
+            if (*node_name++ != static_cast<XMLCh>(c))
+                return false;
+        }
+        return *node_name == 0;
     }
 
     std::string get_text_value(const DOMElement* elem) {
@@ -417,8 +508,14 @@ namespace songbook {
         if (!attr)    
             return "";
 
-        TranscodeToStr tts(attr->getValue(), "utf-8");
-        return reinterpret_cast<char*>(tts.adopt());
+        std::string result;
+        append_utf8(attr->getValue(), result, false);
+        transcoded_total.fetch_add(result.size(), std::memory_order_relaxed);
+        return result;
+    }
+
+    std::uint64_t transcoded_bytes() {
+        return transcoded_total.load(std::memory_order_relaxed);
     }
 
     std::string get_attr_value(const DOMElement* elem, std::string attr_name) {
@@ -2,17 +2,103 @@
 #define SONGBOOK_SONGBOOKCONVERTER_HPP
 
 #include "songbookTypes.hpp"
+#include "LineBuffer.hpp"
 #include "SongbookParser.hpp"
 #include "SongbookPrinter.hpp"
+#include "SongbookException.hpp"
 #include "Song.hpp"
+#include "songModel.hpp"
+#include "chordTransposition.hpp"
+#include "ConversionStats.hpp"
+#include "allocationStats.hpp"
 
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <memory>
+#include <algorithm>
+#include <functional>
 #include <xercesc/parsers/XercesDOMParser.hpp>
 #include <xercesc/dom/DOM.hpp>
 
 namespace songbook {
 
+    /**
+     * Forwards printing calls to a `SongbookPrinter` through its virtual 
+     * functions. 
+     * 
+     * `SongbookConverter` calls printer functions qualified with the 
+     * printer type so that they are bound statically (and can be inlined)
+     * when the type is known at compile time (see `StaticSongbookConverter`);
+     * this class is the printer type used when it is not.
+     */
+    class VirtualPrinter {
+
+        public:
+        /**
+         * Constructor.
+         * 
+         * @param printer printer to forward calls to
+         */
+        explicit VirtualPrinter(const SongbookPrinter& printer): printer(printer) {}
+
+        /** @copydoc SongbookPrinter::print_multicols_start() */
+        std::string print_multicols_start(const std::string& number) const {
+            return printer.print_multicols_start(number);
+        }
+
+        /** @copydoc SongbookPrinter::print_columnbreak() */
+        std::string print_columnbreak() const {
+            return printer.print_columnbreak();
+        }
+
+        /** @copydoc SongbookPrinter::print_multicols_end() */
+        std::string print_multicols_end() const {
+            return printer.print_multicols_end();
+        }
+
+        /** @copydoc SongbookPrinter::print_verse_start() */
+        std::string print_verse_start(VerseType type) const {
+            return printer.print_verse_start(type);
+        }
+
+        /** @copydoc SongbookPrinter::print_verse_end() */
+        std::string print_verse_end(VerseType type) const {
+            return printer.print_verse_end(type);
+        }
+
+        /** @copydoc SongbookPrinter::append_chord() */
+        void append_chord(const TagValueMap& chord, std::string& output) const {
+            printer.append_chord(chord, output);
+        }
+
+        /** @copydoc SongbookPrinter::append_line() */
+        void append_line(const std::vector<LineItem>& line_content, std::string& output) const {
+            printer.append_line(line_content, output);
+        }
+
+        /** @copydoc SongbookPrinter::print_song() */
+        std::string print_song(const TagValueMultiMap& header, const std::string& content) const {
+            return printer.print_song(header, content);
+        }
+
+        /** @copydoc SongbookPrinter::print_document() */
+        std::string print_document(const std::vector<Song>& songs) const {
+            return printer.print_document(songs);
+        }
+
+        private:
+        const SongbookPrinter& printer;  ///< the actual printer
+    };
+
+    /**
+     * Function called after each converted song with the number of songs 
+     * processed so far and the total number of songs. Conversion is 
+     * cancelled when it returns `false`.
+     */
+    using ProgressHandler = std::function<bool(size_t done, size_t total)>;
+
     /**
      * Converts a XML songbook file into other format, depending on the 
      * specified `SongbookPrinter`-derived class. 
@@ -77,6 +163,7 @@ namespace songbook {
          * Converts parsed XML into final format using the `printer`.
          * 
          * @return converted songbook
+         * @throws ConversionCancelled conversion was cancelled by the progress handler
          */
         std::string convert();
 
@@ -99,7 +186,73 @@ namespace songbook {
          */
         template <typename T> void set_printer();
 
-        private:
+        /**
+         * Sets transposition of all songs. A song's own `<transpose>` value
+         * is added to it.
+         * 
+         * @param semitones shift in semitones
+         */
+        void set_transposition(int semitones);
+
+        /**
+         * Sets a function to be called after each converted song.
+         * 
+         * @param handler progress handler; conversion is cancelled (with 
+         * `ConversionCancelled`) when it returns `false`
+         */
+        void set_progress_handler(ProgressHandler handler);
+
+        /**
+         * Sets statistics to which times of conversion phases (reading,
+         * parsing, converting, sorting, ...) and counts of songs, lines and
+         * chords are added.
+         * 
+         * @param target statistics (not owned); `nullptr` disables collecting
+         */
+        void set_stats(ConversionStats* target);
+
+        /**
+         * Restricts parsing to selected songs. Only the selected songs and 
+         * the rest of the XML outside `<songs>` (e.g. settings) are then read
+         * by `parse_songbook()`; song positions are taken from the song index
+         * saved next to the XML file (see `load_song_index()`).
+         * 
+         * @param names names of songs to parse (see `SongIndex::find_songs()`);
+         * all songs are parsed when empty
+         */
+        void select_songs(std::vector<std::string> names);
+
+        /**
+         * Reads parsed XML into a printer-independent `SongbookData`. All songs
+         * are read regardless of the `convertAddedSince` setting and in 
+         * document order.
+         * 
+         * @return songbook settings and songs; chords are not transposed
+         */
+        SongbookData read_songbook() const;
+
+        /**
+         * Reads parsed XML like `read_songbook()`, but passes songs one by
+         * one instead of keeping them, so that a single song of the model
+         * is held in memory at a time (the parsed document still is).
+         *
+         * @param settings_read called once with the setting name-value
+         * pairs before the first song
+         * @param song_read called with each song in document order
+         */
+        void read_songbook(
+            const std::function<void(std::vector<std::pair<std::string, std::string>>)>& settings_read,
+            const std::function<void(SongData)>& song_read) const;
+
+        protected:
+        /**
+         * Converts parsed XML using the `printer` whose type is known to be
+         * `T`, so that printer functions are bound statically.
+         * 
+         * @tparam T exact type of the `printer`
+         * @return converted songbook
+         */
+        template <typename T> std::string convert_static();
 
         /**
          * Reads entity definitions after the `<entities>` element
@@ -110,12 +263,24 @@ namespace songbook {
         TagValueMap read_entities() const;
 
         /**
-         * Processes settings from the XML file and passes them to the `printer`
-         * to save them. `<entities>` element is ignored.
+         * Reads the songbook XML to be parsed: the whole file or only its 
+         * selected songs (see `select_songs()`).
          * 
-         * @param settings `<settings>` XML element
+         * @param filename path to the songbook XML file
+         * @return XML content
+         * @throws std::runtime_error when the file can't be opened
+         * @throws SongbookException a selected song was not found
          */
-        void process_settings(const xercesc::DOMElement* settings);
+        std::string load_songbook(const std::string& filename) const;
+
+        /**
+         * Processes one setting by updating conversion options it affects.
+         * 
+         * @param name setting (element) name
+         * @param value setting value
+         * @return `true` when the setting should also be passed to printers
+         */
+        bool process_setting(const std::string& name, const std::string& value);
 
         /**
          * Reads information from a song header.
@@ -133,70 +298,175 @@ namespace songbook {
          */
         TagValueMap read_chord(const xercesc::DOMNode* chord) const;
 
+        /**
+         * XML parser.
+         */
+        std::unique_ptr<SongbookParser> parser;
+
+        /**
+         * Should songs be sorted by name?
+         */
+        int sort_songs_by = SortSongsBy::name;
+
+        /**
+         * Oldest addition date for a song to be converted
+         */
+        std::string convert_added_since = "0001-01-01";
+
+        /**
+         * Transposition of all songs in semitones.
+         */
+        int transposition{0};
+
+        /**
+         * Called after each converted song.
+         */
+        ProgressHandler progress_handler;
+
+        /**
+         * Collected statistics (`nullptr` when not collected).
+         */
+        ConversionStats* stats{nullptr};
+
+        /**
+         * Names of songs to parse (all songs when empty).
+         */
+        std::vector<std::string> selected_songs;
+
+        private:
+        /**
+         * Processes settings from the XML file and passes them to the `printer`
+         * to save them. `<entities>` element is ignored.
+         * 
+         * @param settings `<settings>` XML element
+         */
+        void process_settings(const xercesc::DOMElement* settings);
+
+        /**
+         * Reads settings from the XML file. `<entities>` element is ignored.
+         * 
+         * @param settings `<settings>` XML element
+         * @return setting name-value pairs in document order
+         */
+        std::vector<std::pair<std::string, std::string>> read_settings(
+            const xercesc::DOMElement* settings) const;
+
+        /**
+         * Reads a `<song>` element into a `SongData` object.
+         * 
+         * @param song_e `<song>` XML element
+         * @return song header and content
+         */
+        SongData read_song(const xercesc::DOMElement* song_e) const;
+
+        /**
+         * Reads content of (a part of) a song. Starts with the given XML 
+         * element and continues with all its subsequent siblings.
+         * 
+         * @param content song content element to start from
+         * @param[out] events vector to append content events to
+         */
+        void read_song_content(const xercesc::DOMElement* content, 
+            std::vector<SongEvent>& events) const;
+
+        /**
+         * Reads all chords inside an element.
+         * 
+         * @param elem XML element to search
+         * @param[out] chords vector to append chord attribute-value pairs to
+         */
+        void read_chords(const xercesc::DOMElement* elem, 
+            std::vector<TagValueMap>& chords) const;
+
+        /**
+         * Converts parsed XML using the given printer. Printer functions
+         * are called qualified with `P` and therefore bound statically.
+         * 
+         * @tparam P printer type (`VirtualPrinter` for virtual calls)
+         * @param target_printer printer used for conversion
+         * @return converted songbook
+         */
+        template <typename P> std::string convert_with(const P& target_printer);
+
         /**
          * Converts a `<song>` element into a `Song` object
          * 
+         * @param target_printer printer used for conversion
          * @param song_n `<song>` XML element
          * @return converted song
          * @throws SongbookException when a song's `dateAdded` is older than `convert_added_since`
          */
-        Song convert_song(const xercesc::DOMNode* song_n) const;
+        template <typename P> 
+        Song convert_song(const P& target_printer, const xercesc::DOMNode* song_n) const;
 
         /**
          * Converts content of (a part of) a song. Starts with the given XML 
          * element and continues with all its subsequent siblings. Typically, it
          * will be called recursively, not directly though.
          * 
+         * @param target_printer printer used for conversion
          * @param content song content element to start from
+         * @param song_transp transposition of the song
+         * @param line_buffer buffer reused for all lines of the song
          * @return converted song content
          */
-        std::string convert_song_content(const xercesc::DOMElement* content) const;
+        template <typename P> 
+        std::string convert_song_content(const P& target_printer, 
+            const xercesc::DOMElement* content, const Transposition& song_transp,
+            LineBuffer& line_buffer) const;
 
         /**
          * Converts the `<multicols>` XML element.
+         * @param target_printer printer used for conversion
          * @param multicols `<multicols>` XML element
+         * @param song_transp transposition of the song
+         * @param line_buffer buffer reused for all lines of the song
          * @return converted song content
          */
-        std::string convert_multicols(const xercesc::DOMElement* multicols) const;
+        template <typename P> 
+        std::string convert_multicols(const P& target_printer, 
+            const xercesc::DOMElement* multicols, const Transposition& song_transp,
+            LineBuffer& line_buffer) const;
 
         /**
          * Converts a verse XML element (`<verse>` or 
          * `<chorus>`).
          * 
+         * @param target_printer printer used for conversion
          * @param verse verse XML element
          * @param type verse type (verse or chorus)
+         * @param song_transp transposition of the song
+         * @param line_buffer buffer reused for all lines of the song
          * @return converted verse
          */
-        std::string convert_verse(const xercesc::DOMElement* verse, VerseType type) const;
+        template <typename P> 
+        std::string convert_verse(const P& target_printer, 
+            const xercesc::DOMElement* verse, VerseType type, 
+            const Transposition& song_transp, LineBuffer& line_buffer) const;
             
         /**
-         * Converts a `<line>` XML element.
+         * Converts a `<line>` XML element. Lyrics and printed chords are 
+         * kept in `line_buffer` until the line is printed, so no memory is 
+         * allocated for them once the buffer has grown.
+         * 
+         * @param target_printer printer used for conversion
          * @param line `<line>` XML element
-         * @return converted line element
+         * @param song_transp transposition of the song
+         * @param line_buffer buffer reused for all lines of the song
+         * @param output string to append the converted line to
          */
-        std::string convert_line(const xercesc::DOMElement* line) const;
+        template <typename P> 
+        void convert_line(const P& target_printer, 
+            const xercesc::DOMElement* line, const Transposition& song_transp,
+            LineBuffer& line_buffer, std::string& output) const;
 
         // data members
         private:
-        /**
-         * XML parser.
-         */
-        std::unique_ptr<SongbookParser> parser;
-
         /**
          * Printer used for creating the final document.
          */
         std::unique_ptr<SongbookPrinter> printer;
 
-        /**
-         * Should songs be sorted by name?
-         */
-        int sort_songs_by = SortSongsBy::name;
-
-        /**
-         * Oldest addition date for a song to be converted
-         */
-        std::string convert_added_since = "0001-01-01";
     };
 
 
@@ -244,6 +514,34 @@ namespace songbook {
      */
     std::string get_text_value(const xercesc::DOMNode* node);
 
+    /**
+     * Appends text content of an XML node to a string, without newlines
+     * (like `get_text_value()`, but without temporary strings).
+     * 
+     * Appends nothing if `node` is not a `DOMNode::NodeType::TEXT_NODE`.
+     * 
+     * @param node XML node
+     * @param output string to append the node text content to
+     */
+    void append_text_value(const xercesc::DOMNode* node, std::string& output);
+
+    /**
+     * Checks an XML node name without transcoding it.
+     * 
+     * @param node XML node
+     * @param name ASCII name
+     * @return `true` when the node is named `name`
+     */
+    bool node_name_is(const xercesc::DOMNode* node, std::string_view name);
+
+    /**
+     * Returns the number of bytes of UTF-8 text produced from XML text and
+     * attribute values so far (by all converters).
+     * 
+     * @return transcoded bytes
+     */
+    std::uint64_t transcoded_bytes();
+
     /**
      * Retrieves text content from XML element's first child node.
      * 
@@ -325,6 +623,227 @@ namespace songbook {
 
         return converter;
     }
+
+    template <typename T>
+    std::string SongbookConverter::convert_static() {
+        return convert_with(static_cast<const T&>(*printer));
+    }
+
+    template <typename P>
+    std::string SongbookConverter::convert_with(const P& target_printer) {
+
+        PhaseTimer convert_timer{stats, "convert"};
+        std::uint64_t transcoded_start = transcoded_bytes();
+
+        xercesc::DOMElement* root = parser->getDocument()->getDocumentElement();
+        xercesc::DOMElement* elem = root->getFirstElementChild();
+
+        // process settings when present
+        if (get_node_name(elem) == "settings") {
+            process_settings(elem);
+            // proceed to the `<songs>` element
+            elem = elem->getNextElementSibling();
+        }
+
+        // for storing converted songs
+        std::vector<Song> songs;
+        if (elem) {
+            size_t total = elem->getChildElementCount();
+            size_t done = 0;
+            // proceed to the first `<song>` element
+            elem = elem->getFirstElementChild();
+
+            // per-song allocations only when they are counted
+            bool count_allocations = stats && allocation_accounting_enabled();
+            ConversionTrace* trace = stats ? stats->get_trace() : nullptr;
+
+            while (elem) {
+                std::uint64_t song_start = count_allocations ? allocation_counts().allocations : 0;
+                try {
+                    TraceSpan span{trace, "song"};
+                    songs.push_back(convert_song(target_printer, elem));
+                    span.set_song(songs.back().get_name());
+                } catch (const SongbookException&) {};
+                if (count_allocations) {
+                    std::uint64_t song_allocations = allocation_counts().allocations - song_start;
+                    stats->add("song allocations", song_allocations);
+                    stats->add_max("song allocations max", song_allocations);
+                }
+                if (progress_handler && !progress_handler(++done, total))
+                    throw ConversionCancelled();
+                elem = elem->getNextElementSibling();
+            }
+        }
+
+        if (stats) {
+            convert_timer.stop();
+            stats->add("songs", songs.size());
+            stats->add("bytes transcoded", transcoded_bytes() - transcoded_start);
+        }
+
+        if (sort_songs_by != SortSongsBy::none) {
+            PhaseTimer timer{stats, "sort"};
+            // songs with equal names keep their order (as with the
+            //   external sort of MultiSongbookConverter)
+            std::stable_sort(begin(songs), end(songs));
+        }
+
+        PhaseTimer timer{stats, "document"};
+        return target_printer.P::print_document(songs);
+    }
+
+    template <typename P>
+    Song SongbookConverter::convert_song(const P& target_printer, 
+        const xercesc::DOMNode* song_n) const {
+
+        auto* song_e = dynamic_cast<const xercesc::DOMElement*>(song_n);
+
+        // process header
+        xercesc::DOMElement* header_e = song_e->getFirstElementChild();
+        TagValueMultiMap header_tags = read_song_header(header_e);
+
+        // abort song processing when it was added before `convert_added_since`
+        auto search = header_tags.find("dateAdded");  // must be present
+        std::string date_added = search->second;
+        if (date_added < convert_added_since) {
+            if (stats)
+                stats->add("songs skipped");
+            throw SongbookException("song added before convertAddedSince");
+        }
+
+        // song's own transposition is added to the global one
+        int semitones = transposition;
+        search = header_tags.find("transpose");
+        if (search != header_tags.end()) {
+            semitones += parse_semitones(search->second);
+            header_tags.erase(search);
+        }
+        Transposition song_transp;
+        if (semitones % 12 != 0) {
+            std::vector<TagValueMap> chords;
+            read_chords(song_e, chords);
+            song_transp = song_transposition(semitones, chords);
+        }
+
+        // convert song content
+        xercesc::DOMElement* elem = header_e->getNextElementSibling();
+        LineBuffer line_buffer;
+        std::string content = convert_song_content(target_printer, elem, song_transp, 
+            line_buffer);
+
+        std::string song = target_printer.P::print_song(header_tags, content);
+
+        std::string sorting_name;
+        if (sort_songs_by == SortSongsBy::dateAdded)
+            sorting_name = date_added;
+        else {
+            search = header_tags.find("sortingName");
+            if (search != header_tags.end())
+                sorting_name = search->second;
+        }
+
+        // name must be present
+        search = header_tags.find("name");
+
+        return Song{
+            search->second,
+            std::move(sorting_name),
+            std::move(song)};
+    }
+
+    template <typename P>
+    std::string SongbookConverter::convert_song_content(const P& target_printer, 
+        const xercesc::DOMElement* content, const Transposition& song_transp,
+        LineBuffer& line_buffer) const {
+
+        std::string result;
+
+        // the given element and all its subsequent siblings
+        while (content) {
+            // lines are the most frequent and are appended directly
+            if (node_name_is(content, "line")) {
+                convert_line(target_printer, content, song_transp, line_buffer, result);
+            } else if (node_name_is(content, "multicols")) {
+                result.append(convert_multicols(target_printer, content, song_transp, 
+                    line_buffer));
+            } else if (node_name_is(content, "columnbreak")) {
+                result.append(target_printer.P::print_columnbreak());
+            } else {     // <verse> or <chorus>
+                result.append(convert_verse(target_printer, content, 
+                    node_name_is(content, "verse") ? VerseType::verse : VerseType::chorus, 
+                    song_transp, line_buffer)); 
+            }
+
+            content = content->getNextElementSibling();
+        }
+
+        return result;
+    }
+
+    template <typename P>
+    std::string SongbookConverter::convert_multicols(const P& target_printer, 
+        const xercesc::DOMElement* multicols, const Transposition& song_transp,
+        LineBuffer& line_buffer) const {
+    
+        std::string number = get_attr_value(multicols, "number");
+
+        // start multicols, add content, end multicols
+        std::string result = target_printer.P::print_multicols_start(number);
+        result.append(convert_song_content(target_printer, 
+            multicols->getFirstElementChild(), song_transp, line_buffer));
+        result.append(target_printer.P::print_multicols_end());
+        return result;
+    }
+
+    template <typename P>
+    std::string SongbookConverter::convert_verse(const P& target_printer, 
+        const xercesc::DOMElement* verse, VerseType type, 
+        const Transposition& song_transp, LineBuffer& line_buffer) const {
+    
+        // start verse, add content, end verse
+        std::string result = target_printer.P::print_verse_start(type);
+        result.append(convert_song_content(target_printer, 
+            verse->getFirstElementChild(), song_transp, line_buffer));
+        result.append(target_printer.P::print_verse_end(type));
+        return result;
+    }
+
+    template <typename P>
+    void SongbookConverter::convert_line(const P& target_printer, 
+        const xercesc::DOMElement* line, const Transposition& song_transp,
+        LineBuffer& line_buffer, std::string& output) const {
+
+        xercesc::DOMNode* node = line->getFirstChild();
+
+        line_buffer.clear();
+
+        // first use `printer` to create string representations of all elements
+        while (node) {
+            xercesc::DOMNode::NodeType type = node->getNodeType();
+            if (type == xercesc::DOMNode::NodeType::TEXT_NODE) {            // lyrics
+                std::string& lyrics = line_buffer.scratch();
+                append_text_value(node, lyrics);
+                // don't include empty lyrics -- might emerge from newline-only
+                //   lyrics nodes after newline removal
+                if (!lyrics.empty())
+                    line_buffer.add(LineItemType::lyrics, lyrics);
+            } else if (type == xercesc::DOMNode::NodeType::ELEMENT_NODE) {  // chord
+                TagValueMap chord = read_chord(node);
+                transpose_chord(chord, song_transp);
+                if (stats)
+                    stats->add("chords");
+                std::string& printed = line_buffer.scratch();
+                target_printer.P::append_chord(chord, printed);
+                line_buffer.add(LineItemType::chord, printed);
+            }
+            node = node->getNextSibling();
+        }
+
+        // now print the final line
+        target_printer.P::append_line(line_buffer.items(), output);
+        if (stats)
+            stats->add("lines");
+    }
 }
 
 #endif  // SONGBOOK_SONGBOOKCONVERTER_HPP
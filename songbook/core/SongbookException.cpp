@@ -16,4 +16,7 @@ namespace songbook {
         const std::string& msg): 
         SongbookException(title, msg.c_str()) {}
 
+    ConversionCancelled::ConversionCancelled(): 
+        SongbookException("Conversion cancelled") {}
+
 }
\ No newline at end of file
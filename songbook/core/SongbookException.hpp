@@ -40,6 +40,17 @@ namespace songbook {
          */
         SongbookException(const std::string& title, const std::string& msg); 
     };
+
+    /**
+     * Exception signalling that conversion was cancelled.
+     */
+    class ConversionCancelled: public SongbookException {
+        public:
+        /**
+         * Constructor.
+         */
+        ConversionCancelled();
+    };
 }
 
 #endif  // SONGBOOK_SONGBOOKEXCEPTION_HPP
\ No newline at end of file
@@ -97,17 +97,25 @@ namespace songbook {
     }
 
     std::string SongbookPrinter::print_line(const std::vector<LineItem>& line_content) const {
-        
         std::string line;
+        append_line(line_content, line);
+        return line;
+    }
+
+    void SongbookPrinter::append_line(const std::vector<LineItem>& line_content, 
+        std::string& output) const {
 
         for (const auto& lc : line_content) {
             if (lc.type==LineItemType::lyrics) 
-                line.append(lc.value);
-            else  // chord
-                line.append("[" + lc.value + "]"); 
+                output.append(lc.value);
+            else {  // chord
+                output += '[';
+                output.append(lc.value);
+                output += ']';
+            }
         }
         
-        return line.append("\n");
+        output += '\n';
     }
 
     std::string SongbookPrinter::print_document(const std::vector<Song> &songs) const {
@@ -122,6 +130,10 @@ namespace songbook {
         return result;
     }
 
+    bool SongbookPrinter::prints_songs_separately() const {
+        return true;
+    }
+
     std::string SongbookPrinter::print_song(const TagValueMultiMap& header_tags, 
         const std::string& content) const {
 
@@ -133,22 +145,31 @@ namespace songbook {
     }
 
     std::string SongbookPrinter::print_chord(const TagValueMap& chord) const {
+        std::string result;
+        append_chord(chord, result);
+        return result;
+    }
 
-        auto attr = chord.find("root");
-        std::string result{attr->second};
+    void SongbookPrinter::append_chord(const TagValueMap& chord, std::string& output) const {
+
+        auto attr = chord.find("optional");
+        bool optional = attr != chord.end() && attr->second == "yes";
+        if (optional)
+            output += '(';
+
+        output.append(chord.find("root")->second);
 
         attr = chord.find("type");
         if (attr != chord.end())
-            result.append(attr->second);
+            output.append(attr->second);
 
         attr = chord.find("bass");
-        if (attr != chord.end())
-            result.append("/" + attr->second);
+        if (attr != chord.end()) {
+            output += '/';
+            output.append(attr->second);
+        }
 
-        attr = chord.find("optional");
-        if (attr != chord.end() && attr->second == "yes")
-            result = "(" + result + ")";
-        
-        return result;
+        if (optional)
+            output += ')';
     }
 }
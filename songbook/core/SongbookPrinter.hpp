@@ -126,20 +126,42 @@ namespace songbook {
         virtual std::string print_song_end() const;
 
         /**
-         * Prints one chord.
+         * Prints one chord (using `append_chord()`).
          * 
          * @param chord chord attributes' name-value pairs
-         * @return simple string representation of a chord
+         * @return string representation of a chord
          */
-        virtual std::string print_chord(const TagValueMap& chord) const;
+        std::string print_chord(const TagValueMap& chord) const;
 
         /**
-         * Prints the whole line.
+         * Prints one chord at the end of a string. Converters call this 
+         * rather than `print_chord()` so that the string's memory can be 
+         * reused for all chords.
+         * 
+         * @param chord chord attributes' name-value pairs
+         * @param output string to append the simple string representation 
+         * of the chord to
+         */
+        virtual void append_chord(const TagValueMap& chord, std::string& output) const;
+
+        /**
+         * Prints the whole line (using `append_line()`).
+         * 
+         * @param line_content line items
+         * @return printed line
+         */
+        std::string print_line(const std::vector<LineItem>& line_content) const;
+
+        /**
+         * Prints the whole line at the end of a string, typically the song 
+         * content printed so far.
          * 
          * @param line_content line items
-         * @return song line witch chords in brackets
+         * @param output string to append the song line witch chords in 
+         * brackets to
          */
-        virtual std::string print_line(const std::vector<LineItem>& line_content) const;
+        virtual void append_line(const std::vector<LineItem>& line_content, 
+            std::string& output) const;
 
         /**
          * Prints the whole song.
@@ -159,6 +181,14 @@ namespace songbook {
          */
         virtual std::string print_document(const std::vector<Song>& songs) const;
 
+        /**
+         * Is the document just document start, songs and document end, so
+         * that it can be written song by song without `print_document()`?
+         * 
+         * @return `true`
+         */
+        virtual bool prints_songs_separately() const;
+
         // ----- data members -----
         protected:
         /**
@@ -1,5 +1,7 @@
 #include "SongbookPrinterLatex.hpp"
 
+#include <algorithm>
+
 namespace songbook {
 
     SongbookPrinterLatex::SongbookPrinterLatex() {
@@ -30,13 +32,42 @@ namespace songbook {
         for (const auto& [name, value]: parameters)
             replace_parameter(doc_start, name, value);
 
-        return doc_start;
+        return print_format_preamble() + doc_start;
+    }
+
+    std::string SongbookPrinterLatex::print_format_preamble() const {
+        return latex_format_preamble;
     }
 
     std::string SongbookPrinterLatex::print_document_end() const {
         return "\n\\end{document}";
     }
 
+    LatexUnits SongbookPrinterLatex::print_document_units(const std::vector<Song>& songs, 
+        size_t unit_songs, const std::string& unit_prefix) const {
+
+        LatexUnits result;
+        result.main = print_document_start();
+
+        // numbers are padded so that unit files are listed in order
+        size_t n_units = (songs.size() + unit_songs - 1) / unit_songs;
+        size_t width = std::max<size_t>(3, std::to_string(n_units).size());
+        for (size_t i = 0; i < n_units; ++i) {
+            std::string number = std::to_string(i + 1);
+            std::string name = unit_prefix + '-' + std::string(width - number.size(), '0') + number;
+
+            std::string content;
+            for (size_t j = i * unit_songs; j < std::min(songs.size(), (i + 1) * unit_songs); ++j)
+                content.append(songs[j].get_content());
+
+            result.main.append("\n\\include{" + name + "}");
+            result.units.emplace_back(std::move(name), std::move(content));
+        }
+
+        result.main.append(print_document_end());
+        return result;
+    }
+
     std::string SongbookPrinterLatex::print_multicols_start(const std::string& number) const {
         return "\\begin{multicols}{" + number + "}\\raggedcolumns\n";
     }
@@ -81,66 +112,84 @@ namespace songbook {
         return header;
     }
 
-    std::string SongbookPrinterLatex::print_line(const std::vector<LineItem>& line_content) const {
+    void SongbookPrinterLatex::append_line(const std::vector<LineItem>& line_content, 
+        std::string& output) const {
 
-        std::string line = "\\sbline{";
-        std::string chords;
+        output.append("\\sbline{");
         int n_lyrics{0};
 
         // count the number of lyrics items to know later whether a lyrics item 
         //   is the last one
-        for (auto lc: line_content) 
+        for (const auto& lc: line_content) 
             if (lc.type==LineItemType::lyrics) 
                 ++n_lyrics;
 
+        // previously read chord(s) are items [chords_start, chords_end)
+        size_t chords_start{0};
+        size_t chords_end{0};
+        auto append_chords = [&]() {
+            for (size_t i = chords_start; i < chords_end; ++i)
+                output.append(line_content[i].value);
+        };
+
         int i_lyrics{0};
-        for (const auto& lc : line_content) {
+        for (size_t i = 0; i < line_content.size(); ++i) {
+            const auto& lc = line_content[i];
             if (lc.type==LineItemType::lyrics) {
                 ++i_lyrics;
                 // put together with previously read chord(s)
-                if (!chords.empty()) {  
-                    line.append("\\chordslyrics");
+                if (chords_end > chords_start) {  
+                    output.append("\\chordslyrics");
                     // use "\chordslyricshyphen" when the current lyrics aren't
                     //   the last on this line and don't end with a space
                     if (i_lyrics < n_lyrics && lc.value.back() != ' ')
-                        line.append("hyphen");
-                    line.append("{" + chords + "}{" + lc.value + "}");
-                    chords = "";
+                        output.append("hyphen");
+                    output += '{';
+                    append_chords();
+                    output.append("}{");
+                    output.append(lc.value);
+                    output += '}';
                 // just lyrics
                 } else               
-                    line.append(lc.value);
+                    output.append(lc.value);
+                chords_start = chords_end = i + 1;
             } else  // LineItemType::chord
-                chords.append(lc.value); 
+                chords_end = i + 1; 
         }
 
         // when trailing chords (without associated lyrics) are present
-        if (!chords.empty())   
-            if (n_lyrics > 0)  // mixed content line
-                line.append("\\chordslyrics{" + chords + "}{}");
-            else               // chords only line
-                line.append(chords);
+        if (chords_end > chords_start) {
+            if (n_lyrics > 0) {  // mixed content line
+                output.append("\\chordslyrics{");
+                append_chords();
+                output.append("}{}");
+            } else               // chords only line
+                append_chords();
+        }
         
-        return line.append("}\n");
+        output.append("}\n");
     }
 
-    std::string SongbookPrinterLatex::print_chord(const TagValueMap& chord) const {
+    void SongbookPrinterLatex::append_chord(const TagValueMap& chord, 
+        std::string& output) const {
+
+        auto attr = chord.find("optional");
+        bool optional = attr != chord.end() && attr->second == "yes";
+        output.append(optional ? "\\chord{(" : "\\chord{");
 
-        auto attr = chord.find("root");
-        std::string result = replace_flat_sharp_latex(attr->second);
+        append_flat_sharp_latex(chord.find("root")->second, output);
 
         attr = chord.find("type");
         if (attr != chord.end())
-            result.append(attr->second);
+            output.append(attr->second);
 
         attr = chord.find("bass");
-        if (attr != chord.end())
-            result.append("/" + replace_flat_sharp_latex(attr->second));
-
-        attr = chord.find("optional");
-        if (attr != chord.end() && attr->second == "yes")
-            result = "(" + result + ")";
+        if (attr != chord.end()) {
+            output += '/';
+            append_flat_sharp_latex(attr->second, output);
+        }
         
-        return "\\chord{" + result +"}";
+        output.append(optional ? ")}" : "}");
     }
 
     bool replace_parameter(std::string& str, const std::string& name, 
@@ -156,17 +205,27 @@ namespace songbook {
     }
 
     std::string replace_flat_sharp_latex(std::string note) {
+        std::string result;
+        append_flat_sharp_latex(note, result);
+        return result;
+    }
+
+    void append_flat_sharp_latex(std::string_view note, std::string& output) {
         // replace sharp
         auto pos = note.find('#');
-        if (pos != std::string::npos)
-            note.replace(pos, 1, "\\msharp ");
-        else {
+        std::string_view replacement{"\\msharp "};
+        if (pos == std::string_view::npos) {
             // replace flat
             pos = note.find('b', 1);
-            if (pos != std::string::npos)
-                note.replace(pos, 1, "$\\flat$");
+            replacement = "$\\flat$";
         }
-        
-        return note;
+        if (pos == std::string_view::npos) {
+            output.append(note);
+            return;
+        }
+
+        output.append(note.substr(0, pos));
+        output.append(replacement);
+        output.append(note.substr(pos + 1));
     }
 }
\ No newline at end of file
@@ -3,10 +3,24 @@
 
 #include "SongbookPrinter.hpp"
 
+#include <string_view>
+#include <utility>
+#include <vector>
+
 namespace songbook {
 
+    extern std::string latex_format_preamble;
     extern std::string latex_document_start;
 
+    /**
+     * A LaTeX document whose songs are in separate files included by
+     * `\include` (see `SongbookPrinterLatex::print_document_units()`).
+     */
+    struct LatexUnits {
+        std::string main;   /**< main document with an `\include` per unit */
+        std::vector<std::pair<std::string, std::string>> units;  /**< unit names and contents */
+    };
+
     /**
      * A `SongbookPrinter` which supplies methods for printing a LaTeX document
      */
@@ -25,6 +39,18 @@ namespace songbook {
          */
         std::string print_document_start() const override;
 
+        /**
+         * Prints the static, parameter-independent part of the LaTeX 
+         * preamble which is also included at the beginning of 
+         * `print_document_start()`. 
+         * 
+         * It ends with `\endofdump` so that it can be dumped into a 
+         * precompiled format (see `LatexBuilder`).
+         * 
+         * @return static part of the LaTeX preamble
+         */
+        std::string print_format_preamble() const;
+
         /**
          * @copybrief SongbookPrinter::print_document_end()
          * 
@@ -32,6 +58,24 @@ namespace songbook {
          */
         std::string print_document_end() const override;
 
+        /**
+         * Prints the whole document with songs grouped into units of
+         * consecutive songs, each of them included by `\include` from its
+         * own file. The document is typeset the same way as by 
+         * `print_document()` (each song starts on a new page), but single
+         * units can be compiled by `\includeonly` (see 
+         * `LatexBuilder::run_units()`).
+         * 
+         * @param songs individual already converted songs
+         * @param unit_songs number of songs in a unit
+         * @param unit_prefix prefix of unit names, which are `<prefix>-<n>`
+         * (file names without `.tex` relative to the directory where XeLaTeX
+         * runs)
+         * @return main document and units
+         */
+        LatexUnits print_document_units(const std::vector<Song>& songs, size_t unit_songs,
+            const std::string& unit_prefix) const;
+
         /**
          * @copybrief SongbookPrinter::print_multicols_start()
          * 
@@ -79,23 +123,25 @@ namespace songbook {
         std::string print_song_header(const TagValueMultiMap& tag_values) const override;
 
         /**
-         * @copybrief SongbookPrinter::print_line()
+         * @copybrief SongbookPrinter::append_line()
          * 
          * Combines line items into a line using the `\chordslyrics`
          * and `\chordslyricshyphen` LaTeX commands where appropriate.
          * 
          * @param line_content line items
-         * @return complete `\sbline` command for one line
+         * @param output string to append the complete `\sbline` command 
+         * for one line to
          */
-        std::string print_line(const std::vector<LineItem>& line_content) const override; 
+        void append_line(const std::vector<LineItem>& line_content, 
+            std::string& output) const override; 
 
         /**
-         * @copybrief SongbookPrinter::print_chord()
+         * @copybrief SongbookPrinter::append_chord()
          * 
          * @param chord chord attributes' name-value pairs
-         * @return `\chord` command for one chord
+         * @param output string to append the `\chord` command for one chord to
          */
-        std::string print_chord(const TagValueMap& chord) const override;
+        void append_chord(const TagValueMap& chord, std::string& output) const override;
     };
 
 
@@ -121,6 +167,15 @@ namespace songbook {
      * @return note with LaTeX sharp or flat
      */
     std::string replace_flat_sharp_latex(std::string note);
+
+    /**
+     * Appends a note with a sharp (#) or a flat (b) musical notation 
+     * replaced by its LaTeX representation (see `replace_flat_sharp_latex()`).
+     * 
+     * @param note musical note
+     * @param output string to append the note with LaTeX sharp or flat to
+     */
+    void append_flat_sharp_latex(std::string_view note, std::string& output);
 }
 
 #endif  // SONGBOOK_SONGBOOKPRINTERLATEX_HPP
@@ -0,0 +1,914 @@
+#include "SongbookPrinterPdf.hpp"
+#include "SongbookException.hpp"
+#include "TrueTypeFont.hpp"
+#include "PdfWriter.hpp"
+#include "textUtils.hpp"
+
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <filesystem>
+
+namespace songbook {
+
+    namespace {
+
+        // separators used in the intermediate representation; control 
+        //   characters cannot appear in XML text so they can't clash with content
+        const char record_end = '\x1e';
+        const char field_sep = '\x1f';
+
+        // page geometry in points, matching the LaTeX `geometry` settings
+        constexpr double page_height = 841.89;   // A4
+        constexpr double page_width = 595.28;
+        constexpr double margin_left = 42.52;    // (21 cm - 18 cm) / 2
+        constexpr double margin_top = 42.52;     // 1.5 cm
+        constexpr double text_width = 510.24;    // 18 cm
+        constexpr double text_height = 751.18;   // 26.5 cm
+        constexpr double footer_skip = 30;
+
+        constexpr double font_size = 10;
+        constexpr double title_size = 17.28;     // \LARGE
+        constexpr double baseline_skip = 12;
+        constexpr double baseline = 0.8 * baseline_skip;  // baseline position in a row
+        constexpr double column_sep = 28.35;     // 1 cm
+        constexpr double chord_skip = 0.4 * font_size;    // space after a chord
+
+        /**
+         * Splits a string by a separator.
+         */
+        std::vector<std::string> split(const std::string& str, char sep) {
+            std::vector<std::string> parts;
+            std::size_t start = 0;
+            std::size_t pos;
+            while ((pos = str.find(sep, start)) != std::string::npos) {
+                parts.push_back(str.substr(start, pos - start));
+                start = pos + 1;
+            }
+            parts.push_back(str.substr(start));
+
+            return parts;
+        }
+
+        /**
+         * A font embedded in the PDF which keeps track of glyphs it was used 
+         * for.
+         */
+        class PdfFont {
+
+            public:
+            PdfFont(const std::string& file, std::string resource): 
+                font(file), resource(std::move(resource)) {}
+
+            const std::string& get_resource() const {
+                return resource;
+            }
+
+            /**
+             * Width of UTF-8 text in points.
+             */
+            double width(const std::string& text, double size) const {
+                long units = 0;
+                for (char32_t c: utf8_to_utf32(text))
+                    units += font.get_advance(glyph(c));
+
+                return units * size / font.units_per_em;
+            }
+
+            /**
+             * Encodes UTF-8 text as a hexadecimal string of glyph indices.
+             */
+            std::string encode(const std::string& text) {
+                const char* digits = "0123456789ABCDEF";
+                std::string hex{"<"};
+                for (char32_t c: utf8_to_utf32(text)) {
+                    std::uint16_t g = glyph(c);
+                    used.emplace(g, c);
+                    for (int shift = 12; shift >= 0; shift -= 4)
+                        hex += digits[(g >> shift) & 0xf];
+                }
+                hex += '>';
+
+                return hex;
+            }
+
+            /**
+             * Writes the font as a Type0 font with Identity-H encoding.
+             */
+            void write(PdfWriter& writer, int id) const {
+                const std::string& name = font.get_postscript_name();
+                double scale = 1000.0 / font.units_per_em;
+
+                int file_id;
+                if (font.has_cff_outlines())
+                    file_id = writer.add_stream("/Subtype /OpenType", font.get_data());
+                else
+                    file_id = writer.add_stream("/Length1 " + 
+                        std::to_string(font.get_data().size()), font.get_data());
+
+                std::string descriptor{"<< /Type /FontDescriptor /FontName /" + name + 
+                    " /Flags 32 /FontBBox ["};
+                for (int b: font.bbox)
+                    descriptor.append(" " + pdf_number(b * scale));
+                descriptor.append(" ] /ItalicAngle " + pdf_number(font.italic_angle) + 
+                    " /Ascent " + pdf_number(font.ascent * scale) + 
+                    " /Descent " + pdf_number(font.descent * scale) + 
+                    " /CapHeight " + pdf_number(font.cap_height * scale) + 
+                    " /StemV 80 " + (font.has_cff_outlines() ? "/FontFile3 " : "/FontFile2 ") + 
+                    std::to_string(file_id) + " 0 R >>");
+                int descriptor_id = writer.add_object(descriptor);
+
+                std::string widths{"["};
+                for (const auto& [g, c]: used)
+                    widths.append(" " + std::to_string(g) + " [" + 
+                        pdf_number(font.get_advance(g) * scale) + "]");
+                widths.append(" ]");
+
+                int cid_id = writer.add_object("<< /Type /Font /Subtype /" + 
+                    std::string{font.has_cff_outlines() ? "CIDFontType0" : "CIDFontType2"} +
+                    " /BaseFont /" + name + 
+                    " /CIDSystemInfo << /Registry (Adobe) /Ordering (Identity) /Supplement 0 >>" +
+                    " /FontDescriptor " + std::to_string(descriptor_id) + " 0 R" + 
+                    " /W " + widths + 
+                    (font.has_cff_outlines() ? "" : " /CIDToGIDMap /Identity") + " >>");
+
+                int to_unicode_id = writer.add_stream("", to_unicode_cmap());
+
+                writer.set_object(id, "<< /Type /Font /Subtype /Type0 /BaseFont /" + name + 
+                    " /Encoding /Identity-H /DescendantFonts [" + std::to_string(cid_id) + 
+                    " 0 R] /ToUnicode " + std::to_string(to_unicode_id) + " 0 R >>");
+            }
+
+            private:
+            /**
+             * Glyph for a character; spaces missing in the font are replaced 
+             * by an ordinary space.
+             */
+            std::uint16_t glyph(char32_t c) const {
+                std::uint16_t g = font.get_glyph(c);
+                if (g == 0 && (c == 0xa0 || (c >= 0x2000 && c <= 0x200b) || c == 0x202f))
+                    g = font.get_glyph(' ');
+
+                return g;
+            }
+
+            /**
+             * Creates a CMap mapping used glyphs back to Unicode so that text 
+             * can be searched and copied from the PDF.
+             */
+            std::string to_unicode_cmap() const {
+                const char* digits = "0123456789ABCDEF";
+                auto hex16 = [digits](std::string& str, unsigned v) {
+                    for (int shift = 12; shift >= 0; shift -= 4)
+                        str += digits[(v >> shift) & 0xf];
+                };
+
+                std::string cmap{"/CIDInit /ProcSet findresource begin\n"
+                    "12 dict begin\nbegincmap\n"
+                    "/CIDSystemInfo << /Registry (Adobe) /Ordering (UCS) /Supplement 0 >> def\n"
+                    "/CMapName /Adobe-Identity-UCS def\n/CMapType 2 def\n"
+                    "1 begincodespacerange\n<0000> <FFFF>\nendcodespacerange\n"};
+
+                // at most 100 entries are allowed in one block
+                auto it = used.begin();
+                while (it != used.end()) {
+                    std::size_t n = std::min<std::size_t>(100, std::distance(it, used.end()));
+                    cmap.append(std::to_string(n) + " beginbfchar\n");
+                    for (std::size_t i = 0; i < n; ++i, ++it) {
+                        cmap += '<';
+                        hex16(cmap, it->first);
+                        cmap.append("> <");
+                        char32_t c = it->second;
+                        if (c < 0x10000)
+                            hex16(cmap, c);
+                        else {  // UTF-16 surrogate pair
+                            c -= 0x10000;
+                            hex16(cmap, 0xd800 + (c >> 10));
+                            hex16(cmap, 0xdc00 + (c & 0x3ff));
+                        }
+                        cmap.append(">\n");
+                    }
+                    cmap.append("endbfchar\n");
+                }
+
+                cmap.append("endcmap\nCMapName currentdict /CMap defineresource pop\nend\nend\n");
+
+                return cmap;
+            }
+
+            TrueTypeFont font;
+            std::string resource;
+            std::map<std::uint16_t, char32_t> used;
+        };
+
+        /**
+         * Text placed in a row (or on a page once the row is placed).
+         */
+        struct TextRun {
+            double x;          // left edge
+            double y;          // baseline, measured from the top
+            PdfFont* font;
+            double size;
+            std::string text;
+        };
+
+        /**
+         * Horizontal rule.
+         */
+        struct Rule {
+            double x;
+            double y;          // top edge, measured from the top
+            double width;
+            double thickness;
+        };
+
+        /**
+         * A piece of content of fixed height which cannot be split between
+         * columns or pages.
+         */
+        struct Row {
+            enum Kind {content, space, columnbreak};
+            Kind kind = content;
+            double height = 0;
+            std::vector<TextRun> runs;
+            std::vector<Rule> rules;
+            int toc_entry = -1;  // index of a song whose page number ends this row
+        };
+
+        struct Page {
+            std::vector<TextRun> runs;
+            std::vector<Rule> rules;
+        };
+
+        /**
+         * Chords and the lyrics they are placed above.
+         */
+        struct LineUnit {
+            std::string chords;   // chords separated by `field_sep`
+            std::string lyrics;
+            bool hyphen = false;  // may a hyphen be needed after lyrics?
+        };
+
+        /**
+         * Lays out songs and the table of contents into pages.
+         */
+        class PdfLayout {
+
+            public:
+            PdfLayout(PdfFont& main_font, PdfFont& chord_font, std::string chorus_label):
+                main_font(main_font), chord_font(chord_font), 
+                chorus_label(std::move(chorus_label)) {
+
+                chorus_indent = main_font.width(this->chorus_label, font_size) + font_size;
+            }
+
+            /**
+             * Lays out one song starting on a new page.
+             * 
+             * @return index of the song's first page
+             */
+            int add_song(const std::string& content) {
+                new_page();
+                int first_page = static_cast<int>(pages.size()) - 1;
+
+                int columns = 1;
+                bool chorus = false;
+                bool label_pending = false;
+                std::vector<Row> block;   // rows of the current multicols
+
+                auto emit = [&](Row row) {
+                    if (columns > 1)
+                        block.push_back(std::move(row));
+                    else
+                        place_row(row);
+                };
+                auto width = [&]() {
+                    return (text_width - (columns - 1) * column_sep) / columns;
+                };
+
+                for (const std::string& record: split(content, record_end)) {
+                    if (record.empty())
+                        continue;
+                    std::vector<std::string> fields = split(record, field_sep);
+                    char type = fields[0][0];
+
+                    if (type == 'S') {
+                        fields.resize(4);
+                        place_row(title_row(fields[1]));
+                        place_row(info_row(fields[2], fields[3]));
+                    } else if (type == 'L') {
+                        fields.erase(fields.begin());
+                        for (Row& row: line_rows(fields, width(), chorus, label_pending))
+                            emit(std::move(row));
+                        label_pending = false;
+                    } else if (type == 'C') {
+                        chorus = true;
+                        label_pending = true;
+                    } else if (type == 'E') {
+                        // empty chorus -- just the label
+                        if (label_pending) {
+                            Row row;
+                            row.height = baseline_skip;
+                            row.runs.push_back({0, baseline, &main_font, font_size, chorus_label});
+                            emit(std::move(row));
+                        }
+                        chorus = false;
+                        label_pending = false;
+                        emit(space_row(baseline_skip));
+                    } else if (type == 'M') {
+                        place_row(space_row(baseline_skip / 2));
+                        columns = std::clamp(fields.size() > 1 ? std::atoi(fields[1].c_str()) : 2, 1, 5);
+                        block.clear();
+                    } else if (type == 'B') {
+                        if (columns > 1) {
+                            Row row;
+                            row.kind = Row::columnbreak;
+                            block.push_back(std::move(row));
+                        }
+                    } else if (type == 'N') {
+                        place_columns(block, columns);
+                        block.clear();
+                        columns = 1;
+                        place_row(space_row(baseline_skip / 2));
+                    }
+                }
+                // unterminated multicols
+                if (columns > 1)
+                    place_columns(block, columns);
+
+                return first_page;
+            }
+
+            /**
+             * Lays out the table of contents on new pages.
+             * 
+             * @param names song names
+             * @param page_number returns a page number for a song index
+             */
+            void add_toc(const std::string& title, const std::vector<std::string>& names,
+                const std::function<std::string(int)>& page_number) {
+
+                new_page();
+                place_row(title_row(title));
+
+                const int columns = 3;
+                double col_width = (text_width - (columns - 1) * column_sep) / columns;
+                // space reserved for page numbers
+                double number_width = 2.55 * font_size;
+
+                std::vector<Row> rows;
+                for (int i = 0; i < static_cast<int>(names.size()); ++i) {
+                    std::vector<std::string> lines = wrap_words(names[i], main_font, 
+                        col_width - number_width);
+                    for (std::size_t j = 0; j < lines.size(); ++j) {
+                        Row row;
+                        // space between entries
+                        double before = (j == 0) ? 0.2 * baseline_skip : 0;
+                        row.height = baseline_skip + before;
+                        row.runs.push_back({0, before + baseline, &main_font, font_size, lines[j]});
+                        if (j + 1 == lines.size())
+                            row.toc_entry = i;
+                        rows.push_back(std::move(row));
+                    }
+                }
+
+                // columns are filled one after another (not balanced)
+                std::size_t i = 0;
+                while (i < rows.size()) {
+                    i += fill_columns(rows, i, columns, bottom() - y, true, 
+                        [&](TextRun& run, int entry) {
+                            std::string number = page_number(entry);
+                            run.x += col_width - main_font.width(number, font_size);
+                            run.text = number;
+                        });
+                    if (i < rows.size())
+                        new_page();
+                }
+            }
+
+            std::vector<Page> pages;
+
+            private:
+            double bottom() const {
+                return margin_top + text_height;
+            }
+
+            void new_page() {
+                pages.emplace_back();
+                y = margin_top;
+            }
+
+            bool at_page_top() const {
+                return y == margin_top;
+            }
+
+            Row space_row(double height) const {
+                Row row;
+                row.kind = Row::space;
+                row.height = height;
+                return row;
+            }
+
+            Row title_row(const std::string& title) {
+                Row row;
+                row.height = title_size + 8 + baseline_skip;
+                row.runs.push_back({0, title_size, &main_font, title_size, title});
+                row.rules.push_back({0, title_size + 6, text_width, 0.4});
+                return row;
+            }
+
+            Row info_row(const std::string& left, const std::string& right) {
+                Row row;
+                row.height = 3 * baseline_skip;
+                if (!left.empty())
+                    row.runs.push_back({0, baseline, &main_font, font_size, left});
+                if (!right.empty())
+                    row.runs.push_back({text_width - main_font.width(right, font_size), 
+                        baseline, &main_font, font_size, right});
+                return row;
+            }
+
+            /**
+             * Splits text into lines not wider than `width` (when possible).
+             */
+            static std::vector<std::string> wrap_words(const std::string& text, 
+                const PdfFont& font, double width) {
+
+                std::vector<std::string> lines{""};
+                for (const std::string& word: split(text, ' ')) {
+                    std::string candidate = lines.back().empty() ? word : lines.back() + ' ' + word;
+                    if (lines.back().empty() || font.width(candidate, font_size) <= width)
+                        lines.back() = candidate;
+                    else
+                        lines.push_back(word);
+                }
+
+                return lines;
+            }
+
+            /**
+             * Converts line items (`c`/`l`-prefixed chords/lyrics) into 
+             * units of chords and lyrics the same way `SongbookPrinterLatex`
+             * does.
+             */
+            static std::vector<LineUnit> line_units(const std::vector<std::string>& items) {
+                int n_lyrics = 0;
+                for (const std::string& item: items)
+                    if (!item.empty() && item[0] == 'l')
+                        ++n_lyrics;
+
+                std::vector<LineUnit> units;
+                std::string chords;
+                int i_lyrics = 0;
+                for (const std::string& item: items) {
+                    if (item.empty())
+                        continue;
+                    std::string value = item.substr(1);
+                    if (item[0] == 'l') {
+                        ++i_lyrics;
+                        if (!chords.empty()) {
+                            bool hyphen = i_lyrics < n_lyrics && !value.empty() && 
+                                value.back() != ' ';
+                            units.push_back({chords, value, hyphen});
+                            chords.clear();
+                        } else {
+                            // plain lyrics can be broken between words
+                            std::size_t start = 0;
+                            while (start < value.size()) {
+                                std::size_t end = value.find(' ', start);
+                                end = (end == std::string::npos) ? value.size() : end + 1;
+                                units.push_back({"", value.substr(start, end - start), false});
+                                start = end;
+                            }
+                        }
+                    } else {
+                        if (!chords.empty())
+                            chords += field_sep;
+                        chords.append(value);
+                    }
+                }
+                if (!chords.empty())
+                    units.push_back({chords, "", false});
+
+                return units;
+            }
+
+            /**
+             * Creates rows (one or more when wrapped) for one line.
+             */
+            std::vector<Row> line_rows(const std::vector<std::string>& items, double width,
+                bool chorus, bool label) {
+
+                std::vector<LineUnit> units = line_units(items);
+                bool has_lyrics = std::any_of(units.begin(), units.end(), 
+                    [](const LineUnit& u) { return !u.lyrics.empty(); });
+                double indent = chorus ? chorus_indent : 0;
+
+                std::vector<Row> rows;
+                Row row;
+                std::vector<std::size_t> lyrics_runs;  // lyrics in `row.runs`
+                bool row_chords = false;
+                double x = indent;
+                auto finish_row = [&]() {
+                    // chords above lyrics need two baselines
+                    row.height = (row_chords && has_lyrics) ? 2 * baseline_skip : baseline_skip;
+                    double lyrics_y = row.height - baseline_skip + baseline;
+                    for (std::size_t i: lyrics_runs)
+                        row.runs[i].y = lyrics_y;
+                    if (label && rows.empty())
+                        row.runs.push_back({0, lyrics_y, &main_font, font_size, chorus_label});
+                    rows.push_back(std::move(row));
+                    row = Row{};
+                    lyrics_runs.clear();
+                    row_chords = false;
+                    x = indent;
+                };
+
+                for (const LineUnit& unit: units) {
+                    std::vector<std::string> chords;
+                    if (!unit.chords.empty())
+                        chords = split(unit.chords, field_sep);
+                    double chords_width = 0;
+                    for (const std::string& chord: chords)
+                        chords_width += chord_font.width(chord, font_size) + chord_skip;
+                    double lyrics_width = main_font.width(unit.lyrics, font_size);
+                    double unit_width = std::max(chords_width, lyrics_width);
+
+                    if (x + unit_width > indent + width && x > indent)
+                        finish_row();
+
+                    // chords (placed above lyrics only when the line has lyrics)
+                    double cx = x;
+                    for (const std::string& chord: chords) {
+                        row.runs.push_back({cx, baseline, &chord_font, font_size, chord});
+                        cx += chord_font.width(chord, font_size) + chord_skip;
+                    }
+                    row_chords = row_chords || !chords.empty();
+
+                    if (!unit.lyrics.empty()) {
+                        lyrics_runs.push_back(row.runs.size());
+                        row.runs.push_back({x, 0, &main_font, font_size, unit.lyrics});
+                    }
+
+                    // a chord change inside a word wider than the preceding lyrics
+                    if (unit.hyphen && chords_width > lyrics_width) {
+                        double hyphen_width = main_font.width("-", font_size);
+                        double hx = x + lyrics_width;
+                        if (chords_width > lyrics_width + hyphen_width)
+                            hx += (chords_width - lyrics_width - hyphen_width) / 2;
+                        lyrics_runs.push_back(row.runs.size());
+                        row.runs.push_back({hx, 0, &main_font, font_size, "-"});
+                    }
+
+                    x += unit_width;
+                }
+                finish_row();
+
+                return rows;
+            }
+
+            /**
+             * Places a single-column row on the current page (or a new one).
+             */
+            void place_row(const Row& row) {
+                if (row.kind != Row::content) {
+                    // vertical space is dropped at page top
+                    if (!at_page_top())
+                        y = std::min(y + row.height, bottom());
+                    return;
+                }
+                if (y + row.height > bottom() && !at_page_top())
+                    new_page();
+                put_row(row, margin_left, y, nullptr);
+                y += row.height;
+            }
+
+            /**
+             * Copies row content onto the current page.
+             */
+            void put_row(const Row& row, double x, double top, 
+                const std::function<void(TextRun&, int)>& toc_number) {
+
+                Page& page = pages.back();
+                for (const TextRun& run: row.runs) {
+                    page.runs.push_back(run);
+                    page.runs.back().x += x;
+                    page.runs.back().y += top;
+                }
+                for (const Rule& rule: row.rules)
+                    page.rules.push_back({rule.x + x, rule.y + top, rule.width, rule.thickness});
+
+                if (row.toc_entry >= 0 && toc_number) {
+                    TextRun run = row.runs.back();
+                    run.x = x;
+                    run.y += top;
+                    toc_number(run, row.toc_entry);
+                    page.runs.push_back(std::move(run));
+                }
+            }
+
+            /**
+             * Distributes rows into columns of the given height. 
+             * 
+             * @param place Should the rows be placed on the current page?
+             * @return number of rows consumed (including skipped ones)
+             */
+            std::size_t fill_columns(const std::vector<Row>& rows, std::size_t start, 
+                int columns, double height, bool place,
+                const std::function<void(TextRun&, int)>& toc_number = nullptr) {
+
+                double col_width = (text_width - (columns - 1) * column_sep) / columns;
+                int col = 0;
+                double col_y = 0;
+                double max_y = 0;
+
+                std::size_t i = start;
+                for (; i < rows.size(); ++i) {
+                    const Row& row = rows[i];
+                    if (row.kind == Row::columnbreak) {
+                        if (col + 1 < columns) {
+                            ++col;
+                            col_y = 0;
+                        }
+                        continue;
+                    }
+                    // vertical space is dropped at column top
+                    if (row.kind == Row::space && col_y == 0)
+                        continue;
+                    if (col_y + row.height > height && col_y > 0) {
+                        if (col + 1 == columns)
+                            break;
+                        ++col;
+                        col_y = 0;
+                        if (row.kind == Row::space)
+                            continue;
+                    }
+                    if (place && row.kind == Row::content)
+                        put_row(row, margin_left + col * (col_width + column_sep), y + col_y, 
+                            toc_number);
+                    col_y += row.height;
+                    max_y = std::max(max_y, col_y);
+                }
+
+                if (place)
+                    y += max_y;
+
+                return i - start;
+            }
+
+            /**
+             * Places rows in balanced columns, continuing on following pages
+             * when necessary.
+             */
+            void place_columns(const std::vector<Row>& rows, int columns) {
+                std::size_t i = 0;
+                while (i < rows.size()) {
+                    double available = bottom() - y;
+
+                    // the smallest column height which fits all remaining rows
+                    double low = 0;
+                    double high = 0;
+                    for (std::size_t j = i; j < rows.size(); ++j)
+                        high += rows[j].height;
+                    for (int iter = 0; iter < 30 && high - low > 0.5; ++iter) {
+                        double mid = (low + high) / 2;
+                        if (i + fill_columns(rows, i, columns, mid, false) == rows.size())
+                            high = mid;
+                        else
+                            low = mid;
+                    }
+
+                    if (high <= available) {
+                        fill_columns(rows, i, columns, high, true);
+                        return;
+                    }
+
+                    // not everything fits -- fill this page and continue on the next one
+                    if (!at_page_top() && fill_columns(rows, i, columns, available, false) == 0) {
+                        new_page();
+                        continue;
+                    }
+                    i += fill_columns(rows, i, columns, available, true);
+                    if (i < rows.size())
+                        new_page();
+                }
+            }
+
+            PdfFont& main_font;
+            PdfFont& chord_font;
+            std::string chorus_label;
+            double chorus_indent;
+            double y = margin_top;   // current vertical position on the page
+        };
+
+        /**
+         * Creates a PDF content stream for a page.
+         */
+        std::string page_content(const Page& page, const std::string& number, PdfFont& font) {
+            std::string content;
+            for (const Rule& rule: page.rules)
+                content.append(pdf_number(rule.x) + " " + 
+                    pdf_number(page_height - rule.y - rule.thickness) + " " + 
+                    pdf_number(rule.width) + " " + pdf_number(rule.thickness) + " re f\n");
+
+            content.append("BT\n");
+            PdfFont* current = nullptr;
+            double current_size = 0;
+            auto put_text = [&](const TextRun& run) {
+                if (run.font != current || run.size != current_size) {
+                    content.append("/" + run.font->get_resource() + " " + 
+                        pdf_number(run.size) + " Tf\n");
+                    current = run.font;
+                    current_size = run.size;
+                }
+                content.append("1 0 0 1 " + pdf_number(run.x) + " " + 
+                    pdf_number(page_height - run.y) + " Tm " + 
+                    run.font->encode(run.text) + " Tj\n");
+            };
+            for (const TextRun& run: page.runs)
+                put_text(run);
+
+            // page number centered in the footer
+            if (!number.empty())
+                put_text({(page_width - font.width(number, font_size)) / 2, 
+                    margin_top + text_height + footer_skip, &font, font_size, number});
+            content.append("ET\n");
+
+            return content;
+        }
+    }
+
+
+    SongbookPrinterPdf::SongbookPrinterPdf() {
+
+        parameters.emplace("pdfMainFontFile", "");
+        parameters.emplace("pdfChordFontFile", "");
+
+        // Unicode characters instead of ASCII approximations
+        TagValueMap ent{
+            {"nbsp", "\u00a0"},
+            {"ndash", "\u2013"},
+            {"mdash", "\u2014"},
+            {"hellip", "\u2026"},
+            {"quoteEnglishOpen", "\u201c"},
+            {"quoteEnglishClose", "\u201d"},
+            {"thinsp", "\u2009"},
+            {"times", "\u00d7"}
+        };
+        update_entities(ent);
+    }
+
+    std::string SongbookPrinterPdf::print_multicols_start(const std::string& number) const {
+        return std::string{"M"} + field_sep + number + record_end;
+    }
+
+    std::string SongbookPrinterPdf::print_columnbreak() const {
+        return std::string{"B"} + record_end;
+    }
+
+    std::string SongbookPrinterPdf::print_multicols_end() const {
+        return std::string{"N"} + record_end;
+    }
+
+    std::string SongbookPrinterPdf::print_verse_start(VerseType type) const {
+        return std::string{type == VerseType::verse ? "V" : "C"} + record_end;
+    }
+
+    std::string SongbookPrinterPdf::print_verse_end(VerseType /* type */) const {
+        return std::string{"E"} + record_end;
+    }
+
+    std::string SongbookPrinterPdf::print_song_header(const TagValueMultiMap& tag_values) const {
+        std::string song_name;
+        std::string left;      // left-aligned header content
+        std::string right;     // right-aligned ...
+
+        for (const auto& [tag, value] : tag_values) {
+            if (tag == "name")
+                song_name = value;
+            else if (tag == "author")  // separate authors with " / "
+                left = left.empty() ? value : left + " / " + value;
+            else if (tag == "album")   // e.g., "1973" or "The Wall (1973)"
+                right = right.empty() ? value : value + " (" + right + ")";
+            else if (tag == "year")    // e.g., "The Wall" or "The Wall (1973)"
+                right = right.empty() ? value : right + " (" + value + ")";
+        }
+
+        return "S" + (field_sep + song_name) + field_sep + left + field_sep + right + 
+            record_end;
+    }
+
+    std::string SongbookPrinterPdf::print_song_end() const {
+        return "";
+    }
+
+    void SongbookPrinterPdf::append_line(const std::vector<LineItem>& line_content, 
+        std::string& output) const {
+
+        output += 'L';
+        for (const auto& lc : line_content) {
+            output += field_sep;
+            output += (lc.type == LineItemType::lyrics) ? 'l' : 'c';
+            output.append(lc.value);
+        }
+        output += record_end;
+    }
+
+    bool SongbookPrinterPdf::prints_songs_separately() const {
+        return false;
+    }
+
+    std::string SongbookPrinterPdf::print_document(const std::vector<Song>& songs) const {
+        std::string main_file = find_pdf_font_file(get_parameter("pdfMainFontFile"));
+        if (main_file.empty())
+            throw SongbookException("No font file found for PDF output; specify one "
+                "using <pdfMainFontFile> in songbook settings");
+
+        PdfFont main_font{main_file, "F1"};
+        std::string chord_file = get_parameter("pdfChordFontFile");
+        std::unique_ptr<PdfFont> chord_font;
+        if (!chord_file.empty() && chord_file != main_file)
+            chord_font = std::make_unique<PdfFont>(chord_file, "F2");
+
+        // songs first -- their page numbers are needed for the table of contents
+        PdfLayout song_layout{main_font, chord_font ? *chord_font : main_font,
+            get_parameter("chorusLabel")};
+        std::vector<int> first_pages;
+        std::vector<std::string> names;
+        for (const auto& song: songs) {
+            first_pages.push_back(song_layout.add_song(song.get_content()));
+            names.push_back(song.get_name());
+        }
+
+        // the table of contents is laid out twice: to find out how many
+        //   pages it takes and then with the final page numbers
+        std::string toc_title = get_parameter("tocTitle");
+        PdfLayout toc_count_layout{main_font, main_font, ""};
+        toc_count_layout.add_toc(toc_title, names, [](int) { return ""; });
+        int n_toc_pages = static_cast<int>(toc_count_layout.pages.size());
+
+        PdfLayout toc_layout{main_font, main_font, ""};
+        toc_layout.add_toc(toc_title, names, [&](int i) { 
+            return std::to_string(n_toc_pages + first_pages[i] + 1); 
+        });
+
+        PdfWriter writer;
+        int catalog = writer.reserve_object();
+        int pages_id = writer.reserve_object();
+        int main_font_id = writer.reserve_object();
+        int chord_font_id = chord_font ? writer.reserve_object() : main_font_id;
+
+        std::string resources{"<< /Font << /F1 " + std::to_string(main_font_id) + " 0 R"};
+        if (chord_font)
+            resources.append(" /F2 " + std::to_string(chord_font_id) + " 0 R");
+        resources.append(" >> >>");
+
+        std::string kids;
+        auto add_page = [&](const Page& page, const std::string& number) {
+            int content_id = writer.add_stream("", page_content(page, number, main_font));
+            int page_id = writer.add_object("<< /Type /Page /Parent " + 
+                std::to_string(pages_id) + " 0 R /MediaBox [0 0 " + 
+                pdf_number(page_width) + " " + pdf_number(page_height) + 
+                "] /Resources " + resources + " /Contents " + 
+                std::to_string(content_id) + " 0 R >>");
+            kids.append(std::to_string(page_id) + " 0 R ");
+        };
+        // the table of contents pages are not numbered
+        for (const Page& page: toc_layout.pages)
+            add_page(page, "");
+        for (std::size_t i = 0; i < song_layout.pages.size(); ++i)
+            add_page(song_layout.pages[i], std::to_string(n_toc_pages + i + 1));
+
+        writer.set_object(pages_id, "<< /Type /Pages /Kids [" + kids + "] /Count " + 
+            std::to_string(toc_layout.pages.size() + song_layout.pages.size()) + " >>");
+        writer.set_object(catalog, "<< /Type /Catalog /Pages " + 
+            std::to_string(pages_id) + " 0 R >>");
+
+        // fonts are written last, when all used glyphs are known
+        main_font.write(writer, main_font_id);
+        if (chord_font)
+            chord_font->write(writer, chord_font_id);
+
+        return writer.finish(catalog);
+    }
+
+    std::string find_pdf_font_file(const std::string& file) {
+        if (!file.empty())
+            return file;
+
+        for (const char* candidate: {
+                "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+                "/usr/share/fonts/TTF/DejaVuSans.ttf",
+                "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+                "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
+                "C:/Windows/Fonts/arial.ttf",
+                "/System/Library/Fonts/Supplemental/Arial.ttf",
+                "/Library/Fonts/Arial.ttf"}) {
+            if (std::filesystem::exists(candidate))
+                return candidate;
+        }
+
+        return "";
+    }
+}
@@ -0,0 +1,123 @@
+#ifndef SONGBOOK_SONGBOOKPRINTERPDF_HPP
+#define SONGBOOK_SONGBOOKPRINTERPDF_HPP
+
+#include "SongbookPrinter.hpp"
+
+namespace songbook {
+
+    /**
+     * A `SongbookPrinter` which lays out songs itself and produces a PDF 
+     * directly, without running XeLaTeX. 
+     * 
+     * Intended for fast drafts: the layout mimics the LaTeX output (chords 
+     * above lyrics, chorus labels, multiple columns, table of contents with
+     * page numbers) but uses just one font file (`pdfMainFontFile` 
+     * parameter) and, optionally, another one for chords 
+     * (`pdfChordFontFile`). When no font file is set, some commonly 
+     * installed fonts are tried.
+     * 
+     * The individual `print_*()` functions produce an intermediate 
+     * representation of the song content which is laid out and converted
+     * into PDF by `print_document()`.
+     */
+    class SongbookPrinterPdf: public SongbookPrinter {
+
+        public:
+        SongbookPrinterPdf();
+
+        /**
+         * @copybrief SongbookPrinter::print_multicols_start()
+         * 
+         * @param number number of columns
+         * @return multicolumn start instruction
+         */
+        std::string print_multicols_start(const std::string& number) const override;
+
+        /**
+         * @copybrief SongbookPrinter::print_columnbreak()
+         * 
+         * @return column break instruction
+         */
+        std::string print_columnbreak() const override;
+
+        /**
+         * @copybrief SongbookPrinter::print_multicols_end()
+         * 
+         * @return multicolumn end instruction
+         */
+        std::string print_multicols_end() const override;
+
+        /**
+         * @copybrief SongbookPrinter::print_verse_start()
+         * 
+         * @param type verse type
+         * @return verse/chorus start instruction
+         */
+        std::string print_verse_start(VerseType type) const override;
+
+        /**
+         * @copybrief SongbookPrinter::print_verse_end()
+         * 
+         * @param type verse type
+         * @return verse/chorus end instruction
+         */
+        std::string print_verse_end(VerseType type) const override;
+
+        /**
+         * @copybrief SongbookPrinter::print_song_header()
+         * 
+         * @param tag_values tag-value pairs for song header properties
+         * @return song header instruction
+         */
+        std::string print_song_header(const TagValueMultiMap& tag_values) const override;
+
+        /**
+         * @copybrief SongbookPrinter::print_song_end()
+         * 
+         * @return empty string
+         */
+        std::string print_song_end() const override;
+
+        /**
+         * @copybrief SongbookPrinter::append_line()
+         * 
+         * @param line_content line items
+         * @param output string to append the line instruction to
+         */
+        void append_line(const std::vector<LineItem>& line_content, 
+            std::string& output) const override;
+
+        /**
+         * @copybrief SongbookPrinter::print_document()
+         * 
+         * Lays out all songs into pages, adds the table of contents and 
+         * writes everything as a PDF with embedded fonts.
+         * 
+         * @param songs individual already converted songs
+         * @return PDF file content
+         * @throws SongbookException when no usable font file is found
+         */
+        std::string print_document(const std::vector<Song>& songs) const override;
+
+        /**
+         * @copybrief SongbookPrinter::prints_songs_separately()
+         * 
+         * @return `false`, the whole document is laid out at once
+         */
+        bool prints_songs_separately() const override;
+    };
+
+
+    // ---- Nonmember functions ------
+
+    /**
+     * Finds a font file usable for PDF drafts.
+     * 
+     * @param file preferred font file; may be empty
+     * @return `file` when not empty, otherwise the first existing commonly 
+     * installed font file; empty when none exists
+     */
+    std::string find_pdf_font_file(const std::string& file);
+}
+
+#endif  // SONGBOOK_SONGBOOKPRINTERPDF_HPP
@@ -0,0 +1,63 @@
+#ifndef SONGBOOK_STATICSONGBOOKCONVERTER_HPP
+#define SONGBOOK_STATICSONGBOOKCONVERTER_HPP
+
+#include "SongbookConverter.hpp"
+
+#include <string>
+
+namespace songbook {
+
+    /**
+     * `SongbookConverter` whose printer type is fixed at compile time.
+     *
+     * All printer functions are called without virtual dispatch which allows
+     * the compiler to inline them (together with interprocedural
+     * optimization, as their definitions live in other translation units).
+     * Use it when the output format is known in advance; `SongbookConverter`
+     * with `init_converter()` remains the choice when it is selected at
+     * runtime:
+     * @code
+     * StaticSongbookConverter<SongbookPrinterLatex> converter{};
+     * converter.parse_songbook("sb.xml");
+     * std::string output = converter.convert();
+     * @endcode
+     *
+     * @tparam T printer class derived from `SongbookPrinter`
+     */
+    template <typename T>
+    class StaticSongbookConverter: public SongbookConverter {
+
+        public:
+        /**
+         * Constructor which also constructs the `T` printer.
+         *
+         * @throws ConverterException failed Xerces initialization
+         */
+        StaticSongbookConverter();
+
+        /**
+         * Converts parsed XML into final format using the `T` printer.
+         *
+         * @return converted songbook
+         */
+        std::string convert();
+
+        /**
+         * Printer type cannot be changed.
+         */
+        template <typename U> void set_printer() = delete;
+    };
+
+
+    template <typename T>
+    StaticSongbookConverter<T>::StaticSongbookConverter() {
+        SongbookConverter::set_printer<T>();
+    }
+
+    template <typename T>
+    std::string StaticSongbookConverter<T>::convert() {
+        return convert_static<T>();
+    }
+}
+
+#endif  // SONGBOOK_STATICSONGBOOKCONVERTER_HPP
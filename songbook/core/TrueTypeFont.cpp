@@ -0,0 +1,250 @@
+#include "TrueTypeFont.hpp"
+#include "SongbookException.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <map>
+
+namespace songbook {
+
+    TrueTypeFont::TrueTypeFont(const std::string& filename) {
+        std::ifstream ifs{filename, std::ios::binary};
+        if (!ifs)
+            throw SongbookException("Font file " + filename + " cannot be opened");
+
+        std::ostringstream oss;
+        oss << ifs.rdbuf();
+        data = std::move(oss).str();
+
+        try {
+            // font collection -- the first font is extracted, because a PDF
+            //   can only embed a single font
+            if (data.compare(0, 4, "ttcf") == 0)
+                data = extract_font(u32(12));
+            parse(0);
+        } catch (const SongbookException& se) {
+            throw SongbookException("Error reading font file " + filename + ": ", 
+                se.what());
+        }
+    }
+
+    std::uint16_t TrueTypeFont::get_glyph(char32_t c) const {
+        auto it = glyphs.find(c);
+        if (it == glyphs.end())
+            return 0;
+
+        return it->second;
+    }
+
+    int TrueTypeFont::get_advance(std::uint16_t glyph) const {
+        if (advances.empty())
+            return 0;
+        // glyphs after the last full metric share its advance width
+        if (glyph >= advances.size())
+            return advances.back();
+
+        return advances[glyph];
+    }
+
+    const std::string& TrueTypeFont::get_data() const {
+        return data;
+    }
+
+    const std::string& TrueTypeFont::get_postscript_name() const {
+        return postscript_name;
+    }
+
+    bool TrueTypeFont::has_cff_outlines() const {
+        return cff;
+    }
+
+    std::string TrueTypeFont::extract_font(std::uint32_t font_offset) const {
+        std::uint16_t n_tables = u16(font_offset + 4);
+        std::uint32_t directory_size = 12 + 16 * n_tables;
+        u32(font_offset + directory_size - 4);  // check bounds
+
+        // the same table directory, with offsets from the start of the new file
+        std::string font = data.substr(font_offset, directory_size);
+        for (std::uint16_t i = 0; i < n_tables; ++i) {
+            std::uint32_t record = font_offset + 12 + 16 * i;
+            std::uint64_t offset = u32(record + 8);
+            std::uint64_t length = u32(record + 12);
+            if (offset + length > data.size())
+                throw SongbookException("table outside of the font collection");
+
+            // tables are aligned to 4 bytes
+            font.resize((font.size() + 3) & ~std::size_t{3}, '\0');
+            std::uint32_t new_offset = static_cast<std::uint32_t>(font.size());
+            for (int b = 0; b < 4; ++b)
+                font[12 + 16 * i + 8 + b] = static_cast<char>(new_offset >> (24 - 8 * b));
+            font.append(data, offset, length);
+        }
+        font.resize((font.size() + 3) & ~std::size_t{3}, '\0');
+
+        return font;
+    }
+
+    void TrueTypeFont::parse(std::uint32_t font_offset) {
+        std::uint16_t n_tables = u16(font_offset + 4);
+
+        // table tag -> offset
+        std::map<std::string, std::uint32_t> tables;
+        for (std::uint16_t i = 0; i < n_tables; ++i) {
+            std::uint32_t record = font_offset + 12 + 16 * i;
+            u32(record + 12);  // check bounds
+            tables.emplace(data.substr(record, 4), u32(record + 8));
+        }
+
+        for (const char* required: {"head", "hhea", "hmtx", "cmap", "maxp"})
+            if (tables.find(required) == tables.end())
+                throw SongbookException(std::string{"missing table "} + required);
+
+        cff = tables.find("CFF ") != tables.end();
+
+        std::uint32_t head = tables["head"];
+        units_per_em = u16(head + 18);
+        if (units_per_em == 0)
+            throw SongbookException("invalid unitsPerEm");
+        for (int i = 0; i < 4; ++i)
+            bbox[i] = i16(head + 36 + 2 * i);
+
+        std::uint32_t hhea = tables["hhea"];
+        ascent = i16(hhea + 4);
+        descent = i16(hhea + 6);
+        cap_height = ascent;
+        std::uint16_t n_metrics = u16(hhea + 34);
+
+        std::uint16_t n_glyphs = u16(tables["maxp"] + 4);
+        std::uint32_t hmtx = tables["hmtx"];
+        advances.reserve(n_metrics);
+        for (std::uint16_t i = 0; i < n_metrics && i < n_glyphs; ++i)
+            advances.push_back(u16(hmtx + 4 * i));
+
+        auto it = tables.find("OS/2");
+        // sCapHeight is present since version 2
+        if (it != tables.end() && u16(it->second) >= 2)
+            cap_height = i16(it->second + 88);
+
+        it = tables.find("post");
+        if (it != tables.end())
+            italic_angle = static_cast<std::int32_t>(u32(it->second + 4)) / 65536.0;
+
+        parse_cmap(tables["cmap"]);
+
+        it = tables.find("name");
+        if (it != tables.end())
+            parse_name(it->second);
+        if (postscript_name.empty())
+            postscript_name = "SongbookFont";
+    }
+
+    void TrueTypeFont::parse_cmap(std::uint32_t offset) {
+        std::uint16_t n_subtables = u16(offset + 2);
+
+        // prefer full Unicode (format 12) over BMP-only (format 4) subtables
+        std::uint32_t best = 0;
+        int best_score = 0;
+        for (std::uint16_t i = 0; i < n_subtables; ++i) {
+            std::uint32_t record = offset + 4 + 8 * i;
+            std::uint16_t platform = u16(record);
+            std::uint16_t encoding = u16(record + 2);
+            std::uint32_t subtable = offset + u32(record + 4);
+            std::uint16_t format = u16(subtable);
+
+            bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+            int score = !unicode ? 0 : (format == 12 ? 2 : (format == 4 ? 1 : 0));
+            if (score > best_score) {
+                best_score = score;
+                best = subtable;
+            }
+        }
+        if (best_score == 0)
+            throw SongbookException("no supported Unicode cmap subtable");
+
+        if (best_score == 2) {  // format 12: groups of consecutive mappings
+            std::uint32_t n_groups = u32(best + 12);
+            for (std::uint32_t i = 0; i < n_groups; ++i) {
+                std::uint32_t group = best + 16 + 12 * i;
+                std::uint32_t start = u32(group);
+                std::uint32_t end = u32(group + 4);
+                std::uint32_t glyph = u32(group + 8);
+                for (std::uint32_t c = start; c <= end && c <= 0x10ffff; ++c)
+                    glyphs.emplace(c, static_cast<std::uint16_t>(glyph + (c - start)));
+            }
+        } else {  // format 4: segments of the Basic Multilingual Plane
+            std::uint16_t n_segments = u16(best + 6) / 2;
+            std::uint32_t ends = best + 14;
+            std::uint32_t starts = ends + 2 * n_segments + 2;
+            std::uint32_t deltas = starts + 2 * n_segments;
+            std::uint32_t range_offsets = deltas + 2 * n_segments;
+
+            for (std::uint16_t s = 0; s < n_segments; ++s) {
+                std::uint16_t start = u16(starts + 2 * s);
+                std::uint16_t end = u16(ends + 2 * s);
+                std::uint16_t delta = u16(deltas + 2 * s);
+                std::uint32_t range_offset_pos = range_offsets + 2 * s;
+                std::uint16_t range_offset = u16(range_offset_pos);
+
+                for (std::uint32_t c = start; c <= end && c != 0xffff; ++c) {
+                    std::uint16_t glyph;
+                    if (range_offset == 0)
+                        glyph = static_cast<std::uint16_t>(c + delta);
+                    else {
+                        glyph = u16(range_offset_pos + range_offset + 2 * (c - start));
+                        if (glyph != 0)
+                            glyph = static_cast<std::uint16_t>(glyph + delta);
+                    }
+                    if (glyph != 0)
+                        glyphs.emplace(c, glyph);
+                }
+            }
+        }
+    }
+
+    void TrueTypeFont::parse_name(std::uint32_t offset) {
+        std::uint16_t count = u16(offset + 2);
+        std::uint32_t strings = offset + u16(offset + 4);
+
+        for (std::uint16_t i = 0; i < count; ++i) {
+            std::uint32_t record = offset + 6 + 12 * i;
+            std::uint16_t platform = u16(record);
+            std::uint16_t name_id = u16(record + 6);
+            std::uint16_t length = u16(record + 8);
+            std::uint32_t pos = strings + u16(record + 10);
+            if (name_id != 6 || pos + length > data.size())
+                continue;
+
+            // Windows names are in UTF-16BE, Macintosh in a single-byte encoding
+            std::string name;
+            int step = (platform == 3 || platform == 0) ? 2 : 1;
+            for (std::uint32_t j = step - 1; j < length; j += step) {
+                char c = data[pos + j];
+                // keep just characters allowed in a PDF name without escaping
+                if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || 
+                        (c >= '0' && c <= '9') || c == '-')
+                    name += c;
+            }
+            if (!name.empty()) {
+                postscript_name = name;
+                return;
+            }
+        }
+    }
+
+    std::uint16_t TrueTypeFont::u16(std::uint32_t pos) const {
+        if (static_cast<std::size_t>(pos) + 2 > data.size())
+            throw SongbookException("unexpected end of file");
+
+        return static_cast<std::uint16_t>(
+            (static_cast<unsigned char>(data[pos]) << 8) | 
+            static_cast<unsigned char>(data[pos + 1]));
+    }
+
+    std::int16_t TrueTypeFont::i16(std::uint32_t pos) const {
+        return static_cast<std::int16_t>(u16(pos));
+    }
+
+    std::uint32_t TrueTypeFont::u32(std::uint32_t pos) const {
+        return (static_cast<std::uint32_t>(u16(pos)) << 16) | u16(pos + 2);
+    }
+}
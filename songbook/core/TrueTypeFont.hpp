@@ -0,0 +1,142 @@
+#ifndef SONGBOOK_TRUETYPEFONT_HPP
+#define SONGBOOK_TRUETYPEFONT_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+namespace songbook {
+
+    /**
+     * A TrueType/OpenType font loaded from a file. 
+     * 
+     * Reads just the information needed for laying out text and embedding
+     * the font in a PDF: character to glyph mapping, glyph widths and global
+     * font metrics. Font collections (.ttc) are supported by using their
+     * first font, which is extracted into a standalone font (as needed for
+     * embedding).
+     */
+    class TrueTypeFont {
+
+        public:
+        /**
+         * Loads and parses a font file.
+         * 
+         * @param filename path to the font file
+         * @throws SongbookException when the file can't be read or parsed
+         */
+        explicit TrueTypeFont(const std::string& filename);
+
+        /**
+         * Finds a glyph for a character.
+         * 
+         * @param c Unicode code point
+         * @return glyph index; 0 (`.notdef`) when the font has no such glyph
+         */
+        std::uint16_t get_glyph(char32_t c) const;
+
+        /**
+         * Returns the advance width of a glyph.
+         * 
+         * @param glyph glyph index
+         * @return advance width in font units
+         */
+        int get_advance(std::uint16_t glyph) const;
+
+        /**
+         * Getter for `data`.
+         * 
+         * @return complete content of the font file (of the first font
+         * for font collections)
+         */
+        const std::string& get_data() const;
+
+        /**
+         * Getter for `postscript_name`.
+         * 
+         * @return font name usable in a PDF (without spaces)
+         */
+        const std::string& get_postscript_name() const;
+
+        /**
+         * Does the font contain CFF (PostScript) outlines?
+         * 
+         * @return `true` for CFF-based OpenType fonts, `false` for TrueType
+         * outlines
+         */
+        bool has_cff_outlines() const;
+
+        int units_per_em = 1000;  ///< font units per em
+        int ascent = 0;           ///< typographic ascent in font units
+        int descent = 0;          ///< typographic descent (negative) in font units
+        int cap_height = 0;       ///< height of capital letters in font units
+        int bbox[4] = {0, 0, 0, 0};  ///< font bounding box in font units
+        double italic_angle = 0;  ///< italic angle in degrees
+
+        private:
+        /**
+         * Copies a font of a font collection into a standalone font file.
+         * 
+         * @param font_offset offset of the font's table directory in `data`
+         * @return font file content
+         * @throws SongbookException when a table is outside of `data`
+         */
+        std::string extract_font(std::uint32_t font_offset) const;
+
+        /**
+         * Reads the table directory and all needed tables.
+         * 
+         * @param font_offset offset of the font in `data` (non-zero for 
+         * font collections)
+         */
+        void parse(std::uint32_t font_offset);
+
+        /**
+         * Reads the character to glyph mapping from the `cmap` table.
+         * 
+         * @param offset table offset
+         */
+        void parse_cmap(std::uint32_t offset);
+
+        /**
+         * Reads the PostScript name from the `name` table.
+         * 
+         * @param offset table offset
+         */
+        void parse_name(std::uint32_t offset);
+
+        /**
+         * Reads an unsigned 16-bit big-endian value.
+         * 
+         * @param pos position in `data`
+         * @return read value
+         * @throws SongbookException when reading past the end of `data`
+         */
+        std::uint16_t u16(std::uint32_t pos) const;
+
+        /**
+         * Reads a signed 16-bit big-endian value.
+         * 
+         * @param pos position in `data`
+         * @return read value
+         */
+        std::int16_t i16(std::uint32_t pos) const;
+
+        /**
+         * Reads an unsigned 32-bit big-endian value.
+         * 
+         * @param pos position in `data`
+         * @return read value
+         */
+        std::uint32_t u32(std::uint32_t pos) const;
+
+        std::string data;                ///< font file content
+        std::string postscript_name;     ///< font name
+        bool cff = false;                ///< CFF outlines present?
+        std::unordered_map<char32_t, std::uint16_t> glyphs;  ///< character to glyph mapping
+        std::vector<std::uint16_t> advances;  ///< advance widths from `hmtx`
+    };
+}
+
+#endif  // SONGBOOK_TRUETYPEFONT_HPP
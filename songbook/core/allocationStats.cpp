@@ -0,0 +1,128 @@
+#include "allocationStats.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <xercesc/util/OutOfMemoryException.hpp>
+
+#ifdef SONGBOOK_ALLOC_STATS
+
+namespace {
+    std::atomic<std::uint64_t> allocation_count{0};  ///< allocations so far
+    std::atomic<std::uint64_t> allocated_bytes{0};   ///< bytes allocated so far
+
+    /**
+     * Allocates memory and counts the allocation.
+     * 
+     * @param size number of bytes
+     * @return allocated memory or `nullptr`
+     */
+    void* counted_malloc(std::size_t size) {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+    }
+
+    /**
+     * Xerces memory manager counting its allocations.
+     */
+    class CountingMemoryManager: public xercesc::MemoryManager {
+        public:
+        xercesc::MemoryManager* getExceptionMemoryManager() override {
+            return this;
+        }
+
+        void* allocate(XMLSize_t size) override {
+            if (void* ptr = counted_malloc(size))
+                return ptr;
+            throw xercesc::OutOfMemoryException();
+        }
+
+        void deallocate(void* ptr) override {
+            std::free(ptr);
+        }
+    };
+}
+
+//------  Replaced global allocation functions ------
+
+void* operator new(std::size_t size) {
+    if (void* ptr = counted_malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_malloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_malloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+#endif
+
+
+namespace songbook {
+
+#ifdef SONGBOOK_ALLOC_STATS
+
+    bool allocation_accounting_enabled() {
+        return true;
+    }
+
+    AllocationCounts allocation_counts() {
+        return AllocationCounts{
+            allocation_count.load(std::memory_order_relaxed),
+            allocated_bytes.load(std::memory_order_relaxed)};
+    }
+
+    xercesc::MemoryManager* counting_memory_manager() {
+        static CountingMemoryManager manager;
+        return &manager;
+    }
+
+#else
+
+    bool allocation_accounting_enabled() {
+        return false;
+    }
+
+    AllocationCounts allocation_counts() {
+        return AllocationCounts{};
+    }
+
+    xercesc::MemoryManager* counting_memory_manager() {
+        return nullptr;
+    }
+
+#endif
+}
@@ -0,0 +1,51 @@
+/**
+ * @file
+ * 
+ * Counting of heap allocations for finding allocation-heavy code.
+ * 
+ * Accounting is compiled in only with the `SONGBOOK_ALLOC_STATS` CMake 
+ * option, which replaces the global `operator new`/`operator delete` and
+ * gives Xerces a counting `MemoryManager`. Otherwise all counts stay 0.
+ */
+
+#ifndef SONGBOOK_ALLOCATIONSTATS_HPP
+#define SONGBOOK_ALLOCATIONSTATS_HPP
+
+#include <cstdint>
+#include <xercesc/framework/MemoryManager.hpp>
+
+namespace songbook {
+
+    /**
+     * Numbers of heap allocations and allocated bytes.
+     */
+    struct AllocationCounts {
+        std::uint64_t allocations{0};  /**< number of allocations */
+        std::uint64_t bytes{0};        /**< allocated bytes (not reduced by deallocations) */
+    };
+
+    /**
+     * Is allocation accounting compiled in?
+     * 
+     * @return `true` when built with `SONGBOOK_ALLOC_STATS`
+     */
+    bool allocation_accounting_enabled();
+
+    /**
+     * Returns allocations made since the program start by `operator new`
+     * (except over-aligned allocations) and by Xerces.
+     * 
+     * @return allocation counts; zeros when accounting is not enabled
+     */
+    AllocationCounts allocation_counts();
+
+    /**
+     * Returns the memory manager to be used by Xerces.
+     * 
+     * @return counting memory manager; `nullptr` (Xerces' default manager)
+     * when accounting is not enabled
+     */
+    xercesc::MemoryManager* counting_memory_manager();
+}
+
+#endif  // SONGBOOK_ALLOCATIONSTATS_HPP
@@ -0,0 +1,412 @@
+#include "chordPro.hpp"
+#include "chordTransposition.hpp"
+#include "SongbookException.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace songbook {
+
+    namespace {
+
+        /**
+         * Removes leading and trailing whitespace.
+         *
+         * @param str string to trim
+         * @return trimmed string
+         */
+        std::string_view trim(std::string_view str) {
+            size_t start = 0;
+            while (start < str.size() && std::isspace(static_cast<unsigned char>(str[start])))
+                ++start;
+            size_t end = str.size();
+            while (end > start && std::isspace(static_cast<unsigned char>(str[end - 1])))
+                --end;
+            return str.substr(start, end - start);
+        }
+
+        /**
+         * Is `str` a note as allowed in the XML (`[a-hA-H][b#]?`)?
+         *
+         * @param str string to check
+         * @return `true` for a note
+         */
+        bool is_note(std::string_view str) {
+            if (str.empty() || str.size() > 2)
+                return false;
+            char letter = static_cast<char>(std::tolower(static_cast<unsigned char>(str[0])));
+            if (letter < 'a' || letter > 'h')
+                return false;
+            return str.size() == 1 || str[1] == 'b' || str[1] == '#';
+        }
+
+        /**
+         * Builds songs from ChordPro lines.
+         */
+        class ChordProReader {
+
+            public:
+            /**
+             * Processes one line (without the line break).
+             *
+             * @param line line text
+             * @param number line number (for error messages)
+             */
+            void read_line(std::string_view line, size_t number) {
+                line_number = number;
+                if (!line.empty() && line.back() == '\r')
+                    line.remove_suffix(1);
+
+                std::string_view trimmed = trim(line);
+                if (!skip_until.empty()) {
+                    if (trimmed.size() > 2 && trimmed.front() == '{' && trimmed.back() == '}') {
+                        auto [name, value] = split_directive(trimmed);
+                        if (name == skip_until || name == "eot" || name == "eog")
+                            skip_until.clear();
+                    }
+                    return;
+                }
+
+                if (trimmed.empty()) {
+                    // a blank line ends a paragraph
+                    if (section == Section::implicit_verse)
+                        end_section();
+                } else if (trimmed.front() == '#') {
+                    return;
+                } else if (trimmed.front() == '{') {
+                    if (trimmed.back() != '}')
+                        error("'}' missing at the end of a directive");
+                    auto [name, value] = split_directive(trimmed);
+                    directive(name, value);
+                } else {
+                    text_line(trimmed);
+                }
+            }
+
+            /**
+             * Finishes the last song and returns all songs.
+             *
+             * @return songs read
+             */
+            std::vector<SongData> finish() {
+                if (!skip_until.empty())
+                    error("{" + skip_until + "} missing");
+                end_song();
+                return std::move(songs);
+            }
+
+            private:
+            /**
+             * Kind of the section currently open.
+             */
+            enum class Section {
+                none,            ///< no section
+                implicit_verse,  ///< paragraph outside of section directives
+                verse,           ///< `start_of_verse` or `start_of_bridge`
+                chorus           ///< `start_of_chorus`
+            };
+
+            /**
+             * Throws an exception with the line number.
+             *
+             * @param message error description
+             */
+            [[noreturn]] void error(const std::string& message) const {
+                throw SongbookException("ChordPro line " + std::to_string(line_number) +
+                    ": " + message);
+            }
+
+            /**
+             * Splits a directive into its name (lowercase) and value.
+             *
+             * @param directive directive including braces
+             * @return name and trimmed value
+             */
+            static std::pair<std::string, std::string_view> split_directive(std::string_view directive) {
+                directive = trim(directive.substr(1, directive.size() - 2));
+                size_t sep = directive.find_first_of(": \t");
+                std::string name{directive.substr(0, sep)};
+                std::transform(begin(name), end(name), begin(name),
+                    [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+                std::string_view value;
+                if (sep != std::string_view::npos)
+                    value = trim(directive.substr(sep + 1));
+                return {std::move(name), value};
+            }
+
+            /**
+             * Processes a directive.
+             *
+             * @param name directive name (lowercase)
+             * @param value directive value
+             */
+            void directive(const std::string& name, std::string_view value) {
+                if (name == "title" || name == "t") {
+                    if (song && song->header.count("name"))
+                        end_song();
+                    set_header("name", value);
+                } else if (name == "sorttitle") {
+                    set_header("sortingName", value);
+                } else if (name == "artist" || name == "composer" || name == "lyricist" ||
+                    name == "a") {
+                    start_song().header.emplace("author", value);
+                } else if (name == "album" || name == "year") {
+                    set_header(name, value);
+                } else if (name == "transpose") {
+                    start_song().transpose = parse_semitones(std::string{value});
+                } else if (name == "meta") {
+                    size_t sep = value.find_first_of(" \t");
+                    if (sep == std::string_view::npos)
+                        error("value missing in {meta}");
+                    std::string meta{value.substr(0, sep)};
+                    std::string_view meta_value = trim(value.substr(sep + 1));
+                    if (meta == "transpose")
+                        start_song().transpose = parse_semitones(std::string{meta_value});
+                    else if (meta == "author" || meta == "artist")
+                        start_song().header.emplace("author", meta_value);
+                    else
+                        set_header(meta == "title" ? "name" : meta, meta_value);
+                } else if (name == "start_of_verse" || name == "sov" ||
+                    name == "start_of_bridge" || name == "sob") {
+                    start_section(Section::verse);
+                } else if (name == "start_of_chorus" || name == "soc") {
+                    start_section(Section::chorus);
+                } else if (name.compare(0, 7, "end_of_") == 0 || name == "eov" ||
+                    name == "eoc" || name == "eob") {
+                    end_section();
+                } else if (name == "start_of_tab" || name == "sot") {
+                    skip_until = "end_of_tab";
+                } else if (name == "start_of_grid" || name == "sog") {
+                    skip_until = "end_of_grid";
+                } else if (name == "columns" || name == "col") {
+                    set_columns(value);
+                } else if (name == "column_break" || name == "colb") {
+                    end_section();
+                    start_song().events.push_back(SongEvent{SongEventType::columnbreak});
+                } else if (name == "new_song" || name == "ns") {
+                    end_song();
+                }
+                // other directives (comments, key, capo, ...) have no equivalent
+            }
+
+            /**
+             * Processes a line of lyrics and chords.
+             *
+             * @param text line text
+             */
+            void text_line(std::string_view text) {
+                if (section == Section::none)
+                    start_section(Section::implicit_verse);
+
+                SongEvent line{SongEventType::line};
+                size_t pos = 0;
+                while (pos < text.size()) {
+                    size_t open = text.find('[', pos);
+                    if (open != pos) {
+                        std::string_view lyrics = text.substr(pos, open - pos);
+                        line.line.push_back(LineElement{LineItemType::lyrics, std::string{lyrics}, {}});
+                        if (open == std::string_view::npos)
+                            break;
+                    }
+                    size_t close = text.find(']', open);
+                    if (close == std::string_view::npos)
+                        error("']' missing after a chord");
+                    line.line.push_back(LineElement{LineItemType::chord, {},
+                        parse_chordpro_chord(text.substr(open + 1, close - open - 1))});
+                    pos = close + 1;
+                }
+                song->events.push_back(std::move(line));
+            }
+
+            /**
+             * Returns the current song, starting a new one when needed.
+             *
+             * @return current song
+             */
+            SongData& start_song() {
+                if (!song) {
+                    songs.emplace_back();
+                    song = &songs.back();
+                    song_line = line_number;
+                }
+                return *song;
+            }
+
+            /**
+             * Sets a header value of the current song.
+             *
+             * @param name header element name
+             * @param value header value
+             */
+            void set_header(const std::string& name, std::string_view value) {
+                TagValueMultiMap& header = start_song().header;
+                header.erase(name);
+                header.emplace(name, value);
+            }
+
+            /**
+             * Closes everything open in the current song and checks it.
+             */
+            void end_song() {
+                if (!song)
+                    return;
+                end_section();
+                if (multicols) {
+                    song->events.push_back(SongEvent{SongEventType::multicols_end});
+                    multicols = false;
+                }
+
+                if (!song->header.count("name")) {
+                    line_number = song_line;
+                    error("song without {title}");
+                }
+                if (!song->header.count("dateAdded"))
+                    song->header.emplace("dateAdded", "0001-01-01");
+
+                song = nullptr;
+            }
+
+            /**
+             * Starts a verse or chorus, closing the current one.
+             *
+             * @param type section type
+             */
+            void start_section(Section type) {
+                end_section();
+                start_song().events.push_back(SongEvent{SongEventType::verse_start,
+                    type == Section::chorus ? VerseType::chorus : VerseType::verse});
+                section = type;
+            }
+
+            /**
+             * Ends the current verse or chorus (if any).
+             */
+            void end_section() {
+                if (section == Section::none)
+                    return;
+                song->events.push_back(SongEvent{SongEventType::verse_end,
+                    section == Section::chorus ? VerseType::chorus : VerseType::verse});
+                section = Section::none;
+            }
+
+            /**
+             * Starts or ends multiple columns.
+             *
+             * @param value number of columns (1 ends multiple columns)
+             */
+            void set_columns(std::string_view value) {
+                if (value.size() != 1 || value[0] < '1' || value[0] > '5')
+                    error("number of columns must be 1-5");
+
+                end_section();
+                SongData& current = start_song();
+                if (multicols) {
+                    current.events.push_back(SongEvent{SongEventType::multicols_end});
+                    multicols = false;
+                }
+                if (value[0] != '1') {
+                    SongEvent start{SongEventType::multicols_start};
+                    start.number = std::string{value};
+                    current.events.push_back(std::move(start));
+                    multicols = true;
+                }
+            }
+
+            std::vector<SongData> songs;        ///< songs read so far
+            SongData* song{nullptr};            ///< current song (the last one of `songs`)
+            Section section{Section::none};     ///< section open in the current song
+            bool multicols{false};              ///< are multiple columns open?
+            std::string skip_until;             ///< directive ending a skipped section
+            size_t line_number{0};              ///< line being processed
+            size_t song_line{0};                ///< line where the current song started
+        };
+    }
+
+    //------  Nonmember functions ------
+
+    std::vector<SongData> read_chordpro(std::string_view text) {
+        ChordProReader reader;
+
+        size_t number = 1;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find('\n', pos);
+            if (end == std::string_view::npos)
+                end = text.size();
+            reader.read_line(text.substr(pos, end - pos), number++);
+            pos = end + 1;
+        }
+
+        return reader.finish();
+    }
+
+    std::vector<SongData> load_chordpro(const std::string& filename) {
+        std::ifstream ifs{filename, std::ios::binary};
+        if (!ifs)
+            throw std::runtime_error("Input file " + filename + " cannot be opened");
+
+        std::ostringstream oss;
+        oss << ifs.rdbuf();
+        std::string text = std::move(oss).str();
+
+        // UTF-8 byte order mark
+        std::string_view view{text};
+        if (view.compare(0, 3, "\xEF\xBB\xBF") == 0)
+            view.remove_prefix(3);
+
+        try {
+            return read_chordpro(view);
+        } catch (const SongbookException& e) {
+            throw SongbookException(filename + ": ", e.what());
+        }
+    }
+
+    TagValueMap parse_chordpro_chord(std::string_view chord) {
+        TagValueMap attrs;
+
+        chord = trim(chord);
+        bool optional = chord.size() > 2 && chord.front() == '(' && chord.back() == ')';
+        if (optional)
+            chord = trim(chord.substr(1, chord.size() - 2));
+        attrs.emplace("optional", optional ? "yes" : "no");
+
+        // root: a note letter with an optional accidental
+        size_t root_length = (chord.size() > 1 && is_note(chord.substr(0, 2))) ? 2 : 1;
+        if (!is_note(chord.substr(0, root_length))) {
+            // special chord, e.g. N.C.
+            attrs.emplace("root", "");
+            if (!chord.empty())
+                attrs.emplace("type", chord);
+            return attrs;
+        }
+        attrs.emplace("root", chord.substr(0, root_length));
+        chord.remove_prefix(root_length);
+
+        // bass only when a note follows the slash (`6/9` is a type)
+        size_t slash = chord.rfind('/');
+        if (slash != std::string_view::npos && is_note(chord.substr(slash + 1))) {
+            attrs.emplace("bass", chord.substr(slash + 1));
+            chord = chord.substr(0, slash);
+        }
+        if (!chord.empty())
+            attrs.emplace("type", chord);
+
+        return attrs;
+    }
+
+    bool is_chordpro_file(const std::string& filename) {
+        size_t dot = filename.find_last_of('.');
+        size_t slash = filename.find_last_of("/\\");
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            return false;
+
+        std::string extension = filename.substr(dot + 1);
+        std::transform(begin(extension), end(extension), begin(extension),
+            [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+        return extension == "cho" || extension == "chopro" || extension == "chordpro" ||
+            extension == "crd";
+    }
+}
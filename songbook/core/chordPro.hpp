@@ -0,0 +1,75 @@
+/**
+ * @file
+ *
+ * Reading of songs in the ChordPro format into the songbook model.
+ *
+ * Supported are lyrics with chords in brackets (`[Am]lyrics`), comment
+ * lines (`#`) and these directives (short forms in parentheses):
+ *   - `title` (`t`), `sorttitle`, `artist`/`composer`/`lyricist` (`a`),
+ *     `album`, `year`, `transpose` and `meta: <name> <value>` for any of
+ *     the song header elements (e.g. `{meta: dateAdded 2024-05-01}`),
+ *   - `start_of_verse` (`sov`), `start_of_chorus` (`soc`),
+ *     `start_of_bridge` (`sob`) and the corresponding `end_of_...`,
+ *   - `columns` (`col`) and `column_break` (`colb`),
+ *   - `new_song` (`ns`); a `title` in a song which already has one also
+ *     starts a new song.
+ *
+ * Paragraphs outside of verse/chorus directives become verses, `tab` and
+ * `grid` sections are skipped, other directives are ignored. Chords in
+ * parentheses are optional; chords not starting with a note become
+ * special chords. Songs without `{meta: dateAdded ...}` are treated as
+ * added on an unknown date (like `NA` in the XML).
+ */
+
+#ifndef SONGBOOK_CHORDPRO_HPP
+#define SONGBOOK_CHORDPRO_HPP
+
+#include "songModel.hpp"
+#include "songbookTypes.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * Reads songs from a ChordPro text in a single pass.
+     *
+     * @param text ChordPro text (UTF-8)
+     * @return songs in the order of the text
+     * @throw SongbookException an unterminated chord or directive, or a
+     * song without a title (the message contains the line number)
+     */
+    std::vector<SongData> read_chordpro(std::string_view text);
+
+    /**
+     * Reads songs from a ChordPro file.
+     *
+     * @param filename path to the file
+     * @return songs in the order of the file
+     * @throw std::runtime_error when the file can't be opened
+     * @throw SongbookException the file is not valid ChordPro (see `read_chordpro()`)
+     */
+    std::vector<SongData> load_chordpro(const std::string& filename);
+
+    /**
+     * Converts a ChordPro chord (e.g. `F#m7/C#`, `(G)` or `N.C.`) into
+     * chord attribute-value pairs as read from the XML.
+     *
+     * @param chord chord text without brackets
+     * @return chord attribute-value pairs (`root` is empty for special chords)
+     */
+    TagValueMap parse_chordpro_chord(std::string_view chord);
+
+    /**
+     * Does a file name have one of the ChordPro extensions (`.cho`,
+     * `.chopro`, `.chordpro`, `.crd`; letter case is ignored)?
+     *
+     * @param filename file name
+     * @return `true` for ChordPro file names
+     */
+    bool is_chordpro_file(const std::string& filename);
+}
+
+#endif  // SONGBOOK_CHORDPRO_HPP
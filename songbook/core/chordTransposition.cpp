@@ -0,0 +1,145 @@
+#include "chordTransposition.hpp"
+#include "SongbookException.hpp"
+
+#include <cctype>
+#include <stdexcept>
+
+
+namespace songbook {
+
+    namespace {
+        /**
+         * Note names spelled with sharps for each pitch class.
+         */
+        const char* const sharp_names[12] = {
+            "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"};
+
+        /**
+         * Note names spelled with flats for each pitch class.
+         */
+        const char* const flat_names[12] = {
+            "C", "Db", "D", "Eb", "E", "F", "Gb", "G", "Ab", "A", "Bb", "B"};
+
+        /**
+         * Decides whether a key is written with flats.
+         *
+         * @param pitch pitch class of the key's tonic
+         * @param minor is it a minor key?
+         * @return `true` for keys with flats in their signature
+         */
+        bool is_flat_key(int pitch, bool minor) {
+            if (minor)  // d, g, c, f, bb, eb
+                return pitch == 2 || pitch == 7 || pitch == 0 || pitch == 5 ||
+                    pitch == 10 || pitch == 3;
+            // F, Bb, Eb, Ab, Db
+            return pitch == 5 || pitch == 10 || pitch == 3 || pitch == 8 || pitch == 1;
+        }
+    }
+
+    int note_pitch(const std::string& note) {
+        if (note.empty() || note.size() > 2)
+            return -1;
+
+        int pitch;
+        switch (std::toupper(static_cast<unsigned char>(note[0]))) {
+            case 'C': pitch = 0; break;
+            case 'D': pitch = 2; break;
+            case 'E': pitch = 4; break;
+            case 'F': pitch = 5; break;
+            case 'G': pitch = 7; break;
+            case 'A': pitch = 9; break;
+            case 'B':
+            case 'H': pitch = 11; break;
+            default: return -1;
+        }
+
+        if (note.size() == 2) {
+            if (note[1] == '#')
+                ++pitch;
+            else if (note[1] == 'b')
+                --pitch;
+            else
+                return -1;
+        }
+
+        return (pitch + 12) % 12;
+    }
+
+    Transposition song_transposition(int semitones, const std::vector<TagValueMap>& chords) {
+        Transposition transposition;
+        transposition.semitones = ((semitones % 12) + 12) % 12;
+        if (transposition.semitones == 0)
+            return transposition;
+
+        bool key_found{false};
+        bool uses_h{false}, uses_b{false};
+        for (const TagValueMap& chord: chords) {
+            for (const char* attr_name: {"root", "bass"}) {
+                auto attr = chord.find(attr_name);
+                if (attr == chord.end())
+                    continue;
+                if (attr->second == "H" || attr->second == "h")
+                    uses_h = true;
+                else if (attr->second == "B" || attr->second == "b")
+                    uses_b = true;
+            }
+
+            // key is given by the first chord with a real root
+            if (!key_found) {
+                int pitch = note_pitch(chord.find("root")->second);
+                if (pitch >= 0) {
+                    auto type = chord.find("type");
+                    bool minor = type != chord.end() && type->second.size() > 0 &&
+                        type->second[0] == 'm' && type->second.compare(0, 3, "maj") != 0;
+                    transposition.flats = is_flat_key(
+                        (pitch + transposition.semitones) % 12, minor);
+                    key_found = true;
+                }
+            }
+        }
+        transposition.h_notation = uses_h && !uses_b;
+
+        return transposition;
+    }
+
+    std::string transpose_note(const std::string& note, const Transposition& transposition) {
+        int pitch = note_pitch(note);
+        if (pitch < 0 || transposition.semitones == 0)
+            return note;
+
+        pitch = (pitch + transposition.semitones) % 12;
+        std::string result{transposition.flats ? flat_names[pitch] : sharp_names[pitch]};
+        if (transposition.h_notation && pitch == 11)
+            result = "H";
+
+        if (std::islower(static_cast<unsigned char>(note[0])))
+            result[0] = static_cast<char>(std::tolower(static_cast<unsigned char>(result[0])));
+
+        return result;
+    }
+
+    void transpose_chord(TagValueMap& chord, const Transposition& transposition) {
+        if (transposition.semitones == 0)
+            return;
+
+        for (const char* attr_name: {"root", "bass"}) {
+            auto attr = chord.find(attr_name);
+            if (attr != chord.end())
+                attr->second = transpose_note(attr->second, transposition);
+        }
+    }
+
+    int parse_semitones(const std::string& value) {
+        size_t pos{0};
+        int semitones{0};
+        try {
+            semitones = std::stoi(value, &pos);
+        } catch (const std::logic_error&) {
+            pos = 0;
+        }
+        if (pos == 0 || pos != value.size())
+            throw SongbookException("Incorrect transposition: '" + value + "'");
+
+        return semitones;
+    }
+}
@@ -0,0 +1,76 @@
+/**
+ * @file
+ *
+ * Transposition of chords by a number of semitones.
+ */
+
+#ifndef SONGBOOK_CHORDTRANSPOSITION_HPP
+#define SONGBOOK_CHORDTRANSPOSITION_HPP
+
+#include "songbookTypes.hpp"
+
+#include <string>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * Transposition of one song.
+     */
+    struct Transposition {
+        int semitones{0};         /**< shift in semitones (0-11) */
+        bool flats{false};        /**< spell altered notes with flats (sharps otherwise)? */
+        bool h_notation{false};   /**< write B natural as H? */
+    };
+
+    /**
+     * Returns the pitch class of a note.
+     *
+     * Both `B` and `H` stand for B natural; letter case is ignored.
+     *
+     * @param note note as in the `root` and `bass` chord attributes
+     * @return pitch class (0 for C, 11 for B) or -1 when `note` is not a
+     * note (e.g. `special`)
+     */
+    int note_pitch(const std::string& note);
+
+    /**
+     * Creates a transposition for a song. Notes are spelled with flats when
+     * the target key (given by the song's first chord) is a flat key and
+     * `H` is used for B natural when the song uses it and never uses `B`.
+     *
+     * @param semitones shift in semitones (can be negative or more than an octave)
+     * @param chords all chords of the song in order of appearance
+     * @return transposition; `semitones` is 0 when no transposition is needed
+     */
+    Transposition song_transposition(int semitones, const std::vector<TagValueMap>& chords);
+
+    /**
+     * Transposes a note. Letter case is preserved.
+     *
+     * @param note note as in the `root` and `bass` chord attributes
+     * @param transposition transposition to apply
+     * @return transposed note; `note` itself when it is not a note
+     */
+    std::string transpose_note(const std::string& note, const Transposition& transposition);
+
+    /**
+     * Transposes `root` and `bass` of a chord.
+     *
+     * @param[in,out] chord chord attribute-value pairs
+     * @param transposition transposition to apply
+     */
+    void transpose_chord(TagValueMap& chord, const Transposition& transposition);
+
+    /**
+     * Converts a transposition given as text (e.g. in the song header) into
+     * a number of semitones.
+     *
+     * @param value integer, optionally with a sign
+     * @return number of semitones
+     * @throws SongbookException `value` is not an integer
+     */
+    int parse_semitones(const std::string& value);
+}
+
+#endif  // SONGBOOK_CHORDTRANSPOSITION_HPP
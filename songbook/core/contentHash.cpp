@@ -0,0 +1,25 @@
+#include "contentHash.hpp"
+
+namespace songbook {
+
+    std::uint64_t content_hash(std::string_view str, std::uint64_t seed) {
+        std::uint64_t hash = seed;
+        for (unsigned char c: str) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    std::string hash_to_hex(std::uint64_t hash) {
+        const char* digits = "0123456789abcdef";
+        std::string hex(16, '0');
+        for (int i = 15; i >= 0; --i) {
+            hex[i] = digits[hash & 0xf];
+            hash >>= 4;
+        }
+
+        return hex;
+    }
+}
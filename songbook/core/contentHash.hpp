@@ -0,0 +1,38 @@
+/**
+ * @file
+ * 
+ * Hashing of file and string content used for caching.
+*/
+
+#ifndef SONGBOOK_CONTENTHASH_HPP
+#define SONGBOOK_CONTENTHASH_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace songbook {
+
+    /**
+     * Computes a 64-bit FNV-1a hash of a string. 
+     * 
+     * Unlike `std::hash`, the result is the same across platforms and 
+     * program runs so it can be stored in cache files.
+     * 
+     * @param str string to hash
+     * @param seed hash to continue from (allows hashing data in pieces)
+     * @return hash value
+     */
+    std::uint64_t content_hash(std::string_view str, 
+        std::uint64_t seed = 14695981039346656037ull);
+
+    /**
+     * Converts a hash value into a 16 characters long hexadecimal string.
+     * 
+     * @param hash hash value
+     * @return hexadecimal representation of `hash`
+     */
+    std::string hash_to_hex(std::uint64_t hash);
+}
+
+#endif  // SONGBOOK_CONTENTHASH_HPP
@@ -0,0 +1,805 @@
+'''
+Generates validation tables and state machines (see generatedSchema.hpp)
+from the XML schema in a .cpp file.
+Command line arguments:
+argv[1]  input .cpp file (xmlSchema.cpp)
+argv[2]  output .cpp file
+
+Only the parts of XML Schema used by the songbook schema are supported:
+global and local elements (also abstract ones with substitution groups),
+`sequence`, `choice` and `all` groups with minOccurs/maxOccurs, mixed
+content, attributes with `use` and `default`, and simple types derived
+from xs:string, xs:token, xs:Name, xs:integer, xs:date and xs:gYear by
+`enumeration`, `pattern` (ASCII only) and `min/maxInclusive` facets or by
+`union`. Anything else is reported as an error, so a schema change that
+the generated validator would not check fails the build.
+'''
+
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+XS = '{http://www.w3.org/2001/XMLSchema}'
+
+# built-in type -> (whitespace collapsed?, base check)
+BUILTINS = {
+    'xs:string': (False, None),
+    'xs:token': (True, None),
+    'xs:Name': (True, 'is_name(value)'),
+    'xs:integer': (True, 'is_integer(value, number)'),
+    'xs:date': (True, 'is_date(value)'),
+    'xs:gYear': (True, 'is_g_year(value)'),
+}
+
+UNBOUNDED = None
+
+
+class SchemaError(Exception):
+    pass
+
+
+def extract_schema(cpp_file):
+    '''Returns the schema from the raw string literal in `cpp_file`.'''
+    with open(cpp_file, 'r', encoding='utf-8') as cpp:
+        text = cpp.read()
+    match = re.search(r'R"\((<\?xml .*?</xs:schema>)', text, re.DOTALL)
+    if match is None:
+        raise SchemaError(f'schema not found in {cpp_file}')
+    return match.group(1)
+
+
+def c_string(text):
+    return '"' + text.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+
+def c_char(code):
+    char = chr(code)
+    if char in '\\\'':
+        return "'\\" + char + "'"
+    if 0x20 <= code < 0x7F:
+        return "'" + char + "'"
+    return f'\'\\x{code:02x}\''
+
+
+# ------ simple types ------
+
+class SimpleType:
+    '''An atomic simple type (built-in base with facets) or a union.'''
+
+    def __init__(self, name):
+        self.name = name
+        self.base = None           # built-in type
+        self.enumeration = None    # allowed values
+        self.patterns = []         # all must match
+        self.min = None
+        self.max = None
+        self.members = None        # union member types
+
+    def derive(self, name):
+        derived = SimpleType(name)
+        derived.base = self.base
+        derived.enumeration = self.enumeration
+        derived.patterns = list(self.patterns)
+        derived.min, derived.max = self.min, self.max
+        derived.members = self.members
+        return derived
+
+
+class Nfa:
+    '''Nondeterministic automaton built from fragments with one start and
+    one end state; `None` is the empty symbol.'''
+
+    def __init__(self):
+        self.edges = []    # state -> {symbol: [targets]}
+
+    def state(self):
+        self.edges.append({})
+        return len(self.edges) - 1
+
+    def edge(self, source, symbol, target):
+        self.edges[source].setdefault(symbol, []).append(target)
+
+    def repeat(self, build_once, minimum, maximum):
+        '''Fragment matching `build_once()` `minimum` to `maximum` times
+        (`UNBOUNDED` for no limit); each occurrence is a new fragment.'''
+        start = end = self.state()
+        for _ in range(minimum):
+            first, last = build_once()
+            self.edge(end, None, first)
+            end = last
+        if maximum is UNBOUNDED:
+            first, last = build_once()
+            self.edge(end, None, first)
+            self.edge(last, None, end)
+        else:
+            optional_end = self.state()
+            for _ in range(maximum - minimum):
+                first, last = build_once()
+                self.edge(end, None, optional_end)
+                self.edge(end, None, first)
+                end = last
+            self.edge(end, None, optional_end)
+            end = optional_end
+        return start, end
+
+
+class PatternMachine:
+    '''DFA of a `pattern` facet (ASCII-only subset of XML Schema regular
+    expressions: character classes with ranges, `\\d`, groups, `|` and
+    quantifiers).'''
+
+    def __init__(self, pattern):
+        self.pattern = pattern
+        self.pos = 0
+        tree = self.alternation()
+        if self.pos != len(pattern):
+            self.unsupported()
+        nfa = Nfa()
+        start, end = self.build(nfa, tree)
+        self.dfa, self.final = determinize(nfa.edges, start, end)
+
+    def unsupported(self, reason=''):
+        raise SchemaError(f'unsupported pattern {self.pattern!r}{reason}')
+
+    def peek(self):
+        return self.pattern[self.pos] if self.pos < len(self.pattern) else None
+
+    # parsing into ('alt', [...]), ('cat', [...]), ('rep', node, min, max), ('set', codes)
+
+    def alternation(self):
+        branches = [self.concatenation()]
+        while self.peek() == '|':
+            self.pos += 1
+            branches.append(self.concatenation())
+        return ('alt', branches)
+
+    def concatenation(self):
+        items = []
+        while self.peek() not in (None, '|', ')'):
+            items.append(self.quantified())
+        return ('cat', items)
+
+    def quantified(self):
+        atom = self.atom()
+        quantifier = self.peek()
+        if quantifier in ('?', '*', '+'):
+            self.pos += 1
+            minimum, maximum = {'?': (0, 1), '*': (0, UNBOUNDED), '+': (1, UNBOUNDED)}[quantifier]
+        elif quantifier == '{':
+            end = self.pattern.find('}', self.pos)
+            if end < 0:
+                self.unsupported()
+            bounds = self.pattern[self.pos + 1:end].split(',')
+            minimum = int(bounds[0])
+            maximum = minimum if len(bounds) == 1 else (int(bounds[1]) if bounds[1] else UNBOUNDED)
+            self.pos = end + 1
+        else:
+            return atom
+        return ('rep', atom, minimum, maximum)
+
+    def atom(self):
+        char = self.peek()
+        if char == '(':
+            self.pos += 1
+            result = self.alternation()
+            if self.peek() != ')':
+                self.unsupported()
+            self.pos += 1
+            return result
+        if char == '[':
+            return ('set', self.char_class())
+        if char == '\\':
+            return ('set', self.escape())
+        if char in '.^$':
+            self.unsupported(' (only ASCII characters can be matched)')
+        self.pos += 1
+        return ('set', {self.ascii(char)})
+
+    def ascii(self, char):
+        if ord(char) >= 0x80:
+            self.unsupported(' (non-ASCII character)')
+        return ord(char)
+
+    def escape(self):
+        if self.pos + 1 >= len(self.pattern):
+            self.unsupported()
+        char = self.pattern[self.pos + 1]
+        self.pos += 2
+        if char == 'd':
+            return set(range(ord('0'), ord('9') + 1))
+        if char in 'nrt':
+            return {ord({'n': '\n', 'r': '\r', 't': '\t'}[char])}
+        if char.isalpha():
+            self.unsupported(f' (escape \\{char})')
+        return {self.ascii(char)}
+
+    def char_class(self):
+        self.pos += 1
+        if self.peek() == '^':
+            self.unsupported(' (only ASCII characters can be matched)')
+        codes = set()
+        while self.peek() != ']':
+            if self.peek() is None:
+                self.unsupported()
+            if self.peek() == '\\':
+                low = self.escape()
+            else:
+                low = {self.ascii(self.peek())}
+                self.pos += 1
+            if (self.peek() == '-' and self.pos + 1 < len(self.pattern) and
+                    self.pattern[self.pos + 1] != ']' and len(low) == 1):
+                high = self.ascii(self.pattern[self.pos + 1])
+                self.pos += 2
+                low = set(range(min(low), high + 1))
+            codes |= low
+        self.pos += 1
+        return codes
+
+    def build(self, nfa, node):
+        '''NFA fragment of a parsed pattern.'''
+        kind = node[0]
+        if kind == 'rep':
+            return nfa.repeat(lambda: self.build(nfa, node[1]), node[2], node[3])
+        start, end = nfa.state(), nfa.state()
+        if kind == 'set':
+            for code in node[1]:
+                nfa.edge(start, code, end)
+        elif kind == 'cat':
+            current = start
+            for item in node[1]:
+                first, last = self.build(nfa, item)
+                nfa.edge(current, None, first)
+                current = last
+            nfa.edge(current, None, end)
+        else:
+            for branch in node[1]:
+                first, last = self.build(nfa, branch)
+                nfa.edge(start, None, first)
+                nfa.edge(last, None, end)
+        return start, end
+
+
+def determinize(nfa, start, end):
+    '''Subset construction; returns DFA transitions ({symbol: target} per
+    state, state 0 initial) and the set of final states.'''
+
+    def closure(states):
+        stack, result = list(states), set(states)
+        while stack:
+            for target in nfa[stack.pop()].get(None, []):
+                if target not in result:
+                    result.add(target)
+                    stack.append(target)
+        return frozenset(result)
+
+    initial = closure([start])
+    index = {initial: 0}
+    queue = [initial]
+    dfa, final = [], set()
+    while len(dfa) < len(queue):
+        current = queue[len(dfa)]
+        if end in current:
+            final.add(len(dfa))
+        moves = {}
+        for state in current:
+            for symbol, targets in nfa[state].items():
+                if symbol is not None:
+                    moves.setdefault(symbol, set()).update(targets)
+        transitions = {}
+        for symbol, targets in sorted(moves.items(), key=lambda m: str(m[0])):
+            target = closure(targets)
+            if target not in index:
+                index[target] = len(queue)
+                queue.append(target)
+            transitions[symbol] = index[target]
+        dfa.append(transitions)
+    return minimize(dfa, final)
+
+
+def minimize(dfa, final):
+    '''Merges equivalent states of a DFA (Moore's algorithm); state 0 stays
+    initial.'''
+    symbols = {symbol for transitions in dfa for symbol in transitions}
+    block = [1 if state in final else 0 for state in range(len(dfa))]
+    while True:
+        signatures = [(block[state],) + tuple(
+            block[dfa[state][symbol]] if symbol in dfa[state] else -1
+            for symbol in sorted(symbols, key=str)) for state in range(len(dfa))]
+        numbering = {}
+        for signature in signatures:
+            numbering.setdefault(signature, len(numbering))
+        refined = [numbering[signature] for signature in signatures]
+        if len(numbering) == len(set(block)):
+            break
+        block = refined
+
+    # number blocks in the order of their first state (keeps 0 initial)
+    order = {}
+    for state in range(len(dfa)):
+        order.setdefault(block[state], len(order))
+    merged = [None] * len(order)
+    for state, transitions in enumerate(dfa):
+        if merged[order[block[state]]] is None:
+            merged[order[block[state]]] = {symbol: order[block[target]]
+                                           for symbol, target in transitions.items()}
+    return merged, {order[block[state]] for state in final}
+
+
+# ------ the schema ------
+
+class Schema:
+
+    def __init__(self, root):
+        self.simple_types = {}      # name -> SimpleType
+        self.complex_types = {}     # name -> <xs:complexType>
+        self.elements = {}          # name -> global <xs:element>
+        for child in root:
+            name = child.get('name')
+            if child.tag == XS + 'simpleType':
+                self.simple_types[name] = child
+            elif child.tag == XS + 'complexType':
+                self.complex_types[name] = child
+            elif child.tag == XS + 'element':
+                self.elements[name] = child
+            else:
+                raise SchemaError(f'unsupported top-level <{child.tag}>')
+
+        self.simple_list = []       # SimpleType by index
+        self.simple_index = {}      # key -> index
+        self.patterns = []          # PatternMachine by index
+        self.types = []             # generated type records by index
+        self.type_index = {}        # key -> index
+
+    # simple types
+
+    def simple_type(self, name=None, node=None, description=None):
+        '''Index of a simple type given by name or by a <xs:simpleType> node
+        (anonymous, `description` is used in messages).'''
+        key = name if name is not None else id(node)
+        if key in self.simple_index:
+            return self.simple_index[key]
+        if name in BUILTINS:
+            simple = SimpleType(name)
+            simple.base = name
+        elif name is not None:
+            if name not in self.simple_types:
+                raise SchemaError(f'unsupported type {name}')
+            simple = self.read_simple_type(self.simple_types[name], name)
+        else:
+            simple = self.read_simple_type(node, description)
+        self.simple_index[key] = len(self.simple_list)
+        self.simple_list.append(simple)
+        return self.simple_index[key]
+
+    def read_simple_type(self, node, name):
+        restriction = node.find(XS + 'restriction')
+        union = node.find(XS + 'union')
+        if union is not None:
+            simple = SimpleType(name)
+            simple.members = [self.simple_type(member) for member in
+                              union.get('memberTypes', '').split()]
+            simple.members += [self.simple_type(node=member, description=f'{name} (member {i + 1})')
+                               for i, member in enumerate(union.findall(XS + 'simpleType'))]
+            return simple
+        if restriction is None:
+            raise SchemaError(f'unsupported simple type {name}')
+
+        base = self.simple_list[self.simple_type(restriction.get('base'))]
+        if base.members is not None:
+            raise SchemaError(f'restriction of a union in {name} is not supported')
+        simple = base.derive(name)
+        enumeration = []
+        for facet in restriction:
+            value = facet.get('value')
+            if facet.tag == XS + 'enumeration':
+                enumeration.append(value)
+            elif facet.tag == XS + 'pattern':
+                simple.patterns.append(len(self.patterns))
+                self.patterns.append(PatternMachine(value))
+            elif facet.tag == XS + 'minInclusive' and simple.base == 'xs:integer':
+                simple.min = int(value)
+            elif facet.tag == XS + 'maxInclusive' and simple.base == 'xs:integer':
+                simple.max = int(value)
+            else:
+                raise SchemaError(f'unsupported facet {facet.tag} in {name}')
+        if enumeration:
+            simple.enumeration = enumeration
+        return simple
+
+    # element types
+
+    def element_type(self, element):
+        '''Index of the type of an element declaration.'''
+        type_name = element.get('type')
+        complex_node = element.find(XS + 'complexType')
+        simple_node = element.find(XS + 'simpleType')
+        if type_name in self.complex_types:
+            return self.complex_type(type_name, self.complex_types[type_name])
+        if type_name is not None:
+            return self.simple_content_type(self.simple_type(type_name))
+        if complex_node is not None:
+            return self.complex_type(id(complex_node), complex_node,
+                                     f'anonymous type of <{element.get("name")}>')
+        if simple_node is not None:
+            return self.simple_content_type(self.simple_type(
+                node=simple_node, description=f'anonymous type of <{element.get("name")}>'))
+        raise SchemaError(f'element <{element.get("name")}> has no type '
+                          '(only abstract elements can be untyped)')
+
+    def simple_content_type(self, simple):
+        key = ('simple', simple)
+        if key not in self.type_index:
+            self.type_index[key] = len(self.types)
+            self.types.append({'name': self.simple_list[simple].name, 'content': 'simple',
+                               'simple': simple, 'attributes': [], 'model': None})
+        return self.type_index[key]
+
+    def complex_type(self, key, node, name=None):
+        if key in self.type_index:
+            return self.type_index[key]
+        index = len(self.types)
+        self.type_index[key] = index
+        record = {'name': name or key, 'simple': -1, 'attributes': [], 'model': None}
+        self.types.append(record)
+
+        particle = None
+        for child in node:
+            if child.tag in (XS + 'sequence', XS + 'choice', XS + 'all'):
+                particle = child
+            elif child.tag == XS + 'attribute':
+                if child.get('ref') is not None:
+                    raise SchemaError('attribute references are not supported')
+                record['attributes'].append((
+                    child.get('name'), self.attribute_type(child),
+                    child.get('use') == 'required'))
+            else:
+                raise SchemaError(f'unsupported <{child.tag}> in {record["name"]}')
+
+        mixed = node.get('mixed') == 'true'
+        if particle is None:
+            record['content'] = 'mixed' if mixed else 'empty'
+            record['model'] = ('dfa', [{}], {0})
+        else:
+            record['content'] = 'mixed' if mixed else 'elements'
+            record['model'] = (self.all_model(particle) if particle.tag == XS + 'all'
+                               else self.dfa_model(particle, record['name']))
+        return index
+
+    def attribute_type(self, attribute):
+        simple_node = attribute.find(XS + 'simpleType')
+        if simple_node is not None:
+            return self.simple_type(node=simple_node,
+                                    description=f'anonymous type of attribute {attribute.get("name")}')
+        return self.simple_type(attribute.get('type', 'xs:string'))
+
+    def substitutes(self, element):
+        '''Element names and type indices which can stand for a particle element.'''
+        ref = element.get('ref')
+        if ref is None:
+            return [(element.get('name'), self.element_type(element))]
+
+        result = []
+        pending = [ref]
+        while pending:
+            name = pending.pop(0)
+            declaration = self.elements[name]
+            if declaration.get('abstract') != 'true':
+                result.append((name, self.element_type(declaration)))
+            pending += [member for member, decl in self.elements.items()
+                        if decl.get('substitutionGroup') == name]
+        return result
+
+    def all_model(self, group):
+        particles = []
+        for bit, element in enumerate(group.findall(XS + 'element')):
+            if element.get('maxOccurs', '1') != '1':
+                raise SchemaError('maxOccurs in <xs:all> must be 1')
+            particles.append((self.substitutes(element), bit,
+                              element.get('minOccurs', '1') != '0'))
+        if len(particles) > 32:
+            raise SchemaError('<xs:all> with more than 32 elements is not supported')
+        return ('all', particles)
+
+    def dfa_model(self, particle, type_name):
+        nfa = Nfa()
+        start, end = self.particle_nfa(nfa, particle)
+        dfa, final = determinize(nfa.edges, start, end)
+        # symbols are (name, type); the same name must always have the same type
+        transitions = []
+        for state in dfa:
+            by_name = {}
+            for (name, child_type), target in state.items():
+                if name in by_name:
+                    raise SchemaError(f'content model of {type_name} is ambiguous for <{name}>')
+                by_name[name] = (child_type, target)
+            transitions.append(by_name)
+        return ('dfa', transitions, final)
+
+    def particle_nfa(self, nfa, particle):
+        '''NFA fragment of a particle including its occurrence bounds.'''
+        minimum = int(particle.get('minOccurs', '1'))
+        maximum = particle.get('maxOccurs', '1')
+        maximum = UNBOUNDED if maximum == 'unbounded' else int(maximum)
+        return nfa.repeat(lambda: self.particle_once(nfa, particle), minimum, maximum)
+
+    def particle_once(self, nfa, particle):
+        start, end = nfa.state(), nfa.state()
+        if particle.tag == XS + 'element':
+            for name, child_type in self.substitutes(particle):
+                nfa.edge(start, (name, child_type), end)
+        elif particle.tag == XS + 'sequence':
+            current = start
+            for child in particle:
+                first, last = self.particle_nfa(nfa, child)
+                nfa.edge(current, None, first)
+                current = last
+            nfa.edge(current, None, end)
+        elif particle.tag == XS + 'choice':
+            for child in particle:
+                first, last = self.particle_nfa(nfa, child)
+                nfa.edge(start, None, first)
+                nfa.edge(last, None, end)
+        else:
+            raise SchemaError(f'unsupported particle {particle.tag}')
+        return start, end
+
+
+# ------ code generation ------
+
+def has_children(record):
+    '''Can elements of a type contain child elements?'''
+    model = record['model']
+    return model is not None and (model[0] == 'all' or any(model[1]))
+
+
+def generate_simple_check(schema, index):
+    simple = schema.simple_list[index]
+    lines = ['        /**', f'         * Checks a value of {simple.name}.', '         */']
+    unrestricted = (simple.members is None and not BUILTINS[simple.base][1] and
+                    simple.enumeration is None and not simple.patterns)
+    lines.append(f'        bool check_simple_{index}(std::string_view{"" if unrestricted else " value"}) {{')
+    if simple.members is not None:
+        # each member processes whitespace itself
+        checks = ' ||\n                '.join(f'check_simple_{member}(value)'
+                                             for member in simple.members)
+        lines.append(f'            return {checks};')
+    else:
+        collapse, base_check = BUILTINS[simple.base]
+        conditions = [base_check] if base_check else []
+        if simple.min is not None:
+            conditions.append(f'number >= {simple.min}LL')
+        if simple.max is not None:
+            conditions.append(f'number <= {simple.max}LL')
+        if simple.enumeration is not None:
+            conditions.append('(' + ' || '.join(f'value == {c_string(v)}'
+                                                for v in simple.enumeration) + ')')
+        conditions += [f'match_pattern_{p}(value)' for p in simple.patterns]
+
+        if conditions and collapse:
+            lines.append('            std::string buffer;')
+            lines.append('            value = collapse_whitespace(value, buffer);')
+        if simple.base == 'xs:integer':
+            lines.append('            long long number;')
+        lines.append('            return ' + (' &&\n                '.join(conditions) or 'true')
+                     + ';')
+    lines.append('        }')
+    return '\n'.join(lines)
+
+
+def byte_ranges(codes):
+    codes = sorted(codes)
+    ranges = []
+    for code in codes:
+        if ranges and ranges[-1][1] == code - 1:
+            ranges[-1][1] = code
+        else:
+            ranges.append([code, code])
+    return ranges
+
+
+def generate_pattern(index, machine):
+    lines = [f'        /**', f'         * Matches pattern `{machine.pattern}`.', f'         */',
+             f'        bool match_pattern_{index}(std::string_view value) {{',
+             '            int state = 0;',
+             '            for (char c: value) {',
+             '                switch (state) {']
+    for state, transitions in enumerate(machine.dfa):
+        lines.append(f'                    case {state}:')
+        by_target = {}
+        for code, target in transitions.items():
+            by_target.setdefault(target, []).append(code)
+        keyword = 'if'
+        for target, codes in sorted(by_target.items()):
+            conditions = [f'c == {c_char(low)}' if low == high else
+                          f'(c >= {c_char(low)} && c <= {c_char(high)})'
+                          for low, high in byte_ranges(codes)]
+            lines.append(f'                        {keyword} ({" || ".join(conditions)})')
+            lines.append(f'                            state = {target};')
+            keyword = 'else if'
+        if keyword == 'if':
+            lines.append('                        return false;')
+        else:
+            lines.append('                        else')
+            lines.append('                            return false;')
+            lines.append('                        break;')
+    lines += ['                }', '            }',
+              '            return ' + (' || '.join(f'state == {s}' for s in sorted(machine.final))
+                                     or 'false') + ';',
+              '        }']
+    return '\n'.join(lines)
+
+
+def generate_child_function(index, record):
+    model = record['model']
+    lines = [f'        /**', f'         * Content of {record["name"]}.', f'         */',
+             f'        int child_{index}(std::uint32_t& state, std::string_view name) {{']
+    if model[0] == 'all':
+        for substitutes, bit, _ in model[1]:
+            names = ' || '.join(f'name == {c_string(name)}' for name, _ in substitutes)
+            lines.append(f'            if ({names}) {{')
+            lines.append(f'                if (state & (1u << {bit}))')
+            lines.append(f'                    return -1;')
+            lines.append(f'                state |= 1u << {bit};')
+            if len({child for _, child in substitutes}) == 1:
+                lines.append(f'                return {substitutes[0][1]};')
+            else:
+                for name, child in substitutes:
+                    lines.append(f'                if (name == {c_string(name)})')
+                    lines.append(f'                    return {child};')
+            lines.append('            }')
+        lines.append('            return -1;')
+    else:
+        transitions = model[1]
+        if any(transitions):
+            lines.append('            switch (state) {')
+            for state, by_name in enumerate(transitions):
+                if not by_name:
+                    continue
+                lines.append(f'                case {state}:')
+                for name, (child, target) in by_name.items():
+                    lines.append(f'                    if (name == {c_string(name)}) {{')
+                    if target != state:
+                        lines.append(f'                        state = {target};')
+                    lines.append(f'                        return {child};')
+                    lines.append('                    }')
+                lines.append('                    break;')
+            lines.append('            }')
+        lines.append('            return -1;')
+    lines.append('        }')
+    return '\n'.join(lines)
+
+
+def generate(schema_text):
+    root = ET.fromstring(schema_text)
+    schema = Schema(root)
+
+    globals_ = []
+    for name, element in schema.elements.items():
+        if element.get('abstract') != 'true':
+            globals_.append((name, schema.element_type(element)))
+    # types used only as attribute types need no records, but all named
+    #   simple types are checked so that errors in them are found
+    for name in schema.simple_types:
+        schema.simple_type(name)
+
+    out = ['// Generated by generate_validator.py from xmlSchema.cpp -- do not edit.', '',
+           '#include "generatedSchema.hpp"', '', '#include <string>', '',
+           'namespace songbook::generated_schema {', '', '    namespace {', '']
+
+    for index, machine in enumerate(schema.patterns):
+        out += [generate_pattern(index, machine), '']
+    for index in range(len(schema.simple_list)):
+        out += [generate_simple_check(schema, index), '']
+
+    for index, record in enumerate(schema.types):
+        if record['attributes']:
+            out.append(f'        const AttributeInfo attributes_{index}[] = {{')
+            for name, simple, required in record['attributes']:
+                out.append(f'            {{{c_string(name)}, {simple}, '
+                           f'{"true" if required else "false"}}},')
+            out += ['        };', '']
+
+    out.append('        const TypeInfo types[] = {')
+    for index, record in enumerate(schema.types):
+        attributes = (f'attributes_{index}, {len(record["attributes"])}'
+                      if record['attributes'] else 'nullptr, 0')
+        out.append(f'            {{{c_string(record["name"])}, '
+                   f'Content::{record["content"]}, {record["simple"]}, {attributes}}},')
+    out += ['        };', '']
+
+    for index, record in enumerate(schema.types):
+        if has_children(record):
+            out += [generate_child_function(index, record), '']
+
+    out += ['    }', '', '    //------  Nonmember functions ------', '']
+
+    out += ['    const TypeInfo& type_info(int type) {', '        return types[type];', '    }', '']
+
+    out.append('    int global_element(std::string_view name) {')
+    for name, index in globals_:
+        out.append(f'        if (name == {c_string(name)})')
+        out.append(f'            return {index};')
+    out += ['        return -1;', '    }', '']
+
+    out += ['    int child_element(int type, std::uint32_t& state, std::string_view name) {',
+            '        switch (type) {']
+    for index, record in enumerate(schema.types):
+        if has_children(record):
+            out.append(f'            case {index}: return child_{index}(state, name);')
+    out += ['        }', '        return -1;', '    }', '']
+
+    out += ['    bool content_complete(int type, std::uint32_t state) {',
+            '        switch (type) {']
+    for index, record in enumerate(schema.types):
+        model = record['model']
+        if not has_children(record):
+            continue
+        if model[0] == 'all':
+            required = sum(1 << bit for _, bit, req in model[1] if req)
+            out.append(f'            case {index}: return ' +
+                       (f'(state & {required}u) == {required}u;' if required else 'true;'))
+        else:
+            if model[2] == set(range(len(model[1]))):
+                out.append(f'            case {index}: return true;')
+            else:
+                finals = ' || '.join(f'state == {s}' for s in sorted(model[2])) or 'false'
+                out.append(f'            case {index}: return {finals};')
+    out += ['        }', '        return true;', '    }', '']
+
+    out += ['    std::string expected_elements(int type, std::uint32_t state) {',
+            '        switch (type) {']
+    for index, record in enumerate(schema.types):
+        model = record['model']
+        if not has_children(record):
+            continue
+        out.append(f'            case {index}:')
+        if model[0] == 'all':
+            # elements of the group not seen yet
+            out.append('            {')
+            out.append('                std::string names;')
+            for substitutes, bit, _ in model[1]:
+                names = ', '.join(name for name, _ in substitutes)
+                out.append(f'                if (!(state & (1u << {bit})))')
+                out.append(f'                    names += names.empty() ? '
+                           f'{c_string(names)} : {c_string(", " + names)};')
+            out.append('                return names;')
+            out.append('            }')
+        else:
+            out.append('                switch (state) {')
+            for state, by_name in enumerate(model[1]):
+                if by_name:
+                    out.append(f'                    case {state}: return '
+                               f'{c_string(", ".join(by_name))};')
+            out.append('                }')
+            out.append('                break;')
+    out += ['        }', '        return "";', '    }', '']
+
+    out += ['    bool check_value(int simple_type, std::string_view value) {',
+            '        switch (simple_type) {']
+    for index in range(len(schema.simple_list)):
+        out.append(f'            case {index}: return check_simple_{index}(value);')
+    out += ['        }', '        return true;', '    }', '']
+
+    out += ['    const char* simple_type_name(int simple_type) {',
+            '        switch (simple_type) {']
+    for index, simple in enumerate(schema.simple_list):
+        out.append(f'            case {index}: return {c_string(simple.name)};')
+    out += ['        }', '        return "";', '    }', '']
+
+    any_strings = [index for index, simple in enumerate(schema.simple_list)
+                   if simple.base == 'xs:string' and simple.members is None and
+                   simple.enumeration is None and not simple.patterns]
+    out += ['    bool is_any_string(int simple_type) {',
+            '        return ' + (' || '.join(f'simple_type == {i}' for i in any_strings)
+                                 or 'false') + ';',
+            '    }', '}', '']
+    return '\n'.join(out)
+
+
+if __name__ == '__main__':
+    try:
+        code = generate(extract_schema(sys.argv[1]))
+    except SchemaError as e:
+        sys.exit(f'generate_validator.py: {e}')
+    with open(sys.argv[2], 'w', encoding='utf-8') as output:
+        output.write(code)
@@ -0,0 +1,757 @@
+// Generated by generate_validator.py from xmlSchema.cpp -- do not edit.
+
+#include "generatedSchema.hpp"
+
+#include <string>
+
+namespace songbook::generated_schema {
+
+    namespace {
+
+        /**
+         * Matches pattern `[a-hA-H][b#]?|special`.
+         */
+        bool match_pattern_0(std::string_view value) {
+            int state = 0;
+            for (char c: value) {
+                switch (state) {
+                    case 0:
+                        if ((c >= 'A' && c <= 'H') || (c >= 'a' && c <= 'h'))
+                            state = 1;
+                        else if (c == 's')
+                            state = 2;
+                        else
+                            return false;
+                        break;
+                    case 1:
+                        if (c == '#' || c == 'b')
+                            state = 3;
+                        else
+                            return false;
+                        break;
+                    case 2:
+                        if (c == 'p')
+                            state = 4;
+                        else
+                            return false;
+                        break;
+                    case 3:
+                        return false;
+                    case 4:
+                        if (c == 'e')
+                            state = 5;
+                        else
+                            return false;
+                        break;
+                    case 5:
+                        if (c == 'c')
+                            state = 6;
+                        else
+                            return false;
+                        break;
+                    case 6:
+                        if (c == 'i')
+                            state = 7;
+                        else
+                            return false;
+                        break;
+                    case 7:
+                        if (c == 'a')
+                            state = 8;
+                        else
+                            return false;
+                        break;
+                    case 8:
+                        if (c == 'l')
+                            state = 3;
+                        else
+                            return false;
+                        break;
+                }
+            }
+            return state == 1 || state == 3;
+        }
+
+        /**
+         * Checks a value of xs:string.
+         */
+        bool check_simple_0(std::string_view) {
+            return true;
+        }
+
+        /**
+         * Checks a value of sortSongsByType.
+         */
+        bool check_simple_1(std::string_view value) {
+            return (value == "name" || value == "dateAdded" || value == "none");
+        }
+
+        /**
+         * Checks a value of xs:date.
+         */
+        bool check_simple_2(std::string_view value) {
+            std::string buffer;
+            value = collapse_whitespace(value, buffer);
+            return is_date(value);
+        }
+
+        /**
+         * Checks a value of convertAddedSinceType (member 1).
+         */
+        bool check_simple_3(std::string_view value) {
+            std::string buffer;
+            value = collapse_whitespace(value, buffer);
+            return is_date(value);
+        }
+
+        /**
+         * Checks a value of xs:token.
+         */
+        bool check_simple_4(std::string_view) {
+            return true;
+        }
+
+        /**
+         * Checks a value of convertAddedSinceType (member 2).
+         */
+        bool check_simple_5(std::string_view value) {
+            std::string buffer;
+            value = collapse_whitespace(value, buffer);
+            return (value == "all");
+        }
+
+        /**
+         * Checks a value of convertAddedSinceType.
+         */
+        bool check_simple_6(std::string_view value) {
+            return check_simple_3(value) ||
+                check_simple_5(value);
+        }
+
+        /**
+         * Checks a value of xs:Name.
+         */
+        bool check_simple_7(std::string_view value) {
+            std::string buffer;
+            value = collapse_whitespace(value, buffer);
+            return is_name(value);
+        }
+
+        /**
+         * Checks a value of xs:gYear.
+         */
+        bool check_simple_8(std::string_view value) {
+            std::string buffer;
+            value = collapse_whitespace(value, buffer);
+            return is_g_year(value);
+        }
+
+        /**
+         * Checks a value of dateAddedType (member 1).
+         */
+        bool check_simple_9(std::string_view value) {
+            std::string buffer;
+            value = collapse_whitespace(value, buffer);
+            return is_date(value);
+        }
+
+        /**
+         * Checks a value of dateAddedType (member 2).
+         */
+        bool check_simple_10(std::string_view value) {
+            std::string buffer;
+            value = collapse_whitespace(value, buffer);
+            return (value == "NA");
+        }
+
+        /**
+         * Checks a value of dateAddedType.
+         */
+        bool check_simple_11(std::string_view value) {
+            return check_simple_9(value) ||
+                check_simple_10(value);
+        }
+
+        /**
+         * Checks a value of xs:integer.
+         */
+        bool check_simple_12(std::string_view value) {
+            std::string buffer;
+            value = collapse_whitespace(value, buffer);
+            long long number;
+            return is_integer(value, number);
+        }
+
+        /**
+         * Checks a value of noteType.
+         */
+        bool check_simple_13(std::string_view value) {
+            return match_pattern_0(value);
+        }
+
+        /**
+         * Checks a value of yesNoType.
+         */
+        bool check_simple_14(std::string_view value) {
+            return (value == "yes" || value == "no");
+        }
+
+        /**
+         * Checks a value of numberColumnsType.
+         */
+        bool check_simple_15(std::string_view value) {
+            std::string buffer;
+            value = collapse_whitespace(value, buffer);
+            long long number;
+            return is_integer(value, number) &&
+                number >= 1LL &&
+                number <= 5LL;
+        }
+
+        const AttributeInfo attributes_17[] = {
+            {"root", 13, true},
+            {"bass", 13, false},
+            {"type", 0, false},
+            {"optional", 14, false},
+        };
+
+        const AttributeInfo attributes_19[] = {
+            {"number", 15, false},
+        };
+
+        const TypeInfo types[] = {
+            {"anonymous type of <songbook>", Content::elements, -1, nullptr, 0},
+            {"settingsType", Content::elements, -1, nullptr, 0},
+            {"xs:string", Content::simple, 0, nullptr, 0},
+            {"sortSongsByType", Content::simple, 1, nullptr, 0},
+            {"convertAddedSinceType", Content::simple, 6, nullptr, 0},
+            {"anonymous type of <entities>", Content::elements, -1, nullptr, 0},
+            {"entityType", Content::elements, -1, nullptr, 0},
+            {"xs:Name", Content::simple, 7, nullptr, 0},
+            {"songsType", Content::elements, -1, nullptr, 0},
+            {"songType", Content::elements, -1, nullptr, 0},
+            {"songHeaderType", Content::elements, -1, nullptr, 0},
+            {"anonymous type of <authors>", Content::elements, -1, nullptr, 0},
+            {"xs:gYear", Content::simple, 8, nullptr, 0},
+            {"dateAddedType", Content::simple, 11, nullptr, 0},
+            {"xs:integer", Content::simple, 12, nullptr, 0},
+            {"verseType", Content::elements, -1, nullptr, 0},
+            {"lineType", Content::mixed, -1, nullptr, 0},
+            {"chordType", Content::empty, -1, attributes_17, 4},
+            {"anonymous type of <columnbreak>", Content::empty, -1, nullptr, 0},
+            {"multicolsType", Content::elements, -1, attributes_19, 1},
+        };
+
+        /**
+         * Content of anonymous type of <songbook>.
+         */
+        int child_0(std::uint32_t& state, std::string_view name) {
+            switch (state) {
+                case 0:
+                    if (name == "settings") {
+                        state = 1;
+                        return 1;
+                    }
+                    if (name == "songs") {
+                        state = 2;
+                        return 8;
+                    }
+                    break;
+                case 1:
+                    if (name == "songs") {
+                        state = 2;
+                        return 8;
+                    }
+                    break;
+            }
+            return -1;
+        }
+
+        /**
+         * Content of settingsType.
+         */
+        int child_1(std::uint32_t& state, std::string_view name) {
+            if (name == "language") {
+                if (state & (1u << 0))
+                    return -1;
+                state |= 1u << 0;
+                return 2;
+            }
+            if (name == "sortSongsBy") {
+                if (state & (1u << 1))
+                    return -1;
+                state |= 1u << 1;
+                return 3;
+            }
+            if (name == "chorusLabel") {
+                if (state & (1u << 2))
+                    return -1;
+                state |= 1u << 2;
+                return 2;
+            }
+            if (name == "tocTitle") {
+                if (state & (1u << 3))
+                    return -1;
+                state |= 1u << 3;
+                return 2;
+            }
+            if (name == "mainFont") {
+                if (state & (1u << 4))
+                    return -1;
+                state |= 1u << 4;
+                return 2;
+            }
+            if (name == "chordFont") {
+                if (state & (1u << 5))
+                    return -1;
+                state |= 1u << 5;
+                return 2;
+            }
+            if (name == "pdfMainFontFile") {
+                if (state & (1u << 6))
+                    return -1;
+                state |= 1u << 6;
+                return 2;
+            }
+            if (name == "pdfChordFontFile") {
+                if (state & (1u << 7))
+                    return -1;
+                state |= 1u << 7;
+                return 2;
+            }
+            if (name == "convertAddedSince") {
+                if (state & (1u << 8))
+                    return -1;
+                state |= 1u << 8;
+                return 4;
+            }
+            if (name == "entities") {
+                if (state & (1u << 9))
+                    return -1;
+                state |= 1u << 9;
+                return 5;
+            }
+            return -1;
+        }
+
+        /**
+         * Content of anonymous type of <entities>.
+         */
+        int child_5(std::uint32_t& state, std::string_view name) {
+            switch (state) {
+                case 0:
+                    if (name == "entity") {
+                        state = 1;
+                        return 6;
+                    }
+                    break;
+                case 1:
+                    if (name == "entity") {
+                        return 6;
+                    }
+                    break;
+            }
+            return -1;
+        }
+
+        /**
+         * Content of entityType.
+         */
+        int child_6(std::uint32_t& state, std::string_view name) {
+            if (name == "name") {
+                if (state & (1u << 0))
+                    return -1;
+                state |= 1u << 0;
+                return 7;
+            }
+            if (name == "value") {
+                if (state & (1u << 1))
+                    return -1;
+                state |= 1u << 1;
+                return 2;
+            }
+            return -1;
+        }
+
+        /**
+         * Content of songsType.
+         */
+        int child_8(std::uint32_t& state, std::string_view name) {
+            switch (state) {
+                case 0:
+                    if (name == "song") {
+                        return 9;
+                    }
+                    break;
+            }
+            return -1;
+        }
+
+        /**
+         * Content of songType.
+         */
+        int child_9(std::uint32_t& state, std::string_view name) {
+            switch (state) {
+                case 0:
+                    if (name == "header") {
+                        state = 1;
+                        return 10;
+                    }
+                    break;
+                case 1:
+                    if (name == "chorus") {
+                        return 15;
+                    }
+                    if (name == "columnbreak") {
+                        return 18;
+                    }
+                    if (name == "line") {
+                        return 16;
+                    }
+                    if (name == "multicols") {
+                        return 19;
+                    }
+                    if (name == "verse") {
+                        return 15;
+                    }
+                    break;
+            }
+            return -1;
+        }
+
+        /**
+         * Content of songHeaderType.
+         */
+        int child_10(std::uint32_t& state, std::string_view name) {
+            if (name == "name") {
+                if (state & (1u << 0))
+                    return -1;
+                state |= 1u << 0;
+                return 2;
+            }
+            if (name == "sortingName") {
+                if (state & (1u << 1))
+                    return -1;
+                state |= 1u << 1;
+                return 2;
+            }
+            if (name == "author" || name == "authors") {
+                if (state & (1u << 2))
+                    return -1;
+                state |= 1u << 2;
+                if (name == "author")
+                    return 2;
+                if (name == "authors")
+                    return 11;
+            }
+            if (name == "album") {
+                if (state & (1u << 3))
+                    return -1;
+                state |= 1u << 3;
+                return 2;
+            }
+            if (name == "year") {
+                if (state & (1u << 4))
+                    return -1;
+                state |= 1u << 4;
+                return 12;
+            }
+            if (name == "dateAdded") {
+                if (state & (1u << 5))
+                    return -1;
+                state |= 1u << 5;
+                return 13;
+            }
+            if (name == "transpose") {
+                if (state & (1u << 6))
+                    return -1;
+                state |= 1u << 6;
+                return 14;
+            }
+            return -1;
+        }
+
+        /**
+         * Content of anonymous type of <authors>.
+         */
+        int child_11(std::uint32_t& state, std::string_view name) {
+            switch (state) {
+                case 0:
+                    if (name == "author") {
+                        state = 1;
+                        return 2;
+                    }
+                    break;
+                case 1:
+                    if (name == "author") {
+                        return 2;
+                    }
+                    break;
+            }
+            return -1;
+        }
+
+        /**
+         * Content of verseType.
+         */
+        int child_15(std::uint32_t& state, std::string_view name) {
+            switch (state) {
+                case 0:
+                    if (name == "line") {
+                        return 16;
+                    }
+                    break;
+            }
+            return -1;
+        }
+
+        /**
+         * Content of lineType.
+         */
+        int child_16(std::uint32_t& state, std::string_view name) {
+            switch (state) {
+                case 0:
+                    if (name == "chord") {
+                        return 17;
+                    }
+                    break;
+            }
+            return -1;
+        }
+
+        /**
+         * Content of multicolsType.
+         */
+        int child_19(std::uint32_t& state, std::string_view name) {
+            switch (state) {
+                case 0:
+                    if (name == "chorus") {
+                        return 15;
+                    }
+                    if (name == "columnbreak") {
+                        return 18;
+                    }
+                    if (name == "line") {
+                        return 16;
+                    }
+                    if (name == "verse") {
+                        return 15;
+                    }
+                    break;
+            }
+            return -1;
+        }
+
+    }
+
+    //------  Nonmember functions ------
+
+    const TypeInfo& type_info(int type) {
+        return types[type];
+    }
+
+    int global_element(std::string_view name) {
+        if (name == "songbook")
+            return 0;
+        if (name == "entities")
+            return 5;
+        if (name == "author")
+            return 2;
+        if (name == "authors")
+            return 11;
+        if (name == "verse")
+            return 15;
+        if (name == "chorus")
+            return 15;
+        if (name == "line")
+            return 16;
+        if (name == "columnbreak")
+            return 18;
+        return -1;
+    }
+
+    int child_element(int type, std::uint32_t& state, std::string_view name) {
+        switch (type) {
+            case 0: return child_0(state, name);
+            case 1: return child_1(state, name);
+            case 5: return child_5(state, name);
+            case 6: return child_6(state, name);
+            case 8: return child_8(state, name);
+            case 9: return child_9(state, name);
+            case 10: return child_10(state, name);
+            case 11: return child_11(state, name);
+            case 15: return child_15(state, name);
+            case 16: return child_16(state, name);
+            case 19: return child_19(state, name);
+        }
+        return -1;
+    }
+
+    bool content_complete(int type, std::uint32_t state) {
+        switch (type) {
+            case 0: return true;
+            case 1: return true;
+            case 5: return state == 1;
+            case 6: return (state & 3u) == 3u;
+            case 8: return true;
+            case 9: return state == 1;
+            case 10: return (state & 33u) == 33u;
+            case 11: return state == 1;
+            case 15: return true;
+            case 16: return true;
+            case 19: return true;
+        }
+        return true;
+    }
+
+    std::string expected_elements(int type, std::uint32_t state) {
+        switch (type) {
+            case 0:
+                switch (state) {
+                    case 0: return "settings, songs";
+                    case 1: return "songs";
+                }
+                break;
+            case 1:
+            {
+                std::string names;
+                if (!(state & (1u << 0)))
+                    names += names.empty() ? "language" : ", language";
+                if (!(state & (1u << 1)))
+                    names += names.empty() ? "sortSongsBy" : ", sortSongsBy";
+                if (!(state & (1u << 2)))
+                    names += names.empty() ? "chorusLabel" : ", chorusLabel";
+                if (!(state & (1u << 3)))
+                    names += names.empty() ? "tocTitle" : ", tocTitle";
+                if (!(state & (1u << 4)))
+                    names += names.empty() ? "mainFont" : ", mainFont";
+                if (!(state & (1u << 5)))
+                    names += names.empty() ? "chordFont" : ", chordFont";
+                if (!(state & (1u << 6)))
+                    names += names.empty() ? "pdfMainFontFile" : ", pdfMainFontFile";
+                if (!(state & (1u << 7)))
+                    names += names.empty() ? "pdfChordFontFile" : ", pdfChordFontFile";
+                if (!(state & (1u << 8)))
+                    names += names.empty() ? "convertAddedSince" : ", convertAddedSince";
+                if (!(state & (1u << 9)))
+                    names += names.empty() ? "entities" : ", entities";
+                return names;
+            }
+            case 5:
+                switch (state) {
+                    case 0: return "entity";
+                    case 1: return "entity";
+                }
+                break;
+            case 6:
+            {
+                std::string names;
+                if (!(state & (1u << 0)))
+                    names += names.empty() ? "name" : ", name";
+                if (!(state & (1u << 1)))
+                    names += names.empty() ? "value" : ", value";
+                return names;
+            }
+            case 8:
+                switch (state) {
+                    case 0: return "song";
+                }
+                break;
+            case 9:
+                switch (state) {
+                    case 0: return "header";
+                    case 1: return "chorus, columnbreak, line, multicols, verse";
+                }
+                break;
+            case 10:
+            {
+                std::string names;
+                if (!(state & (1u << 0)))
+                    names += names.empty() ? "name" : ", name";
+                if (!(state & (1u << 1)))
+                    names += names.empty() ? "sortingName" : ", sortingName";
+                if (!(state & (1u << 2)))
+                    names += names.empty() ? "author, authors" : ", author, authors";
+                if (!(state & (1u << 3)))
+                    names += names.empty() ? "album" : ", album";
+                if (!(state & (1u << 4)))
+                    names += names.empty() ? "year" : ", year";
+                if (!(state & (1u << 5)))
+                    names += names.empty() ? "dateAdded" : ", dateAdded";
+                if (!(state & (1u << 6)))
+                    names += names.empty() ? "transpose" : ", transpose";
+                return names;
+            }
+            case 11:
+                switch (state) {
+                    case 0: return "author";
+                    case 1: return "author";
+                }
+                break;
+            case 15:
+                switch (state) {
+                    case 0: return "line";
+                }
+                break;
+            case 16:
+                switch (state) {
+                    case 0: return "chord";
+                }
+                break;
+            case 19:
+                switch (state) {
+                    case 0: return "chorus, columnbreak, line, verse";
+                }
+                break;
+        }
+        return "";
+    }
+
+    bool check_value(int simple_type, std::string_view value) {
+        switch (simple_type) {
+            case 0: return check_simple_0(value);
+            case 1: return check_simple_1(value);
+            case 2: return check_simple_2(value);
+            case 3: return check_simple_3(value);
+            case 4: return check_simple_4(value);
+            case 5: return check_simple_5(value);
+            case 6: return check_simple_6(value);
+            case 7: return check_simple_7(value);
+            case 8: return check_simple_8(value);
+            case 9: return check_simple_9(value);
+            case 10: return check_simple_10(value);
+            case 11: return check_simple_11(value);
+            case 12: return check_simple_12(value);
+            case 13: return check_simple_13(value);
+            case 14: return check_simple_14(value);
+            case 15: return check_simple_15(value);
+        }
+        return true;
+    }
+
+    const char* simple_type_name(int simple_type) {
+        switch (simple_type) {
+            case 0: return "xs:string";
+            case 1: return "sortSongsByType";
+            case 2: return "xs:date";
+            case 3: return "convertAddedSinceType (member 1)";
+            case 4: return "xs:token";
+            case 5: return "convertAddedSinceType (member 2)";
+            case 6: return "convertAddedSinceType";
+            case 7: return "xs:Name";
+            case 8: return "xs:gYear";
+            case 9: return "dateAddedType (member 1)";
+            case 10: return "dateAddedType (member 2)";
+            case 11: return "dateAddedType";
+            case 12: return "xs:integer";
+            case 13: return "noteType";
+            case 14: return "yesNoType";
+            case 15: return "numberColumnsType";
+        }
+        return "";
+    }
+
+    bool is_any_string(int simple_type) {
+        return simple_type == 0;
+    }
+}
@@ -0,0 +1,163 @@
+/**
+ * @file
+ *
+ * Interface of the validation tables and state machines generated from
+ * the XML schema (xmlSchema.cpp) by generate_validator.py during the
+ * build. Used by schemaValidator.cpp.
+ *
+ * Element content is checked by a state machine per complex type: the
+ * state starts at 0 and each child element moves it on. Types with an
+ * `<xs:all>` group use a bit set of the elements seen as their state.
+ */
+
+#ifndef SONGBOOK_GENERATEDSCHEMA_HPP
+#define SONGBOOK_GENERATEDSCHEMA_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace songbook::generated_schema {
+
+    /**
+     * What an element can contain.
+     */
+    enum class Content {
+        empty,     ///< nothing (whitespace and comments only)
+        simple,    ///< text of a simple type
+        elements,  ///< child elements (and whitespace)
+        mixed      ///< child elements and text
+    };
+
+    /**
+     * An attribute declaration.
+     */
+    struct AttributeInfo {
+        const char* name;  ///< attribute name
+        int simple_type;   ///< simple type index (see `check_value()`)
+        bool required;     ///< is the attribute required?
+    };
+
+    /**
+     * An element type.
+     */
+    struct TypeInfo {
+        const char* name;                  ///< type name (for messages)
+        Content content;                   ///< element content
+        int simple_type;                   ///< simple type of `simple` content, -1 otherwise
+        const AttributeInfo* attributes;   ///< declared attributes
+        int n_attributes;                  ///< number of declared attributes
+    };
+
+    /**
+     * Returns an element type.
+     *
+     * @param type type index
+     * @return type information
+     */
+    const TypeInfo& type_info(int type);
+
+    /**
+     * Finds a global element which can be the document root.
+     *
+     * @param name element name
+     * @return type index of the element, -1 when not declared
+     */
+    int global_element(std::string_view name);
+
+    /**
+     * Moves the content state machine of an element by a child element.
+     *
+     * @param type type index of the parent element
+     * @param state state of the parent element; updated when the child is allowed
+     * @param name child element name
+     * @return type index of the child, -1 when it is not allowed in `state`
+     */
+    int child_element(int type, std::uint32_t& state, std::string_view name);
+
+    /**
+     * Can the content of an element end in a state?
+     *
+     * @param type type index of the element
+     * @param state state of the element
+     * @return `true` when no other child element is required
+     */
+    bool content_complete(int type, std::uint32_t state);
+
+    /**
+     * Lists child elements allowed in a state (for error messages).
+     *
+     * @param type type index of the element
+     * @param state state of the element
+     * @return element names separated by commas
+     */
+    std::string expected_elements(int type, std::uint32_t state);
+
+    /**
+     * Checks a value against a simple type. Whitespace is processed as
+     * the type's `whiteSpace` facet requires.
+     *
+     * @param simple_type simple type index
+     * @param value value with references expanded
+     * @return `true` for a valid value
+     */
+    bool check_value(int simple_type, std::string_view value);
+
+    /**
+     * Returns a simple type name (for messages).
+     *
+     * @param simple_type simple type index
+     * @return type name (e.g. `noteType`, `xs:date`)
+     */
+    const char* simple_type_name(int simple_type);
+
+    /**
+     * Is a simple type `xs:string` without restrictions (so its values
+     * need not be checked)?
+     *
+     * @param simple_type simple type index
+     * @return `true` for unrestricted strings
+     */
+    bool is_any_string(int simple_type);
+
+
+    // checks of built-in XML Schema types used by the generated code
+    //   (schemaValidator.cpp); values are already collapsed
+
+    /**
+     * Is `value` a valid `xs:date` (`[-]YYYY-MM-DD` with an optional time zone)?
+     */
+    bool is_date(std::string_view value);
+
+    /**
+     * Is `value` a valid `xs:gYear` (`[-]YYYY` with an optional time zone)?
+     */
+    bool is_g_year(std::string_view value);
+
+    /**
+     * Is `value` a valid `xs:integer`?
+     *
+     * @param value value to check
+     * @param result the integer (saturated when out of the range of `long long`)
+     * @return `true` for a valid integer
+     */
+    bool is_integer(std::string_view value, long long& result);
+
+    /**
+     * Is `value` a valid `xs:Name`? Characters other than ASCII are
+     * treated as name characters.
+     */
+    bool is_name(std::string_view value);
+
+    /**
+     * Replaces whitespace sequences with single spaces and removes
+     * leading and trailing whitespace (`whiteSpace="collapse"`).
+     *
+     * @param value value to collapse
+     * @param buffer storage for the result when it differs from `value`
+     * @return collapsed value
+     */
+    std::string_view collapse_whitespace(std::string_view value, std::string& buffer);
+}
+
+#endif  // SONGBOOK_GENERATEDSCHEMA_HPP
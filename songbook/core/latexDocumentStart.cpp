@@ -1,26 +1,24 @@
 #include <string>
 
 namespace songbook {
-   std::string latex_document_start = R"(\documentclass[a4paper,10pt]{article}
+   /*
+    * The static part of the preamble does not depend on any parameters and 
+    * can therefore be dumped into a precompiled format. It must not load any 
+    * fonts (XeTeX cannot dump native fonts) and must end with `\endofdump`
+    * (hidden in `\csname` so that it is harmless when no format is used).
+    */
+   std::string latex_format_preamble = R"(\documentclass[a4paper,10pt]{article}
 
 \usepackage{fontspec}
 \usepackage{xunicode}
 \usepackage{polyglossia}
 \setmainlanguage{czech}
-\setmainfont[Mapping=tex-text]{@@@mainFont@@@}
-\setsansfont{@@@chordFont@@@}
 \usepackage[width=18cm, height=26.5cm, top=1.5cm]{geometry}
 \usepackage{multicol}
 \usepackage[unicode, hidelinks]{hyperref}
 \usepackage[titles]{tocloft}  % table of contents formatting
 \usepackage{titlesec}         % section formatting
 
-%%  Define labels
-%   chorus
-\newcommand{\choruslabel}{@@@chorusLabel@@@}
-%   TOC
-\newcommand{\toctitle}{@@@tocTitle@@@}
-
 % sections and below won't be numbered
 \setcounter{secnumdepth}{0}
 
@@ -55,10 +53,8 @@ namespace songbook {
 %%  Verse
 \renewcommand{\verse}[1]{#1\vskip\baselineskip}
 
-%%  Measure chorus indent
+%%  Chorus indent (measured once the fonts are set)
 \newlength\chorusindent
-\setbox\chordhypbox=\hbox{\choruslabel\hskip1em}
-\setlength{\chorusindent}{\wd\chordhypbox}
 
 %%  Chorus
 \newcommand{\chorus}[1]{{\leftskip=\chorusindent\parindent=-\chorusindent\indent\hbox to\chorusindent{\textit{\choruslabel}\hfill}#1\par\vskip\baselineskip}}
@@ -112,6 +108,27 @@ namespace songbook {
 
 \pagestyle{empty}
 
+\csname endofdump\endcsname
+)";
+
+   /*
+    * Parameter-dependent part of the preamble followed by the beginning 
+    * of the document.
+    */
+   std::string latex_document_start = R"(
+\setmainfont[Mapping=tex-text]{@@@mainFont@@@}
+\setsansfont{@@@chordFont@@@}
+
+%%  Define labels
+%   chorus
+\newcommand{\choruslabel}{@@@chorusLabel@@@}
+%   TOC
+\newcommand{\toctitle}{@@@tocTitle@@@}
+
+%%  Measure chorus indent
+\setbox\chordhypbox=\hbox{\choruslabel\hskip1em}
+\setlength{\chorusindent}{\wd\chordhypbox}
+
 \begin{document}
 \raggedright
 
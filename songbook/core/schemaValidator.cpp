@@ -0,0 +1,457 @@
+#include "schemaValidator.hpp"
+#include "generatedSchema.hpp"
+#include "xmlCursor.hpp"
+#include "SongbookException.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace songbook {
+
+    using namespace generated_schema;
+
+    namespace {
+
+        /**
+         * Element being validated.
+         */
+        struct OpenElement {
+            std::string_view name;  ///< element name
+            int type;               ///< type index, -1 for elements not validated
+            std::uint32_t state;    ///< state of the content state machine
+            std::string value;      ///< text of simple content which is checked
+        };
+
+        /**
+         * Is the whole text XML whitespace?
+         */
+        bool is_whitespace(std::string_view text) {
+            for (char c: text) {
+                if (!is_xml_space(c))
+                    return false;
+            }
+            return true;
+        }
+
+        /**
+         * Checks an XML in a single pass and collects the errors.
+         */
+        class SchemaValidator {
+
+            public:
+            /**
+             * Constructor.
+             *
+             * @param xml XML to validate
+             * @param entities entity values
+             * @param line_offset number of lines before `xml`
+             */
+            SchemaValidator(std::string_view xml, const TagValueMap& entities, int line_offset):
+                cursor{xml, entities, line_offset} {}
+
+            /**
+             * Validates the XML.
+             *
+             * @param root name of the expected root element
+             * @return errors found, one per line (empty when valid)
+             */
+            std::string validate(std::string_view root) {
+                try {
+                    read(root);
+                } catch (const SongbookException& e) {
+                    // reading can't continue
+                    errors += e.what();
+                    errors += '\n';
+                }
+                if (!errors.empty())
+                    errors.pop_back();
+                return std::move(errors);
+            }
+
+            private:
+            /**
+             * Reads all tokens.
+             *
+             * @param root name of the expected root element
+             */
+            void read(std::string_view root) {
+                bool root_read = false;
+                for (Token token = cursor.next(); token.type != TokenType::eof;
+                    token = cursor.next()) {
+
+                    switch (token.type) {
+                        case TokenType::start:
+                            if (open.empty() && root_read)
+                                cursor.error_at(token.offset, "content after the root element");
+                            if (open.empty()) {
+                                start_root(token, root);
+                                root_read = true;
+                            } else {
+                                start_child(token);
+                            }
+                            break;
+                        case TokenType::end:
+                            end_element(token);
+                            break;
+                        case TokenType::text:
+                        case TokenType::cdata:
+                            text(token);
+                            break;
+                        default:
+                            break;
+                    }
+                }
+                if (!root_read)
+                    cursor.error("root element <" + std::string{root} + "> missing");
+                if (!open.empty())
+                    cursor.error("unexpected end of the XML");
+            }
+
+            /**
+             * Processes the root start tag.
+             *
+             * @param token the start tag
+             * @param root name of the expected root element
+             */
+            void start_root(const Token& token, std::string_view root) {
+                int type = global_element(token.name);
+                if (token.name != root || type < 0) {
+                    add_error(token.offset, "root element must be <" + std::string{root} +
+                        ">, not <" + std::string{token.name} + ">");
+                    type = -1;
+                }
+                push(token, type);
+            }
+
+            /**
+             * Processes a start tag inside the root element.
+             *
+             * @param token the start tag
+             */
+            void start_child(const Token& token) {
+                OpenElement& parent = open.back();
+                int type = -1;
+                if (parent.type >= 0) {
+                    const TypeInfo& parent_info = type_info(parent.type);
+                    std::uint32_t state = parent.state;
+                    if (parent_info.content == Content::elements ||
+                        parent_info.content == Content::mixed)
+                        type = child_element(parent.type, state, token.name);
+
+                    if (type >= 0) {
+                        parent.state = state;
+                    } else {
+                        std::string expected = expected_elements(parent.type, parent.state);
+                        add_error(token.offset, "element <" + std::string{token.name} +
+                            "> is not allowed in <" + std::string{parent.name} + ">" +
+                            (expected.empty() ? std::string{} : "; expected: " + expected));
+                    }
+                }
+                push(token, type);
+            }
+
+            /**
+             * Starts validating an element and checks its attributes.
+             *
+             * @param token the start tag
+             * @param type type index of the element (-1: not validated)
+             */
+            void push(const Token& token, int type) {
+                open.push_back(OpenElement{token.name, type, 0, {}});
+                if (type < 0)
+                    return;
+
+                const TypeInfo& info = type_info(type);
+                std::uint32_t seen{0};
+                cursor.for_each_raw_attribute(token.value,
+                    [this, &info, &seen, &token](std::string_view name, std::string_view raw) {
+                        attribute(info, token.name, name, raw, seen);
+                    });
+
+                for (int i = 0; i < info.n_attributes; ++i) {
+                    if (info.attributes[i].required && !(seen & (1u << i)))
+                        add_error(token.offset, "required attribute '" +
+                            std::string{info.attributes[i].name} + "' missing in <" +
+                            std::string{token.name} + ">");
+                }
+            }
+
+            /**
+             * Checks an attribute.
+             *
+             * @param info type of the element
+             * @param element element name
+             * @param name attribute name
+             * @param raw attribute value as written in the XML
+             * @param seen attributes already found (bits by declaration index)
+             */
+            void attribute(const TypeInfo& info, std::string_view element, std::string_view name,
+                std::string_view raw, std::uint32_t& seen) {
+
+                size_t offset = cursor.offset_of(name);
+                // namespace declarations and schema location hints
+                if (name.compare(0, 5, "xmlns") == 0 || name.compare(0, 4, "xsi:") == 0) {
+                    cursor.check_references(raw);
+                    return;
+                }
+
+                for (int i = 0; i < info.n_attributes; ++i) {
+                    const AttributeInfo& decl = info.attributes[i];
+                    if (name != decl.name)
+                        continue;
+
+                    if (seen & (1u << i))
+                        add_error(offset, "attribute '" + std::string{name} +
+                            "' specified more than once");
+                    seen |= 1u << i;
+                    if (is_any_string(decl.simple_type)) {
+                        cursor.check_references(raw);
+                    } else if (raw.find_first_of("&\t\n\r") == std::string_view::npos ?
+                        !check_value(decl.simple_type, raw) :
+                        !check_value(decl.simple_type, cursor.expand(raw, true))) {
+                        add_error(offset, "value '" + cursor.expand(raw, true) +
+                            "' of attribute '" + std::string{name} + "' is not valid for type " +
+                            simple_type_name(decl.simple_type));
+                    }
+                    return;
+                }
+                add_error(offset, "attribute '" + std::string{name} + "' is not allowed in <" +
+                    std::string{element} + ">");
+            }
+
+            /**
+             * Processes text or a CDATA section.
+             *
+             * @param token the text
+             */
+            void text(const Token& token) {
+                if (open.empty()) {
+                    if (token.type == TokenType::cdata || !is_whitespace(token.value))
+                        cursor.error_at(token.offset, "text outside of the root element");
+                    return;
+                }
+
+                OpenElement& element = open.back();
+                if (element.type < 0) {
+                    if (token.type == TokenType::text)
+                        cursor.check_references(token.value);
+                    return;
+                }
+
+                const TypeInfo& info = type_info(element.type);
+                if (info.content == Content::simple && !is_any_string(info.simple_type)) {
+                    // the whole value is checked at the end of the element
+                    element.value += token.type == TokenType::text ?
+                        cursor.expand(token.value, false) : std::string{token.value};
+                } else if (token.type == TokenType::text) {
+                    cursor.check_references(token.value);
+                }
+
+                if ((info.content == Content::elements || info.content == Content::empty) &&
+                    !is_whitespace(token.value)) {
+                    add_error(token.offset, "text is not allowed in <" +
+                        std::string{element.name} + ">");
+                }
+            }
+
+            /**
+             * Processes an end tag and checks the element's content.
+             *
+             * @param token the end tag
+             */
+            void end_element(const Token& token) {
+                OpenElement element = std::move(open.back());
+                open.pop_back();
+                if (element.type < 0)
+                    return;
+
+                const TypeInfo& info = type_info(element.type);
+                if (info.content == Content::simple) {
+                    if (!is_any_string(info.simple_type) &&
+                        !check_value(info.simple_type, element.value)) {
+                        add_error(token.offset, "value '" + element.value + "' of <" +
+                            std::string{element.name} + "> is not valid for type " +
+                            simple_type_name(info.simple_type));
+                    }
+                } else if (!content_complete(element.type, element.state)) {
+                    add_error(token.offset, "content of <" + std::string{element.name} +
+                        "> is incomplete; expected: " +
+                        expected_elements(element.type, element.state));
+                }
+            }
+
+            /**
+             * Adds an error message.
+             *
+             * @param offset position of the error in the input
+             * @param message error description
+             */
+            void add_error(size_t offset, const std::string& message) {
+                XmlLocation loc = cursor.location(offset);
+                errors += "XML line " + std::to_string(loc.line) + ", column " +
+                    std::to_string(loc.column) + ": " + message + '\n';
+            }
+
+            XmlCursor cursor;                ///< tokens of the input
+            std::vector<OpenElement> open;   ///< elements being read
+            std::string errors;              ///< errors found, each ending with a newline
+        };
+
+        /**
+         * Number of decimal digits at the start of a string.
+         */
+        size_t count_digits(std::string_view str) {
+            size_t n = 0;
+            while (n < str.size() && str[n] >= '0' && str[n] <= '9')
+                ++n;
+            return n;
+        }
+
+        /**
+         * Value of a string of decimal digits.
+         */
+        int digits_value(std::string_view digits) {
+            int value = 0;
+            for (char c: digits)
+                value = value * 10 + (c - '0');
+            return value;
+        }
+
+        /**
+         * Reads the year of a date (`[-]YYYY`, more digits without a
+         * leading zero; year 0000 is not allowed).
+         *
+         * @param value value starting with the year; the year is removed
+         * @param year the year (only its last four digits for leap years)
+         * @return `false` for an invalid year
+         */
+        bool read_year(std::string_view& value, int& year) {
+            if (!value.empty() && value[0] == '-')
+                value.remove_prefix(1);
+            size_t n = count_digits(value);
+            if (n < 4 || (n > 4 && value[0] == '0'))
+                return false;
+            std::string_view digits = value.substr(0, n);
+            if (digits.find_first_not_of('0') == std::string_view::npos)
+                return false;
+            year = digits_value(digits.substr(n - 4));
+            value.remove_prefix(n);
+            return true;
+        }
+
+        /**
+         * Is the rest of a date a valid time zone (`Z`, `+hh:mm`, `-hh:mm`
+         * or nothing)?
+         */
+        bool is_time_zone(std::string_view value) {
+            if (value.empty() || value == "Z")
+                return true;
+            if (value.size() != 6 || (value[0] != '+' && value[0] != '-') || value[3] != ':' ||
+                count_digits(value.substr(1, 2)) != 2 || count_digits(value.substr(4)) != 2)
+                return false;
+            int hours = digits_value(value.substr(1, 2));
+            int minutes = digits_value(value.substr(4));
+            return minutes < 60 && (hours < 14 || (hours == 14 && minutes == 0));
+        }
+    }
+
+    //------  Nonmember functions ------
+
+    void validate_xml(std::string_view xml, const TagValueMap& entities, std::string_view root,
+        int line_offset) {
+
+        std::string errors = SchemaValidator{xml, entities, line_offset}.validate(root);
+        if (!errors.empty())
+            throw SongbookException(errors);
+    }
+
+    bool generated_schema::is_date(std::string_view value) {
+        int year;
+        if (!read_year(value, year))
+            return false;
+        if (value.size() < 6 || value[0] != '-' || value[3] != '-' ||
+            count_digits(value.substr(1, 2)) != 2 || count_digits(value.substr(4, 2)) != 2)
+            return false;
+
+        int month = digits_value(value.substr(1, 2));
+        int day = digits_value(value.substr(4, 2));
+        // the last 4 digits decide about leap years (400 divides 10000)
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        const int month_days[]{31, leap ? 29 : 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        if (month < 1 || month > 12 || day < 1 || day > month_days[month - 1])
+            return false;
+        return is_time_zone(value.substr(6));
+    }
+
+    bool generated_schema::is_g_year(std::string_view value) {
+        int year;
+        return read_year(value, year) && is_time_zone(value);
+    }
+
+    bool generated_schema::is_integer(std::string_view value, long long& result) {
+        bool negative = !value.empty() && value[0] == '-';
+        if (!value.empty() && (value[0] == '-' || value[0] == '+'))
+            value.remove_prefix(1);
+        if (value.empty() || count_digits(value) != value.size())
+            return false;
+
+        const long long max = std::numeric_limits<long long>::max();
+        result = 0;
+        for (char c: value) {
+            if (result > (max - (c - '0')) / 10) {
+                result = negative ? std::numeric_limits<long long>::min() : max;
+                return true;
+            }
+            result = result * 10 + (c - '0');
+        }
+        if (negative)
+            result = -result;
+        return true;
+    }
+
+    bool generated_schema::is_name(std::string_view value) {
+        if (value.empty())
+            return false;
+        for (size_t i = 0; i < value.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(value[i]);
+            bool start_char = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+                c == ':' || c >= 0x80;
+            bool name_char = (c >= '0' && c <= '9') || c == '-' || c == '.';
+            if (!start_char && (i == 0 || !name_char))
+                return false;
+        }
+        return true;
+    }
+
+    std::string_view generated_schema::collapse_whitespace(std::string_view value,
+        std::string& buffer) {
+
+        size_t start = 0;
+        while (start < value.size() && is_xml_space(value[start]))
+            ++start;
+        size_t end = value.size();
+        while (end > start && is_xml_space(value[end - 1]))
+            --end;
+        value = value.substr(start, end - start);
+
+        // a copy is only needed when whitespace inside has to be replaced
+        bool collapsed = true;
+        for (size_t i = 0; i < value.size() && collapsed; ++i) {
+            if (is_xml_space(value[i]) && (value[i] != ' ' || is_xml_space(value[i + 1])))
+                collapsed = false;
+        }
+        if (collapsed)
+            return value;
+
+        buffer.clear();
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (!is_xml_space(value[i]))
+                buffer += value[i];
+            else if (!is_xml_space(value[i - 1]))
+                buffer += ' ';
+        }
+        return buffer;
+    }
+}
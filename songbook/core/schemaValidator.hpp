@@ -0,0 +1,38 @@
+/**
+ * @file
+ *
+ * Validation of songbook XML by state machines generated from the XML
+ * schema at build time (generate_validator.py), without Xerces.
+ *
+ * The validator makes a single pass over the input (using `XmlCursor`)
+ * and checks element content models, attributes and values of simple
+ * types. It checks the same constraints as Xerces with the schema, so
+ * validated input can then be read by the fast reader from trustedXml.hpp.
+ * Errors are reported with line and column numbers.
+ */
+
+#ifndef SONGBOOK_SCHEMAVALIDATOR_HPP
+#define SONGBOOK_SCHEMAVALIDATOR_HPP
+
+#include "songbookTypes.hpp"
+
+#include <string_view>
+
+namespace songbook {
+
+    /**
+     * Validates an XML against the songbook schema.
+     *
+     * @param xml songbook XML or its part (without the DTD)
+     * @param entities values of all entities which can be referenced
+     * @param root name of the expected root element (`songbook` or `entities`)
+     * @param line_offset number of lines before `xml` (for error messages)
+     * @throw SongbookException the XML is not valid; the message lists all
+     * errors found (or those before the first error which made reading
+     * impossible), one per line, with line and column numbers
+     */
+    void validate_xml(std::string_view xml, const TagValueMap& entities,
+        std::string_view root = "songbook", int line_offset = 0);
+}
+
+#endif  // SONGBOOK_SCHEMAVALIDATOR_HPP
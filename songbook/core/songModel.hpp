@@ -0,0 +1,71 @@
+/**
+ * @file
+ *
+ * Printer-independent representation of a parsed songbook.
+ */
+
+#ifndef SONGBOOK_SONGMODEL_HPP
+#define SONGBOOK_SONGMODEL_HPP
+
+#include "songbookTypes.hpp"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace songbook {
+
+    /**
+     * Type of a song content event.
+     */
+    enum class SongEventType {
+        multicols_start,  /**< `<multicols>` starts */
+        columnbreak,      /**< `<columnbreak>` */
+        multicols_end,    /**< `<multicols>` ends */
+        verse_start,      /**< `<verse>` or `<chorus>` starts */
+        verse_end,        /**< `<verse>` or `<chorus>` ends */
+        line              /**< `<line>` */
+    };
+
+    /**
+     * Lyrics or chord inside a line.
+     */
+    struct LineElement {
+        LineItemType type;  /**< lyrics or chord */
+        std::string lyrics; /**< lyrics text (for lyrics) */
+        TagValueMap chord;  /**< chord attribute-value pairs (for chords) */
+    };
+
+    /**
+     * One item of song content in document order. Nested elements (verses
+     * inside multicols) are represented by start and end events.
+     */
+    struct SongEvent {
+        SongEventType type{SongEventType::line};  /**< event type */
+        VerseType verse_type{verse};     /**< verse type (verse start/end) */
+        std::string number{};            /**< number of columns (multicols start) */
+        std::vector<LineElement> line{}; /**< line content (line) */
+    };
+
+    /**
+     * A song read from the XML.
+     */
+    struct SongData {
+        TagValueMultiMap header;         /**< element-value pairs from the header (without `transpose`) */
+        int transpose{0};                /**< song's own transposition in semitones */
+        std::vector<SongEvent> events;   /**< song content */
+    };
+
+    /**
+     * A whole songbook read from the XML.
+     */
+    struct SongbookData {
+        /**
+         * Setting name-value pairs in document order (without `<entities>`).
+         */
+        std::vector<std::pair<std::string, std::string>> settings;
+        std::vector<SongData> songs;     /**< songs in document order */
+    };
+}
+
+#endif  // SONGBOOK_SONGMODEL_HPP
@@ -9,6 +9,7 @@
 
 #include <map>
 #include <string>
+#include <string_view>
 
 namespace songbook {
     /**
@@ -37,18 +38,20 @@ namespace songbook {
     enum SortSongsBy {name, dateAdded, none};
 
     /**
-     * Lyrics or chord line item structure.
+     * Lyrics or chord line item structure. The value is not owned by the 
+     * item; it refers to text which lives until the line is printed 
+     * (see `LineBuffer`).
      */
     struct LineItem {
-        LineItemType type;  /**< type of the item */
-        std::string value;  /**< item's value*/
+        LineItemType type;       /**< type of the item */
+        std::string_view value;  /**< item's value*/
         /**
          * Constructor
          * 
          * @param type line item type
          * @param value value of the item
          */
-        LineItem(LineItemType type, std::string&& value);
+        LineItem(LineItemType type, std::string_view value);
     };
 
     /**
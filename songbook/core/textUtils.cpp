@@ -0,0 +1,200 @@
+#include "textUtils.hpp"
+
+#include <algorithm>
+
+namespace songbook {
+
+    std::u32string utf8_to_utf32(std::string_view str) {
+        std::u32string result;
+        result.reserve(str.size());
+
+        size_t i = 0;
+        while (i < str.size()) {
+            unsigned char c = str[i];
+            // number of continuation bytes and the initial code point bits
+            int n_cont;
+            char32_t cp;
+            if (c < 0x80) {
+                n_cont = 0;
+                cp = c;
+            } else if ((c & 0xe0) == 0xc0) {
+                n_cont = 1;
+                cp = c & 0x1f;
+            } else if ((c & 0xf0) == 0xe0) {
+                n_cont = 2;
+                cp = c & 0x0f;
+            } else if ((c & 0xf8) == 0xf0) {
+                n_cont = 3;
+                cp = c & 0x07;
+            } else {  // stray continuation byte or invalid lead byte
+                result.push_back(0xfffd);
+                ++i;
+                continue;
+            }
+
+            int j = 1;
+            for (; j <= n_cont && i + j < str.size(); ++j) {
+                unsigned char cc = str[i + j];
+                if ((cc & 0xc0) != 0x80)
+                    break;
+                cp = (cp << 6) | (cc & 0x3f);
+            }
+            // truncated sequence
+            if (j <= n_cont)
+                cp = 0xfffd;
+
+            result.push_back(cp);
+            i += j;
+        }
+
+        return result;
+    }
+
+    void append_utf8(std::string& str, char32_t c) {
+        if (c < 0x80) {
+            str += static_cast<char>(c);
+        } else if (c < 0x800) {
+            str += static_cast<char>(0xc0 | (c >> 6));
+            str += static_cast<char>(0x80 | (c & 0x3f));
+        } else if (c < 0x10000) {
+            str += static_cast<char>(0xe0 | (c >> 12));
+            str += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+            str += static_cast<char>(0x80 | (c & 0x3f));
+        } else {
+            str += static_cast<char>(0xf0 | (c >> 18));
+            str += static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+            str += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+            str += static_cast<char>(0x80 | (c & 0x3f));
+        }
+    }
+
+    namespace {
+        /**
+         * Base letters of the Latin Extended-A block (U+0100 to U+017F).
+         */
+        const char latin_extended_a[] =
+            "aaaaaaccccccccddddeeeeeeeeeegggggggghhhhiiiiiiiiiiiijjkkklllllll"
+            "lllnnnnnnnnnoooooooorrrrrrssssssssttttttuuuuuuuuuuuuwwyyyzzzzzzs";
+    }
+
+    void fold_char(char32_t c, std::u32string& folded) {
+        if (c < 0x80) {
+            folded.push_back((c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c);
+            return;
+        }
+
+        // Latin-1 Supplement
+        if (c >= 0xc0 && c <= 0xff) {
+            static const char latin_1[] = 
+                "aaaaaaaceeeeiiiidnooooo\0ouuuuyts"   // U+00C0 - U+00DF
+                "aaaaaaaceeeeiiiidnooooo\0ouuuuyty";  // U+00E0 - U+00FF
+            char base = latin_1[c - 0xc0];
+            if (c == 0xc6 || c == 0xe6) {                // æ
+                folded.append(U"ae");
+            } else if (c == 0xdf) {                      // ß
+                folded.append(U"ss");
+            } else if (base) {
+                folded.push_back(static_cast<char32_t>(base));
+            } else {                                     // × and ÷
+                folded.push_back(c);
+            }
+            return;
+        }
+
+        // Latin Extended-A
+        if (c >= 0x100 && c <= 0x17f) {
+            if (c == 0x132 || c == 0x133)                // ĳ
+                folded.append(U"ij");
+            else if (c == 0x152 || c == 0x153)           // œ
+                folded.append(U"oe");
+            else
+                folded.push_back(static_cast<char32_t>(latin_extended_a[c - 0x100]));
+            return;
+        }
+
+        // combining diacritical marks
+        if (c >= 0x300 && c <= 0x36f)
+            return;
+
+        // Greek: accented vowels and capital letters
+        if (c >= 0x386 && c <= 0x3ce) {
+            switch (c) {
+                case 0x386: case 0x3ac: folded.push_back(0x3b1); return;  // ά
+                case 0x388: case 0x3ad: folded.push_back(0x3b5); return;  // έ
+                case 0x389: case 0x3ae: folded.push_back(0x3b7); return;  // ή
+                case 0x38a: case 0x3af: case 0x3aa: case 0x3ca: case 0x390:
+                    folded.push_back(0x3b9); return;                       // ί
+                case 0x38c: case 0x3cc: folded.push_back(0x3bf); return;  // ό
+                case 0x38e: case 0x3cd: case 0x3ab: case 0x3cb: case 0x3b0:
+                    folded.push_back(0x3c5); return;                       // ύ
+                case 0x38f: case 0x3ce: folded.push_back(0x3c9); return;  // ώ
+                case 0x3c2: folded.push_back(0x3c3); return;              // final sigma
+            }
+            if (c >= 0x391 && c <= 0x3a9)
+                c += 0x20;
+            folded.push_back(c);
+            return;
+        }
+
+        // Cyrillic capital letters
+        if (c >= 0x400 && c <= 0x40f) {
+            folded.push_back(c + 0x50);
+            return;
+        }
+        if (c >= 0x410 && c <= 0x42f) {
+            folded.push_back(c + 0x20);
+            return;
+        }
+
+        folded.push_back(c);
+    }
+
+    bool is_word_char(char32_t c) {
+        if (c < 0x80)
+            return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+
+        // Latin-1 punctuation and symbols, × and ÷
+        if (c <= 0xbf || c == 0xd7 || c == 0xf7)
+            return false;
+        // general punctuation, supplemental punctuation, CJK punctuation
+        if ((c >= 0x2000 && c <= 0x206f) || (c >= 0x2e00 && c <= 0x2e7f) ||
+            (c >= 0x3000 && c <= 0x303f))
+            return false;
+        // private use area, specials (including the replacement character)
+        if ((c >= 0xe000 && c <= 0xf8ff) || (c >= 0xfff0 && c <= 0xffff))
+            return false;
+
+        return true;
+    }
+
+    std::vector<std::string> tokenize(std::string_view text) {
+        std::vector<std::string> words;
+        std::u32string folded;
+
+        auto finish_word = [&]() {
+            if (folded.empty())
+                return;
+            std::string word;
+            for (char32_t c: folded)
+                append_utf8(word, c);
+            words.push_back(std::move(word));
+            folded.clear();
+        };
+
+        for (char32_t c: utf8_to_utf32(text)) {
+            if (is_word_char(c))
+                fold_char(c, folded);
+            else
+                finish_word();
+        }
+        finish_word();
+
+        return words;
+    }
+
+    std::string remove_separators(std::string str) {
+        std::replace_if(begin(str), end(str),
+            [](char c){ return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+        return str;
+    }
+}
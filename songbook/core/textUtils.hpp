@@ -0,0 +1,72 @@
+/**
+ * @file
+ * 
+ * Helper functions for working with UTF-8 encoded text.
+*/
+
+#ifndef SONGBOOK_TEXTUTILS_HPP
+#define SONGBOOK_TEXTUTILS_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * Decodes a UTF-8 string into code points. 
+     * 
+     * Invalid byte sequences are replaced with U+FFFD.
+     * 
+     * @param str UTF-8 encoded string
+     * @return code points of `str`
+     */
+    std::u32string utf8_to_utf32(std::string_view str);
+
+    /**
+     * Encodes one code point in UTF-8 and appends it to a string.
+     * 
+     * @param str string to append to
+     * @param c code point
+     */
+    void append_utf8(std::string& str, char32_t c);
+
+    /**
+     * Folds a code point for case- and diacritics-insensitive comparison:
+     * letters are lowercased and stripped of diacritics (Latin, Greek and 
+     * Cyrillic scripts), combining marks are removed.
+     * 
+     * @param c code point
+     * @param[out] folded string to append the folded form (zero, one or 
+     * more code points) to
+     */
+    void fold_char(char32_t c, std::u32string& folded);
+
+    /**
+     * Checks whether a code point can be a part of a word. Letters, digits
+     * and combining marks can, whitespace and punctuation cannot.
+     * 
+     * @param c code point
+     * @return `true` for word characters
+     */
+    bool is_word_char(char32_t c);
+
+    /**
+     * Splits text into words folded using `fold_char()`.
+     * 
+     * @param text UTF-8 encoded text
+     * @return folded UTF-8 encoded words in order of appearance
+     */
+    std::vector<std::string> tokenize(std::string_view text);
+
+    /**
+     * Replaces characters used as separators in line-based cache files 
+     * (tabs and newlines) by spaces.
+     * 
+     * @param str string to clean
+     * @return `str` without tabs and newlines
+     */
+    std::string remove_separators(std::string str);
+}
+
+#endif  // SONGBOOK_TEXTUTILS_HPP
@@ -0,0 +1,311 @@
+#include "trustedXml.hpp"
+#include "xmlCursor.hpp"
+#include "SongbookConverter.hpp"
+#include "SongbookException.hpp"
+#include "chordTransposition.hpp"
+#include "contentHash.hpp"
+
+#include <string>
+#include <utility>
+
+namespace songbook {
+
+    namespace {
+
+        /**
+         * Maximal depth of entity references inside entity values.
+         */
+        const int max_entity_depth{16};
+
+        /**
+         * Reads chord attributes like `SongbookConverter::read_chord()`.
+         *
+         * @param cursor cursor positioned just after the `<chord>` start tag
+         * @param attrs attributes of the start tag
+         * @return chord attribute-value pairs
+         */
+        TagValueMap read_chord(XmlCursor& cursor, std::string_view attrs) {
+            TagValueMap chord;
+            cursor.for_each_attribute(attrs, [&chord](std::string_view name, std::string value) {
+                chord.emplace(std::string{name}, std::move(value));
+            });
+            cursor.skip_element();
+
+            // schema default
+            chord.emplace("optional", "no");
+
+            // delete value when "root" is "special", remove "bass" then
+            auto root = chord.find("root");
+            if (root != chord.end() && root->second == "special")
+                root->second = "";
+            if (chord["root"].empty())
+                chord.erase("bass");
+
+            return chord;
+        }
+
+        /**
+         * Reads song content like `SongbookConverter::read_song_content()`,
+         * up to the end of the enclosing element.
+         *
+         * @param cursor cursor positioned inside the enclosing element
+         * @param events vector to append the events to
+         */
+        void read_song_content(XmlCursor& cursor, std::vector<SongEvent>& events) {
+            for (Token elem = cursor.next_element(); elem.type == TokenType::start;
+                elem = cursor.next_element()) {
+
+                if (elem.name == "multicols") {
+                    SongEvent start{SongEventType::multicols_start};
+                    start.number = "2";  // schema default
+                    cursor.for_each_attribute(elem.value,
+                        [&start](std::string_view name, std::string value) {
+                            if (name != "number")
+                                return;
+                            // integer type -- whitespace is collapsed
+                            size_t first = value.find_first_not_of(' ');
+                            size_t last = value.find_last_not_of(' ');
+                            start.number = first == std::string::npos ?
+                                "" : value.substr(first, last - first + 1);
+                        });
+                    events.push_back(std::move(start));
+                    read_song_content(cursor, events);
+                    events.push_back(SongEvent{SongEventType::multicols_end});
+                } else if (elem.name == "line") {
+                    SongEvent line{SongEventType::line};
+                    for (Token token = cursor.next(); token.type != TokenType::end;
+                        token = cursor.next()) {
+
+                        if (token.type == TokenType::text) {           // lyrics
+                            std::string lyrics = cursor.text_value(token.value);
+                            if (!lyrics.empty())
+                                line.line.push_back(LineElement{
+                                    LineItemType::lyrics, std::move(lyrics), {}});
+                        } else if (token.type == TokenType::start) {   // chord
+                            line.line.push_back(LineElement{
+                                LineItemType::chord, {}, read_chord(cursor, token.value)});
+                        } else if (token.type == TokenType::eof) {
+                            cursor.error("unexpected end of the XML");
+                        }
+                    }
+                    events.push_back(std::move(line));
+                } else if (elem.name == "columnbreak") {
+                    events.push_back(SongEvent{SongEventType::columnbreak});
+                    cursor.skip_element();
+                } else {     // <verse> or <chorus>
+                    VerseType type = elem.name == "verse" ? VerseType::verse : VerseType::chorus;
+                    events.push_back(SongEvent{SongEventType::verse_start, type});
+                    read_song_content(cursor, events);
+                    events.push_back(SongEvent{SongEventType::verse_end, type});
+                }
+            }
+        }
+
+        /**
+         * Reads a song header like `SongbookConverter::read_song_header()`.
+         *
+         * @param cursor cursor positioned just after the `<song>` start tag
+         * @return element-value pairs from the header
+         */
+        TagValueMultiMap read_song_header(XmlCursor& cursor) {
+            TagValueMultiMap header;
+
+            Token header_elem = cursor.next_element();
+            if (header_elem.type != TokenType::start || header_elem.name != "header")
+                cursor.error("<header> expected");
+
+            for (Token elem = cursor.next_element(); elem.type == TokenType::start;
+                elem = cursor.next_element()) {
+
+                if (elem.name == "authors") {  // read authors one by one
+                    for (Token author = cursor.next_element(); author.type == TokenType::start;
+                        author = cursor.next_element()) {
+                        header.emplace("author", cursor.element_text());
+                    }
+                } else if (elem.name == "dateAdded") {
+                    std::string date = cursor.element_text();
+                    header.emplace("dateAdded", date == "NA" ? "0001-01-01" : date);
+                } else {
+                    header.emplace(std::string{elem.name}, cursor.element_text());
+                }
+            }
+            if (!header.count("name") || !header.count("dateAdded"))
+                cursor.error("<name> and <dateAdded> are required in the song header");
+
+            return header;
+        }
+
+        /**
+         * Reads settings like `SongbookConverter::read_settings()`.
+         *
+         * @param cursor cursor positioned just after the `<settings>` start tag
+         * @return setting name-value pairs in document order
+         */
+        std::vector<std::pair<std::string, std::string>> read_settings(XmlCursor& cursor) {
+            std::vector<std::pair<std::string, std::string>> settings;
+            for (Token setting = cursor.next_element(); setting.type == TokenType::start;
+                setting = cursor.next_element()) {
+
+                if (setting.name == "entities")
+                    cursor.skip_element();
+                else
+                    settings.emplace_back(std::string{setting.name}, cursor.element_text());
+            }
+            return settings;
+        }
+
+        /**
+         * Reads a song like `SongbookConverter::read_song()`.
+         *
+         * @param cursor cursor positioned just after the `<song>` start tag
+         * @return the song
+         */
+        SongData read_song(XmlCursor& cursor) {
+            SongData song;
+            song.header = read_song_header(cursor);
+
+            auto search = song.header.find("transpose");
+            if (search != song.header.end()) {
+                song.transpose = parse_semitones(search->second);
+                song.header.erase(search);
+            }
+
+            read_song_content(cursor, song.events);
+
+            return song;
+        }
+    }
+
+    //------  Nonmember functions ------
+
+    SongbookData read_trusted_songbook(std::string_view xml, const TagValueMap& entities,
+        TrustedSongCache* cache) {
+
+        XmlCursor cursor{xml, entities, 0};
+        SongbookData data;
+        TrustedSongCache read;
+
+        Token root = cursor.next_element();
+        if (root.type != TokenType::start || root.name != "songbook")
+            cursor.error("<songbook> expected");
+
+        for (Token elem = cursor.next_element(); elem.type == TokenType::start;
+            elem = cursor.next_element()) {
+
+            if (elem.name == "settings") {
+                data.settings = read_settings(cursor);
+            } else if (elem.name == "songs") {
+                for (Token song = cursor.next_element(); song.type == TokenType::start;
+                    song = cursor.next_element()) {
+                    if (!cache) {
+                        data.songs.push_back(read_song(cursor));
+                        continue;
+                    }
+
+                    // the element is hashed first and read only when not cached
+                    XmlCursor song_cursor{cursor};
+                    cursor.skip_element();
+                    std::uint64_t hash = content_hash(
+                        xml.substr(song.offset, cursor.position() - song.offset));
+                    auto cached = cache->find(hash);
+                    data.songs.push_back(cached != cache->end() ? 
+                        cached->second : read_song(song_cursor));
+                    read.emplace(hash, data.songs.back());
+                }
+            } else {
+                cursor.skip_element();
+            }
+        }
+
+        // songs no longer present are dropped
+        if (cache)
+            *cache = std::move(read);
+
+        return data;
+    }
+
+    void stream_trusted_songbook(std::string_view xml, const TagValueMap& entities,
+        const std::function<void(std::vector<std::pair<std::string, std::string>>)>& settings_read,
+        const std::function<void(SongData)>& song_read) {
+
+        XmlCursor cursor{xml, entities, 0};
+        std::vector<std::pair<std::string, std::string>> settings;
+
+        Token root = cursor.next_element();
+        if (root.type != TokenType::start || root.name != "songbook")
+            cursor.error("<songbook> expected");
+
+        // `<settings>` precedes `<songs>` in the schema
+        bool songs_read{false};
+        for (Token elem = cursor.next_element(); elem.type == TokenType::start;
+            elem = cursor.next_element()) {
+
+            if (elem.name == "settings") {
+                settings = read_settings(cursor);
+            } else if (elem.name == "songs") {
+                settings_read(std::move(settings));
+                songs_read = true;
+                for (Token song = cursor.next_element(); song.type == TokenType::start;
+                    song = cursor.next_element())
+                    song_read(read_song(cursor));
+            } else {
+                cursor.skip_element();
+            }
+        }
+
+        if (!songs_read)
+            settings_read(std::move(settings));
+    }
+
+    TagValueMultiMap read_trusted_song_header(std::string_view xml, const TagValueMap& entities,
+        int line_offset) {
+
+        XmlCursor cursor{xml, entities, line_offset};
+
+        Token song = cursor.next_element();
+        if (song.type != TokenType::start || song.name != "song")
+            cursor.error("<song> expected");
+
+        return read_song_header(cursor);
+    }
+
+    TagValueMap read_trusted_entities(std::string_view xml, const TagValueMap& entities,
+        int line_offset) {
+
+        XmlCursor cursor{xml, entities, line_offset};
+        TagValueMap result;
+
+        Token root = cursor.next_element();
+        if (root.type != TokenType::start || root.name != "entities")
+            cursor.error("<entities> expected");
+
+        for (Token entity = cursor.next_element(); entity.type == TokenType::start;
+            entity = cursor.next_element()) {
+
+            // `<name>` and `<value>` elements (not necessarily in this order)
+            std::string name, value;
+            for (Token elem = cursor.next_element(); elem.type == TokenType::start;
+                elem = cursor.next_element()) {
+                (elem.name == "value" ? value : name) = cursor.element_text();
+            }
+            result.emplace(std::move(name), std::move(value));
+        }
+
+        return result;
+    }
+
+    TagValueMap expand_entity_values(const TagValueMap& entities) {
+        auto error = [](const std::string& message) {
+            throw SongbookException("Error in entity values: " + message);
+        };
+
+        TagValueMap result;
+        for (const auto& [name, value]: entities) {
+            // entity values are parsed as element content
+            std::string expanded;
+            expand_references(value, false, entities, max_entity_depth, error, &expanded);
+            result.emplace(name, replace_newlines(std::move(expanded)));
+        }
+        return result;
+    }
+}
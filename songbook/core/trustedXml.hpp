@@ -0,0 +1,103 @@
+/**
+ * @file
+ *
+ * Fast reading of trusted (already validated) songbook XML without Xerces.
+ *
+ * The reader is specialized for the songbook schema: it walks the input
+ * buffer once, refers to names and text in the buffer and only allocates
+ * the strings of the resulting model. There is no validation, but the
+ * result is the same as the one produced by Xerces from a valid document
+ * (`SongbookConverter::read_songbook()`): schema attribute defaults are
+ * added, entities and character references are expanded, newlines are
+ * removed from text and attribute whitespace is normalized. Only UTF-8
+ * input is supported.
+ */
+
+#ifndef SONGBOOK_TRUSTEDXML_HPP
+#define SONGBOOK_TRUSTEDXML_HPP
+
+#include "songModel.hpp"
+#include "songbookTypes.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+
+namespace songbook {
+
+    /**
+     * Songs read by `read_trusted_songbook()` by content hashes of their
+     * `<song>` elements. Valid only for the entity values it was read with.
+     */
+    using TrustedSongCache = std::unordered_map<std::uint64_t, SongData>;
+
+    /**
+     * Reads a songbook XML into the songbook model.
+     *
+     * @param xml songbook XML (without the DTD)
+     * @param entities values of all entities which can be referenced
+     * @param cache songs read from a previous version of the XML, which 
+     * are reused instead of reading unchanged `<song>` elements again; 
+     * replaced by songs of `xml` when reading succeeds (can be `nullptr`)
+     * @return songbook settings (without `<entities>`) and songs
+     * @throw SongbookException malformed XML, an undefined entity or a
+     * missing required song element (the message contains the line number)
+     */
+    SongbookData read_trusted_songbook(std::string_view xml, const TagValueMap& entities,
+        TrustedSongCache* cache = nullptr);
+
+    /**
+     * Reads a songbook XML like `read_trusted_songbook()`, but passes songs
+     * one by one instead of keeping them, so that a single song of the
+     * model is held in memory at a time.
+     *
+     * @param xml songbook XML (without the DTD)
+     * @param entities values of all entities which can be referenced
+     * @param settings_read called once with the setting name-value pairs
+     * (without `<entities>`) before the first song
+     * @param song_read called with each song in document order
+     * @throw SongbookException malformed XML, an undefined entity or a
+     * missing required song element (the message contains the line number)
+     */
+    void stream_trusted_songbook(std::string_view xml, const TagValueMap& entities,
+        const std::function<void(std::vector<std::pair<std::string, std::string>>)>& settings_read,
+        const std::function<void(SongData)>& song_read);
+
+    /**
+     * Reads the header of a single song.
+     *
+     * @param xml the `<song>` element
+     * @param entities values of all entities which can be referenced
+     * @param line_offset number of lines before the element (for error messages)
+     * @return element-value pairs from the header (as in `SongData::header`)
+     * @throw SongbookException malformed XML, an undefined entity or a
+     * missing required header element
+     */
+    TagValueMultiMap read_trusted_song_header(std::string_view xml, const TagValueMap& entities,
+        int line_offset = 0);
+
+    /**
+     * Reads the `<entities>` element.
+     *
+     * @param xml the `<entities>` element (see `extract_entities_element()`)
+     * @param entities values of entities which can be referenced in it
+     * @param line_offset number of lines before the element (for error messages)
+     * @return entity name-value pairs
+     * @throw SongbookException malformed XML or an undefined entity
+     */
+    TagValueMap read_trusted_entities(std::string_view xml, const TagValueMap& entities,
+        int line_offset = 0);
+
+    /**
+     * Expands character and entity references in entity values, which
+     * can refer to each other (as in a DTD).
+     *
+     * @param entities entity name-value pairs
+     * @return entities with expanded values
+     * @throw SongbookException an undefined or recursive entity
+     */
+    TagValueMap expand_entity_values(const TagValueMap& entities);
+}
+
+#endif  // SONGBOOK_TRUSTEDXML_HPP
@@ -0,0 +1,288 @@
+#include "xmlCursor.hpp"
+#include "SongbookException.hpp"
+#include "SongbookConverter.hpp"
+#include "textUtils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace songbook {
+
+    namespace {
+
+        /**
+         * Appends a Unicode code point encoded in UTF-8 after checking that
+         * XML allows it.
+         *
+         * @param out string to append to
+         * @param code code point
+         * @return `false` for an invalid code point
+         */
+        bool append_code_point(std::string& out, std::uint32_t code) {
+            if (code == 0 || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+                return false;
+            append_utf8(out, static_cast<char32_t>(code));
+            return true;
+        }
+
+        /**
+         * Removes trailing whitespace.
+         */
+        std::string_view trim_end(std::string_view str) {
+            while (!str.empty() && is_xml_space(str.back()))
+                str.remove_suffix(1);
+            return str;
+        }
+    }
+
+    XmlCursor::XmlCursor(std::string_view xml, const TagValueMap& entities, int line_offset):
+        xml(xml), entities(entities), line_offset(line_offset) {
+
+        // UTF-8 byte order mark
+        if (this->xml.compare(0, 3, "\xEF\xBB\xBF") == 0)
+            pos = 3;
+    }
+
+    Token XmlCursor::next() {
+        if (pending_end) {
+            pending_end = false;
+            std::string_view name = open.back();
+            open.pop_back();
+            return Token{TokenType::end, name, {}, pos};
+        }
+        if (pos >= xml.size())
+            return Token{TokenType::eof, {}, {}, xml.size()};
+
+        size_t start = pos;
+        if (xml[pos] != '<') {
+            pos = std::min(xml.find('<', pos), xml.size());
+            return Token{TokenType::text, {}, xml.substr(start, pos - start), start};
+        }
+
+        if (starts_with("<!--"))
+            return skip_past(TokenType::other, start, start, "-->");
+        if (starts_with("<![CDATA["))
+            return skip_past(TokenType::cdata, start, start + 9, "]]>");
+        if (starts_with("<?"))
+            return skip_past(TokenType::other, start, start, "?>");
+        if (starts_with("<!")) {
+            // DOCTYPE, possibly with an internal subset
+            size_t end = xml.find_first_of("[>", pos);
+            if (end != std::string_view::npos && xml[end] == '[')
+                end = xml.find("]", end);
+            pos = end;
+            return skip_past(TokenType::other, start, start, ">");
+        }
+
+        if (starts_with("</")) {
+            size_t end = xml.find('>', pos);
+            if (end == std::string_view::npos)
+                error("'>' missing");
+            std::string_view name = trim_end(xml.substr(pos + 2, end - pos - 2));
+            if (open.empty() || open.back() != name)
+                error("unexpected end tag </" + std::string{name} + ">");
+            open.pop_back();
+            pos = end + 1;
+            return Token{TokenType::end, name, {}, start};
+        }
+
+        // start tag; '>' can be inside attribute values
+        size_t name_end = xml.find_first_of(" \t\r\n/>", pos + 1);
+        if (name_end == std::string_view::npos)
+            error("'>' missing");
+        std::string_view name = xml.substr(pos + 1, name_end - pos - 1);
+        size_t end = name_end;
+        char quote{0};
+        for (; end < xml.size(); ++end) {
+            if (quote) {
+                if (xml[end] == quote)
+                    quote = 0;
+            } else if (xml[end] == '"' || xml[end] == '\'') {
+                quote = xml[end];
+            } else if (xml[end] == '>') {
+                break;
+            }
+        }
+        if (end == xml.size())
+            error("'>' missing");
+
+        std::string_view attrs = xml.substr(name_end, end - name_end);
+        pos = end + 1;
+        open.push_back(name);
+        if (!attrs.empty() && attrs.back() == '/') {
+            attrs.remove_suffix(1);
+            pending_end = true;
+        }
+        return Token{TokenType::start, name, attrs, start};
+    }
+
+    Token XmlCursor::next_element() {
+        for (Token token = next(); ; token = next()) {
+            if (token.type == TokenType::start || token.type == TokenType::end)
+                return token;
+            if (token.type == TokenType::eof)
+                error("unexpected end of the XML");
+        }
+    }
+
+    void XmlCursor::finish_element(Token token) {
+        for (int depth = 0; ; token = next()) {
+            if (token.type == TokenType::end) {
+                if (depth == 0)
+                    return;
+                --depth;
+            } else if (token.type == TokenType::start) {
+                ++depth;
+            } else if (token.type == TokenType::eof) {
+                error("unexpected end of the XML");
+            }
+        }
+    }
+
+    void XmlCursor::skip_element() {
+        finish_element(next());
+    }
+
+    std::string XmlCursor::element_text() {
+        Token token = next();
+        std::string text;
+        if (token.type == TokenType::text) {
+            text = text_value(token.value);
+            token = next();
+        }
+        finish_element(token);
+        return text;
+    }
+
+    std::string XmlCursor::text_value(std::string_view raw) const {
+        return replace_newlines(expand(raw, false));
+    }
+
+    std::string XmlCursor::expand(std::string_view raw, bool attribute) const {
+        std::string out;
+        out.reserve(raw.size());
+        size_t offset = offset_of(raw);
+        expand_references(raw, attribute, entities, 0,
+            [this, offset](const std::string& message){ error_at(offset, message); }, &out);
+        return out;
+    }
+
+    void XmlCursor::check_references(std::string_view raw) const {
+        if (raw.find('&') == std::string_view::npos)
+            return;
+        size_t offset = offset_of(raw);
+        expand_references(raw, false, entities, 0,
+            [this, offset](const std::string& message){ error_at(offset, message); }, nullptr);
+    }
+
+    XmlLocation XmlCursor::location(size_t offset) const {
+        offset = std::min(offset, xml.size());
+        size_t line_start = xml.rfind('\n', offset == 0 ? 0 : offset - 1);
+        line_start = (line_start == std::string_view::npos || line_start >= offset) ?
+            0 : line_start + 1;
+
+        // columns are counted in characters, not in UTF-8 bytes
+        size_t column = 1;
+        for (size_t i = line_start; i < offset; ++i) {
+            if ((static_cast<unsigned char>(xml[i]) & 0xC0) != 0x80)
+                ++column;
+        }
+        size_t line = std::count(xml.begin(), xml.begin() + offset, '\n') + 1 + line_offset;
+        return XmlLocation{line, column};
+    }
+
+    size_t XmlCursor::position() const {
+        return pos;
+    }
+
+    size_t XmlCursor::offset_of(std::string_view view) const {
+        return static_cast<size_t>(view.data() - xml.data());
+    }
+
+    void XmlCursor::error(const std::string& message) const {
+        error_at(pos, message);
+    }
+
+    void XmlCursor::error_at(size_t offset, const std::string& message) const {
+        XmlLocation loc = location(offset);
+        throw SongbookException("XML line " + std::to_string(loc.line) + ", column " +
+            std::to_string(loc.column) + ": " + message);
+    }
+
+    bool XmlCursor::starts_with(std::string_view prefix) const {
+        return xml.compare(pos, prefix.size(), prefix) == 0;
+    }
+
+    Token XmlCursor::skip_past(TokenType type, size_t start, size_t content_start,
+        std::string_view end) {
+
+        size_t found = pos == std::string_view::npos ? pos : xml.find(end, pos);
+        if (found == std::string_view::npos)
+            error_at(start, "'" + std::string{end} + "' missing");
+        pos = found + end.size();
+        return Token{type, {}, xml.substr(content_start, found - content_start), start};
+    }
+
+    //------  Nonmember functions ------
+
+    void expand_references(std::string_view raw, bool attribute, const TagValueMap& entities,
+        int depth, const std::function<void(const std::string&)>& error, std::string* out) {
+
+        for (size_t i = 0; i < raw.size(); ++i) {
+            char c = raw[i];
+            if (c == '&') {
+                size_t end = raw.find(';', i);
+                if (end == std::string_view::npos)
+                    error("';' missing after '&'");
+                std::string_view ref = raw.substr(i + 1, end - i - 1);
+                i = end;
+
+                if (!ref.empty() && ref[0] == '#') {
+                    bool hex = ref.size() > 1 && ref[1] == 'x';
+                    std::uint32_t code{0};
+                    bool valid = ref.size() > (hex ? 2u : 1u);
+                    for (char digit: ref.substr(hex ? 2 : 1)) {
+                        int value = (digit >= '0' && digit <= '9') ? digit - '0' :
+                            (hex && digit >= 'a' && digit <= 'f') ? digit - 'a' + 10 :
+                            (hex && digit >= 'A' && digit <= 'F') ? digit - 'A' + 10 : -1;
+                        if (value < 0 || code > 0x10FFFF) {
+                            valid = false;
+                            break;
+                        }
+                        code = code * (hex ? 16 : 10) + value;
+                    }
+                    std::string checked;
+                    if (!valid || !append_code_point(out ? *out : checked, code))
+                        error("invalid character reference '&" + std::string{ref} + ";'");
+                } else if (ref == "amp" || ref == "lt" || ref == "gt" || ref == "quot" ||
+                    ref == "apos") {
+                    if (out)
+                        *out += ref == "amp" ? '&' : ref == "lt" ? '<' : ref == "gt" ? '>' :
+                            ref == "quot" ? '"' : '\'';
+                } else {
+                    auto search = entities.find(std::string{ref});
+                    if (search == entities.end())
+                        error("entity '" + std::string{ref} + "' not defined");
+                    if (depth == 1)
+                        error("entity '" + std::string{ref} + "' is recursive");
+                    if (out && depth == 0)
+                        *out += search->second;
+                    else if (depth > 1)
+                        expand_references(search->second, attribute, entities, depth - 1,
+                            error, out);
+                }
+            } else if (!out) {
+                continue;
+            } else if (c == '\r') {
+                // line ends are normalized to LF
+                if (i + 1 < raw.size() && raw[i + 1] == '\n')
+                    ++i;
+                *out += attribute ? ' ' : '\n';
+            } else if (attribute && (c == '\n' || c == '\t')) {
+                *out += ' ';
+            } else {
+                *out += c;
+            }
+        }
+    }
+}
@@ -0,0 +1,277 @@
+/**
+ * @file
+ *
+ * Splitting of XML into tokens without copying it, shared by the readers
+ * and validators which do not use Xerces (trustedXml.hpp,
+ * schemaValidator.hpp).
+ *
+ * There is no DTD processing: entity values are given by the caller and
+ * DOCTYPE declarations are skipped. Only UTF-8 input is supported.
+ */
+
+#ifndef SONGBOOK_XMLCURSOR_HPP
+#define SONGBOOK_XMLCURSOR_HPP
+
+#include "songbookTypes.hpp"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace songbook {
+
+    /**
+     * Type of an XML token.
+     */
+    enum class TokenType {
+        start,  ///< start tag (an empty element is followed by an `end` token)
+        end,    ///< end tag
+        text,   ///< character data
+        cdata,  ///< CDATA section (`value` is its content)
+        other,  ///< comment, processing instruction, DOCTYPE
+        eof     ///< end of input
+    };
+
+    /**
+     * Part of the XML returned by `XmlCursor`; views into the input.
+     */
+    struct Token {
+        TokenType type;          ///< token type
+        std::string_view name;   ///< element name (start and end tags)
+        std::string_view value;  ///< attributes (start tag) or raw text
+        size_t offset{0};        ///< position of the token in the input
+    };
+
+    /**
+     * Line and column of a position in the XML (both 1-based).
+     */
+    struct XmlLocation {
+        size_t line;    ///< line number
+        size_t column;  ///< column number (in characters)
+    };
+
+    /**
+     * Splits XML into tokens without copying it.
+     *
+     * Only well-formedness needed for reading is checked: tags must be
+     * terminated and properly nested and references must be valid.
+     */
+    class XmlCursor {
+
+        public:
+        /**
+         * Constructor.
+         *
+         * @param xml XML to read
+         * @param entities entity values (expanded)
+         * @param line_offset number of lines before `xml` (for error messages)
+         */
+        XmlCursor(std::string_view xml, const TagValueMap& entities, int line_offset);
+
+        /**
+         * Reads the next token.
+         *
+         * @return the token
+         */
+        Token next();
+
+        /**
+         * Returns the next start or end tag, skipping text and other tokens.
+         *
+         * @return start or end tag
+         */
+        Token next_element();
+
+        /**
+         * Reads until the end of an element.
+         *
+         * @param token the last token read inside the element
+         */
+        void finish_element(Token token);
+
+        /**
+         * Reads an element whose start tag was just read.
+         */
+        void skip_element();
+
+        /**
+         * Returns the text of an element whose start tag was just read
+         * (its first child when it is text, as `get_text_value()` does)
+         * and reads until its end.
+         *
+         * @return element text
+         */
+        std::string element_text();
+
+        /**
+         * Expands references in text and removes newlines.
+         *
+         * @param raw text as written in the XML
+         * @return text value
+         */
+        std::string text_value(std::string_view raw) const;
+
+        /**
+         * Expands references in text.
+         *
+         * @param raw text as written in the XML (a view into the input)
+         * @param attribute is the text an attribute value (whitespace
+         * characters become spaces)?
+         * @return expanded text
+         */
+        std::string expand(std::string_view raw, bool attribute) const;
+
+        /**
+         * Checks references in text without expanding them.
+         *
+         * @param raw text as written in the XML (a view into the input)
+         */
+        void check_references(std::string_view raw) const;
+
+        /**
+         * Calls a function for each attribute of a start tag.
+         *
+         * @param attrs attributes of the start tag
+         * @param fn called with attribute name (a view into the input) and
+         * expanded value
+         */
+        template <typename F>
+        void for_each_attribute(std::string_view attrs, F fn) const;
+
+        /**
+         * Calls a function for each attribute of a start tag without
+         * expanding the values.
+         *
+         * @param attrs attributes of the start tag
+         * @param fn called with attribute name and raw value (views into
+         * the input)
+         */
+        template <typename F>
+        void for_each_raw_attribute(std::string_view attrs, F fn) const;
+
+        /**
+         * Returns the line and column of a position in the input.
+         *
+         * @param offset position in the input
+         * @return its location (including the line offset)
+         */
+        XmlLocation location(size_t offset) const;
+
+        /**
+         * Returns the position just after the last token read.
+         *
+         * @return position in the input
+         */
+        size_t position() const;
+
+        /**
+         * Returns the position of a view into the input.
+         *
+         * @param view part of the input
+         * @return position of its first character
+         */
+        size_t offset_of(std::string_view view) const;
+
+        /**
+         * Throws an exception with the current line and column.
+         *
+         * @param message error description
+         */
+        [[noreturn]] void error(const std::string& message) const;
+
+        /**
+         * Throws an exception with the line and column of a position.
+         *
+         * @param offset position in the input
+         * @param message error description
+         */
+        [[noreturn]] void error_at(size_t offset, const std::string& message) const;
+
+        private:
+        /**
+         * Does the rest of the input start with `prefix`?
+         */
+        bool starts_with(std::string_view prefix) const;
+
+        /**
+         * Moves just after `end` and returns a token of the skipped part.
+         *
+         * @param type type of the token
+         * @param start position of the token
+         * @param content_start position where the token's value starts
+         * @param end string ending the token
+         * @return the token
+         */
+        Token skip_past(TokenType type, size_t start, size_t content_start, std::string_view end);
+
+        std::string_view xml;                ///< the input
+        const TagValueMap& entities;         ///< entity values
+        int line_offset;                     ///< lines before the input
+        size_t pos{0};                       ///< current position
+        std::vector<std::string_view> open;  ///< names of open elements
+        bool pending_end{false};             ///< is an empty element being read?
+    };
+
+    /**
+     * Expands character and entity references in a text.
+     *
+     * @param raw text as written in the XML
+     * @param attribute is the text an attribute value (whitespace
+     * characters become spaces)?
+     * @param entities entity values
+     * @param depth expand references in entity values up to this depth
+     * (0: entity values are inserted as they are)
+     * @param error called with a message when a reference is invalid
+     * (must not return)
+     * @param out string to append the expanded text to; references are
+     * only checked when `nullptr`
+     */
+    void expand_references(std::string_view raw, bool attribute, const TagValueMap& entities,
+        int depth, const std::function<void(const std::string&)>& error, std::string* out);
+
+    /**
+     * Is `c` XML whitespace?
+     *
+     * @param c character
+     * @return `true` for space, tab, CR and LF
+     */
+    inline bool is_xml_space(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+
+    template <typename F>
+    void XmlCursor::for_each_attribute(std::string_view attrs, F fn) const {
+        for_each_raw_attribute(attrs, [this, &fn](std::string_view name, std::string_view raw) {
+            fn(name, expand(raw, true));
+        });
+    }
+
+    template <typename F>
+    void XmlCursor::for_each_raw_attribute(std::string_view attrs, F fn) const {
+        size_t i = 0;
+        while (true) {
+            while (i < attrs.size() && is_xml_space(attrs[i]))
+                ++i;
+            if (i >= attrs.size())
+                return;
+            size_t eq = attrs.find('=', i);
+            if (eq == std::string_view::npos)
+                error_at(offset_of(attrs.substr(i)), "'=' missing after an attribute name");
+            std::string_view name = attrs.substr(i, eq - i);
+            while (!name.empty() && is_xml_space(name.back()))
+                name.remove_suffix(1);
+            size_t quote = attrs.find_first_of("\"'", eq);
+            if (quote == std::string_view::npos)
+                error_at(offset_of(name), "attribute value must be quoted");
+            size_t end = attrs.find(attrs[quote], quote + 1);
+            if (end == std::string_view::npos)
+                error_at(offset_of(name), "attribute value not terminated");
+            fn(name, attrs.substr(quote + 1, end - quote - 1));
+            i = end + 1;
+        }
+    }
+}
+
+#endif  // SONGBOOK_XMLCURSOR_HPP
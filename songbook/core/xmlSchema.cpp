@@ -27,6 +27,8 @@ R"(<?xml version="1.0"?>
     <xs:element name="tocTitle" type="xs:string" minOccurs="0"/>
     <xs:element name="mainFont" type="xs:string" minOccurs="0"/>
     <xs:element name="chordFont" type="xs:string" minOccurs="0"/>
+    <xs:element name="pdfMainFontFile" type="xs:string" minOccurs="0"/>
+    <xs:element name="pdfChordFontFile" type="xs:string" minOccurs="0"/>
     <xs:element name="convertAddedSince" type="convertAddedSinceType" minOccurs="0"/>
     <xs:element ref="entities" minOccurs="0"/>
   </xs:all>
@@ -92,6 +94,7 @@ R"(<?xml version="1.0"?>
     <xs:element name="album" type="xs:string" minOccurs="0"/>
     <xs:element name="year" type="xs:gYear" minOccurs="0"/>
     <xs:element name="dateAdded" type="dateAddedType"/>
+    <xs:element name="transpose" type="xs:integer" minOccurs="0"/>
   </xs:all>
 </xs:complexType>
 
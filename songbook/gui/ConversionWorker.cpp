@@ -0,0 +1,208 @@
+#include "ConversionWorker.hpp"
+#include "SongbookException.hpp"
+#include "SongbookPrinterLatex.hpp"
+#include "SongbookPrinter.hpp"
+#include "contentHash.hpp"
+
+#include <exception>
+#include <fstream>
+#include <QFileInfo>
+
+ConversionWorker::ConversionWorker(QObject *parent): QObject{parent} {}
+
+void ConversionWorker::cancel() {
+    cancelled = true;
+}
+
+void ConversionWorker::warm_up() {
+    if (converter)
+        return;
+
+    // LaTeX for the PDF, plain text for the preview
+    converter = std::make_unique<songbook::MultiSongbookConverter>();
+    converter->add_printer<songbook::SongbookPrinterLatex>(latex_output);
+    converter->add_printer<songbook::SongbookPrinter>(preview_output);
+    converter->set_song_cache(true);
+}
+
+bool ConversionWorker::ensure_parsed(const QString& xml_file, QString& message, QString& details) {
+
+    warm_up();
+
+    try {
+        QFileInfo fi{xml_file};
+
+        // the same file unchanged since the last parse
+        if (xml_file == parsed_file && fi.lastModified() == parsed_modified &&
+            fi.size() == parsed_size) {
+            message = "XML file unchanged, parsing skipped";
+            return true;
+        }
+
+        // the same content (e.g. the file was only saved again)
+        std::uint64_t hash = songbook::content_hash(songbook::load_xml(xml_file.toStdString()));
+        if (xml_file == parsed_file && hash == parsed_hash) {
+            parsed_modified = fi.lastModified();
+            parsed_size = fi.size();
+            message = "XML file unchanged, parsing skipped";
+            return true;
+        }
+
+        parsed_file.clear();
+        converter->parse_songbook(xml_file.toStdString());
+
+        parsed_file = xml_file;
+        parsed_modified = fi.lastModified();
+        parsed_size = fi.size();
+        parsed_hash = hash;
+        message = "XML file parsed succesfully";
+        return true;
+
+    } catch (songbook::SongbookException& se) {
+        message = "Error(s) during XML parsing:";
+        details = se.what();
+
+    } catch (std::exception& e) {
+        // e.g. the file could not be opened or an error of the trusted reader
+        message = "Error: " + QString::fromStdString(e.what());
+    }
+
+    return false;
+}
+
+void ConversionWorker::parse(const QString& xml_file) {
+
+    cancelled = false;
+    QString message, details;
+    bool success = ensure_parsed(xml_file, message, details);
+    emit parsed(success, message, details);
+}
+
+void ConversionWorker::convert(const QString& xml_file, const QString& latex_file) {
+
+    cancelled = false;
+    QString message, details;
+
+    // summary of parsing and conversion shown with the result
+    warm_up();
+    songbook::ConversionStats stats;
+    converter->set_stats(&stats);
+    struct StatsReset {
+        songbook::MultiSongbookConverter& converter;
+        ~StatsReset() { converter.set_stats(nullptr); }
+    } stats_reset{*converter};
+
+    if (!ensure_parsed(xml_file, message, details)) {
+        emit converted(false, message, details);
+        return;
+    }
+
+    // report progress only when the percentage changes
+    int last_percent = -1;
+    converter->set_progress_handler([this, &last_percent](size_t done, size_t total) {
+        int percent = total > 0 ? static_cast<int>(done * 100 / total) : 100;
+        if (percent != last_percent) {
+            last_percent = percent;
+            emit progress(static_cast<int>(done), static_cast<int>(total));
+        }
+        return !cancelled;
+    });
+
+    try {
+        if (cancelled)
+            throw songbook::ConversionCancelled();
+        convert_parsed();
+    } catch (songbook::ConversionCancelled&) {
+        converter->set_progress_handler(nullptr);
+        emit converted(false, "Conversion cancelled", "");
+        return;
+    } catch (songbook::SongbookException& se) {
+        converter->set_progress_handler(nullptr);
+        emit converted(false, "Error(s) during conversion:", se.what());
+        return;
+    } catch (std::exception& e) {
+        // nothing may escape the slot running in the worker thread
+        converter->set_progress_handler(nullptr);
+        emit converted(false, "Error: " + QString::fromStdString(e.what()), "");
+        return;
+    }
+    converter->set_progress_handler(nullptr);
+    converted_file = xml_file;
+    converted_hash = parsed_hash;
+
+    std::ofstream ofs{latex_file.toStdString()};
+    if (!ofs.is_open()) {
+        emit converted(false, "Error: LaTeX file <b>" + latex_file + "</b> could not be saved!", "");
+        return;
+    }
+    {
+        songbook::PhaseTimer timer{&stats, "write"};
+        ofs << latex_output.str();
+        ofs.close();
+    }
+
+    emit converted(true, "LaTeX file saved to <b>" + latex_file + "</b> (" +
+                   QString::fromStdString(stats.summary()) + ")", "");
+}
+
+void ConversionWorker::preview(const QString& xml_file) {
+
+    cancelled = false;
+    QString message, details;
+    if (!ensure_parsed(xml_file, message, details)) {
+        emit previewed(false, message, details);
+        return;
+    }
+
+    // nothing changed since the last conversion
+    if (xml_file == converted_file && parsed_hash == converted_hash)
+        return;
+
+    // the preview can be cancelled like a conversion, without progress
+    converter->set_progress_handler([this](size_t, size_t) { return !cancelled; });
+
+    try {
+        if (cancelled)
+            throw songbook::ConversionCancelled();
+        convert_parsed();
+    } catch (songbook::ConversionCancelled&) {
+        converter->set_progress_handler(nullptr);
+        emit previewed(false, "Preview cancelled", "");
+        return;
+    } catch (songbook::SongbookException& se) {
+        converter->set_progress_handler(nullptr);
+        emit previewed(false, "Error(s) during conversion:", se.what());
+        return;
+    } catch (std::exception& e) {
+        // nothing may escape the slot running in the worker thread
+        converter->set_progress_handler(nullptr);
+        emit previewed(false, "Error: " + QString::fromStdString(e.what()), "");
+        return;
+    }
+    converter->set_progress_handler(nullptr);
+
+    // songs of a newly converted file are not changed, just cached
+    bool same_file = xml_file == converted_file;
+    converted_file = xml_file;
+    converted_hash = parsed_hash;
+
+    const std::vector<size_t>& changed = converter->get_changed_songs();
+    if (!same_file || changed.empty()) {
+        emit previewed(true, same_file ? "No song changed" : "Waiting for changes", "");
+        return;
+    }
+
+    const songbook::Song& song = converter->get_printed_song(1, changed.front());
+    emit previewed(true,
+                   QString("Changed songs: %1, showing \"%2\"")
+                       .arg(changed.size())
+                       .arg(QString::fromStdString(song.get_name())),
+                   QString::fromStdString(song.get_content()));
+}
+
+void ConversionWorker::convert_parsed() {
+
+    latex_output.str("");
+    preview_output.str("");
+    converter->convert();
+}
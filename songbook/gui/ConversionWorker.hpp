@@ -0,0 +1,137 @@
+#ifndef CONVERSIONWORKER_HPP
+#define CONVERSIONWORKER_HPP
+
+#include <MultiSongbookConverter.hpp>
+
+#include <QObject>
+#include <QString>
+#include <QDateTime>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+
+/**
+ * Parses and converts songbooks in a background thread.
+ *
+ * The object is meant to be moved to a `QThread`; its slots are then
+ * invoked through queued connections and results are reported with
+ * signals. The converter (Xerces initialization, grammar loading) is
+ * created by `warm_up()` so that it doesn't delay the GUI. Parse results
+ * are reused while the XML file is unchanged (same modification time and
+ * size, or same content hash) and printed songs are cached, so that
+ * a changed file only has its changed songs converted again.
+ */
+class ConversionWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ConversionWorker(QObject *parent = nullptr);
+
+    /**
+     * Requests cancellation of the running task. Can be called from any
+     * thread; conversion stops after the song being converted.
+     */
+    void cancel();
+
+public slots:
+    /**
+     * Creates the converter.
+     */
+    void warm_up();
+
+    /**
+     * Parses an XML file unless it has already been parsed.
+     *
+     * @param xml_file path to the XML file
+     */
+    void parse(const QString& xml_file);
+
+    /**
+     * Parses an XML file (unless it has already been parsed), converts it
+     * and saves the LaTeX file.
+     *
+     * @param xml_file path to the XML file
+     * @param latex_file path to the LaTeX file
+     */
+    void convert(const QString& xml_file, const QString& latex_file);
+
+    /**
+     * Parses and converts a changed XML file and reports the first song
+     * which changed since the previous conversion of the file.
+     *
+     * @param xml_file path to the XML file
+     */
+    void preview(const QString& xml_file);
+
+signals:
+    /**
+     * Emitted when parsing finishes.
+     *
+     * @param success Was parsing successful?
+     * @param message status message
+     * @param details detailed output (e.g. parser errors)
+     */
+    void parsed(bool success, const QString& message, const QString& details);
+
+    /**
+     * Emitted during conversion.
+     *
+     * @param done number of songs converted so far
+     * @param total total number of songs
+     */
+    void progress(int done, int total);
+
+    /**
+     * Emitted when conversion finishes.
+     *
+     * @param success Was the LaTeX file saved?
+     * @param message status message
+     * @param details detailed output (e.g. parser errors)
+     */
+    void converted(bool success, const QString& message, const QString& details);
+
+    /**
+     * Emitted when a preview is ready.
+     *
+     * @param success Were parsing and conversion successful?
+     * @param message status message
+     * @param content plain text of the changed song (empty when no song
+     * changed) or parser errors
+     */
+    void previewed(bool success, const QString& message, const QString& content);
+
+private:
+    /**
+     * Parses an XML file unless the last parsed file is the same and
+     * has not changed since.
+     *
+     * @param xml_file path to the XML file
+     * @param[out] message status message
+     * @param[out] details detailed output
+     * @return Is the parsed file available?
+     */
+    bool ensure_parsed(const QString& xml_file, QString& message, QString& details);
+
+    /**
+     * Converts the parsed file into `latex_output` and `preview_output`.
+     *
+     * @throws ConversionCancelled the conversion was cancelled
+     */
+    void convert_parsed();
+
+    std::unique_ptr<songbook::MultiSongbookConverter> converter;  /**< LaTeX and plain text printers */
+    std::ostringstream latex_output;     /**< LaTeX output of the last conversion */
+    std::ostringstream preview_output;   /**< plain text output of the last conversion */
+    std::atomic<bool> cancelled{false};
+
+    QString parsed_file;             /**< last successfully parsed file (empty when none) */
+    QDateTime parsed_modified;       /**< modification time of `parsed_file` */
+    qint64 parsed_size{0};           /**< size of `parsed_file` */
+    std::uint64_t parsed_hash{0};    /**< content hash of `parsed_file` */
+
+    QString converted_file;          /**< file of the last conversion (empty when none) */
+    std::uint64_t converted_hash{0}; /**< content hash of `converted_file` */
+};
+
+#endif // CONVERSIONWORKER_HPP
@@ -1,22 +1,30 @@
 #include "MainWindow.hpp"
-#include "SongbookException.hpp"
-#include "SongbookPrinterLatex.hpp"
 
-#include <fstream>
 #include <QGridLayout>
 #include <QVBoxLayout>
+#include <QSplitter>
+#include <QFileInfo>
 #include <QFileDialog>
 #include <QMessageBox>
 
 using namespace std::string_literals;
 
+/**
+ * Number of lines kept in the output area; older lines are discarded.
+ */
+const int max_output_lines = 5000;
+
 MainWindow::MainWindow(QWidget *parent): QWidget{parent} {
 
-    converter = songbook::init_converter<songbook::SongbookPrinterLatex>();
     latex_run_i = 0;
+    latex_errors = 0;
+    latex_overfull_boxes = 0;
+    latex_error_context = false;
     latex_process = new QProcess(this);
     connect(latex_process, &QProcess::finished,
             this, &MainWindow::latex_finished);
+    connect(latex_process, &QProcess::readyReadStandardOutput,
+            this, &MainWindow::read_latex_output);
 
     xml_label = new QLabel(tr("XML file:"));
     pdf_label = new QLabel(tr("PDF file:"));
@@ -52,14 +60,45 @@ MainWindow::MainWindow(QWidget *parent): QWidget{parent} {
     twice_checkbox = new QCheckBox(tr("Twice"));
     twice_checkbox->setToolTip("Should XeLaTeX be run twice to correctly produce the table of contents?");
 
-    output_text = new QTextEdit();
+    output_text = new QPlainTextEdit();
     output_text->setReadOnly(true);
+    output_text->setMaximumBlockCount(max_output_lines);
     output_text->setStyleSheet("font-family: Consolas, \"Courier New\", monospace");
 
+    progress_bar = new QProgressBar();
+    progress_bar->setVisible(false);
+
+    cancel_button = new QPushButton(tr("Cancel"));
+    cancel_button->setToolTip("Stops the conversion or XeLaTeX");
+    cancel_button->setEnabled(false);
+    connect(cancel_button, &QPushButton::clicked,
+            this, &MainWindow::cancel);
+
+    preview_label = new QLabel(tr("Song preview"));
+    preview_text = new QPlainTextEdit();
+    preview_text->setReadOnly(true);
+    preview_text->setPlaceholderText(tr("Songs are shown here when they change in the XML file"));
+    preview_text->setStyleSheet("font-family: Consolas, \"Courier New\", monospace");
+
+    // reconvert after the file stopped changing for a while
+    xml_watcher = new QFileSystemWatcher(this);
+    connect(xml_watcher, &QFileSystemWatcher::fileChanged,
+            this, &MainWindow::xml_file_changed);
+    preview_timer = new QTimer(this);
+    preview_timer->setSingleShot(true);
+    preview_timer->setInterval(300);
+    connect(preview_timer, &QTimer::timeout,
+            this, [this]() {
+                QString xml_file = xml_file_button->text();
+                if (xml_watcher->files().isEmpty() && QFileInfo::exists(xml_file))
+                    xml_watcher->addPath(xml_file);
+                emit preview_requested(xml_file);
+            });
+
     clear_button = new QPushButton(tr("Clear output"));
     clear_button->setToolTip("Clears the above text area");
     connect(clear_button, &QPushButton::clicked,
-            output_text, &QTextEdit::clear);
+            output_text, &QPlainTextEdit::clear);
 
 
     auto grid_layout = new QGridLayout();
@@ -73,13 +112,55 @@ MainWindow::MainWindow(QWidget *parent): QWidget{parent} {
     grid_layout->addWidget(twice_checkbox, 1, 3);
 
     grid_layout->addWidget(status_label, 2, 0, 1, 4);
+    grid_layout->addWidget(progress_bar, 3, 0, 1, 3);
+    grid_layout->addWidget(cancel_button, 3, 3);
+
+    auto preview_widget = new QWidget();
+    auto preview_layout = new QVBoxLayout(preview_widget);
+    preview_layout->setContentsMargins(0, 0, 0, 0);
+    preview_layout->addWidget(preview_label);
+    preview_layout->addWidget(preview_text);
+
+    auto splitter = new QSplitter();
+    splitter->addWidget(output_text);
+    splitter->addWidget(preview_widget);
 
     auto main_layout = new QVBoxLayout(this);
     main_layout->addLayout(grid_layout);
-    main_layout->addWidget(output_text);
+    main_layout->addWidget(splitter);
     main_layout->addWidget(clear_button);
 
     setWindowTitle(tr("Songbook Converter"));
+
+    // parsing and conversion run in a separate thread, the converter is
+    //   created there as well so that the window shows up immediately
+    worker = new ConversionWorker();
+    worker->moveToThread(&worker_thread);
+    connect(&worker_thread, &QThread::finished,
+            worker, &QObject::deleteLater);
+    connect(this, &MainWindow::parse_requested,
+            worker, &ConversionWorker::parse);
+    connect(this, &MainWindow::convert_requested,
+            worker, &ConversionWorker::convert);
+    connect(worker, &ConversionWorker::parsed,
+            this, &MainWindow::parse_finished);
+    connect(worker, &ConversionWorker::progress,
+            this, &MainWindow::show_progress);
+    connect(worker, &ConversionWorker::converted,
+            this, &MainWindow::conversion_finished);
+    connect(this, &MainWindow::preview_requested,
+            worker, &ConversionWorker::preview);
+    connect(worker, &ConversionWorker::previewed,
+            this, &MainWindow::preview_finished);
+    worker_thread.start();
+    QMetaObject::invokeMethod(worker, &ConversionWorker::warm_up, Qt::QueuedConnection);
+}
+
+MainWindow::~MainWindow() {
+
+    worker->cancel();
+    worker_thread.quit();
+    worker_thread.wait();
 }
 
 
@@ -93,6 +174,7 @@ void MainWindow::select_xml_file() {
             "; text-align: left"));
         xml_file_button->setText(xml_file);
         parse_button->setEnabled(true);
+        watch_xml_file(xml_file);
 
         // set PDF file name
         QString pdf_basename_new = xml_file.left(xml_file.size() - 4);
@@ -130,59 +212,105 @@ void MainWindow::select_pdf_file() {
         set_pdf_file(pdf_file);
 }
 
-bool MainWindow::parse_xml() {
+void MainWindow::parse_xml() {
 
     status_label->clear();
     auto xml_file = xml_file_button->text();
 
     if (!xml_file.isEmpty()) {
-        try {
-            converter.parse_songbook(xml_file.toStdString());
-            display_status("XML file parsed succesfully");
-            return true;
-
-        } catch (songbook::SongbookException se) {
-            display_status("Error(s) during XML parsing:", false);
-            output_text->setText(se.what());
-
-        } catch (std::runtime_error re) {
-            display_status("Error: the file \"" + xml_file +
-                               "\" could not be opened",
-                           false);
-        }
+        set_busy(true);
+        emit parse_requested(xml_file);
     }
-    return false;
 }
 
-void MainWindow::create_pdf() {
+void MainWindow::parse_finished(bool success, const QString& message, const QString& details) {
 
-    // always parse XML first and abort when parsing was not successful
-    if (!parse_xml())
-        return;
+    set_busy(false);
+    display_status(message, success);
+    if (!details.isEmpty())
+        output_text->setPlainText(details);
+}
+
+void MainWindow::create_pdf() {
 
-    // try to create LaTeX file
-    std::ofstream ofs;
+    // XML is parsed only when it has changed since the last parsing
     latex_file = pdf_file_basename + ".tex";
-    ofs.open(latex_file.toStdString());
+    progress_bar->reset();
+    progress_bar->setVisible(true);
+    set_busy(true);
+    emit convert_requested(xml_file_button->text(), latex_file);
+}
+
+void MainWindow::conversion_finished(bool success, const QString& message, const QString& details) {
 
-    // abort when LaTeX file can't be opened
-    if (!ofs.is_open()) {
-        display_status("Error: LaTeX file <b>" + latex_file + "</b>" +
-               "could not be saved!");
+    progress_bar->setVisible(false);
+    display_status(message, success);
+    if (!details.isEmpty())
+        output_text->setPlainText(details);
+
+    if (!success) {
+        set_busy(false);
         return;
     }
 
-    // create LaTeX file
-    ofs << converter.convert();
-    ofs.close();
-    display_status("LaTeX file saved to <b>" + latex_file + "</b>");
-
     // LaTeX will run once when this is 0, twice when 1
     latex_run_i = twice_checkbox->isChecked();
-    create_pdf_button->setEnabled(false);
     run_latex();
 }
 
+void MainWindow::show_progress(int done, int total) {
+
+    progress_bar->setMaximum(total);
+    progress_bar->setValue(done);
+}
+
+void MainWindow::cancel() {
+
+    worker->cancel();
+    if (latex_process->state() != QProcess::NotRunning) {
+        latex_run_i = 0;
+        latex_process->kill();
+    }
+}
+
+void MainWindow::watch_xml_file(const QString& xml_file) {
+
+    if (!xml_watcher->files().isEmpty())
+        xml_watcher->removePaths(xml_watcher->files());
+    xml_watcher->addPath(xml_file);
+    preview_text->clear();
+
+    // the first conversion fills the song cache
+    preview_label->setText(tr("Song preview"));
+    preview_timer->start();
+}
+
+void MainWindow::xml_file_changed(const QString& path) {
+
+    // editors saving by replacing the file make the watcher drop it; it
+    //   may not exist again yet, so it's added back when the timer fires
+    if (!xml_watcher->files().contains(path) && QFileInfo::exists(path))
+        xml_watcher->addPath(path);
+    preview_timer->start();
+}
+
+void MainWindow::preview_finished(bool success, const QString& message, const QString& content) {
+
+    preview_label->setStyleSheet(success ? "" : "color: red");
+    preview_label->setText(message);
+    if (!content.isEmpty())
+        preview_text->setPlainText(content);
+}
+
+void MainWindow::set_busy(bool busy) {
+
+    xml_file_button->setEnabled(!busy);
+    parse_button->setEnabled(!busy);
+    pdf_file_button->setEnabled(!busy);
+    create_pdf_button->setEnabled(!busy);
+    cancel_button->setEnabled(busy);
+}
+
 QString MainWindow::add_latex_run_suffix(QString message) {
 
     if (latex_run_i > 0) {
@@ -195,7 +323,14 @@ QString MainWindow::add_latex_run_suffix(QString message) {
 void MainWindow::run_latex() {
 
     display_status(add_latex_run_suffix("Running XeLaTeX") + "...");
+    latex_decoder.resetState();
+    latex_output_rest.clear();
+    latex_errors = 0;
+    latex_overfull_boxes = 0;
+    latex_error_context = false;
+
     QFileInfo fi{latex_file};
+    latex_timer.start();
     latex_process->start("xelatex", {"-interaction=nonstopmode",
                                      "-output-directory=" + fi.canonicalPath(),
                                      latex_file
@@ -204,31 +339,99 @@ void MainWindow::run_latex() {
 
 void MainWindow::latex_finished(int exitCode, QProcess::ExitStatus exitStatus) {
 
-    if (exitCode == 0) {
+    // the rest of the output including an unterminated last line
+    read_latex_output();
+    if (!latex_output_rest.isEmpty()) {
+        append_latex_output(latex_output_rest);
+        latex_output_rest.clear();
+    }
+    if (latex_errors > 0 || latex_overfull_boxes > 0)
+        output_text->appendHtml(QString("<b>XeLaTeX: %1 error(s), %2 overfull box(es)</b>")
+                                    .arg(latex_errors)
+                                    .arg(latex_overfull_boxes));
+
+    if (exitStatus == QProcess::NormalExit && exitCode == 0) {
 
-        display_status(add_latex_run_suffix("PDF file created"));
-        output_text->append(latex_process->readAllStandardOutput());
+        display_status(add_latex_run_suffix("PDF file created") +
+                       QString(" (XeLaTeX: %1 s)").arg(latex_timer.elapsed() / 1000.0, 0, 'f', 1));
 
         // second LaTeX run
         if (latex_run_i > 0 && latex_run_i < 2) {
             ++latex_run_i;
             run_latex();
         } else
-            create_pdf_button->setEnabled(true);
+            set_busy(false);
 
     } else {
 
-        display_status("Error(s) while running XeLaTeX!", false);
-        output_text->append(latex_process->readAllStandardOutput());
-        create_pdf_button->setEnabled(true);
+        display_status(exitStatus == QProcess::CrashExit ?
+                           "XeLaTeX stopped" : "Error(s) while running XeLaTeX!",
+                       false);
+        set_busy(false);
+    }
+}
+
+void MainWindow::read_latex_output() {
+
+    // XeLaTeX writes UTF-8; a character split between reads is completed
+    //   by the next one
+    latex_output_rest.append(QString(latex_decoder.decode(latex_process->readAllStandardOutput())));
+
+    // only complete lines are shown, the rest waits for more output
+    qsizetype end = latex_output_rest.lastIndexOf('\n');
+    if (end < 0)
+        return;
+    append_latex_output(latex_output_rest.left(end));
+    latex_output_rest.remove(0, end + 1);
+}
+
+void MainWindow::append_latex_output(const QString& output) {
+
+    // consecutive ordinary lines are appended at once
+    QStringList plain_lines;
+    auto flush_plain_lines = [this, &plain_lines]() {
+        if (!plain_lines.isEmpty()) {
+            output_text->appendPlainText(plain_lines.join('\n'));
+            plain_lines.clear();
+        }
+    };
+
+    const QStringList lines = output.split('\n');
+    for (QString line: lines) {
+        if (line.endsWith('\r'))
+            line.chop(1);
+
+        // errors start with "!" and end with the line number ("l.123 ...")
+        QString color;
+        if (line.startsWith('!')) {
+            ++latex_errors;
+            latex_error_context = true;
+            color = "red";
+        } else if (latex_error_context) {
+            color = "red";
+            if (line.startsWith("l.") || line.isEmpty())
+                latex_error_context = false;
+        } else if (line.startsWith("Overfull \\")) {
+            ++latex_overfull_boxes;
+            color = "darkorange";
+        }
+
+        if (color.isEmpty())
+            plain_lines.append(line);
+        else {
+            flush_plain_lines();
+            output_text->appendHtml("<span style=\"color: " + color + "\">" +
+                                    line.toHtmlEscaped() + "</span>");
+        }
     }
+    flush_plain_lines();
 }
 
 void MainWindow::display_status(const QString& message, bool success) {
 
     if (!status_label->text().isEmpty()) {
-        output_text->append(status_label->text());
-        output_text->append("<b>=============</b>");
+        output_text->appendHtml(status_label->text());
+        output_text->appendHtml("<b>=============</b>");
     }
 
     std::string color{"color: "};
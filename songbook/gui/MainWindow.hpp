@@ -1,25 +1,46 @@
 #ifndef MAINWINDOW_HPP
 #define MAINWINDOW_HPP
 
-#include <SongbookConverter.hpp>
+#include "ConversionWorker.hpp"
 
 #include <QWidget>
 #include <QLabel>
 #include <QPushButton>
 #include <QLineEdit>
-#include <QTextEdit>
+#include <QPlainTextEdit>
 #include <QCheckBox>
 #include <QProcess>
+#include <QProgressBar>
+#include <QThread>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QStringDecoder>
 
 class MainWindow : public QWidget
 {
     Q_OBJECT
 public:
     explicit MainWindow(QWidget *parent = nullptr);
+    ~MainWindow() override;
     QSize minimumSizeHint() const override;
     QSize sizeHint() const override;
 
 signals:
+    /**
+     * Asks the worker to parse an XML file.
+     */
+    void parse_requested(const QString& xml_file);
+
+    /**
+     * Asks the worker to convert an XML file to a LaTeX file.
+     */
+    void convert_requested(const QString& xml_file, const QString& latex_file);
+
+    /**
+     * Asks the worker to convert a changed XML file for the preview.
+     */
+    void preview_requested(const QString& xml_file);
 
 private:
 
@@ -43,10 +64,18 @@ private:
     void select_pdf_file();
 
     /**
-     * Parses selected XML file.
-     * @return Was parsing successful?
+     * Starts parsing of the selected XML file in the background.
+     */
+    void parse_xml();
+
+    /**
+     * Displays the result of parsing.
+     *
+     * @param success Was parsing successful?
+     * @param message status message
+     * @param details detailed output (e.g. parser errors)
      */
-    bool parse_xml();
+    void parse_finished(bool success, const QString& message, const QString& details);
 
     /**
      * Adds LaTeX run number to a message when appropriate.
@@ -57,10 +86,64 @@ private:
     QString add_latex_run_suffix(QString message);
 
     /**
-     * Parses XML, creates LaTeX file and produces the final PDF.
+     * Parses XML (when changed) and starts creating the LaTeX file in the
+     * background; XeLaTeX is run when it's done.
      */
     void create_pdf();
 
+    /**
+     * Runs XeLaTeX when the LaTeX file was created, displays the error otherwise.
+     *
+     * @param success Was the LaTeX file saved?
+     * @param message status message
+     * @param details detailed output (e.g. parser errors)
+     */
+    void conversion_finished(bool success, const QString& message, const QString& details);
+
+    /**
+     * Displays conversion progress.
+     *
+     * @param done number of songs converted so far
+     * @param total total number of songs
+     */
+    void show_progress(int done, int total);
+
+    /**
+     * Cancels the running conversion or XeLaTeX process.
+     */
+    void cancel();
+
+    /**
+     * Starts watching an XML file for changes (and stops watching the
+     * previous one).
+     *
+     * @param xml_file the file to watch
+     */
+    void watch_xml_file(const QString& xml_file);
+
+    /**
+     * Restarts the preview timer after the watched file changed.
+     *
+     * @param path path of the changed file
+     */
+    void xml_file_changed(const QString& path);
+
+    /**
+     * Displays the song changed in the XML file.
+     *
+     * @param success Were parsing and conversion successful?
+     * @param message status message
+     * @param content changed song or parser errors
+     */
+    void preview_finished(bool success, const QString& message, const QString& content);
+
+    /**
+     * Enables/disables controls while a task is running.
+     *
+     * @param busy Is a task running?
+     */
+    void set_busy(bool busy);
+
     /**
      * Runs XeLaTeX.
      *
@@ -76,6 +159,20 @@ private:
      */
     void latex_finished(int exitCode, QProcess::ExitStatus exitStatus);
 
+    /**
+     * Appends complete lines of XeLaTeX output available so far to the
+     * output area.
+     */
+    void read_latex_output();
+
+    /**
+     * Appends XeLaTeX output lines to the output area, highlighting errors
+     * and overfull boxes.
+     *
+     * @param output complete lines of XeLaTeX output
+     */
+    void append_latex_output(const QString& output);
+
     /**
      * Displays given message in the status label; in green when OK, red otherwise.
      *
@@ -87,22 +184,38 @@ private:
     QLabel *xml_label;
     QLabel *pdf_label;
     QLabel *status_label;
+    QLabel *preview_label;
 
-    QTextEdit *output_text;
+    QPlainTextEdit *output_text;
+    QPlainTextEdit *preview_text;
 
     QPushButton *xml_file_button;
     QPushButton *parse_button;
     QPushButton *pdf_file_button;
     QPushButton *create_pdf_button;
     QPushButton *clear_button;
+    QPushButton *cancel_button;
+
+    QProgressBar *progress_bar;
 
     QCheckBox *twice_checkbox;
 
     QString pdf_file_basename;  /**< base name for LaTeX and XML files (without the extension) */
     QString latex_file;			/**< LaTeX file name */
     int latex_run_i;  			/**< LaTeX run index. 0 when running only once, 1 or 2 when running twice */
-    songbook::SongbookConverter converter;
     QProcess *latex_process;
+    QElapsedTimer latex_timer;      /**< measures the current XeLaTeX run */
+    QStringDecoder latex_decoder{QStringDecoder::Utf8};  /**< keeps incomplete UTF-8 sequences between reads */
+    QString latex_output_rest;      /**< incomplete last line of XeLaTeX output */
+    int latex_errors;               /**< errors in the current XeLaTeX run */
+    int latex_overfull_boxes;       /**< overfull boxes in the current XeLaTeX run */
+    bool latex_error_context;       /**< Do the following lines belong to an error message? */
+
+    QFileSystemWatcher *xml_watcher;
+    QTimer *preview_timer;      /**< delays the preview until the file stops changing */
+
+    ConversionWorker *worker;   /**< parses and converts in `worker_thread` */
+    QThread worker_thread;
 };
 
 #endif // MAINWINDOW_HPP
@@ -0,0 +1,1000 @@
+#include "runCli.hpp"
+#include "SongbookConverter.hpp"
+#include "StaticSongbookConverter.hpp"
+#include "MultiSongbookConverter.hpp"
+#include "SongbookPrinterLatex.hpp"
+#include "SongbookPrinterPdf.hpp"
+#include "SongbookException.hpp"
+#include "LatexBuilder.hpp"
+#include "LatexJobRunner.hpp"
+#include "SearchIndex.hpp"
+#include "ConversionStats.hpp"
+#include "ConversionTrace.hpp"
+#include "FileWatcher.hpp"
+#include "contentHash.hpp"
+#include "chordPro.hpp"
+#include "textUtils.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <fstream>
+#include <exception>
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <sstream>
+
+
+/**
+ * Used for storing parameters from command line arguments.
+ */
+struct StartupArgs {
+    std::string xml_file;      /**< input file (XML or ChordPro) */
+    bool input_is_xml{true};   /**< is `xml_file` a XML file? */
+    std::vector<std::string> chordpro_files;  /**< input ChordPro files */
+    bool trusted{false};       /**< read the XML without validation? */
+    bool fast_validation{false};  /**< validate the XML by the generated validator? */
+    size_t memory_budget{0};   /**< memory for printed songs in bytes; 0 for no limit */
+    std::vector<std::string> songs;  /**< names of songs to convert; all songs when empty */
+    std::string setlist_file;  /**< file with names of songs to convert */
+    bool watch{false};         /**< convert again whenever an input file changes? */
+    size_t split_volumes{0};   /**< number of volumes built separately; 0 for no split */
+    bool split_songs{false};   /**< build a PDF for each song? */
+    unsigned jobs{0};          /**< maximal number of parallel XeLaTeX jobs; 0 for all cores */
+    size_t chunk_songs{0};     /**< number of songs in an `\include` unit; 0 for no units */
+    std::string latex_file;    /**< output LaTeX file*/
+    std::string draft_file;    /**< output draft PDF file */
+    std::string text_file;     /**< output plain text file */
+    int pdf{0};                /**< number of times XeLaTeX should be run */
+    bool use_format{true};     /**< should the precompiled preamble be used? */
+    std::vector<int> transpositions;  /**< requested transpositions (keys) */
+    std::string search_query;  /**< words to search for */
+    std::string stats;         /**< statistics format ("text" or "json"); empty when not collected */
+    std::string trace_file;    /**< output Chrome trace file */
+};
+
+/**
+ * Prints program usage to `std::cerr`.
+ * 
+ * @param gui_available is the GUI available (without arguments)?
+ */
+void print_usage(bool gui_available) {
+    if (gui_available)
+        std::cerr << "GUI version runs when no command line arguments are given.\n\n";
+    std::cerr << R"(Command line usage:   songbook[-cli] [options] <input_xml_file>
+Options:
+  -l <file>     Save LaTeX source code to <file>. Standard output is used when 
+                output file is not specified and '-pdf[2]' is not used.
+  -pdf          Run xelatex to produce a PDF. XeTeX must be installed and 
+                available to the program. PDF file name is based on the LaTeX 
+                file name. If '-l' was not used, LaTeX file name is derived
+                from the XML file name by removing the '.xml' extension (when 
+                present) and adding the '.tex' extension.
+  -pdf2         Run XeLaTeX twice to properly generate the table of contents. 
+                See '-pdf' for other details. Only one of '-pdf'/'-pdf2' can be 
+                used.
+  -draft <file> Create a draft PDF <file> directly, without XeLaTeX. Fonts are 
+                taken from the 'pdfMainFontFile' and 'pdfChordFontFile' 
+                settings or a commonly installed font is used.
+  -txt <file>   Save plain text to <file>.
+  -transpose <n>[,<n>...]
+                Transpose all songs by <n> semitones (can be negative). When 
+                several values are given, each output is created for each of 
+                them from a single parse and '.t<n>' is inserted before the 
+                extension of the output file names (e.g. 'sb.t-2.tex', except
+                for 0); 
+                output files must be specified in this case.
+                When more than one of '-l'/'-pdf[2]', '-draft' and '-txt' is
+                used, the XML is parsed only once and all outputs are 
+                created in parallel. LaTeX is only produced when '-l' or 
+                '-pdf[2]' is used or when no other output is requested.
+  --chordpro <file>
+                Add songs from a ChordPro <file> after the songs of the 
+                input XML file (can be used several times). The input file
+                itself can also be a ChordPro file ('.cho', '.chopro', 
+                '.chordpro' or '.crd'); no settings are used then. ChordPro
+                files are read directly, without the XML parser.
+  --trusted     Read the input XML by a faster reader which does not 
+                validate it (use only for XML already validated, e.g. in CI).
+                Invalid XML can then produce incorrect output instead of 
+                an error message.
+  --fast-validate
+                Validate the input XML by a validator generated from the
+                XML schema at build time instead of Xerces and read it by
+                the reader of '--trusted'. Errors are reported with line
+                and column numbers.
+  --memory-budget <MB>
+                Keep at most <MB> megabytes of converted songs in memory.
+                Songs are read one at a time and those over the budget are
+                sorted into temporary files, which are merged directly into
+                the output files. The input XML is still read into memory
+                and, unless '--trusted' or '--fast-validate' is used, also
+                parsed as a whole by Xerces. For very large songbooks;
+                cannot be used with '-draft'.
+  --song <name> Convert only the song named <name> (can be used several 
+                times). Only the XML settings and the selected songs are 
+                parsed; their positions are taken from a song index saved 
+                next to the XML file ('<input_xml_file>.songs'), which is 
+                updated whenever the XML file changes. Names are compared 
+                exactly or, when no song matches, ignoring case and 
+                diacritics.
+  --setlist <file>
+                Convert only songs listed in <file>, one name per line 
+                (empty lines and lines starting with '#' are ignored); see
+                '--song'.
+  --watch       Keep running and convert the songbook again whenever an input
+                file changes (until interrupted by Ctrl+C). Only changed
+                songs are read and converted again and only changed output
+                files are rewritten (and built by '-pdf[2]'). The XML is
+                validated as with '--fast-validate' unless '--trusted' is
+                used. Output files must be specified; cannot be used with
+                '--memory-budget'.
+  --split <n>|song
+                Split the songbook into <n> volumes of consecutive songs or
+                into single songs ('song') and build a PDF from each of 
+                them by XeLaTeX processes running in parallel. Needs 
+                '-pdf[2]'; PDFs are saved in a directory named after the 
+                LaTeX file ('sb.split' for 'sb.tex'), where each of them is 
+                also built in its own subdirectory with a log of all XeLaTeX
+                runs ('xelatex.log'). Fails when any of the PDFs fails.
+  --jobs <n>    Run at most <n> XeLaTeX processes at once with '--split' 
+                (default: the number of processor cores).
+  --chunks <n>  Put every <n> consecutive songs into a separate LaTeX file
+                ('sb-001.tex', ... for 'sb.tex') included by '\include'.
+                Needs '-pdf[2]'. After a full build, '-pdf' compiles only
+                chunks which differ from it (by one XeLaTeX run with 
+                '\includeonly') into a proof PDF ('sb.proof.pdf'), keeping
+                page numbers and the table of contents of the full build.
+                The whole songbook is built again when anything else 
+                changed, when page numbers of changed chunks change or with
+                '-pdf2'.
+  --search <words>
+                List songs containing all <words> in their name, authors or 
+                lyrics (ignoring case and diacritics; the last word can be 
+                incomplete) instead of converting. The search index is saved
+                next to the XML file ('<input_xml_file>.index') and rebuilt 
+                whenever the XML file changes.
+  --stats[=json]
+                Print time spent in each phase of the conversion (reading,
+                parsing, converting, sorting, writing, XeLaTeX passes, ...),
+                peak memory usage and numbers of songs, lines and chords to
+                standard error output as a table or as JSON.
+  --trace <file>
+                Save spans of the conversion phases, of each song and of 
+                XeLaTeX passes (with the threads they ran in) to <file> in
+                the Chrome trace event format, viewable in Perfetto 
+                (ui.perfetto.dev) or chrome://tracing.
+  -nofmt        Don't precompile the static part of the LaTeX preamble into 
+                a format file. By default, the format is built (using the 
+                'mylatexformat' package) on the first '-pdf[2]' run, cached in
+                the working directory and reused while the preamble and 
+                XeTeX version stay the same.
+)";
+}
+
+/**
+ * Processes command line arguments.
+ * 
+ * @param argc number of command line arguments
+ * @param argv command line arguments
+ * @return processed arguments
+ */
+StartupArgs process_args(int argc, char* argv[]) {
+
+    using namespace std::literals;
+    StartupArgs args;
+
+    int i{1};
+    while (i < argc) {
+        if (argv[i] == "-l"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("LaTeX file name missing after '-l'");
+            if (!args.latex_file.empty())
+                throw std::runtime_error("LaTeX file ('-l') specified more than once");
+            args.latex_file = argv[i+1];
+            i += 2;
+        } else if (argv[i] == "-pdf"s || argv[i] == "-pdf2"s) {
+            if (args.pdf > 0) 
+                throw std::runtime_error("more than one usage of '-pdf' or '-pdf2'");
+            args.pdf = (argv[i] == "-pdf"s) ? 1 : 2;
+            ++i;
+        } else if (argv[i] == "-draft"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("PDF file name missing after '-draft'");
+            args.draft_file = argv[i+1];
+            i += 2;
+        } else if (argv[i] == "-txt"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("text file name missing after '-txt'");
+            args.text_file = argv[i+1];
+            i += 2;
+        } else if (argv[i] == "-transpose"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("number of semitones missing after '-transpose'");
+            if (!args.transpositions.empty())
+                throw std::runtime_error("'-transpose' specified more than once");
+            std::istringstream iss{argv[i+1]};
+            std::string value;
+            while (getline(iss, value, ','))
+                args.transpositions.push_back(songbook::parse_semitones(value));
+            if (args.transpositions.empty())
+                throw std::runtime_error("number of semitones missing after '-transpose'");
+            i += 2;
+        } else if (argv[i] == "--chordpro"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("file name missing after '--chordpro'");
+            args.chordpro_files.push_back(argv[i+1]);
+            i += 2;
+        } else if (argv[i] == "--trusted"s) {
+            args.trusted = true;
+            ++i;
+        } else if (argv[i] == "--fast-validate"s) {
+            args.fast_validation = true;
+            ++i;
+        } else if (argv[i] == "--memory-budget"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("number of megabytes missing after '--memory-budget'");
+            size_t pos{0};
+            long megabytes{0};
+            try {
+                megabytes = std::stol(argv[i+1], &pos);
+            } catch (const std::logic_error&) {
+                pos = 0;
+            }
+            if (pos == 0 || argv[i+1][pos] != '\0' || megabytes <= 0)
+                throw std::runtime_error("incorrect memory budget after '--memory-budget'");
+            args.memory_budget = static_cast<size_t>(megabytes) << 20;
+            i += 2;
+        } else if (argv[i] == "--song"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("song name missing after '--song'");
+            args.songs.push_back(argv[i+1]);
+            i += 2;
+        } else if (argv[i] == "--setlist"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("file name missing after '--setlist'");
+            args.setlist_file = argv[i+1];
+            i += 2;
+        } else if (argv[i] == "--watch"s) {
+            args.watch = true;
+            ++i;
+        } else if (argv[i] == "--split"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("number of volumes missing after '--split'");
+            if (argv[i+1] == "song"s) {
+                args.split_songs = true;
+            } else {
+                size_t pos{0};
+                long volumes{0};
+                try {
+                    volumes = std::stol(argv[i+1], &pos);
+                } catch (const std::logic_error&) {
+                    pos = 0;
+                }
+                if (pos == 0 || argv[i+1][pos] != '\0' || volumes <= 0)
+                    throw std::runtime_error("incorrect number of volumes after '--split'");
+                args.split_volumes = static_cast<size_t>(volumes);
+            }
+            i += 2;
+        } else if (argv[i] == "--jobs"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("number of jobs missing after '--jobs'");
+            size_t pos{0};
+            long jobs{0};
+            try {
+                jobs = std::stol(argv[i+1], &pos);
+            } catch (const std::logic_error&) {
+                pos = 0;
+            }
+            if (pos == 0 || argv[i+1][pos] != '\0' || jobs <= 0)
+                throw std::runtime_error("incorrect number of jobs after '--jobs'");
+            args.jobs = static_cast<unsigned>(jobs);
+            i += 2;
+        } else if (argv[i] == "--chunks"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("number of songs missing after '--chunks'");
+            size_t pos{0};
+            long songs{0};
+            try {
+                songs = std::stol(argv[i+1], &pos);
+            } catch (const std::logic_error&) {
+                pos = 0;
+            }
+            if (pos == 0 || argv[i+1][pos] != '\0' || songs <= 0)
+                throw std::runtime_error("incorrect number of songs after '--chunks'");
+            args.chunk_songs = static_cast<size_t>(songs);
+            i += 2;
+        } else if (argv[i] == "--search"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("words missing after '--search'");
+            args.search_query = argv[i+1];
+            i += 2;
+        } else if (argv[i] == "--stats"s || argv[i] == "--stats=json"s) {
+            args.stats = (argv[i] == "--stats"s) ? "text" : "json";
+            ++i;
+        } else if (argv[i] == "--trace"s) {
+            if (i+1 == argc) 
+                throw std::runtime_error("file name missing after '--trace'");
+            args.trace_file = argv[i+1];
+            i += 2;
+        } else if (argv[i] == "-nofmt"s) {
+            args.use_format = false;
+            ++i;
+        } else if (i == argc-1) {  // last argument left -> input file name
+            args.xml_file = argv[i];
+            ++i;
+        } else {
+            throw std::runtime_error("incorrect argument(s)");
+        }
+    }
+
+    // arguments parsed correctly but input file not specified
+    if (args.xml_file.empty()) 
+        throw std::runtime_error("input XML file not specified");
+
+    // generate LaTeX file name when not given but LaTeX file is produced
+    if (args.pdf && args.latex_file.empty()) {
+        std::string latex_file{args.xml_file};
+        // remove .xml extension when present (first make lowercase)
+        if (latex_file.size() > 4) {
+            std::string extension = latex_file.substr(latex_file.size() - 4);
+            std::transform(begin(extension), end(extension), begin(extension),
+                [](unsigned char c){ return std::tolower(c); });
+            if (extension == ".xml")
+                latex_file.erase(latex_file.size() - 4);
+        }
+        // ... or the ChordPro one
+        if (songbook::is_chordpro_file(latex_file))
+            latex_file.erase(latex_file.find_last_of('.'));
+        latex_file.append(".tex");
+        args.latex_file = latex_file;
+    }
+
+    // ChordPro input instead of XML
+    if (songbook::is_chordpro_file(args.xml_file)) {
+        if (!args.search_query.empty())
+            throw std::runtime_error("'--search' needs an XML input file");
+        if (!args.songs.empty() || !args.setlist_file.empty())
+            throw std::runtime_error("'--song' and '--setlist' need an XML input file");
+        args.chordpro_files.insert(begin(args.chordpro_files), args.xml_file);
+        args.input_is_xml = false;
+    }
+
+    // the PDF layout needs all songs at once
+    if (args.memory_budget > 0 && !args.draft_file.empty())
+        throw std::runtime_error("'--memory-budget' cannot be used with '-draft'");
+
+    // outputs are rewritten on each change
+    if (args.watch) {
+        if (!args.search_query.empty() || args.memory_budget > 0)
+            throw std::runtime_error("'--watch' cannot be used with '--search' or '--memory-budget'");
+        if (args.latex_file.empty() && args.draft_file.empty() && args.text_file.empty())
+            throw std::runtime_error("output file(s) must be specified with '--watch'");
+    }
+
+    // split documents are only built as PDFs
+    if (args.split_volumes > 0 || args.split_songs) {
+        if (!args.pdf)
+            throw std::runtime_error("'--split' needs '-pdf' or '-pdf2'");
+        if (!args.draft_file.empty() || !args.text_file.empty() || args.transpositions.size() > 1)
+            throw std::runtime_error("'--split' cannot be used with '-draft', '-txt' or "
+                "several transpositions");
+        if (args.watch || args.memory_budget > 0 || !args.search_query.empty())
+            throw std::runtime_error("'--split' cannot be used with '--watch', "
+                "'--memory-budget' or '--search'");
+    }
+
+    // chunks are compiled from their files
+    if (args.chunk_songs > 0) {
+        if (!args.pdf)
+            throw std::runtime_error("'--chunks' needs '-pdf' or '-pdf2'");
+        if (!args.draft_file.empty() || !args.text_file.empty() || args.transpositions.size() > 1)
+            throw std::runtime_error("'--chunks' cannot be used with '-draft', '-txt' or "
+                "several transpositions");
+        if (args.split_volumes > 0 || args.split_songs || args.watch || 
+            args.memory_budget > 0 || !args.search_query.empty())
+            throw std::runtime_error("'--chunks' cannot be used with '--split', '--watch', "
+                "'--memory-budget' or '--search'");
+    }
+
+    // several keys cannot be sent to standard output
+    if (args.transpositions.size() > 1 && args.latex_file.empty() && 
+        args.draft_file.empty() && args.text_file.empty())
+        throw std::runtime_error("output file(s) must be specified with several transpositions");
+
+    return args;
+}
+
+/**
+ * Reads song names from a setlist file.
+ * 
+ * @param file setlist file with one song name per line; empty lines and
+ * lines starting with '#' are skipped
+ * @return song names
+ * @throws std::runtime_error the file cannot be opened or has no song names
+ */
+std::vector<std::string> read_setlist(const std::string& file) {
+    std::ifstream ifs{file};
+    if (!ifs)
+        throw std::runtime_error("Setlist file " + file + " cannot be opened");
+
+    std::vector<std::string> names;
+    std::string line;
+    while (getline(ifs, line)) {
+        // trailing whitespace (including '\r' of Windows line ends)
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() && line[0] != '#')
+            names.push_back(line);
+    }
+    if (names.empty())
+        throw std::runtime_error("Setlist file " + file + " contains no songs");
+
+    return names;
+}
+
+/**
+ * Inserts transposition into a file name before its extension, e.g. 
+ * `sb.tex` becomes `sb.t-2.tex`.
+ * 
+ * @param file file name
+ * @param semitones transposition
+ * @return file name for the transposed variant
+ */
+std::string variant_file_name(const std::string& file, int semitones) {
+    std::string suffix{".t" + std::to_string(semitones)};
+
+    // extension must be in the last path component
+    size_t dot = file.find_last_of('.');
+    size_t slash = file.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return file + suffix;
+
+    return file.substr(0, dot) + suffix + file.substr(dot);
+}
+
+/**
+ * Returns transpositions for which outputs are created.
+ * 
+ * @param args command line arguments
+ * @return transpositions (at least one)
+ */
+std::vector<int> output_keys(const StartupArgs& args) {
+    std::vector<int> keys{args.transpositions};
+    if (keys.empty())
+        keys.push_back(0);
+    return keys;
+}
+
+/**
+ * Returns the name of an output file for a transposition.
+ * 
+ * @param args command line arguments
+ * @param file output file name from the arguments
+ * @param semitones transposition
+ * @return `file` or its variant with several transpositions (see 
+ * `variant_file_name()`)
+ */
+std::string output_file_name(const StartupArgs& args, const std::string& file, int semitones) {
+    return (args.transpositions.size() > 1 && semitones != 0) ? 
+        variant_file_name(file, semitones) : file;
+}
+
+/**
+ * Adds printers for all requested outputs (each format in each key) to a 
+ * converter.
+ * 
+ * @param converter converter to add printers to
+ * @param args command line arguments
+ * @param add_output returns the stream for an output file (an empty file
+ * name stands for standard output), which is opened in the given mode
+ */
+void add_printers(songbook::MultiSongbookConverter& converter, const StartupArgs& args,
+    const std::function<std::ostream&(const std::string&, std::ios::openmode)>& add_output) {
+
+    using namespace songbook;
+
+    // LaTeX is produced unless only other outputs were requested
+    bool latex = !args.latex_file.empty() || 
+        (args.draft_file.empty() && args.text_file.empty());
+
+    for (int semitones: output_keys(args)) {
+        if (latex)
+            converter.add_printer<SongbookPrinterLatex>(add_output(
+                output_file_name(args, args.latex_file, semitones), std::ios::out), semitones);
+        if (!args.draft_file.empty())
+            converter.add_printer<SongbookPrinterPdf>(add_output(
+                output_file_name(args, args.draft_file, semitones), std::ios::binary), semitones);
+        if (!args.text_file.empty())
+            converter.add_printer<SongbookPrinter>(add_output(
+                output_file_name(args, args.text_file, semitones), std::ios::out), semitones);
+    }
+}
+
+/**
+ * Returns names of songs to convert given by '--song' and '--setlist'.
+ * 
+ * @param args command line arguments
+ * @return song names; empty to convert all songs
+ * @throws std::runtime_error the setlist file cannot be read
+ */
+std::vector<std::string> selected_songs(const StartupArgs& args) {
+    std::vector<std::string> songs{args.songs};
+    if (!args.setlist_file.empty()) {
+        std::vector<std::string> setlist = read_setlist(args.setlist_file);
+        songs.insert(end(songs), begin(setlist), end(setlist));
+    }
+    return songs;
+}
+
+/**
+ * Creates a file name part from a song name.
+ * 
+ * @param name song name
+ * @return folded words of the name (see `tokenize()`) joined by '-'
+ */
+std::string file_name_slug(const std::string& name) {
+    std::string slug;
+    for (const std::string& word: songbook::tokenize(name)) {
+        if (!slug.empty())
+            slug.push_back('-');
+        slug.append(word);
+    }
+    return slug;
+}
+
+/**
+ * Prints collected statistics and saves the trace as requested.
+ * 
+ * @param args command line arguments
+ * @param stats collected statistics
+ * @param trace collected trace
+ */
+void report_stats(const StartupArgs& args, const songbook::ConversionStats& stats,
+    const songbook::ConversionTrace& trace) {
+
+    if (args.stats == "text")
+        std::cerr << stats.to_text();
+    else if (args.stats == "json")
+        std::cerr << stats.to_json();
+    if (!args.trace_file.empty())
+        trace.save(args.trace_file);
+}
+
+/**
+ * Reads the input files and converts their songs by the printer already
+ * added to a converter.
+ * 
+ * @param args command line arguments
+ * @param converter converter with a printer
+ * @param stats_target statistics to collect to; `nullptr` for none
+ * @return sorted printed songs
+ */
+std::vector<songbook::Song> convert_songs(const StartupArgs& args, 
+    songbook::MultiSongbookConverter& converter, songbook::ConversionStats* stats_target) {
+
+    using namespace songbook;
+
+    converter.set_stats(stats_target);
+    converter.set_trusted(args.trusted);
+    converter.set_generated_validation(args.fast_validation);
+    converter.select_songs(selected_songs(args));
+    if (args.input_is_xml)
+        converter.parse_songbook(args.xml_file);
+    {
+        PhaseTimer timer{stats_target, "read chordpro"};
+        for (const std::string& file: args.chordpro_files)
+            converter.add_songs(load_chordpro(file));
+    }
+    return converter.convert_songs();
+}
+
+/**
+ * Converts the songbook into several LaTeX documents -- volumes of 
+ * consecutive songs or single songs (see '--split') -- and builds them
+ * by parallel XeLaTeX jobs (see `LatexJobRunner`).
+ * 
+ * @param args command line arguments
+ * @return exit code; 1 when any of the jobs failed
+ */
+int run_split(const StartupArgs& args) {
+
+    using namespace songbook;
+
+    ConversionStats stats;
+    ConversionTrace trace;
+    ConversionStats* stats_target = (args.stats.empty() && args.trace_file.empty()) ? 
+        nullptr : &stats;
+    if (!args.trace_file.empty())
+        stats.set_trace(&trace);
+
+    // documents are printed per job rather than written to the stream
+    MultiSongbookConverter converter{};
+    std::ostringstream unused;
+    const SongbookPrinterLatex& printer = converter.add_printer<SongbookPrinterLatex>(
+        unused, output_keys(args).front());
+    std::vector<Song> songs = convert_songs(args, converter, stats_target);
+
+    LatexJobRunner runner{std::filesystem::path{args.latex_file}.replace_extension(".split").string()};
+    runner.set_job_limit(args.jobs);
+    runner.set_passes(args.pdf);
+    runner.set_use_format(args.use_format);
+    runner.set_stats(stats_target);
+
+    // numbers are padded so that files are listed in the songbook's order
+    auto number = [](size_t n, size_t max) {
+        std::string str = std::to_string(n);
+        return std::string(std::to_string(max).size() - str.size(), '0') + str;
+    };
+    {
+        PhaseTimer timer{stats_target, "document"};
+        if (args.split_songs) {
+            for (size_t i = 0; i < songs.size(); ++i) {
+                runner.add_job(number(i + 1, songs.size()) + '-' + 
+                    file_name_slug(songs[i].get_name()), printer.print_document({songs[i]}));
+            }
+        } else {
+            size_t volumes = std::min(args.split_volumes, songs.size());
+            for (size_t v = 0; v < volumes; ++v) {
+                std::vector<Song> volume(begin(songs) + v * songs.size() / volumes,
+                    begin(songs) + (v + 1) * songs.size() / volumes);
+                runner.add_job("vol" + number(v + 1, volumes), printer.print_document(volume));
+            }
+        }
+    }
+
+    bool success = runner.run();
+    std::cerr << runner.summary();
+    report_stats(args, stats, trace);
+
+    return success ? 0 : 1;
+}
+
+/**
+ * Converts the songbook into a LaTeX document with songs in `\include`
+ * units (see '--chunks') and builds it, compiling only changed units when
+ * possible (see `LatexBuilder::run_units()`).
+ * 
+ * @param args command line arguments
+ * @return exit code; 1 when XeLaTeX failed
+ */
+int run_chunks(const StartupArgs& args) {
+
+    using namespace songbook;
+
+    ConversionStats stats;
+    ConversionTrace trace;
+    ConversionStats* stats_target = (args.stats.empty() && args.trace_file.empty()) ? 
+        nullptr : &stats;
+    if (!args.trace_file.empty())
+        stats.set_trace(&trace);
+
+    // the document is written by the builder rather than to the stream
+    MultiSongbookConverter converter{};
+    std::ostringstream unused;
+    const SongbookPrinterLatex& printer = converter.add_printer<SongbookPrinterLatex>(
+        unused, output_keys(args).front());
+    std::vector<Song> songs = convert_songs(args, converter, stats_target);
+
+    // unit names are relative to the directory where XeLaTeX runs
+    LatexUnits document;
+    {
+        PhaseTimer timer{stats_target, "document"};
+        document = printer.print_document_units(songs, args.chunk_songs,
+            std::filesystem::path{args.latex_file}.replace_extension("").generic_string());
+    }
+
+    LatexBuilder builder{args.latex_file};
+    builder.set_use_format(args.use_format);
+    builder.set_stats(stats_target);
+    bool success = builder.run_units(document, args.pdf);
+    if (!success)
+        std::cerr << "Error(s) while running XeLaTeX\n";
+    report_stats(args, stats, trace);
+
+    return success ? 0 : 1;
+}
+
+/**
+ * Converts the songbook and then again whenever an input file changes 
+ * (see '--watch'). Only changed songs are read and printed again (using
+ * the song cache of `MultiSongbookConverter`) and only changed outputs 
+ * are written. Errors are reported and watching continues.
+ * 
+ * @param args command line arguments
+ * @return exit code; only returns when outputs cannot be set up
+ */
+int run_watch(const StartupArgs& args) {
+
+    using namespace songbook;
+
+    // outputs are kept in memory and files are rewritten when they change
+    struct WatchedOutput {
+        std::string file;            /**< output file */
+        std::ios::openmode mode;     /**< mode of opening the file */
+        std::ostringstream content;  /**< output of the last conversion */
+        std::uint64_t hash{0};       /**< content hash of the written file */
+    };
+    std::vector<std::unique_ptr<WatchedOutput>> outputs;
+
+    MultiSongbookConverter converter{};
+    add_printers(converter, args, [&outputs](const std::string& file, std::ios::openmode mode)
+        -> std::ostream& {
+
+        outputs.push_back(std::make_unique<WatchedOutput>());
+        outputs.back()->file = file;
+        outputs.back()->mode = mode;
+        return outputs.back()->content;
+    });
+    converter.set_song_cache(true);
+    converter.set_trusted(args.trusted);
+    converter.set_generated_validation(!args.trusted);
+
+    std::vector<std::string> inputs{args.chordpro_files};
+    if (args.input_is_xml)
+        inputs.insert(begin(inputs), args.xml_file);
+    if (!args.setlist_file.empty())
+        inputs.push_back(args.setlist_file);
+
+    auto convert = [&]() {
+        auto start = std::chrono::steady_clock::now();
+
+        ConversionStats stats;
+        ConversionTrace trace;
+        ConversionStats* stats_target = (args.stats.empty() && args.trace_file.empty()) ? 
+            nullptr : &stats;
+        if (!args.trace_file.empty())
+            stats.set_trace(&trace);
+        converter.set_stats(stats_target);
+
+        converter.select_songs(selected_songs(args));
+        if (args.input_is_xml)
+            converter.parse_songbook(args.xml_file);
+        {
+            PhaseTimer timer{stats_target, "read chordpro"};
+            converter.clear_added_songs();
+            for (const std::string& file: args.chordpro_files)
+                converter.add_songs(load_chordpro(file));
+        }
+        for (auto& output: outputs)
+            output->content.str("");
+        converter.convert();
+
+        PhaseTimer write_timer{stats_target, "write"};
+        std::vector<std::string> written;
+        for (auto& output: outputs) {
+            std::string content = output->content.str();
+            std::uint64_t hash = content_hash(content);
+            if (hash == output->hash)
+                continue;
+
+            std::ofstream ofs{output->file, output->mode};
+            if (!ofs.is_open())
+                throw std::runtime_error("Output file " + output->file + " cannot be opened");
+            ofs << content;
+            output->hash = hash;
+            written.push_back(output->file);
+        }
+        write_timer.stop();
+
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cerr << "Converted " << converter.get_changed_songs().size() << 
+            " changed song(s) in " << ms << " ms, " << written.size() << 
+            " output file(s) written\n";
+
+        // run XeLaTeX for rewritten LaTeX files
+        if (args.pdf) {
+            for (int semitones: output_keys(args)) {
+                std::string latex_file = output_file_name(args, args.latex_file, semitones);
+                if (std::find(begin(written), end(written), latex_file) == end(written))
+                    continue;
+                LatexBuilder builder{latex_file};
+                builder.set_use_format(args.use_format);
+                builder.set_stats(stats_target);
+                if (!builder.run(args.pdf))
+                    std::cerr << "Error(s) while running XeLaTeX\n";
+            }
+        }
+
+        report_stats(args, stats, trace);
+    };
+
+    FileWatcher watcher{inputs};
+    std::cerr << "Watching input file(s) for changes" << 
+        (watcher.uses_notifications() ? "" : " (polling)") << ", press Ctrl+C to stop\n";
+
+    while (true) {
+        try {
+            convert();
+        } 
+        catch (SongbookException& ce) {
+            std::cerr << "Error(s) during XML parsing:\n" << ce.what() << '\n';
+        } 
+        catch (std::exception& e) {
+            std::cerr << e.what() << '\n';
+        }
+        watcher.wait();
+    }
+}
+
+int run_cli(int argc, char* argv[], bool gui_available) {
+
+    using namespace songbook;
+
+    // parse command line arguments
+    StartupArgs args;
+    try {
+        args = process_args(argc, argv);
+    } catch (std::runtime_error& e) {
+        std::cerr << "Error during parsing command line arguments: " <<
+            e.what() << "\n\n";
+        print_usage(gui_available);
+        return 1;
+    }
+
+    try {
+        // search instead of conversion
+        if (!args.search_query.empty()) {
+            SearchIndex index = load_search_index(args.xml_file);
+            std::vector<size_t> found = index.search(args.search_query);
+            for (size_t id: found) {
+                const SearchDocument& doc = index.get_document(id);
+                std::cout << doc.name;
+                if (!doc.authors.empty())
+                    std::cout << " (" << doc.authors << ')';
+                std::cout << '\n';
+            }
+            return found.empty() ? 1 : 0;
+        }
+
+        if (args.watch)
+            return run_watch(args);
+        if (args.split_volumes > 0 || args.split_songs)
+            return run_split(args);
+        if (args.chunk_songs > 0)
+            return run_chunks(args);
+
+        // songs to convert (all when empty)
+        std::vector<std::string> songs = selected_songs(args);
+
+        // statistics are only collected when requested (also for a trace)
+        ConversionStats stats;
+        ConversionTrace trace;
+        ConversionStats* stats_target = (args.stats.empty() && args.trace_file.empty()) ? 
+            nullptr : &stats;
+        if (!args.trace_file.empty())
+            stats.set_trace(&trace);
+
+        // LaTeX is produced unless only other outputs were requested
+        bool latex = !args.latex_file.empty() || 
+            (args.draft_file.empty() && args.text_file.empty());
+        int n_formats = latex + !args.draft_file.empty() + !args.text_file.empty();
+
+        // a key variant of each output for each transposition
+        std::vector<int> keys = output_keys(args);
+        auto output_file = [&](const std::string& file, int semitones) {
+            return output_file_name(args, file, semitones);
+        };
+
+        // opens an output file
+        auto open_output = [](std::ofstream& ofs, const std::string& file, 
+            std::ios::openmode mode = std::ios::out) {
+
+            ofs.open(file, mode);
+            if (!ofs.is_open())
+                throw std::runtime_error("Output file " + file + " cannot be opened");
+        };
+
+        // ChordPro songs and XML read without Xerces are only read into the
+        //   model used by MultiSongbookConverter, which is also the one
+        //   with a memory budget
+        if (n_formats * keys.size() > 1 || !args.chordpro_files.empty() || args.trusted ||
+            args.fast_validation || args.memory_budget > 0) {
+            // all outputs from a single parse
+            MultiSongbookConverter converter{};
+            std::vector<std::unique_ptr<std::ofstream>> streams;
+            auto add_output = [&](const std::string& file, std::ios::openmode mode) 
+                -> std::ostream& {
+
+                // LaTeX to standard output (only possible without variants)
+                if (file.empty())
+                    return std::cout;
+                streams.push_back(std::make_unique<std::ofstream>());
+                open_output(*streams.back(), file, mode);
+                return *streams.back();
+            };
+
+            add_printers(converter, args, add_output);
+            converter.set_stats(stats_target);
+            converter.set_trusted(args.trusted);
+            converter.set_generated_validation(args.fast_validation);
+            converter.set_memory_budget(args.memory_budget);
+            converter.select_songs(songs);
+            if (args.input_is_xml)
+                converter.parse_songbook(args.xml_file);
+            {
+                PhaseTimer timer{stats_target, "read chordpro"};
+                for (const std::string& file: args.chordpro_files)
+                    converter.add_songs(load_chordpro(file));
+            }
+            converter.convert();
+        } else if (!args.draft_file.empty()) {
+            // draft PDF produced directly
+            StaticSongbookConverter<SongbookPrinterPdf> converter{};
+            converter.set_transposition(keys[0]);
+            converter.set_stats(stats_target);
+            converter.select_songs(songs);
+            converter.parse_songbook(args.xml_file);
+            std::string pdf = converter.convert();
+
+            PhaseTimer timer{stats_target, "write"};
+            std::ofstream ofs;
+            open_output(ofs, args.draft_file, std::ios::binary);
+            ofs << pdf;
+        } else if (!args.text_file.empty()) {
+            StaticSongbookConverter<SongbookPrinter> converter{};
+            converter.set_transposition(keys[0]);
+            converter.set_stats(stats_target);
+            converter.select_songs(songs);
+            converter.parse_songbook(args.xml_file);
+            std::string text = converter.convert();
+
+            PhaseTimer timer{stats_target, "write"};
+            std::ofstream ofs;
+            open_output(ofs, args.text_file);
+            ofs << text;
+        } else {
+            StaticSongbookConverter<SongbookPrinterLatex> converter{};
+            converter.set_transposition(keys[0]);
+            converter.set_stats(stats_target);
+            converter.select_songs(songs);
+            converter.parse_songbook(args.xml_file);
+            std::string latex = converter.convert();
+
+            // send output to a file when name was given or to std::cout otherwise
+            PhaseTimer timer{stats_target, "write"};
+            std::ofstream ofs;
+            if (!args.latex_file.empty())
+                open_output(ofs, args.latex_file);
+            std::ostream& output = (ofs.is_open() ? ofs : std::cout);
+
+            output << latex;
+            output.flush();
+        }
+
+        // run XeLaTeX once or twice (for each key variant)
+        if (args.pdf) {
+            for (int semitones: keys) {
+                LatexBuilder builder{output_file(args.latex_file, semitones)};
+                builder.set_use_format(args.use_format);
+                builder.set_stats(stats_target);
+                if (!builder.run(args.pdf)) {
+                    std::cerr << "Error(s) while running XeLaTeX\n";
+                    // the trace may show which pass failed
+                    if (!args.trace_file.empty())
+                        trace.save(args.trace_file);
+                    return 1;
+                }
+            }
+        }
+
+        report_stats(args, stats, trace);
+    } 
+    catch (SongbookException& ce) {
+        std::cerr << "Error(s) during XML parsing:\n" << ce.what();
+        return 1;
+    } 
+    catch (std::exception& e) {
+        std::cerr << e.what();
+        return 1;
+    } 
+    catch (...) {
+        std::cerr << "Unknown error";
+        return 1;
+    }
+
+    return 0;
+}
+
@@ -0,0 +1,18 @@
+#ifndef SONGBOOK_RUNCLI_HPP
+#define SONGBOOK_RUNCLI_HPP
+
+/**
+ * Runs the command line version: processes the arguments, converts the
+ * songbook (or searches it) and reports errors to `std::cerr`.
+ * 
+ * Does not depend on Qt so that it can be linked into `songbook-cli`.
+ * 
+ * @param argc number of command line arguments
+ * @param argv command line arguments
+ * @param gui_available is the GUI available (without arguments)? Only 
+ * affects the usage message.
+ * @return program exit code
+ */
+int run_cli(int argc, char* argv[], bool gui_available);
+
+#endif  // SONGBOOK_RUNCLI_HPP
@@ -0,0 +1,9 @@
+#include "runCli.hpp"
+
+
+/**
+ * Command line version without the GUI; does not link Qt.
+ */
+int main(int argc, char *argv[]) {
+    return run_cli(argc, argv, false);
+}
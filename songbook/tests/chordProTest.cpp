@@ -0,0 +1,166 @@
+/**
+ * @file
+ *
+ * Tests of reading ChordPro songs (chordPro.hpp).
+ */
+
+#include "testing.hpp"
+
+#include "chordPro.hpp"
+#include "SongbookException.hpp"
+
+#include <string>
+
+using namespace songbook;
+
+namespace {
+
+    /**
+     * Describes song events as text, e.g. `verse{ line[G|lyrics] }`.
+     *
+     * @param song song to describe
+     * @return one word per event
+     */
+    std::string describe(const SongData& song) {
+        std::string result;
+        for (const SongEvent& event: song.events) {
+            switch (event.type) {
+                case SongEventType::multicols_start:
+                    result += "cols" + event.number + "{ ";
+                    break;
+                case SongEventType::columnbreak:
+                    result += "break ";
+                    break;
+                case SongEventType::multicols_end:
+                    result += "} ";
+                    break;
+                case SongEventType::verse_start:
+                    result += event.verse_type == VerseType::chorus ? "chorus{ " : "verse{ ";
+                    break;
+                case SongEventType::verse_end:
+                    result += "} ";
+                    break;
+                case SongEventType::line:
+                    result += "line[";
+                    for (const LineElement& element: event.line) {
+                        if (element.type == LineItemType::chord)
+                            result += element.chord.at("root") + '|';
+                        else
+                            result += element.lyrics + '|';
+                    }
+                    result += "] ";
+                    break;
+            }
+        }
+        return result;
+    }
+
+    void test_directives() {
+        std::vector<SongData> songs = read_chordpro(
+            "{title: First}\n"
+            "{sorttitle: First, The}\n"
+            "{artist: Anna}\n"
+            "{composer: Bob}\n"
+            "{album: Album}\n"
+            "{year: 2001}\n"
+            "{transpose: -2}\n"
+            "{meta: dateAdded 2024-05-01}\n"
+            "{soc}\n"
+            "Chorus\n"
+            "{eoc}\n"
+            "{key: G}\n"
+            "{t: Second}\n"
+            "{col: 2}\n"
+            "{start_of_verse}\n"
+            "One\n"
+            "{end_of_verse}\n"
+            "{colb}\n"
+            "{start_of_tab}\n"
+            "e|--3--|\n"
+            "{end_of_tab}\n"
+            "Two\n"
+            "{ns}\n"
+            "{title: Third}\n");
+
+        CHECK_EQUAL(songs.size(), 3u);
+        const SongData& first = songs[0];
+        CHECK_EQUAL(first.header.find("name")->second, "First");
+        CHECK_EQUAL(first.header.find("sortingName")->second, "First, The");
+        CHECK_EQUAL(first.header.count("author"), 2u);
+        CHECK_EQUAL(first.header.find("album")->second, "Album");
+        CHECK_EQUAL(first.header.find("year")->second, "2001");
+        CHECK_EQUAL(first.header.find("dateAdded")->second, "2024-05-01");
+        CHECK_EQUAL(first.transpose, -2);
+        CHECK_EQUAL(describe(first), "chorus{ line[Chorus|] } ");
+
+        // the tab is skipped, the multicols are closed at the end of the song
+        CHECK_EQUAL(describe(songs[1]), "cols2{ verse{ line[One|] } break verse{ line[Two|] } } ");
+        CHECK_EQUAL(songs[1].header.find("dateAdded")->second, "0001-01-01");
+        CHECK_EQUAL(songs[2].header.find("name")->second, "Third");
+    }
+
+    void test_inline_chords() {
+        std::vector<SongData> songs = read_chordpro(
+            "{title: Chords}\n"
+            "[G]Walking [D/F#]down the [(Am7)]road[N.C.]\n");
+        CHECK_EQUAL(songs.size(), 1u);
+        CHECK_EQUAL(describe(songs[0]), "verse{ line[G|Walking |D|down the |A|road||] } ");
+
+        const std::vector<LineElement>& line = songs[0].events[1].line;
+        CHECK_EQUAL(line[2].chord.at("bass"), "F#");
+        CHECK_EQUAL(line[4].chord.at("type"), "m7");
+        CHECK_EQUAL(line[4].chord.at("optional"), "yes");
+        CHECK_EQUAL(line[6].chord.at("type"), "N.C.");
+
+        TagValueMap sixnine = parse_chordpro_chord("C6/9");
+        CHECK_EQUAL(sixnine.at("type"), "6/9");
+        CHECK(!sixnine.count("bass"));
+    }
+
+    void test_comments_and_paragraphs() {
+        std::vector<SongData> songs = read_chordpro(
+            "# a comment before the song\n"
+            "{title: Paragraphs}\r\n"
+            "First\n"
+            "  # an indented comment\n"
+            "Second\n"
+            "\n"
+            "Third\n");
+        CHECK_EQUAL(songs.size(), 1u);
+        CHECK_EQUAL(describe(songs[0]), "verse{ line[First|] line[Second|] } verse{ line[Third|] } ");
+    }
+
+    void test_errors() {
+        CHECK_THROWS(read_chordpro("{title: A}\n[G lyrics\n"), SongbookException);
+        CHECK_THROWS(read_chordpro("{title: A\n"), SongbookException);
+        CHECK_THROWS(read_chordpro("lyrics without a title\n"), SongbookException);
+        CHECK_THROWS(read_chordpro("{title: A}\n{sot}\n"), SongbookException);
+        CHECK_THROWS(read_chordpro("{title: A}\n{columns: 7}\n"), SongbookException);
+
+        std::string message;
+        try {
+            read_chordpro("{title: A}\nfine\n[G broken\n");
+        }
+        catch (const SongbookException& e) {
+            message = e.what();
+        }
+        CHECK(message.find("line 3") != std::string::npos);
+    }
+
+    void test_file_names() {
+        CHECK(is_chordpro_file("song.cho"));
+        CHECK(is_chordpro_file("dir/Song.ChordPro"));
+        CHECK(!is_chordpro_file("songbook.xml"));
+        CHECK(!is_chordpro_file("dir.cho/songbook"));
+    }
+}
+
+int main() {
+    return testing::run_tests({
+        {"directives", test_directives},
+        {"inline chords", test_inline_chords},
+        {"comments and paragraphs", test_comments_and_paragraphs},
+        {"errors", test_errors},
+        {"file names", test_file_names},
+    });
+}
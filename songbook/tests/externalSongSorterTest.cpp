@@ -0,0 +1,131 @@
+/**
+ * @file
+ *
+ * Tests of the external merge sort of songs (ExternalSongSorter.hpp).
+ */
+
+#include "testing.hpp"
+
+#include "ExternalSongSorter.hpp"
+#include "Song.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace songbook;
+
+namespace {
+
+    /**
+     * Songs with sorting names from a small set, so that many of them have
+     * equal keys; the content is unique and records the order of addition.
+     *
+     * @param count number of songs
+     * @return songs in the order of addition
+     */
+    std::vector<Song> make_songs(size_t count) {
+        const char* names[] = {"Zebra", "apple", "Mango", "Apple", "banana", "Mango 2",
+            "cherry", "Zebra crossing", "", "Banana"};
+        std::vector<Song> songs;
+        std::uint64_t state = 12345;
+        for (size_t i = 0; i < count; ++i) {
+            // a linear congruential generator keeps the test deterministic
+            state = state * 6364136223846793005u + 1442695040888963407u;
+            std::string name = names[(state >> 33) % std::size(names)];
+            songs.emplace_back(name, name, name + " #" + std::to_string(i) + '\n');
+        }
+        return songs;
+    }
+
+    /**
+     * Expected output: contents ordered by sorting names (the C locale
+     * compares bytes), songs with equal names in the order of addition.
+     *
+     * @param songs songs in the order of addition
+     * @return expected output
+     */
+    std::string expected_output(std::vector<Song> songs) {
+        std::stable_sort(begin(songs), end(songs), [](const Song& lhs, const Song& rhs) {
+            return lhs.get_sorting_name() < rhs.get_sorting_name();
+        });
+        std::string result;
+        for (const Song& song: songs)
+            result += song.get_content();
+        return result;
+    }
+
+    /**
+     * Sorts songs by an `ExternalSongSorter`.
+     *
+     * @param songs songs to sort
+     * @param budget memory budget in bytes
+     * @param runs number of run files written
+     * @return output of the sorter
+     */
+    std::string sort_songs(const std::vector<Song>& songs, size_t budget, size_t& runs) {
+        ExternalSongSorter sorter{budget};
+        for (const Song& song: songs)
+            sorter.add(song);
+        std::ostringstream output;
+        sorter.write(output);
+        runs = sorter.get_run_count();
+        return output.str();
+    }
+
+    void test_in_memory() {
+        std::vector<Song> songs = make_songs(100);
+        size_t runs;
+        CHECK_EQUAL(sort_songs(songs, 1 << 20, runs), expected_output(songs));
+        CHECK_EQUAL(runs, 0u);
+    }
+
+    void test_several_runs() {
+        std::vector<Song> songs = make_songs(100);
+        size_t runs;
+        CHECK_EQUAL(sort_songs(songs, 1000, runs), expected_output(songs));
+        CHECK(runs > 1);
+        CHECK(runs < ExternalSongSorter::max_merge_runs);
+    }
+
+    void test_merged_runs() {
+        // more runs than are merged at once, so runs are merged into longer ones
+        std::vector<Song> songs = make_songs(2000);
+        size_t runs;
+        CHECK_EQUAL(sort_songs(songs, 1000, runs), expected_output(songs));
+        CHECK(runs > 2 * ExternalSongSorter::max_merge_runs);
+    }
+
+    void test_one_song_per_run() {
+        std::vector<Song> songs = make_songs(40);
+        size_t runs;
+        CHECK_EQUAL(sort_songs(songs, 0, runs), expected_output(songs));
+    }
+
+    void test_unsorted() {
+        std::vector<Song> songs = make_songs(300);
+        ExternalSongSorter sorter{500, false};
+        std::string expected;
+        for (const Song& song: songs) {
+            sorter.add(song);
+            expected += song.get_content();
+        }
+        std::ostringstream output;
+        sorter.write(output);
+        CHECK(sorter.get_run_count() > 1);
+        CHECK_EQUAL(output.str(), expected);
+    }
+}
+
+int main() {
+    return testing::run_tests({
+        {"in memory", test_in_memory},
+        {"several runs", test_several_runs},
+        {"merged runs", test_merged_runs},
+        {"one song per run", test_one_song_per_run},
+        {"unsorted", test_unsorted},
+    });
+}
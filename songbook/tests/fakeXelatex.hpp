@@ -0,0 +1,152 @@
+/**
+ * @file
+ *
+ * Fake `xelatex` for tests of building PDFs: a shell script put first on
+ * `PATH` (POSIX systems only), so that no TeX installation is needed.
+ */
+
+#ifndef SONGBOOK_FAKEXELATEX_HPP
+#define SONGBOOK_FAKEXELATEX_HPP
+
+#include "testing.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace songbook::testing {
+
+    /**
+     * The script. `--version` fails, so that no preamble format is built.
+     * A document containing `FAIL` fails, otherwise `<job>.pdf` is written.
+     *
+     * Documents with `\include{<unit>}` lines are compiled like LaTeX
+     * does: the main `.aux` file inputs the `.aux` file of each unit and
+     * only units listed by `\includeonly` (all without it) are compiled.
+     * Each line of a unit is a page; the `.aux` file of a compiled unit
+     * sets the page counter to the last page of the unit, and a unit
+     * containing `FAIL` fails. An excluded unit sets the page counter from
+     * its `.aux` file only when the job's `.aux` file from the previous run
+     * inputs it (otherwise its pages are missing, as in LaTeX).
+     *
+     * Each run appends `<job>:<compiled units>` to `$FAKE_XELATEX_STATE/runs`
+     * and the number of runs in progress (including itself) to
+     * `$FAKE_XELATEX_STATE/concurrency`; it lasts `$FAKE_XELATEX_SLEEP`
+     * seconds.
+     */
+    inline const char* fake_xelatex_script = R"(#!/bin/sh
+state="$FAKE_XELATEX_STATE"
+[ "$1" = "--version" ] && exit 1
+touch "$state/running/$$"
+ls "$state/running" | wc -l >> "$state/concurrency"
+sleep "$FAKE_XELATEX_SLEEP"
+rm -f "$state/running/$$"
+
+job=$(basename "$1" .tex)
+only=$(sed -n 's/^\\includeonly{\(.*\)}$/\1/p' "$1" | tr ',' ' ')
+inputs=$(cat "$job.aux" 2>/dev/null)
+compiled=""
+page=0
+: > "$job.aux"
+for unit in $(grep -o '\\include{[^}]*}' "$1" | sed 's/^\\include{\(.*\)}$/\1/'); do
+    printf '\\@input{%s.aux}\n' "$unit" >> "$job.aux"
+    case " $only " in
+        "  "|*" $unit "*) ;;
+        *)
+            case "$inputs" in
+                *"\\@input{$unit.aux}"*)
+                    page=$(sed -n 's/^\\setcounter{page}{\(.*\)}$/\1/p' "$unit.aux") ;;
+            esac
+            continue ;;
+    esac
+    grep -q FAIL "$unit.tex" && exit 1
+    page=$((page + $(wc -l < "$unit.tex")))
+    printf '\\setcounter{page}{%s}\n' $page > "$unit.aux"
+    compiled="$compiled $unit"
+done
+echo "$job:$compiled" >> "$state/runs"
+grep -q FAIL "$1" && exit 1
+echo "PDF of $job" > "$job.pdf"
+)";
+
+    /**
+     * Temporary directory with the fake `xelatex` first on `PATH` for the
+     * lifetime of the object.
+     */
+    class FakeXelatex {
+        public:
+        /**
+         * Constructor.
+         *
+         * @param seconds duration of each run (e.g. so that runs overlap)
+         */
+        explicit FakeXelatex(const std::string& seconds = "0") {
+            namespace fs = std::filesystem;
+            fs::create_directories(dir.path("bin"));
+            fs::create_directories(dir.path("state/running"));
+            std::string script = dir.path("bin/xelatex");
+            write_file(script, fake_xelatex_script);
+            fs::permissions(script, fs::perms::owner_all);
+
+            old_path = std::getenv("PATH") ? std::getenv("PATH") : "";
+            setenv("PATH", (dir.path("bin") + ':' + old_path).c_str(), 1);
+            setenv("FAKE_XELATEX_STATE", dir.path("state").c_str(), 1);
+            setenv("FAKE_XELATEX_SLEEP", seconds.c_str(), 1);
+        }
+
+        FakeXelatex(const FakeXelatex&) = delete;
+        FakeXelatex& operator=(const FakeXelatex&) = delete;
+
+        ~FakeXelatex() {
+            setenv("PATH", old_path.c_str(), 1);
+        }
+
+        /**
+         * Returns the runs so far.
+         *
+         * @return `<job>:<compiled units>` (separated by spaces) per run
+         */
+        std::vector<std::string> runs() const {
+            std::vector<std::string> result;
+            std::string content;
+            if (std::filesystem::exists(dir.path("state/runs")))
+                content = read_file(dir.path("state/runs"));
+            std::istringstream iss{content};
+            for (std::string line; getline(iss, line); )
+                result.push_back(line);
+            return result;
+        }
+
+        /**
+         * Returns the maximal number of runs in progress at once.
+         *
+         * @return number of runs; 0 when XeLaTeX did not run
+         */
+        int max_concurrency() const {
+            std::istringstream counts{read_file(dir.path("state/concurrency"))};
+            int max = 0;
+            for (int count; counts >> count; )
+                max = std::max(max, count);
+            return max;
+        }
+
+        /**
+         * Path of a file in a directory for the test output.
+         *
+         * @param name file name
+         * @return path
+         */
+        std::string path(const std::string& name) const {
+            return dir.path(name);
+        }
+
+        private:
+        TempDir dir;
+        std::string old_path;
+    };
+}
+
+#endif  // SONGBOOK_FAKEXELATEX_HPP
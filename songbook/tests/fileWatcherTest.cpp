@@ -0,0 +1,134 @@
+/**
+ * @file
+ *
+ * Tests of waiting for file changes (FileWatcher.hpp).
+ */
+
+#include "testing.hpp"
+
+#include "FileWatcher.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace songbook;
+using namespace std::chrono_literals;
+
+namespace {
+
+    /**
+     * Makes a change while a watcher waits and returns what it reported.
+     * The test executable ends when nothing is reported in time, because
+     * `FileWatcher::wait()` would block forever.
+     *
+     * @param watcher watcher
+     * @param change function changing files
+     * @return changed files reported by the watcher
+     */
+    std::vector<std::string> wait_for_change(FileWatcher& watcher,
+        const std::function<void()>& change) {
+
+        auto changed = std::async(std::launch::async, [&watcher]() { return watcher.wait(); });
+        // let the watcher start waiting
+        std::this_thread::sleep_for(50ms);
+        change();
+        if (changed.wait_for(10s) != std::future_status::ready) {
+            std::cerr << "FAIL no change reported in 10 s\n";
+            std::_Exit(1);
+        }
+        return changed.get();
+    }
+
+    /**
+     * Creates a file whose modification time is in the past, so that
+     * replacing it changes the time even with a coarse clock.
+     *
+     * @param file file name
+     * @param content file content
+     */
+    void create_old_file(const std::string& file, const std::string& content) {
+        testing::write_file(file, content);
+        std::filesystem::last_write_time(file,
+            std::filesystem::last_write_time(file) - std::chrono::seconds{10});
+    }
+
+    void test_atomic_save() {
+        testing::TempDir dir;
+        std::string file = dir.path("sb.xml");
+        create_old_file(file, "<songbook/>");
+        FileWatcher watcher{{file}};
+
+        // as editors save: write a temporary file and rename it over the original
+        std::vector<std::string> changed = wait_for_change(watcher, [&]() {
+            testing::write_file(dir.path("sb.xml.tmp"), "<songbook/>");
+            std::filesystem::rename(dir.path("sb.xml.tmp"), file);
+        });
+        CHECK_EQUAL(changed.size(), 1u);
+        CHECK(changed == std::vector<std::string>{file});
+
+        // the watcher keeps working with the new file
+        changed = wait_for_change(watcher, [&]() {
+            testing::write_file(dir.path("sb.xml.tmp"), "<songbook></songbook>");
+            std::filesystem::rename(dir.path("sb.xml.tmp"), file);
+        });
+        CHECK(changed == std::vector<std::string>{file});
+    }
+
+    void test_write_in_place() {
+        testing::TempDir dir;
+        std::string file = dir.path("sb.xml");
+        create_old_file(file, "<songbook/>");
+        FileWatcher watcher{{file}};
+
+        std::vector<std::string> changed = wait_for_change(watcher, [&]() {
+            testing::write_file(file, "<songbook></songbook>");
+        });
+        CHECK(changed == std::vector<std::string>{file});
+    }
+
+    void test_only_watched_files() {
+        testing::TempDir dir;
+        std::string watched = dir.path("sb.xml");
+        std::string other = dir.path("song.cho");
+        create_old_file(watched, "<songbook/>");
+        create_old_file(other, "{title: A}");
+        FileWatcher watcher{{watched, other}};
+
+        std::vector<std::string> changed = wait_for_change(watcher, [&]() {
+            testing::write_file(dir.path("unrelated.txt"), "text");
+            testing::write_file(other, "{title: B}\n");
+        });
+        CHECK(changed == std::vector<std::string>{other});
+    }
+
+    void test_missing_file() {
+        testing::TempDir dir;
+        std::string file = dir.path("sb.xml");
+        create_old_file(file, "<songbook/>");
+        FileWatcher watcher{{file}};
+
+        // a removed file is only reported when it exists again
+        std::vector<std::string> changed = wait_for_change(watcher, [&]() {
+            std::filesystem::remove(file);
+            std::this_thread::sleep_for(FileWatcher::poll_interval * 2);
+            testing::write_file(file, "<songbook></songbook>");
+        });
+        CHECK(changed == std::vector<std::string>{file});
+    }
+}
+
+int main() {
+    return testing::run_tests({
+        {"atomic save", test_atomic_save},
+        {"write in place", test_write_in_place},
+        {"only watched files", test_only_watched_files},
+        {"missing file", test_missing_file},
+    });
+}
@@ -0,0 +1,95 @@
+/**
+ * @file
+ *
+ * Tests of parallel XeLaTeX jobs (LatexJobRunner.hpp) with a fake
+ * `xelatex` (see fakeXelatex.hpp).
+ */
+
+#include "fakeXelatex.hpp"
+#include "testing.hpp"
+
+#include "LatexJobRunner.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace songbook;
+
+namespace {
+
+    /**
+     * Minimal LaTeX document.
+     *
+     * @param text document text
+     * @return LaTeX document
+     */
+    std::string document(const std::string& text) {
+        return "\\documentclass{article}\n\\begin{document}\n" + text + "\n\\end{document}\n";
+    }
+
+    void test_all_succeed() {
+        testing::FakeXelatex xelatex;
+        LatexJobRunner runner{xelatex.path("out")};
+        runner.set_use_format(false);
+        runner.set_passes(2);
+        runner.add_job("vol1", document("one"));
+        runner.add_job("vol2", document("two"));
+
+        CHECK(runner.run());
+        CHECK_EQUAL(runner.get_results().size(), 2u);
+        for (const LatexJobResult& result: runner.get_results()) {
+            CHECK(result.success);
+            CHECK_EQUAL(testing::read_file(result.pdf_file), "PDF of " + result.name + "\n");
+            // one line per pass
+            std::string log = testing::read_file(result.log_file);
+            CHECK_EQUAL(log.find("Running: "), 0u);
+            CHECK(log.find("Running: ", 1) != std::string::npos);
+        }
+        CHECK(runner.summary().find("2 PDF(s) built") != std::string::npos);
+    }
+
+    void test_one_fails() {
+        testing::FakeXelatex xelatex;
+        LatexJobRunner runner{xelatex.path("out")};
+        runner.set_use_format(false);
+        runner.add_job("good1", document("one"));
+        runner.add_job("bad", document("FAIL"));
+        runner.add_job("good2", document("two"));
+
+        CHECK(!runner.run());
+        const std::vector<LatexJobResult>& results = runner.get_results();
+        CHECK_EQUAL(results.size(), 3u);
+        CHECK(results[0].success);
+        CHECK(!results[1].success);
+        CHECK(results[2].success);
+        CHECK(!std::filesystem::exists(results[1].pdf_file));
+
+        std::string summary = runner.summary();
+        CHECK(summary.find("Failed: bad") != std::string::npos);
+        CHECK(summary.find("2 PDF(s) built") != std::string::npos);
+        CHECK(summary.find("1 failed") != std::string::npos);
+    }
+
+    void test_job_limit() {
+        for (unsigned limit: {1u, 2u, 3u}) {
+            testing::FakeXelatex xelatex;
+            LatexJobRunner runner{xelatex.path("out")};
+            runner.set_use_format(false);
+            runner.set_job_limit(limit);
+            for (int i = 0; i < 6; ++i)
+                runner.add_job("job" + std::to_string(i), document("text"));
+
+            CHECK(runner.run());
+            CHECK_EQUAL(xelatex.max_concurrency(), static_cast<int>(limit));
+        }
+    }
+}
+
+int main() {
+    return testing::run_tests({
+        {"all succeed", test_all_succeed},
+        {"one fails", test_one_fails},
+        {"job limit", test_job_limit},
+    });
+}
@@ -0,0 +1,188 @@
+/**
+ * @file
+ *
+ * Tests of documents split into `\include` units: splitting
+ * (`SongbookPrinterLatex::print_document_units()`) and partial builds
+ * (`LatexBuilder::run_units()`) with a fake `xelatex` (see
+ * fakeXelatex.hpp).
+ */
+
+#include "fakeXelatex.hpp"
+#include "testing.hpp"
+
+#include "LatexBuilder.hpp"
+#include "Song.hpp"
+#include "SongbookPrinterLatex.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace songbook;
+
+namespace {
+
+    /**
+     * Songs whose content is `<name>\n` (one line each).
+     *
+     * @param names song names
+     * @return songs
+     */
+    std::vector<Song> make_songs(const std::vector<std::string>& names) {
+        std::vector<Song> songs;
+        for (const std::string& name: names)
+            songs.emplace_back(name, name, name + '\n');
+        return songs;
+    }
+
+    /**
+     * Document with two songs per unit.
+     *
+     * @param names song names
+     * @return main document and units `sb-001`, ...
+     */
+    LatexUnits units(const std::vector<std::string>& names) {
+        return SongbookPrinterLatex{}.print_document_units(make_songs(names), 2, "sb");
+    }
+
+    /**
+     * Runs after the first `first` ones.
+     *
+     * @param xelatex fake XeLaTeX
+     * @param first number of runs to skip
+     * @return runs, one per line
+     */
+    std::string runs_since(const testing::FakeXelatex& xelatex, size_t first) {
+        std::string result;
+        std::vector<std::string> runs = xelatex.runs();
+        for (size_t i = first; i < runs.size(); ++i)
+            result += runs[i] + '\n';
+        return result;
+    }
+
+    /**
+     * Builder of `sb.tex` in the fake XeLaTeX's directory.
+     *
+     * @param xelatex fake XeLaTeX
+     * @return builder
+     */
+    LatexBuilder make_builder(const testing::FakeXelatex& xelatex) {
+        LatexBuilder builder{"sb.tex"};
+        builder.set_working_directory(xelatex.path(""));
+        builder.set_log_file(xelatex.path("xelatex.log"));
+        builder.set_use_format(false);
+        return builder;
+    }
+
+    void test_splitting() {
+        LatexUnits document = units({"A", "B", "C", "D", "E"});
+        CHECK_EQUAL(document.units.size(), 3u);
+        CHECK_EQUAL(document.units[0].first, "sb-001");
+        CHECK_EQUAL(document.units[0].second, "A\nB\n");
+        CHECK_EQUAL(document.units[2].first, "sb-003");
+        CHECK_EQUAL(document.units[2].second, "E\n");
+
+        size_t begin_document = document.main.find("\\begin{document}");
+        size_t first = document.main.find("\\include{sb-001}");
+        size_t last = document.main.find("\\include{sb-003}");
+        CHECK(begin_document != std::string::npos);
+        CHECK(first > begin_document && first != std::string::npos);
+        CHECK(last > first && last != std::string::npos);
+        CHECK(document.main.find("\\end{document}") > last);
+
+        // numbers are padded so that unit files are listed in order
+        std::vector<std::string> names(2001, "x");
+        LatexUnits large = SongbookPrinterLatex{}.print_document_units(
+            make_songs(names), 2, "dir/sb");
+        CHECK_EQUAL(large.units.size(), 1001u);
+        CHECK_EQUAL(large.units[0].first, "dir/sb-0001");
+        CHECK_EQUAL(large.units[1000].first, "dir/sb-1001");
+    }
+
+    void test_includeonly_decision() {
+        testing::FakeXelatex xelatex;
+        LatexBuilder builder = make_builder(xelatex);
+        LatexUnits original = units({"A", "B", "C", "D", "E"});
+
+        // the first build is a full one
+        CHECK(builder.run_units(original));
+        CHECK_EQUAL(runs_since(xelatex, 0), "sb: sb-001 sb-002 sb-003\n");
+        CHECK(std::filesystem::exists(xelatex.path("sb.units")));
+
+        // nothing changed
+        CHECK(builder.run_units(original));
+        CHECK_EQUAL(xelatex.runs().size(), 1u);
+
+        // one unit changed; its pages follow those of the excluded units
+        //   and the table of contents of the full build is kept
+        testing::write_file(xelatex.path("sb.toc"), "contents\n");
+        CHECK(builder.run_units(units({"A", "B", "C", "X", "E"})));
+        CHECK_EQUAL(runs_since(xelatex, 1), "sb.proof: sb-002\n");
+        CHECK(testing::read_file(xelatex.path("sb.proof.tex")).find("\\includeonly{sb-002}")
+            != std::string::npos);
+        CHECK_EQUAL(testing::read_file(xelatex.path("sb-002.aux")), "\\setcounter{page}{4}\n");
+        CHECK_EQUAL(testing::read_file(xelatex.path("sb.proof.toc")), "contents\n");
+
+        // more passes build the whole document
+        CHECK(builder.run_units(units({"A", "B", "C", "X", "E"}), 2));
+        CHECK_EQUAL(runs_since(xelatex, 2), "sb: sb-001 sb-002 sb-003\nsb: sb-001 sb-002 sb-003\n");
+
+        // so do a different list of units and a missing PDF of the full build
+        CHECK(builder.run_units(units({"A", "B", "C", "X", "E", "F", "G"})));
+        CHECK_EQUAL(runs_since(xelatex, 4), "sb: sb-001 sb-002 sb-003 sb-004\n");
+        std::filesystem::remove(xelatex.path("sb.pdf"));
+        CHECK(builder.run_units(units({"A", "B", "C", "X", "E", "F", "Y"})));
+        CHECK_EQUAL(runs_since(xelatex, 5), "sb: sb-001 sb-002 sb-003 sb-004\n");
+
+        // changed page numbers of a unit renumber the following ones
+        CHECK(builder.run_units(units({"A", "B", "C\nC", "X", "E", "F", "Y"})));
+        CHECK_EQUAL(runs_since(xelatex, 6), "sb.proof: sb-002\nsb: sb-001 sb-002 sb-003 sb-004\n");
+    }
+
+    void test_partial_builds_in_a_row() {
+        testing::FakeXelatex xelatex;
+        LatexBuilder builder = make_builder(xelatex);
+        CHECK(builder.run_units(units({"A", "B", "C", "D", "E"})));
+
+        // the second partial build includes the edit of the first one,
+        //   which the full build lacks
+        CHECK(builder.run_units(units({"X", "B", "C", "D", "E"})));
+        CHECK(builder.run_units(units({"X", "B", "C", "D", "Y"})));
+        CHECK_EQUAL(runs_since(xelatex, 1), "sb.proof: sb-001\nsb.proof: sb-001 sb-003\n");
+
+        // the same build again compiles the same units
+        CHECK(builder.run_units(units({"X", "B", "C", "D", "Y"})));
+        CHECK_EQUAL(runs_since(xelatex, 3), "sb.proof: sb-001 sb-003\n");
+
+        // undone edits match the full build, whose PDF is up to date
+        CHECK(builder.run_units(units({"A", "B", "C", "D", "E"})));
+        CHECK_EQUAL(xelatex.runs().size(), 4u);
+    }
+
+    void test_failures() {
+        testing::FakeXelatex xelatex;
+        LatexBuilder builder = make_builder(xelatex);
+        CHECK(builder.run_units(units({"A", "B", "C", "D"})));
+
+        // a failed unit is compiled again until it succeeds
+        CHECK(!builder.run_units(units({"FAIL", "B", "C", "D"})));
+        CHECK(!builder.run_units(units({"FAIL", "B", "C", "D"})));
+        CHECK(builder.run_units(units({"Z", "B", "C", "D"})));
+        CHECK_EQUAL(runs_since(xelatex, 1), "sb.proof: sb-001\n");
+
+        // after a failed full build, the next build is a full one again
+        CHECK(!builder.run_units(units({"FAIL", "B", "C", "D"}), 2));
+        CHECK(!std::filesystem::exists(xelatex.path("sb.units")));
+        CHECK(builder.run_units(units({"A", "B", "C", "D"})));
+        CHECK_EQUAL(runs_since(xelatex, 2), "sb: sb-001 sb-002\n");
+    }
+}
+
+int main() {
+    return testing::run_tests({
+        {"splitting", test_splitting},
+        {"includeonly decision", test_includeonly_decision},
+        {"partial builds in a row", test_partial_builds_in_a_row},
+        {"failures", test_failures},
+    });
+}
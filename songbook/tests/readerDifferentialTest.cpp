@@ -0,0 +1,84 @@
+/**
+ * @file
+ *
+ * Differential test of the XML readers: Xerces, the trusted reader
+ * (`--trusted`) and the generated validator with the trusted reader
+ * (`--fast-validate`) must give byte-identical LaTeX, text and transposed
+ * LaTeX for the songbooks passed as arguments.
+ */
+
+#include "testing.hpp"
+
+#include "MultiSongbookConverter.hpp"
+#include "SongbookPrinter.hpp"
+#include "SongbookPrinterLatex.hpp"
+
+#include <array>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace songbook;
+
+namespace {
+
+    std::vector<std::string> inputs;  ///< songbooks from the command line
+
+    /**
+     * XML reader of a conversion.
+     */
+    enum class Reader {xerces, trusted, fast_validate};
+
+    /**
+     * Converts a songbook to LaTeX, text and LaTeX transposed by three
+     * semitones.
+     *
+     * @param filename songbook XML
+     * @param reader XML reader to use
+     * @return the three outputs
+     */
+    std::array<std::string, 3> convert(const std::string& filename, Reader reader) {
+        std::array<std::ostringstream, 3> outputs;
+        MultiSongbookConverter converter{};
+        converter.add_printer<SongbookPrinterLatex>(outputs[0]);
+        converter.add_printer<SongbookPrinter>(outputs[1]);
+        converter.add_printer<SongbookPrinterLatex>(outputs[2], 3);
+        converter.set_trusted(reader == Reader::trusted);
+        converter.set_generated_validation(reader == Reader::fast_validate);
+        converter.parse_songbook(filename);
+        converter.convert();
+
+        return {outputs[0].str(), outputs[1].str(), outputs[2].str()};
+    }
+
+    void test_same_output() {
+        const char* output_names[] = {"LaTeX", "text", "transposed LaTeX"};
+        for (const std::string& input: inputs) {
+            std::array<std::string, 3> xerces = convert(input, Reader::xerces);
+            std::array<std::string, 3> trusted = convert(input, Reader::trusted);
+            std::array<std::string, 3> validated = convert(input, Reader::fast_validate);
+            for (size_t i = 0; i < xerces.size(); ++i) {
+                CHECK(!xerces[i].empty());
+                if (trusted[i] != xerces[i])
+                    std::cerr << input << ": --trusted " << output_names[i] << " differs\n";
+                if (validated[i] != xerces[i])
+                    std::cerr << input << ": --fast-validate " << output_names[i] << " differs\n";
+                CHECK(trusted[i] == xerces[i]);
+                CHECK(validated[i] == xerces[i]);
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    inputs.assign(argv + 1, argv + argc);
+    if (inputs.empty()) {
+        std::cerr << "Usage: readerDifferentialTest <songbook.xml>...\n";
+        return 1;
+    }
+
+    return testing::run_tests({
+        {"same output of all readers", test_same_output},
+    });
+}
@@ -0,0 +1,141 @@
+/**
+ * @file
+ *
+ * Tests of the song index (SongIndex.hpp).
+ */
+
+#include "testing.hpp"
+
+#include "SongIndex.hpp"
+#include "SongbookException.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace songbook;
+
+namespace {
+
+    /**
+     * Songbook XML with songs of the given names.
+     *
+     * @param names song names
+     * @return songbook XML
+     */
+    std::string songbook_xml(const std::vector<std::string>& names) {
+        std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<songbook>\n"
+            "<settings>\n  <sortSongsBy>name</sortSongsBy>\n</settings>\n<songs>\n";
+        for (const std::string& name: names) {
+            xml += "<song>\n  <header>\n    <name>" + name + "</name>\n"
+                "    <dateAdded>NA</dateAdded>\n  </header>\n"
+                "<verse>\n<line>" + name + " lyrics</line>\n</verse>\n</song>\n";
+        }
+        return xml + "</songs>\n</songbook>\n";
+    }
+
+    /**
+     * Names of songs found by `SongIndex::find_songs()`.
+     *
+     * @param index song index
+     * @param name name to look for
+     * @return names of the songs found, joined by `|`
+     */
+    std::string found(const SongIndex& index, const std::string& name) {
+        std::string result;
+        for (size_t id: index.find_songs({name})) {
+            if (!result.empty())
+                result += '|';
+            result += index.get_song(id).header.find("name")->second;
+        }
+        return result;
+    }
+
+    void test_lookup() {
+        std::string xml = songbook_xml({"Bludný Holaňďan", "Bludny Holandan", "Čas"});
+        SongIndex index{xml, 1, xml.size()};
+        CHECK_EQUAL(index.size(), 3u);
+
+        // the exact name is preferred to names equal after folding
+        CHECK_EQUAL(found(index, "Bludný Holaňďan"), "Bludný Holaňďan");
+        CHECK_EQUAL(found(index, "Bludny Holandan"), "Bludny Holandan");
+        CHECK_EQUAL(found(index, "bludny holandan"), "Bludný Holaňďan|Bludny Holandan");
+        CHECK_EQUAL(found(index, "ČAS!"), "Čas");
+        CHECK_THROWS(index.find_songs({"Čas", "Missing"}), SongbookException);
+    }
+
+    void test_read_songs() {
+        testing::TempDir dir;
+        std::string file = dir.path("sb.xml");
+        std::string xml = songbook_xml({"First", "Second", "Third"});
+        testing::write_file(file, xml);
+
+        SongIndex index = load_song_index(file);
+        std::string subset = index.read_songs(file, index.find_songs({"Third"}));
+        CHECK(subset.find("Third lyrics") != std::string::npos);
+        CHECK(subset.find("First") == std::string::npos);
+        CHECK(subset.find("Second") == std::string::npos);
+        // songs stay on their original lines
+        CHECK_EQUAL(std::count(begin(subset), end(subset), '\n'),
+            std::count(begin(xml), end(xml), '\n'));
+    }
+
+    void test_rebuild_after_change() {
+        testing::TempDir dir;
+        std::string file = dir.path("sb.xml");
+        testing::write_file(file, songbook_xml({"Old Song", "Kept Song"}));
+
+        SongIndex index = load_song_index(file);
+        CHECK(std::filesystem::exists(song_index_file(file)));
+        CHECK_EQUAL(found(index, "Old Song"), "Old Song");
+
+        // another song of the same length, so only the modification time changes
+        testing::write_file(file, songbook_xml({"New Song", "Kept Song"}));
+        std::filesystem::last_write_time(file,
+            std::filesystem::last_write_time(file) + std::chrono::seconds{2});
+        index = load_song_index(file);
+        CHECK_EQUAL(found(index, "new song"), "New Song");
+        CHECK_EQUAL(found(index, "Kept Song"), "Kept Song");
+        CHECK_THROWS(index.find_songs({"Old Song"}), SongbookException);
+
+        // an added song changes the size
+        testing::write_file(file, songbook_xml({"New Song", "Kept Song", "Žluťoučký kůň"}));
+        index = load_song_index(file);
+        CHECK_EQUAL(index.size(), 3u);
+        CHECK_EQUAL(found(index, "zlutoucky kun"), "Žluťoučký kůň");
+
+        // the saved index is current and is loaded as it is
+        SongIndex saved;
+        CHECK(saved.load(song_index_file(file)));
+        CHECK(saved.is_current(
+            static_cast<std::int64_t>(std::filesystem::last_write_time(file).time_since_epoch().count()),
+            std::filesystem::file_size(file)));
+        CHECK_EQUAL(found(saved, "Žluťoučký kůň"), "Žluťoučký kůň");
+    }
+
+    void test_reused_headers() {
+        std::string old_xml = songbook_xml({"First", "Second"});
+        SongIndex old_index{old_xml, 1, old_xml.size()};
+        std::string xml = songbook_xml({"Zeroth", "First", "Second"});
+        SongIndex index{xml, 2, xml.size(), &old_index};
+
+        CHECK_EQUAL(index.size(), 3u);
+        CHECK_EQUAL(found(index, "Zeroth"), "Zeroth");
+        CHECK_EQUAL(index.get_song(1).hash, old_index.get_song(0).hash);
+        CHECK(index.get_song(1).offset > old_index.get_song(0).offset);
+        CHECK(index.is_current(2, xml.size()));
+        CHECK(!index.is_current(1, xml.size()));
+    }
+}
+
+int main() {
+    return testing::run_tests({
+        {"lookup", test_lookup},
+        {"read songs", test_read_songs},
+        {"rebuild after change", test_rebuild_after_change},
+        {"reused headers", test_reused_headers},
+    });
+}
@@ -0,0 +1,170 @@
+/**
+ * @file
+ *
+ * Minimal helpers for the unit tests run by ctest. Each test executable
+ * passes its test functions to `run_tests()`, which returns the exit
+ * status (1 when any check failed).
+ */
+
+#ifndef SONGBOOK_TESTING_HPP
+#define SONGBOOK_TESTING_HPP
+
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace songbook::testing {
+
+    inline int failures = 0;  ///< number of failed checks
+
+    /**
+     * Records the result of a check.
+     *
+     * @param ok did the check pass?
+     * @param expression checked expression
+     * @param file source file
+     * @param line source line
+     */
+    inline void check(bool ok, const char* expression, const char* file, int line) {
+        if (ok)
+            return;
+        ++failures;
+        std::cerr << file << ':' << line << ": check failed: " << expression << '\n';
+    }
+
+    /**
+     * Records the result of comparing two values and prints both when
+     * they differ.
+     *
+     * @param actual value computed by the tested code
+     * @param expected expected value
+     * @param expression compared expressions
+     * @param file source file
+     * @param line source line
+     */
+    template<typename A, typename E>
+    void check_equal(const A& actual, const E& expected, const char* expression,
+        const char* file, int line) {
+
+        if (actual == expected)
+            return;
+        ++failures;
+        std::cerr << file << ':' << line << ": check failed: " << expression
+            << "\n  actual:   " << actual << "\n  expected: " << expected << '\n';
+    }
+
+    /**
+     * Runs test functions; an exception thrown by a test is a failure.
+     *
+     * @param tests test names and functions
+     * @return exit status of the test executable
+     */
+    inline int run_tests(std::initializer_list<std::pair<const char*, void (*)()>> tests) {
+        for (const auto& [name, test]: tests) {
+            int before = failures;
+            try {
+                test();
+            }
+            catch (std::exception& e) {
+                ++failures;
+                std::cerr << name << ": unexpected exception: " << e.what() << '\n';
+            }
+            std::cout << (failures == before ? "PASS " : "FAIL ") << name << '\n';
+        }
+        return failures ? 1 : 0;
+    }
+
+    /**
+     * Temporary directory removed with its content by the destructor.
+     */
+    class TempDir {
+        public:
+        /**
+         * Constructor, creates a new empty directory.
+         */
+        TempDir() {
+            // tests may run in parallel, so the name must be unique
+            std::random_device random;
+            do {
+                dir = std::filesystem::temp_directory_path() /
+                    ("songbook_test_" + std::to_string(random()));
+            } while (!std::filesystem::create_directory(dir));
+        }
+
+        TempDir(const TempDir&) = delete;
+        TempDir& operator=(const TempDir&) = delete;
+
+        ~TempDir() {
+            std::error_code ec;
+            std::filesystem::remove_all(dir, ec);
+        }
+
+        /**
+         * Path of a file inside the directory.
+         *
+         * @param name file name
+         * @return file path
+         */
+        std::string path(const std::string& name) const {
+            return (dir / name).string();
+        }
+
+        private:
+        std::filesystem::path dir;
+    };
+
+    /**
+     * Writes a file, replacing its content.
+     *
+     * @param filename file path
+     * @param content new content
+     */
+    inline void write_file(const std::string& filename, const std::string& content) {
+        std::ofstream ofs{filename, std::ios::binary};
+        ofs << content;
+        if (!ofs)
+            throw std::runtime_error("File " + filename + " cannot be written");
+    }
+
+    /**
+     * Reads a whole file.
+     *
+     * @param filename file path
+     * @return file content
+     */
+    inline std::string read_file(const std::string& filename) {
+        std::ifstream ifs{filename, std::ios::binary};
+        if (!ifs)
+            throw std::runtime_error("File " + filename + " cannot be opened");
+        std::ostringstream oss;
+        oss << ifs.rdbuf();
+        return std::move(oss).str();
+    }
+}
+
+/** Fails the current test when `condition` is false. */
+#define CHECK(condition) \
+    songbook::testing::check((condition), #condition, __FILE__, __LINE__)
+
+/** Fails the current test when `actual` is not equal to `expected`. */
+#define CHECK_EQUAL(actual, expected) \
+    songbook::testing::check_equal((actual), (expected), #actual " == " #expected, \
+        __FILE__, __LINE__)
+
+/** Fails the current test unless `statement` throws `exception_type`. */
+#define CHECK_THROWS(statement, exception_type) \
+    do { \
+        bool thrown = false; \
+        try { statement; } catch (const exception_type&) { thrown = true; } \
+        songbook::testing::check(thrown, #statement " throws " #exception_type, \
+            __FILE__, __LINE__); \
+    } while (false)
+
+#endif  // SONGBOOK_TESTING_HPP
@@ -0,0 +1,96 @@
+/**
+ * @file
+ *
+ * Negative cases of validation: every songbook in the directory passed
+ * as the first argument breaks the schema in one way (described by
+ * a comment in the file) and must be rejected both by Xerces and by
+ * the generated validator (`--fast-validate`). The valid songbook passed
+ * as the second argument must be accepted, so that a validator rejecting
+ * everything does not pass.
+ */
+
+#include "testing.hpp"
+
+#include "MultiSongbookConverter.hpp"
+#include "SongbookException.hpp"
+#include "SongbookPrinter.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace songbook;
+
+namespace {
+
+    std::vector<std::string> invalid_files;  ///< songbooks which must be rejected
+    std::string valid_file;                  ///< songbook which must be accepted
+
+    /**
+     * Parses and converts a songbook to text.
+     *
+     * @param filename songbook XML
+     * @param generated validate by the generated validator instead of Xerces?
+     * @return error message; empty when the songbook was accepted
+     * @throw std::exception other than `SongbookException`
+     */
+    std::string conversion_error(const std::string& filename, bool generated) {
+        std::ostringstream output;
+        MultiSongbookConverter converter{};
+        converter.add_printer<SongbookPrinter>(output);
+        converter.set_generated_validation(generated);
+        try {
+            converter.parse_songbook(filename);
+            converter.convert();
+        }
+        catch (const SongbookException& e) {
+            return e.what();
+        }
+        return {};
+    }
+
+    void test_rejected_by_xerces() {
+        for (const std::string& file: invalid_files) {
+            bool rejected = !conversion_error(file, false).empty();
+            if (!rejected)
+                std::cerr << file << ": accepted by Xerces\n";
+            CHECK(rejected);
+        }
+    }
+
+    void test_rejected_by_generated_validator() {
+        for (const std::string& file: invalid_files) {
+            std::string error = conversion_error(file, true);
+            if (error.empty())
+                std::cerr << file << ": accepted by the generated validator\n";
+            // errors of the generated validator are reported with the position
+            CHECK(error.find("line") != std::string::npos);
+        }
+    }
+
+    void test_valid_accepted() {
+        CHECK_EQUAL(conversion_error(valid_file, true), "");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: validatorNegativeTest <directory with invalid songbooks> <valid songbook>\n";
+        return 1;
+    }
+    for (const auto& entry: std::filesystem::directory_iterator{argv[1]}) {
+        if (entry.path().extension() == ".xml")
+            invalid_files.push_back(entry.path().string());
+    }
+    std::sort(begin(invalid_files), end(invalid_files));
+    valid_file = argv[2];
+
+    return testing::run_tests({
+        {"rejected by Xerces", test_rejected_by_xerces},
+        {"rejected by the generated validator", test_rejected_by_generated_validator},
+        {"valid songbook accepted", test_valid_accepted},
+    });
+}